@@ -0,0 +1,15 @@
+#version 330 core
+
+/* Earth disc (km-space) for the per-pixel passes (day/night, heatmaps):
+ * hands the km position to the fragment stage for inverse projection. */
+
+layout(location = 0) in vec2 a_pos;
+
+uniform mat4 u_mvp;
+out vec2 v_km;
+
+void main()
+{
+    gl_Position = u_mvp * vec4(a_pos, 0.0, 1.0);
+    v_km = a_pos;
+}
@@ -0,0 +1,43 @@
+#version 330 core
+
+/* GPU-side forward projection for static lat/lon geometry.
+ * Mirrors projection_forward(): x = cos φ sin Δλ, y = cos φ₁ sin φ − sin φ₁ cos φ cos Δλ,
+ * scaled by R (ortho) or R·c/sin(c) (azimuthal equidistant).  c is taken
+ * from atan(sin c, cos c) to stay precise near the projection center. */
+
+layout(location = 0) in vec2 a_geo;   /* (lat, lon) in degrees */
+
+uniform vec3 u_center;  /* sin(center lat), cos(center lat), center lon (radians) */
+uniform int  u_mode;    /* 0 = azimuthal equidistant, 1 = orthographic */
+
+out vec2  g_pos;        /* projected position in km */
+out float g_front;      /* 1.0 if visible (front hemisphere), else 0.0 */
+out float g_alpha;      /* passed through to map.frag */
+
+const float EARTH_RADIUS_KM = 6371.0;
+const float DEG2RAD = 0.017453292519943295;
+
+void main()
+{
+    g_alpha = 1.0;
+    float lat  = a_geo.x * DEG2RAD;
+    float dlon = a_geo.y * DEG2RAD - u_center.z;
+
+    float sin_lat = sin(lat);
+    float cos_lat = cos(lat);
+    float cos_dlon = cos(dlon);
+
+    vec2 p = vec2(cos_lat * sin(dlon),
+                  u_center.y * sin_lat - u_center.x * cos_lat * cos_dlon);
+    float cos_c = u_center.x * sin_lat + u_center.y * cos_lat * cos_dlon;
+
+    if (u_mode == 1) {
+        g_pos = EARTH_RADIUS_KM * p;
+        g_front = (cos_c > 0.0) ? 1.0 : 0.0;
+    } else {
+        float sin_c = length(p);
+        float c = atan(sin_c, cos_c);
+        g_pos = (EARTH_RADIUS_KM * c / max(sin_c, 1e-7)) * p;
+        g_front = 1.0;
+    }
+}
@@ -0,0 +1,53 @@
+#version 330 core
+
+/* Per-pixel lat/lon heatmap (aurora, DRAP).  Inverse-projects the
+ * fragment's km-space position the same way as night.frag, samples the
+ * single-channel raster with bilinear filtering (longitude wraps, latitude
+ * clamps) and maps the value to alpha through a piecewise linear ramp. */
+
+uniform vec4      u_color;
+uniform vec3      u_center;   /* sin(center lat), cos(center lat), center lon (radians) */
+uniform int       u_mode;     /* 0 = azimuthal equidistant, 1 = orthographic */
+uniform sampler2D u_grid;
+uniform vec4      u_grid_map; /* lon0, dlon, lat0, dlat (degrees, texel centres) */
+uniform vec2      u_grid_size;
+uniform vec2      u_ramp[4];  /* (value, alpha) stops, ascending */
+
+in vec2 v_km;
+out vec4 frag_color;
+
+const float EARTH_RADIUS_KM = 6371.0;
+
+float ramp_alpha(float v)
+{
+    if (v <= u_ramp[0].x) return 0.0;
+    int i = 1;
+    while (i < 3 && v > u_ramp[i].x) i++;
+    vec2 a = u_ramp[i - 1], b = u_ramp[i];
+    return a.y + (v - a.x) / (b.x - a.x) * (b.y - a.y);
+}
+
+void main()
+{
+    float sin_lat0 = u_center.x, cos_lat0 = u_center.y;
+    float sin_lon0 = sin(u_center.z), cos_lon0 = cos(u_center.z);
+
+    vec3 c_dir = vec3(cos_lat0 * cos_lon0, cos_lat0 * sin_lon0, sin_lat0);
+    vec3 east  = vec3(-sin_lon0, cos_lon0, 0.0);
+    vec3 north = vec3(-sin_lat0 * cos_lon0, -sin_lat0 * sin_lon0, cos_lat0);
+
+    float rho = length(v_km);
+    float c = (u_mode == 1) ? asin(min(rho / EARTH_RADIUS_KM, 1.0))
+                            : rho / EARTH_RADIUS_KM;
+    vec2 dir = (rho > 1e-3) ? v_km / rho : vec2(0.0);
+    vec3 p = cos(c) * c_dir + sin(c) * (dir.x * east + dir.y * north);
+
+    float lat = degrees(asin(clamp(p.z, -1.0, 1.0)));
+    float lon = degrees(atan(p.y, p.x));
+
+    vec2 uv = (vec2((lon - u_grid_map.x) / u_grid_map.y,
+                    (lat - u_grid_map.z) / u_grid_map.w) + 0.5) / u_grid_size;
+    float alpha = ramp_alpha(texture(u_grid, uv).r);
+    if (alpha <= 0.0) discard;
+    frag_color = vec4(u_color.rgb, u_color.a * alpha);
+}
@@ -0,0 +1,39 @@
+#version 330 core
+
+/* Per-pixel day/night shading.  Inverse-projects the fragment's km-space
+ * position (mirrors projection_inverse(): c = ρ/R for azimuthal
+ * equidistant, asin(ρ/R) for orthographic) to a unit vector on the globe,
+ * then takes the solar zenith angle against the subsolar point.  Alpha is
+ * 0 up to 80° (day), smoothstepped to 0.75 at 108° (astronomical night). */
+
+uniform vec4 u_color;
+uniform vec3 u_center;  /* sin(center lat), cos(center lat), center lon (radians) */
+uniform int  u_mode;    /* 0 = azimuthal equidistant, 1 = orthographic */
+uniform vec3 u_sun;     /* subsolar point as an Earth-centered unit vector */
+
+in vec2 v_km;
+out vec4 frag_color;
+
+const float EARTH_RADIUS_KM = 6371.0;
+const float MAX_ALPHA = 0.75;
+
+void main()
+{
+    float sin_lat0 = u_center.x, cos_lat0 = u_center.y;
+    float sin_lon0 = sin(u_center.z), cos_lon0 = cos(u_center.z);
+
+    /* Center, east and north unit vectors of the projection center */
+    vec3 c_dir = vec3(cos_lat0 * cos_lon0, cos_lat0 * sin_lon0, sin_lat0);
+    vec3 east  = vec3(-sin_lon0, cos_lon0, 0.0);
+    vec3 north = vec3(-sin_lat0 * cos_lon0, -sin_lat0 * sin_lon0, cos_lat0);
+
+    float rho = length(v_km);
+    float c = (u_mode == 1) ? asin(min(rho / EARTH_RADIUS_KM, 1.0))
+                            : rho / EARTH_RADIUS_KM;
+    vec2 dir = (rho > 1e-3) ? v_km / rho : vec2(0.0);
+    vec3 p = cos(c) * c_dir + sin(c) * (dir.x * east + dir.y * north);
+
+    float zenith = degrees(acos(clamp(dot(p, u_sun), -1.0, 1.0)));
+    float alpha = smoothstep(80.0, 108.0, zenith) * MAX_ALPHA;
+    frag_color = vec4(u_color.rgb, u_color.a * alpha);
+}
@@ -0,0 +1,58 @@
+#version 330 core
+
+/* Instanced great-circle paths for many-target mode.  One instance per
+ * spot, u_points vertices per instance: vertex i is the slerp between the
+ * home point and the spot at t = i / (u_points - 1), projected as in
+ * geo.vert (directly from the unit vector).  geo.geom then drops the
+ * pieces on the ortho back hemisphere or across the antipode. */
+
+layout(location = 1) in vec3 a_spot;  /* lat, lon (degrees), born (seconds, < 0 = pinned) */
+
+uniform vec3  u_center;    /* sin(center lat), cos(center lat), center lon (radians) */
+uniform int   u_mode;      /* 0 = azimuthal equidistant, 1 = orthographic */
+uniform vec3  u_home;      /* path start as a unit vector */
+uniform int   u_points;    /* vertices per path */
+uniform float u_now;       /* current time, same clock as born */
+uniform float u_max_age;   /* age (seconds) at which a spot has faded out */
+
+out vec2  g_pos;
+out float g_front;
+out float g_alpha;
+
+const float EARTH_RADIUS_KM = 6371.0;
+const float DEG2RAD = 0.017453292519943295;
+
+void main()
+{
+    float lat = a_spot.x * DEG2RAD;
+    float lon = a_spot.y * DEG2RAD;
+    vec3 b = vec3(cos(lat) * cos(lon), cos(lat) * sin(lon), sin(lat));
+
+    /* Spherical interpolation; a zero-length (or antipodal, undefined)
+     * path collapses onto the home point */
+    float t = float(gl_VertexID) / float(u_points - 1);
+    float omega = acos(clamp(dot(u_home, b), -1.0, 1.0));
+    float s = sin(omega);
+    vec3 q = u_home;
+    if (s > 1e-5)
+        q = (sin((1.0 - t) * omega) * u_home + sin(t * omega) * b) / s;
+
+    /* cos φ cos Δλ, cos φ sin Δλ and sin φ of q */
+    float cl = cos(u_center.z), sl = sin(u_center.z);
+    float cos_lat_cos_dlon = q.x * cl + q.y * sl;
+    vec2 p = vec2(q.y * cl - q.x * sl,
+                  u_center.y * q.z - u_center.x * cos_lat_cos_dlon);
+    float cos_c = u_center.x * q.z + u_center.y * cos_lat_cos_dlon;
+
+    if (u_mode == 1) {
+        g_pos = EARTH_RADIUS_KM * p;
+        g_front = (cos_c > 0.0) ? 1.0 : 0.0;
+    } else {
+        float sin_c = length(p);
+        float c = atan(sin_c, cos_c);
+        g_pos = (EARTH_RADIUS_KM * c / max(sin_c, 1e-7)) * p;
+        g_front = 1.0;
+    }
+    g_alpha = a_spot.z < 0.0 ? 1.0
+            : clamp(1.0 - (u_now - a_spot.z) / u_max_age, 0.0, 1.0);
+}
@@ -0,0 +1,52 @@
+#version 330 core
+
+/* Instanced spot markers for many-target mode: a small disc (corner
+ * offsets, attribute 0) placed at each spot's projected position
+ * (instance attribute 1), faded by age.  Spots on the ortho back
+ * hemisphere are moved outside the clip volume. */
+
+layout(location = 0) in vec2 a_corner;  /* unit disc outline / center */
+layout(location = 1) in vec3 a_spot;    /* lat, lon (degrees), born (seconds, < 0 = pinned) */
+
+uniform mat4  u_mvp;
+uniform vec3  u_center;    /* sin(center lat), cos(center lat), center lon (radians) */
+uniform int   u_mode;      /* 0 = azimuthal equidistant, 1 = orthographic */
+uniform float u_size_km;   /* marker radius */
+uniform float u_now;       /* current time, same clock as born */
+uniform float u_max_age;   /* age (seconds) at which a spot has faded out */
+
+out float v_alpha;
+
+const float EARTH_RADIUS_KM = 6371.0;
+const float DEG2RAD = 0.017453292519943295;
+
+void main()
+{
+    float lat  = a_spot.x * DEG2RAD;
+    float dlon = a_spot.y * DEG2RAD - u_center.z;
+
+    float sin_lat = sin(lat);
+    float cos_lat = cos(lat);
+    float cos_dlon = cos(dlon);
+
+    vec2 p = vec2(cos_lat * sin(dlon),
+                  u_center.y * sin_lat - u_center.x * cos_lat * cos_dlon);
+    float cos_c = u_center.x * sin_lat + u_center.y * cos_lat * cos_dlon;
+
+    vec2 pos;
+    if (u_mode == 1) {
+        if (cos_c <= 0.0) {
+            gl_Position = vec4(0.0, 0.0, 2.0, 1.0);
+            v_alpha = 0.0;
+            return;
+        }
+        pos = EARTH_RADIUS_KM * p;
+    } else {
+        float sin_c = length(p);
+        float c = atan(sin_c, cos_c);
+        pos = (EARTH_RADIUS_KM * c / max(sin_c, 1e-7)) * p;
+    }
+    gl_Position = u_mvp * vec4(pos + a_corner * u_size_km, 0.0, 1.0);
+    v_alpha = a_spot.z < 0.0 ? 1.0
+            : clamp(1.0 - (u_now - a_spot.z) / u_max_age, 0.0, 1.0);
+}
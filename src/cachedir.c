@@ -0,0 +1,35 @@
+/* cachedir.c — Location of azMap's on-disk caches. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include "cachedir.h"
+
+int cache_dir(char *out, size_t sz)
+{
+    const char *xdg = getenv("XDG_CACHE_HOME");
+    const char *home = getenv("HOME");
+    if (xdg && xdg[0])
+        snprintf(out, sz, "%s/azmap", xdg);
+    else if (home)
+        snprintf(out, sz, "%s/.cache/azmap", home);
+    else
+        return -1;
+    return 0;
+}
+
+int make_dirs(const char *dir)
+{
+    char tmp[PATH_MAX];
+    snprintf(tmp, sizeof(tmp), "%s", dir);
+    for (char *p = tmp + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        if (mkdir(tmp, 0755) != 0 && errno != EEXIST) return -1;
+        *p = '/';
+    }
+    if (mkdir(tmp, 0755) != 0 && errno != EEXIST) return -1;
+    return 0;
+}
@@ -0,0 +1,19 @@
+/* cachedir.h — Location of azMap's on-disk caches.
+ *
+ * The geometry cache, the feed cache and the QRZ cache all live under
+ * $XDG_CACHE_HOME/azmap (default ~/.cache/azmap). */
+
+#ifndef CACHEDIR_H
+#define CACHEDIR_H
+
+#include <stddef.h>
+
+/* Write the cache directory to out.  Returns 0, or -1 if neither
+ * XDG_CACHE_HOME nor HOME is set. */
+int cache_dir(char *out, size_t sz);
+
+/* mkdir -p dir (mode 0755).  Returns 0 if it exists afterwards, -1
+ * otherwise. */
+int make_dirs(const char *dir);
+
+#endif
@@ -34,6 +34,11 @@ static void get_config_path(char *out, size_t sz)
 int config_load(Config *cfg)
 {
     memset(cfg, 0, sizeof(*cfg));
+    cfg->gpu_projection = 1;
+    cfg->geometry_cache = 1;
+    cfg->spore_grid_step = 2.0;
+    cfg->spot_max_age = 900.0;
+    cfg->wsjtx_port = 2237;
 
     char path[1024];
     get_config_path(path, sizeof(path));
@@ -74,6 +79,30 @@ int config_load(Config *cfg)
         } else if (strcmp(key, "qrz_pass") == 0) {
             strncpy(cfg->qrz_pass, val, sizeof(cfg->qrz_pass) - 1);
             cfg->qrz_pass[sizeof(cfg->qrz_pass) - 1] = '\0';
+        } else if (strcmp(key, "gpu_projection") == 0) {
+            cfg->gpu_projection = (int)strtol(val, NULL, 10);
+        } else if (strcmp(key, "fast_projection") == 0) {
+            cfg->fast_projection = (int)strtol(val, NULL, 10);
+        } else if (strcmp(key, "geometry_cache") == 0) {
+            cfg->geometry_cache = (int)strtol(val, NULL, 10);
+        } else if (strcmp(key, "spore_grid_step") == 0) {
+            cfg->spore_grid_step = strtod(val, NULL);
+        } else if (strcmp(key, "aurora_contours") == 0) {
+            cfg->aurora_contours = (int)strtol(val, NULL, 10);
+        } else if (strcmp(key, "drap_contours") == 0) {
+            cfg->drap_contours = (int)strtol(val, NULL, 10);
+        } else if (strcmp(key, "offline") == 0) {
+            cfg->offline = (int)strtol(val, NULL, 10);
+        } else if (strcmp(key, "spot_max_age") == 0) {
+            cfg->spot_max_age = strtod(val, NULL);
+        } else if (strcmp(key, "wsjtx_port") == 0) {
+            cfg->wsjtx_port = (int)strtol(val, NULL, 10);
+        } else if (strcmp(key, "wsjtx_group") == 0) {
+            strncpy(cfg->wsjtx_group, val, sizeof(cfg->wsjtx_group) - 1);
+            cfg->wsjtx_group[sizeof(cfg->wsjtx_group) - 1] = '\0';
+        } else if (strcmp(key, "ipc_socket") == 0) {
+            strncpy(cfg->ipc_socket, val, sizeof(cfg->ipc_socket) - 1);
+            cfg->ipc_socket[sizeof(cfg->ipc_socket) - 1] = '\0';
         } else if (strcmp(key, "target_lat") == 0) {
             cfg->target_lat = strtod(val, NULL);
             has_tlat = 1;
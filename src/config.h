@@ -15,6 +15,17 @@ typedef struct {
     int valid; /* 1 if both lat and lon were found */
     char qrz_user[64];
     char qrz_pass[64];
+    int  gpu_projection;       /* 0 forces CPU reprojection of coastlines/borders (default 1) */
+    int  fast_projection;      /* 1 selects the float32 batch projection tier (default 0) */
+    int  geometry_cache;       /* 0 disables the ~/.cache/azmap geometry cache (default 1) */
+    double spore_grid_step;    /* Sporadic E interpolation grid, degrees: 2, 1 or 0.5 (default 2) */
+    int  aurora_contours;      /* 1 adds probability isolines to the aurora layer (default 0) */
+    int  drap_contours;        /* 1 adds HAF isolines to the DRAP layer (default 0) */
+    int  offline;              /* 1 shows overlays from the feed cache only (default 0) */
+    double spot_max_age;       /* seconds a spot stays on the map after it was heard (default 900) */
+    int  wsjtx_port;           /* WSJT-X UDP server port, 0 disables the listener (default 2237) */
+    char wsjtx_group[64];      /* multicast group to join for WSJT-X, "" = unicast (default "") */
+    char ipc_socket[108];      /* IPC socket path, "" = $XDG_RUNTIME_DIR/azmap.sock, "off" = none */
 
     /* Persisted target */
     double target_lat, target_lon;
@@ -0,0 +1,237 @@
+/* contour.c — Isolines of regular lat/lon grids (marching squares).
+ *
+ * Edge ids: horizontal edge (r, c) joins values (r, c) and (r, c + 1)
+ * (column 0 when wrapping) and has id r * cols + c; vertical edge (r, c)
+ * joins (r, c) and (r + 1, c) and has id (rows + r) * cols + c.  A piece
+ * is the line through one cell between two of its edges.  Tracing walks
+ * from a piece through its edges to the neighbouring pieces, first back
+ * to an open end (or round to itself on a ring), then forward emitting
+ * one vertex per edge. */
+
+#include <stdlib.h>
+#include <string.h>
+#include "contour.h"
+
+/* Cell edges as in the marching squares case table */
+enum { EDGE_BOTTOM, EDGE_RIGHT, EDGE_TOP, EDGE_LEFT };
+
+/* For each of the 16 corner cases (bit 0 = (r,c), 1 = (r,c+1),
+ * 2 = (r+1,c+1), 3 = (r+1,c) at or above the level), the pair of edges
+ * to connect.  Saddles (5, 10) are handled separately. */
+static const signed char ms_edges[16][2] = {
+    { -1, -1 },  /* 0000 */
+    {  3,  0 },  /* 0001 */
+    {  0,  1 },  /* 0010 */
+    {  3,  1 },  /* 0011 */
+    {  1,  2 },  /* 0100 */
+    { -1, -1 },  /* 0101 saddle */
+    {  0,  2 },  /* 0110 */
+    {  3,  2 },  /* 0111 */
+    {  2,  3 },  /* 1000 */
+    {  2,  0 },  /* 1001 */
+    { -1, -1 },  /* 1010 saddle */
+    {  2,  1 },  /* 1011 */
+    {  1,  3 },  /* 1100 */
+    {  1,  0 },  /* 1101 */
+    {  0,  3 },  /* 1110 */
+    { -1, -1 },  /* 1111 */
+};
+
+void contour_init(Contour *c, SegTable *segs)
+{
+    memset(c, 0, sizeof(*c));
+    c->segs = segs;
+}
+
+void contour_free(Contour *c)
+{
+    free(c->lats);
+    free(c->lons);
+    free(c->links);
+    free(c->pieces);
+    free(c->used);
+    c->lats = c->lons = NULL;
+    c->links = c->pieces = NULL;
+    c->used = NULL;
+    c->count = c->cap = c->links_size = c->pieces_cap = 0;
+}
+
+/* Id of edge e (EDGE_*) of cell (r, col). */
+static int edge_id(const ContourGrid *g, int r, int col, int e)
+{
+    int c1 = (col + 1 == g->cols) ? 0 : col + 1;
+    switch (e) {
+    case EDGE_BOTTOM: return r * g->cols + col;
+    case EDGE_RIGHT:  return (g->rows + r) * g->cols + c1;
+    case EDGE_TOP:    return (r + 1) * g->cols + col;
+    default:          return (g->rows + r) * g->cols + col;
+    }
+}
+
+/* Where the level crosses edge id. */
+static void edge_point(const ContourGrid *g, int id, float level,
+                       double *lat, double *lon)
+{
+    int vertical = id >= g->rows * g->cols;
+    if (vertical) id -= g->rows * g->cols;
+    int r = id / g->cols, col = id % g->cols;
+    int ia = id;
+    int ib = vertical ? id + g->cols
+                      : r * g->cols + (col + 1 == g->cols ? 0 : col + 1);
+    float va = g->values[ia], vb = g->values[ib];
+    float t = (va == vb) ? 0.5f : (level - va) / (vb - va);
+    if (vertical) {
+        *lat = g->lat0 + (r + t) * g->dlat;
+        *lon = g->lon0 + col * g->dlon;
+    } else {
+        *lat = g->lat0 + r * g->dlat;
+        *lon = g->lon0 + (col + t) * g->dlon;
+    }
+}
+
+static int add_piece(Contour *c, int *n, int e0, int e1)
+{
+    if (*n == c->pieces_cap) {
+        int ncap = c->pieces_cap ? c->pieces_cap * 2 : 1024;
+        int *p = realloc(c->pieces, (size_t)ncap * 2 * sizeof(int));
+        if (!p) return -1;
+        c->pieces = p;
+        unsigned char *u = realloc(c->used, ncap);
+        if (!u) return -1;
+        c->used = u;
+        c->pieces_cap = ncap;
+    }
+    int k = (*n)++;
+    c->pieces[k * 2] = e0;
+    c->pieces[k * 2 + 1] = e1;
+    c->used[k] = 0;
+    c->links[e0 * 2 + (c->links[e0 * 2] >= 0)] = k;
+    c->links[e1 * 2 + (c->links[e1 * 2] >= 0)] = k;
+    return 0;
+}
+
+static int emit(Contour *c, const ContourGrid *g, int edge, float level)
+{
+    if (c->count == c->cap) {
+        int ncap = c->cap ? c->cap * 2 : 4096;
+        double *lats = realloc(c->lats, ncap * sizeof(double));
+        if (!lats) return -1;
+        c->lats = lats;
+        double *lons = realloc(c->lons, ncap * sizeof(double));
+        if (!lons) return -1;
+        c->lons = lons;
+        c->cap = ncap;
+    }
+    edge_point(g, edge, level, &c->lats[c->count], &c->lons[c->count]);
+    c->count++;
+    return 0;
+}
+
+/* The piece other than p crossing edge e (-1 if none). */
+static int other_piece(const Contour *c, int e, int p)
+{
+    int a = c->links[e * 2];
+    return a == p ? c->links[e * 2 + 1] : a;
+}
+
+/* The edge of piece p other than e. */
+static int far_edge(const Contour *c, int p, int e)
+{
+    return c->pieces[p * 2] == e ? c->pieces[p * 2 + 1] : c->pieces[p * 2];
+}
+
+int contour_trace(Contour *c, const ContourGrid *g, float level)
+{
+    int rows = g->rows, cols = g->cols;
+    if (rows < 2 || cols < 2) return 0;
+
+    int nedges = 2 * rows * cols;
+    if (c->links_size < nedges) {
+        int *l = realloc(c->links, (size_t)nedges * 2 * sizeof(int));
+        if (!l) return -1;
+        c->links = l;
+        c->links_size = nedges;
+    }
+    memset(c->links, 0xff, (size_t)nedges * 2 * sizeof(int));
+
+    /* Pieces of every cell with data at all four corners */
+    int npieces = 0;
+    int cell_cols = g->wrap ? cols : cols - 1;
+    for (int r = 0; r < rows - 1; r++) {
+        for (int col = 0; col < cell_cols; col++) {
+            int c1 = (col + 1 == cols) ? 0 : col + 1;
+            int i00 = r * cols + col, i10 = r * cols + c1;
+            int i01 = i00 + cols, i11 = i10 + cols;
+            if (g->valid && (!g->valid[i00] || !g->valid[i10] ||
+                             !g->valid[i01] || !g->valid[i11]))
+                continue;
+
+            float v00 = g->values[i00], v10 = g->values[i10];
+            float v01 = g->values[i01], v11 = g->values[i11];
+            int ci = (v00 >= level) | (v10 >= level) << 1 |
+                     (v11 >= level) << 2 | (v01 >= level) << 3;
+            int e[4];   /* up to two pieces: e[0]-e[1], e[2]-e[3] */
+            int n = 1;
+
+            if (ci == 5 || ci == 10) {
+                /* Saddle: the cell centre decides which corners connect */
+                int center_above = (v00 + v10 + v01 + v11) * 0.25f >= level;
+                static const int saddle[2][2][4] = {
+                    { { EDGE_LEFT, EDGE_BOTTOM, EDGE_TOP, EDGE_RIGHT },     /* 5, below */
+                      { EDGE_LEFT, EDGE_TOP, EDGE_BOTTOM, EDGE_RIGHT } },   /* 5, above */
+                    { { EDGE_BOTTOM, EDGE_RIGHT, EDGE_TOP, EDGE_LEFT },     /* 10, below */
+                      { EDGE_BOTTOM, EDGE_LEFT, EDGE_RIGHT, EDGE_TOP } },   /* 10, above */
+                };
+                memcpy(e, saddle[ci == 10][center_above], sizeof(e));
+                n = 2;
+            } else if (ms_edges[ci][0] >= 0) {
+                e[0] = ms_edges[ci][0];
+                e[1] = ms_edges[ci][1];
+            } else {
+                continue;
+            }
+            for (int k = 0; k < n; k++)
+                if (add_piece(c, &npieces, edge_id(g, r, col, e[k * 2]),
+                              edge_id(g, r, col, e[k * 2 + 1])) != 0)
+                    return -1;
+        }
+    }
+
+    int lines = 0;
+    for (int k = 0; k < npieces; k++) {
+        if (c->used[k]) continue;
+
+        /* Walk back to an open end, or round to k on a closed ring */
+        int start = k, e_start = c->pieces[k * 2];
+        int cur = k, e = e_start;
+        for (;;) {
+            int p = other_piece(c, e, cur);
+            if (p < 0) {
+                start = cur;
+                e_start = e;
+                break;
+            }
+            if (p == k) break;
+            e = far_edge(c, p, e);
+            cur = p;
+        }
+
+        /* Emit forward: one vertex per edge crossed */
+        int first = c->count;
+        if (emit(c, g, e_start, level) != 0) return -1;
+        cur = start;
+        e = e_start;
+        for (;;) {
+            c->used[cur] = 1;
+            int far = far_edge(c, cur, e);
+            if (emit(c, g, far, level) != 0) return -1;
+            int p = other_piece(c, far, cur);
+            if (p < 0 || c->used[p]) break;
+            cur = p;
+            e = far;
+        }
+        if (segtable_push(c->segs, first, c->count - first) < 0) return -1;
+        lines++;
+    }
+    return lines;
+}
@@ -0,0 +1,56 @@
+/* contour.h — Isolines of regular lat/lon grids (marching squares).
+ *
+ * Each crossing of the level lies on a grid edge, and every edge is shared
+ * by at most the two cells on either side of it.  The line pieces of a
+ * cell are therefore linked to those of its neighbours through a table
+ * indexed by edge id, instead of by matching endpoints within a distance,
+ * and whole polylines are traced in time linear in cells plus crossings.
+ * Polylines are open (ending at the grid border or at cells without data)
+ * or closed rings (first vertex repeated at the end).  Saddle cells are
+ * resolved with the average of their four corners.
+ *
+ * Used by the Sporadic E contours and the optional aurora / DRAP
+ * isolines in overlay.c. */
+
+#ifndef CONTOUR_H
+#define CONTOUR_H
+
+#include "segtable.h"
+
+typedef struct {
+    const float         *values;  /* rows * cols, row-major */
+    const unsigned char *valid;   /* per value, 0 = no data (NULL = all valid) */
+    int     rows, cols;
+    double  lat0, dlat;           /* latitude of row 0, row step (deg, signed) */
+    double  lon0, dlon;           /* longitude of column 0, column step (deg) */
+    int     wrap;                 /* last column is next to the first
+                                   * (cols * dlon == 360) */
+} ContourGrid;
+
+typedef struct {
+    /* Output: vertices of every traced polyline, one segment each */
+    double   *lats, *lons;
+    int       count, cap;
+    SegTable *segs;
+
+    /* Scratch reused by the next contour_trace() */
+    int      *links;       /* per edge: the (up to) two pieces crossing it */
+    int       links_size;
+    int      *pieces;      /* per piece: the ids of its two edges */
+    unsigned char *used;   /* per piece: already part of a polyline */
+    int       pieces_cap;
+} Contour;
+
+/* Start an empty output that appends segments to segs (not owned). */
+void contour_init(Contour *c, SegTable *segs);
+
+/* Trace the isolines of g at level and append them to c: the vertices to
+ * lats/lons, one segment per polyline to segs.  Returns the number of
+ * polylines added, or -1 when out of memory. */
+int  contour_trace(Contour *c, const ContourGrid *g, float level);
+
+/* Free the scratch and the vertex arrays.  A caller that keeps the
+ * vertices takes lats/lons and sets them to NULL first. */
+void contour_free(Contour *c);
+
+#endif
@@ -0,0 +1,216 @@
+/* feedbuild.c — Background build of fetched overlay feeds.
+ *
+ * One long-lived worker sleeps on a condition variable until a job is
+ * queued, builds it with its projection state set to the job's, and
+ * appends the result to the handoff queue under the same mutex.  Jobs
+ * run one at a time in submission order; the Sporadic E scatter still
+ * spreads over the thread pool (inline when the pool is busy). */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "feedbuild.h"
+
+struct FeedJob {
+    FeedBuildKind kind;
+    ProjState     proj;
+    OverlayStream stream;       /* MUF / Es / aurora */
+    char         *text;         /* DRAP */
+    FeedJob      *next;
+};
+
+static void (*feedbuild_wake)(void);
+
+void feedbuild_set_wake(void (*wake)(void))
+{
+    feedbuild_wake = wake;
+}
+
+/* Build one job into a new result (worker thread, or inline). */
+static FeedResult *run_job(FeedBuilder *b, FeedJob *job)
+{
+    FeedResult *r = calloc(1, sizeof(*r));
+    if (!r) return NULL;
+    r->kind = job->kind;
+    r->proj = job->proj;
+    muf_data_init(&r->lines);
+    heat_grid_init(&r->heat);
+    projection_set_state(&job->proj);
+
+    switch (job->kind) {
+    case FEED_BUILD_MUF:
+        r->ok = muf_take_stream(&r->lines, &job->stream) == 0;
+        break;
+    case FEED_BUILD_SPORE:
+        r->ok = spore_take_stream(&b->spore, &r->lines, &job->stream) == 0;
+        break;
+    case FEED_BUILD_AURORA: {
+        AuroraGrid g;
+        aurora_grid_init(&g);
+        r->ok = aurora_take_stream(&g, &job->stream) == 0 &&
+                aurora_heat_build(&r->heat, &g) == 0;
+        if (r->ok && b->aurora_contours)
+            aurora_contours_build(&r->lines, &r->heat);
+        aurora_grid_free(&g);
+        break;
+    }
+    case FEED_BUILD_DRAP: {
+        DrapGrid g;
+        drap_grid_init(&g);
+        r->ok = drap_parse_text(job->text, &g) == 0 &&
+                drap_heat_build(&r->heat, &g) == 0;
+        r->drap_peak = g.peak_mhz;
+        if (r->ok && b->drap_contours)
+            drap_contours_build(&r->lines, &r->heat);
+        drap_grid_free(&g);
+        break;
+    }
+    }
+    return r;
+}
+
+static void job_free(FeedJob *job)
+{
+    overlay_stream_free(&job->stream);
+    free(job->text);
+    free(job);
+}
+
+/* Append r to the handoff queue (mutex held). */
+static void push_result(FeedBuilder *b, FeedResult *r)
+{
+    if (!r) return;
+    if (b->done_tail) b->done_tail->next = r;
+    else b->done = r;
+    b->done_tail = r;
+}
+
+static void *worker(void *arg)
+{
+    FeedBuilder *b = arg;
+    pthread_mutex_lock(&b->mutex);
+    for (;;) {
+        while (!b->stop && !b->jobs)
+            pthread_cond_wait(&b->cond, &b->mutex);
+        if (b->stop) break;
+        FeedJob *job = b->jobs;
+        b->jobs = job->next;
+        if (!b->jobs) b->jobs_tail = NULL;
+        pthread_mutex_unlock(&b->mutex);
+
+        FeedResult *r = run_job(b, job);
+        job_free(job);
+
+        pthread_mutex_lock(&b->mutex);
+        push_result(b, r);
+        if (feedbuild_wake) feedbuild_wake();
+    }
+    pthread_mutex_unlock(&b->mutex);
+    return NULL;
+}
+
+int feedbuild_init(FeedBuilder *b, double spore_step, int aurora_contours,
+                   int drap_contours)
+{
+    memset(b, 0, sizeof(*b));
+    pthread_mutex_init(&b->mutex, NULL);
+    pthread_cond_init(&b->cond, NULL);
+    spore_grid_init(&b->spore, spore_step);
+    b->aurora_contours = aurora_contours;
+    b->drap_contours = drap_contours;
+    if (pthread_create(&b->thread, NULL, worker, b) != 0) {
+        fprintf(stderr, "Warning: cannot start the overlay build thread, building inline\n");
+        return -1;
+    }
+    b->running = 1;
+    return 0;
+}
+
+/* Queue a job, or run it right away without a worker. */
+static void submit(FeedBuilder *b, FeedJob *job)
+{
+    if (!b->running) {
+        FeedResult *r = run_job(b, job);
+        job_free(job);
+        pthread_mutex_lock(&b->mutex);
+        push_result(b, r);
+        pthread_mutex_unlock(&b->mutex);
+        return;
+    }
+    pthread_mutex_lock(&b->mutex);
+    if (b->jobs_tail) b->jobs_tail->next = job;
+    else b->jobs = job;
+    b->jobs_tail = job;
+    pthread_cond_signal(&b->cond);
+    pthread_mutex_unlock(&b->mutex);
+}
+
+void feedbuild_submit_stream(FeedBuilder *b, FeedBuildKind kind, OverlayStream *s,
+                             const ProjState *proj)
+{
+    FeedJob *job = calloc(1, sizeof(*job));
+    if (!job) return;
+    job->kind = kind;
+    job->proj = *proj;
+    job->stream = *s;
+    overlay_stream_init(s, s->feed);   /* the data is the job's now */
+    submit(b, job);
+}
+
+void feedbuild_submit_text(FeedBuilder *b, char *text, const ProjState *proj)
+{
+    FeedJob *job = calloc(1, sizeof(*job));
+    if (!job) {
+        free(text);
+        return;
+    }
+    job->kind = FEED_BUILD_DRAP;
+    job->proj = *proj;
+    overlay_stream_init(&job->stream, OVERLAY_FEED_MUF);   /* unused */
+    job->text = text;
+    submit(b, job);
+}
+
+FeedResult *feedbuild_take(FeedBuilder *b)
+{
+    pthread_mutex_lock(&b->mutex);
+    FeedResult *r = b->done;
+    if (r) {
+        b->done = r->next;
+        if (!b->done) b->done_tail = NULL;
+        r->next = NULL;
+    }
+    pthread_mutex_unlock(&b->mutex);
+    return r;
+}
+
+void feedbuild_result_free(FeedResult *r)
+{
+    if (!r) return;
+    muf_data_free(&r->lines);
+    heat_grid_free(&r->heat);
+    free(r);
+}
+
+void feedbuild_free(FeedBuilder *b)
+{
+    if (b->running) {
+        pthread_mutex_lock(&b->mutex);
+        b->stop = 1;
+        pthread_cond_signal(&b->cond);
+        pthread_mutex_unlock(&b->mutex);
+        pthread_join(b->thread, NULL);
+        b->running = 0;
+    }
+    while (b->jobs) {
+        FeedJob *job = b->jobs;
+        b->jobs = job->next;
+        job_free(job);
+    }
+    FeedResult *r;
+    while ((r = feedbuild_take(b)))
+        feedbuild_result_free(r);
+    spore_grid_free(&b->spore);
+    pthread_mutex_destroy(&b->mutex);
+    pthread_cond_destroy(&b->cond);
+}
@@ -0,0 +1,79 @@
+/* feedbuild.h — Background build of fetched overlay feeds.
+ *
+ * Turns a finished overlay response into ready-to-upload data on a worker
+ * thread: MUF lines, Sporadic E IDW + contours, aurora / DRAP heat
+ * rasters and their optional isolines, all projected at the ProjState
+ * passed with the job.  The main thread submits a job when a fetch
+ * finishes and takes FeedResults from a handoff queue; it only swaps them
+ * into its layers and uploads them.
+ *
+ * The worker owns the Sporadic E grid, which is updated incrementally
+ * from one refresh to the next. */
+
+#ifndef FEEDBUILD_H
+#define FEEDBUILD_H
+
+#include <pthread.h>
+#include "overlay.h"
+#include "projection.h"
+
+typedef enum {
+    FEED_BUILD_MUF,
+    FEED_BUILD_SPORE,
+    FEED_BUILD_AURORA,
+    FEED_BUILD_DRAP,
+} FeedBuildKind;
+
+/* A finished build (owned by the caller after feedbuild_take()) */
+typedef struct FeedResult {
+    FeedBuildKind kind;
+    int        ok;          /* 0: the response held no usable data */
+    ProjState  proj;        /* state lines was projected at */
+    MufData    lines;       /* MUF / Es lines, or the raster's isolines */
+    HeatGrid   heat;        /* aurora / DRAP raster */
+    float      drap_peak;   /* DRAP: peak HAF (MHz) */
+    struct FeedResult *next;
+} FeedResult;
+
+typedef struct FeedJob FeedJob;
+
+typedef struct {
+    pthread_t       thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;          /* a job was queued, or stop */
+    int             running;
+    int             stop;
+    FeedJob        *jobs, *jobs_tail;       /* submitted */
+    FeedResult     *done, *done_tail;       /* handoff queue */
+    SporeGrid       spore;         /* worker only while running */
+    int             aurora_contours, drap_contours;
+} FeedBuilder;
+
+/* Start the worker.  spore_step: Sporadic E grid spacing (see
+ * spore_grid_init()); *_contours: also build the raster isolines.
+ * Returns 0, or -1 if no thread could be started (jobs then run inline
+ * in feedbuild_submit_*()). */
+int  feedbuild_init(FeedBuilder *b, double spore_step, int aurora_contours,
+                    int drap_contours);
+
+/* Call wake (must be thread-safe, e.g. glfwPostEmptyEvent) when a result
+ * is ready.  NULL disables it. */
+void feedbuild_set_wake(void (*wake)(void));
+
+/* Queue a build of the complete stream s, projected at proj.  The
+ * stream's data moves into the job; s is left empty. */
+void feedbuild_submit_stream(FeedBuilder *b, FeedBuildKind kind, OverlayStream *s,
+                             const ProjState *proj);
+
+/* Queue a DRAP build of text (malloc'd; the job frees it). */
+void feedbuild_submit_text(FeedBuilder *b, char *text, const ProjState *proj);
+
+/* Next finished result in submission order, or NULL. */
+FeedResult *feedbuild_take(FeedBuilder *b);
+
+void feedbuild_result_free(FeedResult *r);
+
+/* Stop the worker (after the job it is running) and drop what is left. */
+void feedbuild_free(FeedBuilder *b);
+
+#endif
@@ -0,0 +1,169 @@
+/* feedcache.c — On-disk cache of overlay feed responses.
+ *
+ * File layout: FeedCacheHeader, then the response body exactly as
+ * received.  The header is written last (the body size is only known at
+ * the end) and the file is renamed into place, so a reader sees either
+ * the previous copy or the complete new one. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "feedcache.h"
+#include "cachedir.h"
+
+#define FEEDCACHE_MAGIC "AZMAPFC"   /* 8 bytes with NUL */
+
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t body_size;
+    char     etag[FEEDCACHE_ETAG_MAX];
+    char     last_modified[FEEDCACHE_DATE_MAX];
+} FeedCacheHeader;
+
+/* ── Paths ────────────────────────────────────────────────────────── */
+
+/* <cache dir>/feed-<name>.bin */
+static int cache_path(const char *name, char *out, size_t sz)
+{
+    char dir[PATH_MAX];
+    if (cache_dir(dir, sizeof(dir)) != 0) return -1;
+    snprintf(out, sz, "%s/feed-%s.bin", dir, name);
+    return 0;
+}
+
+/* ── Load ─────────────────────────────────────────────────────────── */
+
+/* Open the cached copy of name and read its header.  Returns the file
+ * positioned at the body, or NULL on a miss or an invalid file. */
+static FILE *open_cached(const char *name, FeedCacheHeader *h)
+{
+    char path[PATH_MAX];
+    struct stat st;
+    if (cache_path(name, path, sizeof(path)) != 0) return NULL;
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    if (fread(h, sizeof(*h), 1, f) != 1 || fstat(fileno(f), &st) != 0 ||
+        memcmp(h->magic, FEEDCACHE_MAGIC, sizeof(h->magic)) != 0 ||
+        h->version != FEEDCACHE_VERSION ||
+        h->body_size != (uint64_t)st.st_size - sizeof(*h) ||
+        h->body_size >= SIZE_MAX) {
+        fclose(f);
+        return NULL;
+    }
+    h->etag[FEEDCACHE_ETAG_MAX - 1] = '\0';
+    h->last_modified[FEEDCACHE_DATE_MAX - 1] = '\0';
+    return f;
+}
+
+int feedcache_validators(const char *name, FeedValidators *v)
+{
+    FeedCacheHeader h;
+    FILE *f = open_cached(name, &h);
+    if (!f) return -1;
+    fclose(f);
+    memcpy(v->etag, h.etag, sizeof(v->etag));
+    memcpy(v->last_modified, h.last_modified, sizeof(v->last_modified));
+    return 0;
+}
+
+char *feedcache_load(const char *name, size_t *len)
+{
+    FeedCacheHeader h;
+    FILE *f = open_cached(name, &h);
+    if (!f) return NULL;
+    size_t n = (size_t)h.body_size;
+    char *body = malloc(n + 1);
+    if (body && fread(body, 1, n, f) != n) {
+        free(body);
+        body = NULL;
+    }
+    fclose(f);
+    if (!body) return NULL;
+    body[n] = '\0';
+    if (len) *len = n;
+    return body;
+}
+
+/* ── Save ─────────────────────────────────────────────────────────── */
+
+int feedcache_begin(FeedCacheWriter *w, const char *name)
+{
+    char dir[PATH_MAX], path[PATH_MAX], tmp[PATH_MAX + 32];
+    memset(w, 0, sizeof(*w));
+    if (cache_dir(dir, sizeof(dir)) != 0 || cache_path(name, path, sizeof(path)) != 0)
+        return -1;
+    if (make_dirs(dir) != 0) {
+        fprintf(stderr, "Warning: cannot create cache directory %s\n", dir);
+        return -1;
+    }
+
+    /* Unique per writer: the same feed can be fetched twice at once */
+    static atomic_uint seq;
+    snprintf(tmp, sizeof(tmp), "%s.tmp.%ld.%u", path, (long)getpid(),
+             atomic_fetch_add(&seq, 1));
+    w->path = strdup(path);
+    w->tmp = strdup(tmp);
+    if (w->path && w->tmp)
+        w->file = fopen(tmp, "wb");
+
+    /* Header placeholder, rewritten by feedcache_commit() */
+    FeedCacheHeader h;
+    memset(&h, 0, sizeof(h));
+    if (!w->file || fwrite(&h, sizeof(h), 1, w->file) != 1) {
+        fprintf(stderr, "Warning: cannot write feed cache %s\n", tmp);
+        feedcache_abort(w);
+        return -1;
+    }
+    return 0;
+}
+
+int feedcache_write(FeedCacheWriter *w, const void *data, size_t len)
+{
+    if (fwrite(data, 1, len, w->file) != len) return -1;
+    w->size += len;
+    return 0;
+}
+
+void feedcache_commit(FeedCacheWriter *w, const FeedValidators *v)
+{
+    FeedCacheHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, FEEDCACHE_MAGIC, sizeof(h.magic));
+    h.version = FEEDCACHE_VERSION;
+    h.body_size = w->size;
+    memcpy(h.etag, v->etag, sizeof(h.etag));
+    memcpy(h.last_modified, v->last_modified, sizeof(h.last_modified));
+
+    int ok = fseek(w->file, 0, SEEK_SET) == 0 && fwrite(&h, sizeof(h), 1, w->file) == 1;
+    if (fclose(w->file) != 0) ok = 0;
+    w->file = NULL;
+    if (!ok || rename(w->tmp, w->path) != 0) {
+        fprintf(stderr, "Warning: cannot write feed cache %s\n", w->path);
+        unlink(w->tmp);
+    }
+    feedcache_abort(w);
+}
+
+void feedcache_abort(FeedCacheWriter *w)
+{
+    if (w->file) {
+        fclose(w->file);
+        unlink(w->tmp);
+    }
+    free(w->path);
+    free(w->tmp);
+    memset(w, 0, sizeof(*w));
+}
+
+void feedcache_drop(const char *name)
+{
+    char path[PATH_MAX];
+    if (cache_path(name, path, sizeof(path)) == 0)
+        unlink(path);
+}
@@ -0,0 +1,61 @@
+/* feedcache.h — On-disk cache of overlay feed responses.
+ *
+ * Keeps the last good response of each overlay feed under
+ * $XDG_CACHE_HOME/azmap (default ~/.cache/azmap) as feed-<name>.bin,
+ * together with the ETag and Last-Modified headers it came with.  fetch.c
+ * writes a new body while it streams in and revalidates a cached one with
+ * a conditional GET; main.c shows the cached copy as soon as a layer is
+ * switched on, and only the cache is used in offline mode. */
+
+#ifndef FEEDCACHE_H
+#define FEEDCACHE_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+/* Bump when the file layout changes. */
+#define FEEDCACHE_VERSION   1
+#define FEEDCACHE_ETAG_MAX  256
+#define FEEDCACHE_DATE_MAX  64
+
+/* Validators of a response; empty strings when the server sent none */
+typedef struct {
+    char etag[FEEDCACHE_ETAG_MAX];
+    char last_modified[FEEDCACHE_DATE_MAX];
+} FeedValidators;
+
+/* A body being written (feedcache_begin .. feedcache_commit / _abort) */
+typedef struct {
+    FILE  *file;
+    char  *path, *tmp;
+    size_t size;
+} FeedCacheWriter;
+
+/* Validators of the cached copy of feed name.  Returns 0 if there is one,
+ * -1 otherwise. */
+int   feedcache_validators(const char *name, FeedValidators *v);
+
+/* The cached body of feed name, malloc'd and NUL-terminated (caller
+ * frees), its length in *len if len is not NULL.  NULL when not cached. */
+char *feedcache_load(const char *name, size_t *len);
+
+/* Start writing a new body for feed name to a temporary file.  Returns 0,
+ * or -1 (with a warning) if the cache cannot be written. */
+int   feedcache_begin(FeedCacheWriter *w, const char *name);
+
+/* Append a chunk.  Returns 0, or -1 on a write error. */
+int   feedcache_write(FeedCacheWriter *w, const void *data, size_t len);
+
+/* Finish the body with its validators and replace the cached copy
+ * atomically (via rename).  Failures only print a warning. */
+void  feedcache_commit(FeedCacheWriter *w, const FeedValidators *v);
+
+/* Drop a body that will not be kept; the cached copy stays as it was. */
+void  feedcache_abort(FeedCacheWriter *w);
+
+/* Remove the cached copy of feed name, once its body failed to build.
+ * Its validators would otherwise get a 304 on every refresh and the feed
+ * would never recover; the next fetch is unconditional instead. */
+void  feedcache_drop(const char *name);
+
+#endif
@@ -1,13 +1,37 @@
-/* fetch.c — Threaded non-blocking HTTP GET via libcurl + pthread.
+/* fetch.c — Non-blocking HTTP GET on a single libcurl multi worker.
  *
- * Each request runs in a detached thread so the main GL loop never blocks.
- * A mutex protects the shared status/response fields; the main loop polls
- * fetch_check() each frame and takes ownership of the response when ready. */
+ * fetch_start*() put the request on a submission queue and wake the
+ * worker (curl_multi_wakeup).  The worker owns the multi handle and every
+ * easy handle: it adds queued requests, runs curl_multi_perform(),
+ * finishes completed transfers and sleeps in curl_multi_poll().  The
+ * multi handle keeps the connection pool and DNS cache alive between
+ * refreshes; a share handle adds the TLS session cache.
+ *
+ * A mutex per request protects its status/response fields; the main loop
+ * polls fetch_check() each frame and takes ownership of the response
+ * when ready.  Streaming requests pass each chunk to their sink instead
+ * of buffering.  Cached requests tee a 200 body into the feed cache and
+ * send the cached copy's validators, so an unchanged feed comes back as
+ * 304.  Cancellation is a flag the worker picks up on its next pass;
+ * fetch_cancel() waits on eng.done until the request has finished. */
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <time.h>
 #include <curl/curl.h>
 #include "fetch.h"
+#include "feedcache.h"
+
+/* Longest worker sleep; curl's own timers and wakeups cut it short */
+#define FETCH_POLL_MS 1000
+
+/* Called from the worker when a request finishes */
+static void (*fetch_wake)(void);
+
+/* Set once at startup, before any request */
+static int fetch_offline;
 
 /* Growable buffer for accumulating curl response data. */
 typedef struct {
@@ -16,89 +40,452 @@ typedef struct {
     size_t  cap;
 } Buffer;
 
-/* libcurl write callback: appends received data to the growable buffer. */
-static size_t write_cb(void *ptr, size_t size, size_t nmemb, void *userdata)
+/* State of one transfer, owned by the worker */
+typedef struct Transfer {
+    FetchRequest      *req;
+    CURL              *curl;
+    struct curl_slist *headers;    /* conditional GET headers */
+    Buffer             buf;        /* body, unless it goes to a sink */
+    long               body_bytes;
+    FeedCacheWriter    cache;      /* body copy for the feed cache */
+    int                caching;    /* 0 = not yet decided, 1 = writing, -1 = not */
+    FeedValidators     got;        /* validators sent with the response */
+    struct Transfer   *next;
+} Transfer;
+
+static struct {
+    pthread_mutex_t lock;          /* queue, cancel flags, stop, stats */
+    pthread_cond_t  done;          /* signalled whenever a request finishes */
+    pthread_t       thread;
+    int             running;
+    int             stop;
+    FetchRequest   *head, *tail;   /* submitted, not yet picked up */
+    CURLM          *multi;
+    CURLSH         *share;
+    Transfer       *active;        /* worker only */
+    FetchStats      stats;
+} eng = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER,
+};
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+void fetch_set_wake(void (*wake)(void))
+{
+    fetch_wake = wake;
+}
+
+void fetch_set_offline(int offline)
+{
+    fetch_offline = offline;
+}
+
+/* ── Callbacks ────────────────────────────────────────────────────── */
+
+/* Appends received data to the growable buffer. */
+static int buffer_append(Buffer *buf, const char *data, size_t total)
 {
-    Buffer *buf = userdata;
-    size_t total = size * nmemb;
     if (buf->len + total + 1 > buf->cap) {
         size_t newcap = (buf->cap + total + 1) * 2;
         char *p = realloc(buf->data, newcap);
-        if (!p) return 0;   /* signal error to curl */
+        if (!p) return -1;
         buf->data = p;
         buf->cap = newcap;
     }
-    memcpy(buf->data + buf->len, ptr, total);
+    memcpy(buf->data + buf->len, data, total);
     buf->len += total;
     buf->data[buf->len] = '\0';
-    return total;
+    return 0;
 }
 
-/* Thread entry point: performs the HTTP GET and stores result under mutex. */
-static void *fetch_thread(void *arg)
+/* libcurl write callback: copies a 200 body into the feed cache, then
+ * passes the chunk to the sink or appends it to the buffer. */
+static size_t write_cb(void *ptr, size_t size, size_t nmemb, void *userdata)
 {
-    FetchRequest *req = arg;
-    CURL *curl = curl_easy_init();
-    if (!curl) {
-        pthread_mutex_lock(&req->mutex);
-        req->status = -1;
-        pthread_mutex_unlock(&req->mutex);
-        return NULL;
-    }
+    Transfer *t = userdata;
+    FetchRequest *req = t->req;
+    size_t total = size * nmemb;
+    if (total == 0) return 0;
+    t->body_bytes += (long)total;
 
-    Buffer buf = { .data = malloc(4096), .len = 0, .cap = 4096 };
-    if (!buf.data) {
-        curl_easy_cleanup(curl);
-        pthread_mutex_lock(&req->mutex);
-        req->status = -1;
-        pthread_mutex_unlock(&req->mutex);
-        return NULL;
+    if (t->caching == 0) {
+        long code = 0;
+        curl_easy_getinfo(t->curl, CURLINFO_RESPONSE_CODE, &code);
+        t->caching = req->cache && code == 200 &&
+                     feedcache_begin(&t->cache, req->cache) == 0 ? 1 : -1;
+    }
+    if (t->caching == 1 && feedcache_write(&t->cache, ptr, total) != 0) {
+        feedcache_abort(&t->cache);
+        t->caching = -1;
     }
-    buf.data[0] = '\0';
 
-    curl_easy_setopt(curl, CURLOPT_URL, req->url);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_cb);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &buf);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
-    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-    curl_easy_setopt(curl, CURLOPT_USERAGENT, "azMap/1.0");
+    if (req->sink)
+        return req->sink(req->sink_ctx, ptr, total) == 0 ? total : 0;
+    return buffer_append(&t->buf, ptr, total) == 0 ? total : 0;  /* 0 aborts */
+}
 
-    CURLcode res = curl_easy_perform(curl);
-    curl_easy_cleanup(curl);
+/* Copy the value of header `name` out of line if that is the header. */
+static void header_value(const char *line, size_t n, const char *name,
+                         char *out, size_t out_sz)
+{
+    size_t k = strlen(name);
+    if (n <= k || line[k] != ':' || strncasecmp(line, name, k) != 0) return;
+    line += k + 1;
+    n -= k + 1;
+    while (n > 0 && (*line == ' ' || *line == '\t')) { line++; n--; }
+    while (n > 0 && (line[n - 1] == '\r' || line[n - 1] == '\n' || line[n - 1] == ' '))
+        n--;
+    if (n >= out_sz) return;   /* too long to send back */
+    memcpy(out, line, n);
+    out[n] = '\0';
+}
 
-    pthread_mutex_lock(&req->mutex);
-    if (res == CURLE_OK) {
-        req->response = buf.data;
-        req->response_len = buf.len;
-        req->status = 1;
+/* libcurl header callback: keeps the validators of the final response. */
+static size_t header_cb(char *line, size_t size, size_t nitems, void *userdata)
+{
+    Transfer *t = userdata;
+    size_t n = size * nitems;
+    if (n >= 5 && strncmp(line, "HTTP/", 5) == 0) {
+        memset(&t->got, 0, sizeof(t->got));   /* next response of a redirect */
     } else {
-        free(buf.data);
-        req->status = -1;
+        header_value(line, n, "ETag", t->got.etag, sizeof(t->got.etag));
+        header_value(line, n, "Last-Modified", t->got.last_modified,
+                     sizeof(t->got.last_modified));
     }
+    return n;
+}
+
+/* ── Completion ───────────────────────────────────────────────────── */
+
+/* Publish the result of a request, count it and wake the main loop (and
+ * any fetch_cancel() waiting for it).  The worker must not touch req
+ * afterwards: its owner may clean it up at once. */
+static void fetch_finish(FetchRequest *req, int status, Buffer *buf,
+                         long wire_bytes, long body_bytes, int new_conns)
+{
+    pthread_mutex_lock(&eng.lock);
+    int cancelled = req->cancel || eng.stop;
+    pthread_mutex_lock(&req->mutex);
+    if (status == 1 && buf) {
+        req->response = buf->data;
+        req->response_len = buf->len;
+    } else if (buf) {
+        free(buf->data);
+    }
+    req->ms = now_ms() - req->start_ms;
+    req->wire_bytes = wire_bytes;
+    req->body_bytes = body_bytes;
+    req->reused = new_conns == 0;
+    req->status = status;
     pthread_mutex_unlock(&req->mutex);
+
+    eng.stats.requests++;
+    if (status == 2) eng.stats.not_modified++;
+    if (status == -1 && cancelled) eng.stats.cancelled++;
+    else if (status == -1) eng.stats.failed++;
+    eng.stats.wire_bytes += wire_bytes;
+    eng.stats.body_bytes += body_bytes;
+    eng.stats.connections += new_conns;
+    pthread_cond_broadcast(&eng.done);
+    pthread_mutex_unlock(&eng.lock);
+    if (fetch_wake) fetch_wake();
+}
+
+/* Offline: answer from the feed cache only. */
+static void fetch_offline_request(FetchRequest *req)
+{
+    if (!req->cache) {
+        fetch_finish(req, -1, NULL, 0, 0, 0);
+        return;
+    }
+    if (req->revalidate) {
+        fetch_finish(req, 2, NULL, 0, 0, 0);   /* the caller already has the cached copy */
+        return;
+    }
+    Buffer buf = { 0 };
+    buf.data = feedcache_load(req->cache, &buf.len);
+    if (!buf.data) {
+        fetch_finish(req, -1, NULL, 0, 0, 0);
+        return;
+    }
+    long n = (long)buf.len;
+    int status = 1;
+    if (req->sink) {
+        status = req->sink(req->sink_ctx, buf.data, buf.len) == 0 &&
+                 req->sink(req->sink_ctx, NULL, 0) == 0 ? 1 : -1;
+        free(buf.data);
+        buf.data = NULL;
+    }
+    fetch_finish(req, status, &buf, 0, n, 0);
+}
+
+/* Detach t from the multi handle and free it; returns the request. */
+static FetchRequest *transfer_free(Transfer *t)
+{
+    for (Transfer **pp = &eng.active; *pp; pp = &(*pp)->next)
+        if (*pp == t) {
+            *pp = t->next;
+            break;
+        }
+    FetchRequest *req = t->req;
+    curl_multi_remove_handle(eng.multi, t->curl);
+    curl_easy_cleanup(t->curl);
+    curl_slist_free_all(t->headers);
+    free(t);
+    return req;
+}
+
+/* A transfer curl reported as done. */
+static void transfer_done(Transfer *t, CURLcode res)
+{
+    FetchRequest *req = t->req;
+    long code = 0, new_conns = 0;
+    curl_off_t wire = 0;
+    curl_easy_getinfo(t->curl, CURLINFO_RESPONSE_CODE, &code);
+    curl_easy_getinfo(t->curl, CURLINFO_NUM_CONNECTS, &new_conns);
+    curl_easy_getinfo(t->curl, CURLINFO_SIZE_DOWNLOAD_T, &wire);
+
+    /* 304: nothing to parse, the caller keeps what it has.  Error pages
+     * are not passed on as data. */
+    int status;
+    if (res != CURLE_OK || code >= 400)
+        status = -1;
+    else if (code == 304 && t->headers)
+        status = 2;
+    else if (req->sink)
+        status = req->sink(req->sink_ctx, NULL, 0) == 0 ? 1 : -1;
+    else
+        status = 1;
+
+    if (t->caching == 1 && status == 1)
+        feedcache_commit(&t->cache, &t->got);
+    else if (t->caching == 1)
+        feedcache_abort(&t->cache);
+
+    Buffer buf = t->buf;
+    long body = t->body_bytes;
+    transfer_free(t);
+    fetch_finish(req, status, req->sink ? NULL : &buf, (long)wire, body, (int)new_conns);
+}
+
+/* A transfer dropped before it completed (cancel or shutdown). */
+static void transfer_abort(Transfer *t)
+{
+    if (t->caching == 1) feedcache_abort(&t->cache);
+    Buffer buf = t->buf;
+    long body = t->body_bytes;
+    fetch_finish(transfer_free(t), -1, &buf, 0, body, 0);
+}
+
+/* ── Worker ───────────────────────────────────────────────────────── */
+
+/* Hand a queued request to the multi handle (or answer it offline). */
+static void transfer_start(FetchRequest *req)
+{
+    if (fetch_offline) {
+        fetch_offline_request(req);
+        return;
+    }
+    Transfer *t = calloc(1, sizeof(*t));
+    if (!t || !(t->curl = curl_easy_init())) {
+        free(t);
+        fetch_finish(req, -1, NULL, 0, 0, 0);
+        return;
+    }
+    t->req = req;
+
+    if (!req->sink) {
+        t->buf.data = malloc(4096);
+        t->buf.cap = 4096;
+        if (!t->buf.data) {
+            curl_easy_cleanup(t->curl);
+            free(t);
+            fetch_finish(req, -1, NULL, 0, 0, 0);
+            return;
+        }
+        t->buf.data[0] = '\0';
+    }
+
+    /* Conditional GET against the cached copy */
+    FeedValidators have;
+    if (req->cache && req->revalidate && feedcache_validators(req->cache, &have) == 0) {
+        char line[FEEDCACHE_ETAG_MAX + 32];
+        if (have.etag[0]) {
+            snprintf(line, sizeof(line), "If-None-Match: %s", have.etag);
+            t->headers = curl_slist_append(t->headers, line);
+        }
+        if (have.last_modified[0]) {
+            snprintf(line, sizeof(line), "If-Modified-Since: %s", have.last_modified);
+            t->headers = curl_slist_append(t->headers, line);
+        }
+    }
+
+    CURL *c = t->curl;
+    curl_easy_setopt(c, CURLOPT_URL, req->url);
+    curl_easy_setopt(c, CURLOPT_PRIVATE, t);
+    curl_easy_setopt(c, CURLOPT_SHARE, eng.share);
+    curl_easy_setopt(c, CURLOPT_WRITEFUNCTION, write_cb);
+    curl_easy_setopt(c, CURLOPT_WRITEDATA, t);
+    curl_easy_setopt(c, CURLOPT_HEADERFUNCTION, header_cb);
+    curl_easy_setopt(c, CURLOPT_HEADERDATA, t);
+    if (t->headers)
+        curl_easy_setopt(c, CURLOPT_HTTPHEADER, t->headers);
+    curl_easy_setopt(c, CURLOPT_ACCEPT_ENCODING, "");   /* all built-in decoders */
+    curl_easy_setopt(c, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+    curl_easy_setopt(c, CURLOPT_PIPEWAIT, 1L);           /* prefer a shared h2 connection */
+    curl_easy_setopt(c, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(c, CURLOPT_TIMEOUT, 30L);
+    curl_easy_setopt(c, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(c, CURLOPT_USERAGENT, "azMap/1.0");
+
+    t->next = eng.active;
+    eng.active = t;
+    if (curl_multi_add_handle(eng.multi, c) != CURLM_OK)
+        transfer_abort(t);
+}
+
+static void *fetch_worker(void *arg)
+{
+    (void)arg;
+    for (;;) {
+        /* Take the submissions and note which transfers to drop */
+        pthread_mutex_lock(&eng.lock);
+        int stop = eng.stop;
+        FetchRequest *queued = eng.head;
+        eng.head = eng.tail = NULL;
+        Transfer *drop = NULL;
+        for (Transfer *t = eng.active; t; t = t->next)
+            if (stop || t->req->cancel) {
+                drop = t;
+                break;
+            }
+        pthread_mutex_unlock(&eng.lock);
+
+        for (FetchRequest *r = queued, *next; r; r = next) {
+            next = r->next;
+            r->next = NULL;
+            if (stop)
+                fetch_finish(r, -1, NULL, 0, 0, 0);
+            else
+                transfer_start(r);
+        }
+        if (drop) {
+            transfer_abort(drop);
+            continue;   /* look for the next one */
+        }
+        if (stop) break;
+
+        int running;
+        curl_multi_perform(eng.multi, &running);
+        CURLMsg *msg;
+        int left;
+        while ((msg = curl_multi_info_read(eng.multi, &left))) {
+            if (msg->msg != CURLMSG_DONE) continue;
+            char *t = NULL;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &t);
+            transfer_done((Transfer *)t, msg->data.result);
+        }
+        curl_multi_poll(eng.multi, NULL, 0, FETCH_POLL_MS, NULL);
+    }
     return NULL;
 }
 
-/* Spawn a detached background thread to fetch the given URL. */
+/* ── API ──────────────────────────────────────────────────────────── */
+
+int fetch_init(void)
+{
+    if (eng.running) return 0;
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    eng.multi = curl_multi_init();
+    eng.share = curl_share_init();
+    if (!eng.multi || !eng.share) goto fail;
+    curl_share_setopt(eng.share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(eng.share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    curl_multi_setopt(eng.multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    curl_multi_setopt(eng.multi, CURLMOPT_MAX_TOTAL_CONNECTIONS, (long)FETCH_MAX_CONNECTIONS);
+    curl_multi_setopt(eng.multi, CURLMOPT_MAX_HOST_CONNECTIONS, (long)FETCH_MAX_HOST_CONNECTIONS);
+
+    eng.stop = 0;
+    memset(&eng.stats, 0, sizeof(eng.stats));
+    if (pthread_create(&eng.thread, NULL, fetch_worker, NULL) != 0) goto fail;
+    eng.running = 1;
+    return 0;
+
+fail:
+    fprintf(stderr, "Warning: cannot start the fetch worker, overlays disabled\n");
+    if (eng.multi) curl_multi_cleanup(eng.multi);
+    if (eng.share) curl_share_cleanup(eng.share);
+    eng.multi = NULL;
+    eng.share = NULL;
+    curl_global_cleanup();
+    return -1;
+}
+
+void fetch_shutdown(void)
+{
+    if (!eng.running) return;
+    pthread_mutex_lock(&eng.lock);
+    eng.stop = 1;
+    pthread_mutex_unlock(&eng.lock);
+    curl_multi_wakeup(eng.multi);
+    pthread_join(eng.thread, NULL);
+    eng.running = 0;
+    curl_multi_cleanup(eng.multi);
+    curl_share_cleanup(eng.share);
+    eng.multi = NULL;
+    eng.share = NULL;
+    curl_global_cleanup();
+}
+
+/* Queue an async HTTP GET of the given URL. */
 void fetch_start(FetchRequest *req, const char *url)
+{
+    fetch_start_cached(req, url, NULL, 0, NULL, NULL);
+}
+
+/* As fetch_start(), with the body going to sink (NULL = buffered). */
+void fetch_start_stream(FetchRequest *req, const char *url,
+                        int (*sink)(void *ctx, const char *data, size_t len),
+                        void *ctx)
+{
+    fetch_start_cached(req, url, NULL, 0, sink, ctx);
+}
+
+/* As fetch_start_stream(), kept in / revalidated against the feed cache. */
+void fetch_start_cached(FetchRequest *req, const char *url,
+                        const char *cache, int revalidate,
+                        int (*sink)(void *ctx, const char *data, size_t len),
+                        void *ctx)
 {
     memset(req, 0, sizeof(*req));
     pthread_mutex_init(&req->mutex, NULL);
+    req->sink = sink;
+    req->sink_ctx = ctx;
+    req->cache = cache;
+    req->revalidate = revalidate;
+    req->start_ms = now_ms();
     req->url = strdup(url);
-    if (!req->url) {
+    if (!req->url || !eng.running) {
         req->status = -1;
         return;
     }
     req->status = 0;
 
-    pthread_attr_t attr;
-    pthread_attr_init(&attr);
-    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
-    pthread_create(&req->thread, &attr, fetch_thread, req);
-    pthread_attr_destroy(&attr);
+    pthread_mutex_lock(&eng.lock);
+    if (eng.tail) eng.tail->next = req;
+    else eng.head = req;
+    eng.tail = req;
+    pthread_mutex_unlock(&eng.lock);
+    curl_multi_wakeup(eng.multi);
 }
 
-/* Poll status: 0=pending, 1=done, -1=error.  Lock-protected. */
+/* Poll status: 0=pending, 1=done, 2=not modified, -1=error.  Lock-protected. */
 int fetch_check(FetchRequest *req)
 {
     pthread_mutex_lock(&req->mutex);
@@ -107,6 +494,19 @@ int fetch_check(FetchRequest *req)
     return s;
 }
 
+/* Flag the request and wait for the worker to finish it. */
+void fetch_cancel(FetchRequest *req)
+{
+    pthread_mutex_lock(&eng.lock);
+    if (eng.running && fetch_check(req) == 0) {
+        req->cancel = 1;
+        curl_multi_wakeup(eng.multi);
+        while (fetch_check(req) == 0)
+            pthread_cond_wait(&eng.done, &eng.lock);
+    }
+    pthread_mutex_unlock(&eng.lock);
+}
+
 /* Transfer ownership of the response string to the caller (who must free it). */
 char *fetch_take_response(FetchRequest *req)
 {
@@ -117,12 +517,20 @@ char *fetch_take_response(FetchRequest *req)
     return r;
 }
 
-/* Release URL and response memory, destroy mutex. */
+/* Cancel if still pending, release URL and response memory, destroy mutex. */
 void fetch_cleanup(FetchRequest *req)
 {
+    fetch_cancel(req);
     free(req->url);
     req->url = NULL;
     free(req->response);
     req->response = NULL;
     pthread_mutex_destroy(&req->mutex);
 }
+
+void fetch_get_stats(FetchStats *out)
+{
+    pthread_mutex_lock(&eng.lock);
+    *out = eng.stats;
+    pthread_mutex_unlock(&eng.lock);
+}
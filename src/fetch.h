@@ -1,9 +1,24 @@
-/* fetch.h — Threaded non-blocking HTTP GET via libcurl + pthread.
+/* fetch.h — Non-blocking HTTP GET on a single libcurl multi worker.
  *
- * Each FetchRequest spawns a detached thread that performs an HTTP GET.
- * The main loop polls fetch_check() each frame; when done, it takes
- * ownership of the response string.  Used by all overlay data sources
- * (MUF, Sporadic E, Aurora, DRAP, Kp/Bz) for async refresh. */
+ * fetch_init() starts one long-lived worker thread that drives every
+ * request through a curl multi handle: connections (HTTP/2 multiplexed
+ * where the server offers it), TLS sessions and DNS results are reused
+ * across requests, responses are asked for gzip/deflate, and at most
+ * FETCH_MAX_CONNECTIONS transfers are on the wire at once.  The main loop
+ * polls fetch_check() each frame; when done, it takes ownership of the
+ * response string.  An optional wake hook lets a sleeping main loop
+ * notice completions without polling.  Used by all overlay data sources
+ * (MUF, Sporadic E, Aurora, DRAP, Kp/Bz) for async refresh.
+ *
+ * A request started with fetch_start_stream() keeps no response: each
+ * chunk goes to a sink on the worker thread as it arrives (e.g. an
+ * incremental parser), so the body is never held in memory whole.
+ *
+ * With a feed cache name (fetch_start_cached()) a good response is also
+ * stored in the feed cache, and a request that revalidates sends the
+ * cached copy's ETag / Last-Modified: status 2 means the feed did not
+ * change and there is nothing to parse.  In offline mode no request goes
+ * out and cached requests are answered from the cache. */
 
 #ifndef FETCH_H
 #define FETCH_H
@@ -11,25 +26,92 @@
 #include <pthread.h>
 #include <stddef.h>
 
-typedef struct {
+/* Transfers on the wire at once (more are queued), and per host */
+#define FETCH_MAX_CONNECTIONS      4
+#define FETCH_MAX_HOST_CONNECTIONS 2
+
+typedef struct FetchRequest {
     char           *url;
     char           *response;      /* malloc'd response body (caller frees) */
     size_t          response_len;
-    int             status;        /* 0=pending, 1=done, -1=error */
-    pthread_t       thread;
+    int             status;        /* 0=pending, 1=done, 2=not modified, -1=error */
+    int           (*sink)(void *ctx, const char *data, size_t len);
+    void           *sink_ctx;
+    const char     *cache;         /* feed cache name (static string), or NULL */
+    int             revalidate;    /* caller holds the cached copy's data */
+
+    /* Result of the transfer, valid once status != 0 */
+    double          ms;            /* queueing + transfer time */
+    long            wire_bytes;    /* body bytes received (before decompression) */
+    long            body_bytes;    /* body bytes after decompression */
+    int             reused;        /* 1 if no new connection was opened */
+
+    /* Worker bookkeeping */
+    int             cancel;
+    double          start_ms;
+    struct FetchRequest *next;     /* submission queue link */
     pthread_mutex_t mutex;
 } FetchRequest;
 
-/* Start an async HTTP GET in a background thread. */
+/* Totals since fetch_init() */
+typedef struct {
+    long   requests, not_modified, failed, cancelled;
+    long   wire_bytes, body_bytes;
+    long   connections;           /* new connections opened */
+} FetchStats;
+
+/* Start the worker.  Returns 0, or -1 if it cannot (requests then fail). */
+int  fetch_init(void);
+
+/* Cancel what is still queued or running and stop the worker.  Pending
+ * requests end with status -1 and must still be fetch_cleanup()'d. */
+void fetch_shutdown(void);
+
+/* Call wake (must be thread-safe, e.g. glfwPostEmptyEvent) whenever a
+ * request finishes.  NULL disables it. */
+void fetch_set_wake(void (*wake)(void));
+
+/* Start an async HTTP GET. */
 void fetch_start(FetchRequest *req, const char *url);
 
-/* Non-blocking check: returns status (0=pending, 1=done, -1=error). */
+/* Start an async HTTP GET that hands the body to sink chunk by chunk,
+ * on the worker thread, then once more with data NULL at the end of a
+ * successful transfer.  A nonzero return from sink aborts the request
+ * (status -1).  ctx must stay valid until the request is no longer
+ * pending; the response string stays NULL. */
+void fetch_start_stream(FetchRequest *req, const char *url,
+                        int (*sink)(void *ctx, const char *data, size_t len),
+                        void *ctx);
+
+/* As fetch_start_stream() (sink may be NULL for a buffered response),
+ * with the response kept in the feed cache under cache.  revalidate
+ * makes the request conditional on the cached copy, which the caller
+ * must already have parsed: an unchanged feed then ends with status 2. */
+void fetch_start_cached(FetchRequest *req, const char *url,
+                        const char *cache, int revalidate,
+                        int (*sink)(void *ctx, const char *data, size_t len),
+                        void *ctx);
+
+/* 1 = offline: answer cached requests from the feed cache, fail the
+ * others.  Call before the first request. */
+void fetch_set_offline(int offline);
+
+/* Non-blocking check: returns status (0=pending, 1=done, 2=not modified,
+ * -1=error). */
 int  fetch_check(FetchRequest *req);
 
+/* Abort a pending request and wait until the worker has let go of it
+ * (its sink is not called again); the status becomes -1.  No-op once the
+ * request has finished. */
+void fetch_cancel(FetchRequest *req);
+
 /* Take ownership of the response string (caller must free). Returns NULL on error. */
 char *fetch_take_response(FetchRequest *req);
 
-/* Cleanup request resources (does NOT join thread — it is detached). */
+/* Cleanup request resources; cancels the request first if it is pending. */
 void fetch_cleanup(FetchRequest *req);
 
+/* Copy of the running totals (thread-safe). */
+void fetch_get_stats(FetchStats *out);
+
 #endif
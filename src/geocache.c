@@ -0,0 +1,273 @@
+/* geocache.c — On-disk cache of preprocessed map geometry.
+ *
+ * File layout (native byte order, checked via a marker word):
+ *   GeoCacheHeader, GeoCacheLevel[num_levels], then per level the arrays
+ *   lats, lons (double), unit (3 float planes), starts, counts (int) and
+ *   caps (float[4]) at GEOCACHE_ALIGN-aligned offsets.
+ * Vertex arrays are stored exactly as the projection paths consume them, so
+ * a hit needs no decoding; only the small segment tables are copied into
+ * growable SegTables. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "geocache.h"
+#include "cachedir.h"
+
+#define GEOCACHE_MAGIC "AZMAPGC"   /* 8 bytes with NUL */
+#define GEOCACHE_BOM   0x01020304u
+#define GEOCACHE_ALIGN 64
+
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t src_size;
+    int64_t  src_mtime_sec;
+    int64_t  src_mtime_nsec;
+    int32_t  nosplit;
+    int32_t  num_levels;
+    uint64_t file_size;
+} GeoCacheHeader;
+
+typedef struct {
+    double   tol_km;
+    int32_t  raw_count;
+    int32_t  seg_count;
+    uint64_t lats_off, lons_off, unit_off;
+    uint64_t starts_off, counts_off, caps_off;
+} GeoCacheLevel;
+
+/* ── Paths ────────────────────────────────────────────────────────── */
+
+static uint64_t fnv1a64(const char *s)
+{
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (; *s; s++) {
+        h ^= (unsigned char)*s;
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+/* <cache dir>/<shapefile basename>-<hash of its absolute path>[-rings].bin */
+static int cache_path(const char *shp_path, int nosplit, char *out, size_t sz)
+{
+    char dir[PATH_MAX], abs[PATH_MAX];
+    if (cache_dir(dir, sizeof(dir)) != 0) return -1;
+    if (!realpath(shp_path, abs)) return -1;
+
+    const char *base = strrchr(abs, '/');
+    base = base ? base + 1 : abs;
+    int len = (int)strcspn(base, ".");
+    snprintf(out, sz, "%s/%.*s-%016llx%s.bin", dir, len, base,
+             (unsigned long long)fnv1a64(abs), nosplit ? "-rings" : "");
+    return 0;
+}
+
+static void fill_source(GeoCacheHeader *h, const struct stat *st)
+{
+    h->src_size = (uint64_t)st->st_size;
+    h->src_mtime_sec = (int64_t)st->st_mtim.tv_sec;
+    h->src_mtime_nsec = (int64_t)st->st_mtim.tv_nsec;
+}
+
+/* ── Load ─────────────────────────────────────────────────────────── */
+
+static int range_ok(uint64_t off, uint64_t len, uint64_t file_size)
+{
+    return off % sizeof(double) == 0 && off <= file_size && len <= file_size - off;
+}
+
+static int level_ok(const GeoCacheLevel *lv, uint64_t file_size)
+{
+    if (lv->raw_count < 0 || lv->seg_count < 0) return 0;
+    uint64_t n = (uint64_t)lv->raw_count, m = (uint64_t)lv->seg_count;
+    return range_ok(lv->lats_off, n * sizeof(double), file_size) &&
+           range_ok(lv->lons_off, n * sizeof(double), file_size) &&
+           range_ok(lv->unit_off, 3 * n * sizeof(float), file_size) &&
+           range_ok(lv->starts_off, m * sizeof(int), file_size) &&
+           range_ok(lv->counts_off, m * sizeof(int), file_size) &&
+           range_ok(lv->caps_off, 4 * m * sizeof(float), file_size);
+}
+
+static int load_level(MapData *md, const unsigned char *base, const GeoCacheLevel *lv)
+{
+    const int *starts = (const int *)(base + lv->starts_off);
+    const int *counts = (const int *)(base + lv->counts_off);
+    for (int s = 0; s < lv->seg_count; s++)
+        if (starts[s] < 0 || counts[s] < 0 || starts[s] > lv->raw_count - counts[s])
+            return -1;
+
+    memset(md, 0, sizeof(*md));
+    md->raw_segs = segtable_new(SEG_CAPS);
+    if (!md->raw_segs || segtable_reserve(md->raw_segs, lv->seg_count) != 0)
+        return -1;
+    size_t m = (size_t)lv->seg_count;
+    memcpy(md->raw_segs->starts, starts, m * sizeof(int));
+    memcpy(md->raw_segs->counts, counts, m * sizeof(int));
+    memcpy(md->raw_segs->caps, base + lv->caps_off, m * sizeof(md->raw_segs->caps[0]));
+    md->raw_segs->num = lv->seg_count;
+
+    /* MAP_PRIVATE + PROT_READ: the arrays are only ever read */
+    md->raw_lats = (double *)(base + lv->lats_off);
+    md->raw_lons = (double *)(base + lv->lons_off);
+    md->raw_unit = (float *)(base + lv->unit_off);
+    md->raw_count = lv->raw_count;
+    md->raw_borrowed = 1;
+    return 0;
+}
+
+int geocache_load(MapLod *lod, const char *shp_path, int nosplit)
+{
+    char path[PATH_MAX];
+    struct stat src_st, st;
+    if (stat(shp_path, &src_st) != 0 || cache_path(shp_path, nosplit, path, sizeof(path)) != 0)
+        return -1;
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(GeoCacheHeader)) {
+        close(fd);
+        return -1;
+    }
+    size_t len = (size_t)st.st_size;
+    void *map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+
+    const unsigned char *base = map;
+    const GeoCacheHeader *h = map;
+    GeoCacheHeader want;
+    fill_source(&want, &src_st);
+    if (memcmp(h->magic, GEOCACHE_MAGIC, sizeof(h->magic)) != 0 ||
+        h->version != GEOCACHE_VERSION || h->byte_order != GEOCACHE_BOM ||
+        h->src_size != want.src_size || h->src_mtime_sec != want.src_mtime_sec ||
+        h->src_mtime_nsec != want.src_mtime_nsec || h->nosplit != nosplit ||
+        h->file_size != len || h->num_levels < 1 || h->num_levels > MAP_LOD_MAX_LEVELS ||
+        sizeof(*h) + h->num_levels * sizeof(GeoCacheLevel) > len)
+        goto stale;
+
+    const GeoCacheLevel *lv = (const GeoCacheLevel *)(base + sizeof(*h));
+    for (int i = 0; i < h->num_levels; i++) {
+        if (!level_ok(&lv[i], len) || load_level(&lod->levels[i], base, &lv[i]) != 0) {
+            for (int j = 0; j <= i; j++)
+                map_data_free(&lod->levels[j]);
+            goto stale;
+        }
+        lod->tol_km[i] = lv[i].tol_km;
+    }
+    lod->num_levels = h->num_levels;
+    lod->cache_map = map;
+    lod->cache_len = len;
+    return 0;
+
+stale:
+    munmap(map, len);
+    return -1;
+}
+
+void geocache_release(MapLod *lod)
+{
+    if (lod->cache_map)
+        munmap(lod->cache_map, lod->cache_len);
+    lod->cache_map = NULL;
+    lod->cache_len = 0;
+}
+
+/* ── Save ─────────────────────────────────────────────────────────── */
+
+static uint64_t align_up(uint64_t off)
+{
+    return (off + GEOCACHE_ALIGN - 1) & ~(uint64_t)(GEOCACHE_ALIGN - 1);
+}
+
+/* Pad the file to off, then write len bytes. */
+static int write_at(FILE *f, uint64_t *pos, uint64_t off, const void *data, size_t len)
+{
+    static const unsigned char zero[GEOCACHE_ALIGN];
+    while (*pos < off) {
+        size_t pad = (size_t)(off - *pos);
+        if (pad > sizeof(zero)) pad = sizeof(zero);
+        if (fwrite(zero, 1, pad, f) != pad) return -1;
+        *pos += pad;
+    }
+    if (len && fwrite(data, 1, len, f) != len) return -1;
+    *pos += len;
+    return 0;
+}
+
+void geocache_save(const MapLod *lod, const char *shp_path)
+{
+    char dir[PATH_MAX], path[PATH_MAX], tmp[PATH_MAX + 32];
+    struct stat src_st;
+    if (lod->num_levels < 1 || stat(shp_path, &src_st) != 0 ||
+        cache_dir(dir, sizeof(dir)) != 0 || cache_path(shp_path, lod->nosplit, path, sizeof(path)) != 0)
+        return;
+    for (int i = 0; i < lod->num_levels; i++)
+        if (!lod->levels[i].raw_unit || !lod->levels[i].raw_segs ||
+            !lod->levels[i].raw_segs->caps)
+            return;
+    if (make_dirs(dir) != 0) {
+        fprintf(stderr, "Warning: cannot create cache directory %s\n", dir);
+        return;
+    }
+
+    GeoCacheHeader h;
+    GeoCacheLevel lv[MAP_LOD_MAX_LEVELS];
+    memset(&h, 0, sizeof(h));
+    memset(lv, 0, sizeof(lv));
+    memcpy(h.magic, GEOCACHE_MAGIC, sizeof(h.magic));
+    h.version = GEOCACHE_VERSION;
+    h.byte_order = GEOCACHE_BOM;
+    fill_source(&h, &src_st);
+    h.nosplit = lod->nosplit;
+    h.num_levels = lod->num_levels;
+
+    uint64_t off = sizeof(h) + lod->num_levels * sizeof(GeoCacheLevel);
+    for (int i = 0; i < lod->num_levels; i++) {
+        const MapData *md = &lod->levels[i];
+        uint64_t n = (uint64_t)md->raw_count, m = (uint64_t)md->raw_segs->num;
+        lv[i].tol_km = lod->tol_km[i];
+        lv[i].raw_count = md->raw_count;
+        lv[i].seg_count = md->raw_segs->num;
+        lv[i].lats_off = off = align_up(off);   off += n * sizeof(double);
+        lv[i].lons_off = off = align_up(off);   off += n * sizeof(double);
+        lv[i].unit_off = off = align_up(off);   off += 3 * n * sizeof(float);
+        lv[i].starts_off = off = align_up(off); off += m * sizeof(int);
+        lv[i].counts_off = off = align_up(off); off += m * sizeof(int);
+        lv[i].caps_off = off = align_up(off);   off += 4 * m * sizeof(float);
+    }
+    h.file_size = off;
+
+    snprintf(tmp, sizeof(tmp), "%s.tmp.%ld", path, (long)getpid());
+    FILE *f = fopen(tmp, "wb");
+    if (!f) {
+        fprintf(stderr, "Warning: cannot write geometry cache %s\n", tmp);
+        return;
+    }
+    uint64_t pos = 0;
+    int ok = write_at(f, &pos, 0, &h, sizeof(h)) == 0 &&
+             write_at(f, &pos, pos, lv, lod->num_levels * sizeof(GeoCacheLevel)) == 0;
+    for (int i = 0; ok && i < lod->num_levels; i++) {
+        const MapData *md = &lod->levels[i];
+        size_t n = (size_t)md->raw_count, m = (size_t)md->raw_segs->num;
+        ok = write_at(f, &pos, lv[i].lats_off, md->raw_lats, n * sizeof(double)) == 0 &&
+             write_at(f, &pos, lv[i].lons_off, md->raw_lons, n * sizeof(double)) == 0 &&
+             write_at(f, &pos, lv[i].unit_off, md->raw_unit, 3 * n * sizeof(float)) == 0 &&
+             write_at(f, &pos, lv[i].starts_off, md->raw_segs->starts, m * sizeof(int)) == 0 &&
+             write_at(f, &pos, lv[i].counts_off, md->raw_segs->counts, m * sizeof(int)) == 0 &&
+             write_at(f, &pos, lv[i].caps_off, md->raw_segs->caps, m * sizeof(md->raw_segs->caps[0])) == 0;
+    }
+    if (fclose(f) != 0) ok = 0;
+    if (!ok || rename(tmp, path) != 0) {
+        fprintf(stderr, "Warning: cannot write geometry cache %s\n", path);
+        unlink(tmp);
+    }
+}
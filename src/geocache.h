@@ -0,0 +1,29 @@
+/* geocache.h — On-disk cache of preprocessed map geometry.
+ *
+ * Stores the finished LOD pyramid of a shapefile layer (raw lat/lon, unit
+ * vectors, chunked segment tables with bounding caps) under
+ * $XDG_CACHE_HOME/azmap (default ~/.cache/azmap), keyed by the shapefile's
+ * path, size and modification time.  A hit mmap()s the file and points the
+ * levels' raw arrays straight into the mapping: no shapefile parsing, no
+ * simplification and no vertex copies at startup. */
+
+#ifndef GEOCACHE_H
+#define GEOCACHE_H
+
+#include "map_lod.h"
+
+/* Bump when the file layout or the LOD/chunk parameters change. */
+#define GEOCACHE_VERSION 1
+
+/* Fill lod's levels from the cache for shp_path (lod must be initialized,
+ * with no levels).  Returns 0 on a hit, -1 on a miss or a stale/invalid file. */
+int geocache_load(MapLod *lod, const char *shp_path, int nosplit);
+
+/* Write lod's levels to the cache for shp_path (atomically, via rename).
+ * Failures only print a warning. */
+void geocache_save(const MapLod *lod, const char *shp_path);
+
+/* Unmap the cache file held by lod (after its levels were freed). */
+void geocache_release(MapLod *lod);
+
+#endif
@@ -4,7 +4,8 @@
  * - grid_build(): AZEQ mode — concentric range rings + radial azimuth lines,
  *   drawn directly in km-space (no projection needed).
  * - grid_build_geo(): ORTHO mode — geographic parallels + meridians, projected
- *   through projection_forward() with back-hemisphere clipping.
+ *   in batches through projection_forward_batch() with back-hemisphere
+ *   clipping.
  * - grid_build_dist_circles(): great-circle distance rings from the source
  *   location, computed via the forward geodesic formula and projected. */
 
@@ -22,10 +23,13 @@
 #define GEO_LON_STEP   30.0    /* degrees between meridians */
 #define GEO_SAMPLE_STEP 5.0    /* degrees between sample points */
 
+#define DIST_CIRCLE_PTS 90     /* points per distance circle */
+#define POLYLINE_MAX_PTS (DIST_CIRCLE_PTS + 1)  /* longest sampled polyline */
+
 void grid_build(MapData *md)
 {
     md->vertex_count = 0;
-    md->num_segments = 0;
+    if (segtable_reset(&md->segs, 0) != 0) return;
 
     double max_r = EARTH_MAX_PROJ_RADIUS;   /* ~20015 km */
     int num_rings = (int)(max_r / RING_STEP_KM);
@@ -46,11 +50,7 @@ void grid_build(MapData *md)
             md->vertices[md->vertex_count * 2 + 1] = r * sinf(a);
             md->vertex_count++;
         }
-        if (md->num_segments < MAX_SEGMENTS) {
-            md->segment_starts[md->num_segments] = start;
-            md->segment_counts[md->num_segments] = md->vertex_count - start;
-            md->num_segments++;
-        }
+        segtable_push(md->segs, start, md->vertex_count - start);
     }
 
     /* Radial azimuth lines from center to edge */
@@ -63,18 +63,47 @@ void grid_build(MapData *md)
         md->vertices[md->vertex_count * 2]     = (float)max_r * cosf(a);
         md->vertices[md->vertex_count * 2 + 1] = (float)max_r * sinf(a);
         md->vertex_count++;
-        if (md->num_segments < MAX_SEGMENTS) {
-            md->segment_starts[md->num_segments] = start;
-            md->segment_counts[md->num_segments] = 2;
-            md->num_segments++;
+        segtable_push(md->segs, start, 2);
+    }
+}
+
+/* Project a sampled polyline in one batch and append it to md, breaking it
+ * into separate segments wherever it passes through the back hemisphere.
+ * Isolated single front points are dropped. */
+static void append_clipped_polyline(MapData *md, const double *lats,
+                                    const double *lons, int n)
+{
+    float xy[POLYLINE_MAX_PTS * 2];
+    unsigned char back[POLYLINE_MAX_PTS];
+    projection_forward_batch(lats, lons, n, xy, back, 0);
+
+    int seg_start = md->vertex_count;
+    int in_seg = 0;
+    for (int i = 0; i < n; i++) {
+        if (back[i]) {
+            /* Back hemisphere — flush current segment */
+            if (in_seg >= 2)
+                segtable_push(md->segs, seg_start, in_seg);
+            /* Discard isolated point */
+            if (in_seg == 1) md->vertex_count--;
+            in_seg = 0;
+            seg_start = md->vertex_count;
+            continue;
         }
+        md->vertices[md->vertex_count * 2]     = xy[i * 2];
+        md->vertices[md->vertex_count * 2 + 1] = xy[i * 2 + 1];
+        md->vertex_count++;
+        in_seg++;
     }
+    if (in_seg >= 2)
+        segtable_push(md->segs, seg_start, in_seg);
+    if (in_seg == 1) md->vertex_count--;
 }
 
 void grid_build_geo(MapData *md)
 {
     md->vertex_count = 0;
-    md->num_segments = 0;
+    if (segtable_reset(&md->segs, 0) != 0) return;
 
     /* Parallels: -60 to 60 every 30 deg, meridians: every 30 deg */
     int num_parallels = (int)(120.0 / GEO_LAT_STEP) + 1; /* -60 to 60 */
@@ -87,73 +116,31 @@ void grid_build_geo(MapData *md)
     md->vertices = malloc(max_verts * 2 * sizeof(float));
     if (!md->vertices) return;
 
+    double lats[POLYLINE_MAX_PTS], lons[POLYLINE_MAX_PTS];
+
     /* Parallels */
     for (double lat = -60.0; lat <= 60.0 + 0.01; lat += GEO_LAT_STEP) {
-        int seg_start = md->vertex_count;
-        int in_seg = 0;
+        int n = 0;
         for (double lon = -180.0; lon <= 180.0 + 0.01; lon += GEO_SAMPLE_STEP) {
-            double x, y;
-            int rc = projection_forward(lat, lon, &x, &y);
-            if (rc < 0) {
-                /* Back hemisphere — flush current segment */
-                if (in_seg >= 2 && md->num_segments < MAX_SEGMENTS) {
-                    md->segment_starts[md->num_segments] = seg_start;
-                    md->segment_counts[md->num_segments] = in_seg;
-                    md->num_segments++;
-                }
-                /* Discard isolated point */
-                if (in_seg == 1) md->vertex_count--;
-                in_seg = 0;
-                seg_start = md->vertex_count;
-                continue;
-            }
-            md->vertices[md->vertex_count * 2]     = (float)x;
-            md->vertices[md->vertex_count * 2 + 1] = (float)y;
-            md->vertex_count++;
-            in_seg++;
+            lats[n] = lat;
+            lons[n] = lon;
+            n++;
         }
-        if (in_seg >= 2 && md->num_segments < MAX_SEGMENTS) {
-            md->segment_starts[md->num_segments] = seg_start;
-            md->segment_counts[md->num_segments] = in_seg;
-            md->num_segments++;
-        }
-        if (in_seg == 1) md->vertex_count--;
+        append_clipped_polyline(md, lats, lons, n);
     }
 
     /* Meridians */
     for (double lon = -180.0; lon < 180.0 - 0.01; lon += GEO_LON_STEP) {
-        int seg_start = md->vertex_count;
-        int in_seg = 0;
+        int n = 0;
         for (double lat = -90.0; lat <= 90.0 + 0.01; lat += GEO_SAMPLE_STEP) {
-            double x, y;
-            int rc = projection_forward(lat, lon, &x, &y);
-            if (rc < 0) {
-                if (in_seg >= 2 && md->num_segments < MAX_SEGMENTS) {
-                    md->segment_starts[md->num_segments] = seg_start;
-                    md->segment_counts[md->num_segments] = in_seg;
-                    md->num_segments++;
-                }
-                if (in_seg == 1) md->vertex_count--;
-                in_seg = 0;
-                seg_start = md->vertex_count;
-                continue;
-            }
-            md->vertices[md->vertex_count * 2]     = (float)x;
-            md->vertices[md->vertex_count * 2 + 1] = (float)y;
-            md->vertex_count++;
-            in_seg++;
+            lats[n] = lat;
+            lons[n] = lon;
+            n++;
         }
-        if (in_seg >= 2 && md->num_segments < MAX_SEGMENTS) {
-            md->segment_starts[md->num_segments] = seg_start;
-            md->segment_counts[md->num_segments] = in_seg;
-            md->num_segments++;
-        }
-        if (in_seg == 1) md->vertex_count--;
+        append_clipped_polyline(md, lats, lons, n);
     }
 }
 
-#define DIST_CIRCLE_PTS 90  /* points per distance circle */
-
 /* Compute destination point given start lat/lon (radians), distance (km), and bearing (radians). */
 static void geo_destination(double lat1, double lon1, double dist_km, double bearing,
                             double *lat2, double *lon2)
@@ -168,7 +155,7 @@ static void geo_destination(double lat1, double lon1, double dist_km, double bea
 void grid_build_dist_circles(MapData *md, double center_lat, double center_lon)
 {
     md->vertex_count = 0;
-    md->num_segments = 0;
+    if (segtable_reset(&md->segs, 0) != 0) return;
 
     double max_dist = EARTH_MAX_PROJ_RADIUS; /* ~20015 km */
     int num_circles = (int)(max_dist / DIST_CIRCLE_STEP_KM);
@@ -181,41 +168,18 @@ void grid_build_dist_circles(MapData *md, double center_lat, double center_lon)
     double clat = center_lat * M_PI / 180.0;
     double clon = center_lon * M_PI / 180.0;
 
+    double lats[POLYLINE_MAX_PTS], lons[POLYLINE_MAX_PTS];
+
     for (int ri = 1; ri <= num_circles; ri++) {
         double dist_km = ri * DIST_CIRCLE_STEP_KM;
-        int seg_start = md->vertex_count;
-        int in_seg = 0;
 
         for (int i = 0; i <= DIST_CIRCLE_PTS; i++) {
             double bearing = 2.0 * M_PI * i / DIST_CIRCLE_PTS;
             double dlat, dlon;
             geo_destination(clat, clon, dist_km, bearing, &dlat, &dlon);
-
-            double lat_deg = dlat * 180.0 / M_PI;
-            double lon_deg = dlon * 180.0 / M_PI;
-            double x, y;
-            int rc = projection_forward(lat_deg, lon_deg, &x, &y);
-            if (rc < 0) {
-                if (in_seg >= 2 && md->num_segments < MAX_SEGMENTS) {
-                    md->segment_starts[md->num_segments] = seg_start;
-                    md->segment_counts[md->num_segments] = in_seg;
-                    md->num_segments++;
-                }
-                if (in_seg == 1) md->vertex_count--;
-                in_seg = 0;
-                seg_start = md->vertex_count;
-                continue;
-            }
-            md->vertices[md->vertex_count * 2]     = (float)x;
-            md->vertices[md->vertex_count * 2 + 1] = (float)y;
-            md->vertex_count++;
-            in_seg++;
-        }
-        if (in_seg >= 2 && md->num_segments < MAX_SEGMENTS) {
-            md->segment_starts[md->num_segments] = seg_start;
-            md->segment_counts[md->num_segments] = in_seg;
-            md->num_segments++;
+            lats[i] = dlat * 180.0 / M_PI;
+            lons[i] = dlon * 180.0 / M_PI;
         }
-        if (in_seg == 1) md->vertex_count--;
+        append_clipped_polyline(md, lats, lons, DIST_CIRCLE_PTS + 1);
     }
 }
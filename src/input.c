@@ -4,10 +4,13 @@
  * callbacks don't support user data pointers.  Mouse drag converts pixel
  * deltas to lat/lon changes via the Mercator-like formula (adjusted for
  * cos(lat) longitude scaling).  Keyboard arrows pan proportionally to
- * the current zoom level. */
+ * the current zoom level.  Callbacks set redraw only for events that change
+ * what is on screen, so plain mouse motion over the map keeps the
+ * render-on-demand loop asleep. */
 
 #include "input.h"
 #include "projection.h"
+#include "profiler.h"
 #include <math.h>
 #include <ctype.h>
 
@@ -19,6 +22,7 @@ static void scroll_callback(GLFWwindow *window, double xoffset, double yoffset)
     (void)xoffset;
     float factor = (yoffset > 0) ? 0.9f : 1.1f;
     camera_zoom(g_input->cam, factor);
+    g_input->redraw = 1;
 }
 
 static void char_callback(GLFWwindow *window, unsigned int codepoint)
@@ -27,6 +31,7 @@ static void char_callback(GLFWwindow *window, unsigned int codepoint)
     if (!g_input || !g_input->ui) return;
     UI *u = g_input->ui;
     if (!u->popup.visible || !u->popup_input_active) return;
+    g_input->redraw = 1;
 
     char ch = (char)toupper((unsigned char)codepoint);
     /* Accept A-Z, 0-9, / */
@@ -43,6 +48,7 @@ static void key_callback(GLFWwindow *window, int key, int scancode, int action,
     (void)scancode;
     (void)mods;
     if (action != GLFW_PRESS && action != GLFW_REPEAT) return;
+    g_input->redraw = 1;
 
     /* When popup input is active, handle text editing keys and suppress others */
     if (g_input->ui && g_input->ui->popup.visible
@@ -102,6 +108,10 @@ static void key_callback(GLFWwindow *window, int key, int scancode, int action,
         g_input->center_dirty = 1;
         camera_reset(g_input->cam);
         break;
+    case GLFW_KEY_P:
+        if (action == GLFW_PRESS)
+            profiler_set_panel(!profiler_panel_visible());
+        break;
     case GLFW_KEY_Q:
     case GLFW_KEY_ESCAPE:
         glfwSetWindowShouldClose(window, GLFW_TRUE);
@@ -120,6 +130,7 @@ static int in_sidebar(float fb_x)
 static void mouse_button_callback(GLFWwindow *window, int button, int action, int mods)
 {
     (void)mods;
+    g_input->redraw = 1;
     if (button == GLFW_MOUSE_BUTTON_LEFT) {
         if (action == GLFW_PRESS) {
             double mx, my;
@@ -191,9 +202,8 @@ static void mouse_button_callback(GLFWwindow *window, int button, int action, in
     }
 }
 
-static void cursor_pos_callback(GLFWwindow *window, double xpos, double ypos)
+static void cursor_pos_update(double xpos, double ypos)
 {
-    (void)window;
 
     /* Sidebar area: allow hover on buttons, block map panning */
     {
@@ -278,6 +288,21 @@ static void cursor_pos_callback(GLFWwindow *window, double xpos, double ypos)
     g_input->center_dirty = 1;
 }
 
+static void cursor_pos_callback(GLFWwindow *window, double xpos, double ypos)
+{
+    (void)window;
+    UI *u = g_input->ui;
+    int hovered = u ? u->hovered : -1;
+    int close_hovered = u ? u->popup_close_hovered : 0;
+
+    cursor_pos_update(xpos, ypos);
+
+    /* Map drags are reported through center_dirty */
+    if (g_input->popup_dragging ||
+        (u && (u->hovered != hovered || u->popup_close_hovered != close_hovered)))
+        g_input->redraw = 1;
+}
+
 static void update_cursor_scale(GLFWwindow *window)
 {
     int ww, wh;
@@ -295,6 +320,14 @@ static void framebuffer_size_callback(GLFWwindow *window, int width, int height)
     g_input->win_height = height;
     /* Don't set aspect or glViewport here — main loop handles sidebar split */
     update_cursor_scale(window);
+    g_input->redraw = 1;
+}
+
+/* Window exposed or damaged: the last frame must be presented again. */
+static void window_refresh_callback(GLFWwindow *window)
+{
+    (void)window;
+    g_input->redraw = 1;
 }
 
 void input_init(InputState *is, GLFWwindow *window, Camera *cam, UI *ui,
@@ -316,6 +349,7 @@ void input_init(InputState *is, GLFWwindow *window, Camera *cam, UI *ui,
     is->original_center_lat = center_lat;
     is->original_center_lon = center_lon;
     is->center_dirty = 0;
+    is->redraw = 1;
 
     int w, h;
     glfwGetFramebufferSize(window, &w, &h);
@@ -331,4 +365,5 @@ void input_init(InputState *is, GLFWwindow *window, Camera *cam, UI *ui,
     glfwSetMouseButtonCallback(window, mouse_button_callback);
     glfwSetCursorPosCallback(window, cursor_pos_callback);
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetWindowRefreshCallback(window, window_refresh_callback);
 }
@@ -1,9 +1,10 @@
 /* input.h — GLFW input callbacks: scroll zoom, mouse drag pan, keyboard shortcuts.
  *
  * Installs GLFW callbacks for scroll (zoom), mouse drag (map panning or popup
- * dragging), keyboard (arrow keys pan, R resets, Q/Esc quits), and character
- * input (popup text entry).  Tracks the current projection center lat/lon and
- * signals the main loop via center_dirty when it changes. */
+ * dragging), keyboard (arrow keys pan, R resets, P toggles the profiler panel,
+ * Q/Esc quits), and character input (popup text entry).  Tracks the current projection center lat/lon and
+ * signals the main loop via center_dirty when it changes, and via redraw
+ * when anything else visible changed (zoom, hover, popup, resize). */
 
 #ifndef INPUT_H
 #define INPUT_H
@@ -29,6 +30,7 @@ typedef struct {
     double  center_lat, center_lon;           /* current projection center */
     double  original_center_lat, original_center_lon; /* for R reset */
     int     center_dirty;                     /* set by drag/keys, cleared by main */
+    int     redraw;                           /* set by callbacks, cleared by main */
 } InputState;
 
 /* Initialize input state and install GLFW callbacks. */
@@ -0,0 +1,572 @@
+/* ipc.c — Unix domain socket server for target, station and spot updates.
+ *
+ * One thread polls the listening socket, the clients and the legacy pipe.
+ * Each readable input is read once per round (so one busy client cannot
+ * starve the others), split into lines and parsed; the updates of a read
+ * are queued under one lock.  The queue keeps one slot per key, found
+ * through a small open-addressed table, so a repeated key overwrites its
+ * slot in place and the main thread only ever sees the latest value. */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "ipc.h"
+
+#define IPC_POLL_MS     250             /* lets ipc_server_stop() end the thread */
+#define IPC_READ_CHUNK  16384           /* bytes read per input and round */
+#define IPC_BATCH       64              /* updates parsed before taking the lock */
+#define IPC_SLOTS       (IPC_QUEUE_MAX * 2)
+#define IPC_FIFO        IPC_CLIENTS_MAX /* index of the pipe in inputs[] */
+
+void ipc_default_path(char *out, int out_sz)
+{
+    const char *dir = getenv("XDG_RUNTIME_DIR");
+    if (dir && dir[0])
+        snprintf(out, (size_t)out_sz, "%s/%s", dir, IPC_SOCKET_NAME);
+    else
+        snprintf(out, (size_t)out_sz, "/tmp/azmap-%u.sock", (unsigned)getuid());
+}
+
+/* ── Parsing ─────────────────────────────────────────────────────── */
+
+/* Station detail fields, in the order of the pipe format */
+static const char *detail_keys[] = { "station", "freq", "country", "site", "lang", "target" };
+#define DETAIL_FIELDS 6
+
+/* Copy src into dst, with '|' (the field separator) replaced */
+static void copy_field(char *dst, size_t dst_sz, const char *src)
+{
+    size_t k = 0;
+    for (; src[k] && k + 1 < dst_sz; k++)
+        dst[k] = src[k] == '|' ? '/' : src[k];
+    dst[k] = '\0';
+}
+
+static int valid_latlon(double lat, double lon)
+{
+    return lat >= -90.0 && lat <= 90.0 && lon >= -180.0 && lon <= 180.0;
+}
+
+/* Legacy pipe line: "lat,lon,name|station|freq|country|site|lang|target" */
+static int parse_fifo(const char *line, IpcUpdate out[2], char *reason, size_t reason_sz)
+{
+    IpcUpdate *t = &out[0];
+    memset(t, 0, sizeof(*t));
+    t->kind = IPC_TARGET;
+    if (sscanf(line, "%lf,%lf,", &t->lat, &t->lon) != 2 || !valid_latlon(t->lat, t->lon)) {
+        snprintf(reason, reason_sz, "expected lat,lon,name");
+        return -1;
+    }
+    const char *p = strchr(line, ',');
+    p = p ? strchr(p + 1, ',') : NULL;
+    if (!p) return 1;
+    p++;
+    const char *pipe = strchr(p, '|');
+    size_t n = pipe ? (size_t)(pipe - p) : strlen(p);
+    if (n >= sizeof(t->name)) n = sizeof(t->name) - 1;
+    memcpy(t->name, p, n);
+    t->name[n] = '\0';
+    if (!pipe) return 1;
+
+    IpcUpdate *st = &out[1];
+    memset(st, 0, sizeof(*st));
+    st->kind = IPC_STATION;
+    snprintf(st->detail, sizeof(st->detail), "%s", pipe + 1);
+    return 2;
+}
+
+/* JSON line: one flat object (see ipc.h).  *is_stats is set for a stats
+ * request, which yields no update. */
+static int parse_json(JsonPull *p, const char *line, IpcUpdate out[2], int *is_stats,
+                      char *reason, size_t reason_sz)
+{
+    char type[16] = "", key[IPC_KEY_MAX] = "", name[64] = "";
+    char detail[DETAIL_FIELDS][40];     /* as long as a sidebar line takes */
+    int has_detail = 0, has_lat = 0, has_lon = 0, pinned = 0;
+    double lat = 0.0, lon = 0.0;
+    memset(detail, 0, sizeof(detail));
+
+    json_pull_reset(p);
+    json_pull_feed(p, line, strlen(line));
+    for (int first = 1;; first = 0) {
+        JsonToken t = json_pull_next(p);
+        if (t == JSON_TOK_MORE) {
+            json_pull_end(p);
+            continue;
+        }
+        if (t == JSON_TOK_END) break;
+        if (t == JSON_TOK_ERROR || (first && t != JSON_TOK_OBJECT)) {
+            snprintf(reason, reason_sz, first ? "expected a JSON object" : "invalid JSON");
+            return -1;
+        }
+        if (p->depth != 1) continue;                /* nested values are ignored */
+        const char *k = p->levels[0].key;
+        if (t == JSON_TOK_STRING) {
+            if (strcmp(k, "type") == 0) {
+                snprintf(type, sizeof(type), "%s", p->str);
+            } else if (strcmp(k, "key") == 0) {
+                snprintf(key, sizeof(key), "%s", p->str);
+            } else if (strcmp(k, "name") == 0) {
+                snprintf(name, sizeof(name), "%s", p->str);
+            } else {
+                for (int i = 0; i < DETAIL_FIELDS; i++)
+                    if (strcmp(k, detail_keys[i]) == 0) {
+                        copy_field(detail[i], sizeof(detail[i]), p->str);
+                        has_detail = 1;
+                    }
+            }
+        } else if (t == JSON_TOK_NUMBER) {
+            if (strcmp(k, "lat") == 0) {
+                lat = p->num;
+                has_lat = 1;
+            } else if (strcmp(k, "lon") == 0) {
+                lon = p->num;
+                has_lon = 1;
+            }
+        } else if (t == JSON_TOK_TRUE && strcmp(k, "pinned") == 0) {
+            pinned = 1;
+        }
+    }
+
+    *is_stats = 0;
+    if (strcmp(type, "stats") == 0) {
+        *is_stats = 1;
+        return 0;
+    }
+    int is_target = strcmp(type, "target") == 0;
+    int is_spot = strcmp(type, "spot") == 0;
+    int is_unspot = strcmp(type, "unspot") == 0;
+    int is_station = strcmp(type, "station") == 0;
+    if (!is_target && !is_spot && !is_unspot && !is_station) {
+        snprintf(reason, reason_sz, type[0] ? "unknown type" : "missing type");
+        return -1;
+    }
+    if ((is_target || is_spot) && (!has_lat || !has_lon || !valid_latlon(lat, lon))) {
+        snprintf(reason, reason_sz, "missing or invalid lat/lon");
+        return -1;
+    }
+    if ((is_spot || is_unspot) && !key[0]) {
+        snprintf(reason, reason_sz, "missing key");
+        return -1;
+    }
+    if (is_station && !has_detail) {
+        snprintf(reason, reason_sz, "no station fields");
+        return -1;
+    }
+
+    int n = 0;
+    if (!is_station) {
+        IpcUpdate *u = &out[n++];
+        memset(u, 0, sizeof(*u));
+        u->kind = is_target ? IPC_TARGET : is_spot ? IPC_SPOT : IPC_UNSPOT;
+        snprintf(u->key, sizeof(u->key), "%s", key);
+        snprintf(u->name, sizeof(u->name), "%s", name);
+        u->lat = lat;
+        u->lon = lon;
+        u->pinned = pinned;
+    }
+    if (has_detail && (is_target || is_station)) {
+        IpcUpdate *u = &out[n++];
+        memset(u, 0, sizeof(*u));
+        u->kind = IPC_STATION;
+        snprintf(u->detail, sizeof(u->detail), "%s|%s|%s|%s|%s|%s", detail[0], detail[1],
+                 detail[2], detail[3], detail[4], detail[5]);
+    }
+    return n;
+}
+
+/* ── Coalescing queue ────────────────────────────────────────────── */
+
+/* Updates with the same slot replace each other: the target, the station
+ * info, and a spot with its unspot */
+static int same_slot(const IpcUpdate *a, const IpcUpdate *b)
+{
+    int ka = a->kind == IPC_UNSPOT ? IPC_SPOT : (int)a->kind;
+    int kb = b->kind == IPC_UNSPOT ? IPC_SPOT : (int)b->kind;
+    return ka == kb && (ka != IPC_SPOT || strcmp(a->key, b->key) == 0);
+}
+
+static unsigned slot_hash(const IpcUpdate *u)
+{
+    unsigned h = 2166136261u;
+    if (u->kind != IPC_SPOT && u->kind != IPC_UNSPOT)
+        return h ^ (unsigned)u->kind;
+    for (const unsigned char *p = (const unsigned char *)u->key; *p; p++) {
+        h ^= *p;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/* Queue n updates (mutex held).  Returns how many did not fit. */
+static int enqueue(IpcServer *s, const IpcUpdate *u, int n)
+{
+    int dropped = 0;
+    for (int i = 0; i < n; i++) {
+        unsigned h = slot_hash(&u[i]) & (IPC_SLOTS - 1);
+        while (s->slots[h] >= 0 && !same_slot(&s->queue[s->slots[h]], &u[i]))
+            h = (h + 1) & (IPC_SLOTS - 1);
+        if (s->slots[h] >= 0) {
+            s->queue[s->slots[h]] = u[i];
+            s->coalesced++;
+        } else if (s->queued < IPC_QUEUE_MAX) {
+            s->queue[s->queued] = u[i];
+            s->slots[h] = s->queued++;
+        } else {
+            dropped++;
+            continue;
+        }
+        s->received++;
+    }
+    s->dropped += dropped;
+    return dropped;
+}
+
+int ipc_take(IpcServer *s, const IpcUpdate **out)
+{
+    if (!s->started) return 0;
+    pthread_mutex_lock(&s->mutex);
+    int n = s->queued;
+    if (n > 0) {
+        IpcUpdate *t = s->front;
+        s->front = s->queue;
+        s->queue = t;
+        s->queued = 0;
+        memset(s->slots, 0xff, sizeof(*s->slots) * IPC_SLOTS);
+    }
+    pthread_mutex_unlock(&s->mutex);
+    *out = s->front;
+    return n;
+}
+
+void ipc_get_stats(IpcServer *s, IpcStats *out)
+{
+    memset(out, 0, sizeof(*out));
+    if (!s->started) return;
+    pthread_mutex_lock(&s->mutex);
+    out->clients = s->clients;
+    out->received = s->received;
+    out->coalesced = s->coalesced;
+    out->dropped = s->dropped;
+    out->errors = s->errors;
+    pthread_mutex_unlock(&s->mutex);
+}
+
+/* ── Reader thread ───────────────────────────────────────────────── */
+
+/* Reply to a client; lost if its socket buffer is full */
+static void reply(IpcClient *c, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+static void reply(IpcClient *c, const char *fmt, ...)
+{
+    if (c->is_fifo) return;
+    char msg[256];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(msg, sizeof(msg) - 1, fmt, ap);
+    va_end(ap);
+    if (n < 0) return;
+    if (n > (int)sizeof(msg) - 2) n = (int)sizeof(msg) - 2;
+    msg[n++] = '\n';
+    send(c->fd, msg, (size_t)n, MSG_DONTWAIT | MSG_NOSIGNAL);
+}
+
+/* Updates parsed from one read, queued under one lock */
+typedef struct {
+    IpcUpdate u[IPC_BATCH];
+    int       n;
+    int       errors;
+} Batch;
+
+static void flush(IpcServer *s, IpcClient *c, Batch *b)
+{
+    if (b->n == 0 && b->errors == 0) return;
+    pthread_mutex_lock(&s->mutex);
+    int was_empty = s->queued == 0;
+    int dropped = enqueue(s, b->u, b->n);
+    s->errors += b->errors;
+    int woke = was_empty && s->queued > 0;
+    pthread_mutex_unlock(&s->mutex);
+    if (dropped > 0)
+        reply(c, "{\"status\":\"full\",\"dropped\":%d}", dropped);
+    if (woke && s->wake) s->wake();
+    b->n = 0;
+    b->errors = 0;
+}
+
+static void handle_line(IpcServer *s, IpcClient *c, const char *line, Batch *b)
+{
+    if (!line[0]) return;
+    if (b->n + 2 > IPC_BATCH) flush(s, c, b);
+    char reason[64];
+    int is_stats = 0;
+    int n = c->is_fifo ? parse_fifo(line, &b->u[b->n], reason, sizeof(reason))
+                       : parse_json(&s->jp, line, &b->u[b->n], &is_stats, reason, sizeof(reason));
+    if (n > 0) {
+        b->n += n;
+    } else if (n < 0) {
+        b->errors++;
+        reply(c, "{\"status\":\"error\",\"reason\":\"%s\"}", reason);
+    } else if (is_stats) {
+        flush(s, c, b);
+        IpcStats st;
+        ipc_get_stats(s, &st);
+        reply(c, "{\"status\":\"ok\",\"clients\":%d,\"received\":%ld,\"coalesced\":%ld,"
+                 "\"dropped\":%ld,\"errors\":%ld}",
+              st.clients, st.received, st.coalesced, st.dropped, st.errors);
+    }
+}
+
+/* Split data into lines; a line longer than IPC_LINE_MAX is rejected up
+ * to its newline */
+static void handle_data(IpcServer *s, IpcClient *c, const char *data, size_t len)
+{
+    Batch b;
+    b.n = b.errors = 0;
+    for (size_t i = 0; i < len; i++) {
+        char ch = data[i];
+        if (ch == '\n') {
+            if (!c->skipping) {
+                c->buf[c->len] = '\0';
+                if (c->len > 0 && c->buf[c->len - 1] == '\r')
+                    c->buf[c->len - 1] = '\0';
+                handle_line(s, c, c->buf, &b);
+            }
+            c->len = 0;
+            c->skipping = 0;
+        } else if (c->skipping) {
+            continue;
+        } else if (c->len + 1 < IPC_LINE_MAX) {
+            c->buf[c->len++] = ch;
+        } else {
+            c->skipping = 1;
+            c->len = 0;
+            b.errors++;
+            reply(c, "{\"status\":\"error\",\"reason\":\"line too long\"}");
+        }
+    }
+    flush(s, c, &b);
+}
+
+static void close_client(IpcServer *s, IpcClient *c)
+{
+    close(c->fd);
+    c->fd = -1;
+    c->len = 0;
+    c->skipping = 0;
+    pthread_mutex_lock(&s->mutex);
+    s->clients--;
+    pthread_mutex_unlock(&s->mutex);
+}
+
+static void accept_clients(IpcServer *s)
+{
+    int fd;
+    while ((fd = accept(s->listen_fd, NULL, NULL)) >= 0) {
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        IpcClient *c = NULL;
+        for (int i = 0; i < IPC_CLIENTS_MAX && !c; i++)
+            if (s->inputs[i].fd < 0) c = &s->inputs[i];
+        if (!c) {
+            IpcClient tmp = { .fd = fd };
+            reply(&tmp, "{\"status\":\"error\",\"reason\":\"too many clients\"}");
+            close(fd);
+            continue;
+        }
+        c->fd = fd;
+        c->len = 0;
+        c->skipping = 0;
+        pthread_mutex_lock(&s->mutex);
+        s->clients++;
+        pthread_mutex_unlock(&s->mutex);
+    }
+}
+
+static void *reader_thread(void *arg)
+{
+    IpcServer *s = arg;
+    char chunk[IPC_READ_CHUNK];
+    struct pollfd pfd[IPC_CLIENTS_MAX + 2];
+    IpcClient *who[IPC_CLIENTS_MAX + 2];
+    while (!atomic_load_explicit(&s->stop, memory_order_relaxed)) {
+        int n = 0;
+        if (s->listen_fd >= 0) {
+            pfd[n] = (struct pollfd){ .fd = s->listen_fd, .events = POLLIN };
+            who[n++] = NULL;
+        }
+        for (int i = 0; i <= IPC_CLIENTS_MAX; i++)
+            if (s->inputs[i].fd >= 0) {
+                pfd[n] = (struct pollfd){ .fd = s->inputs[i].fd, .events = POLLIN };
+                who[n++] = &s->inputs[i];
+            }
+        if (poll(pfd, (nfds_t)n, IPC_POLL_MS) <= 0)
+            continue;
+        for (int i = 0; i < n; i++) {
+            if (!pfd[i].revents) continue;
+            IpcClient *c = who[i];
+            if (!c) {
+                accept_clients(s);
+                continue;
+            }
+            ssize_t nr = read(c->fd, chunk, sizeof(chunk));
+            if (nr > 0)
+                handle_data(s, c, chunk, (size_t)nr);
+            else if (!c->is_fifo && (nr == 0 || (errno != EAGAIN && errno != EINTR)))
+                close_client(s, c);
+        }
+    }
+    return NULL;
+}
+
+/* ── Setup ───────────────────────────────────────────────────────── */
+
+/* bind() with umask 077, so the socket file is created owner-only (0700)
+ * and is never reachable by other users, as it was until a later chmod().
+ * The umask is process-wide: a file another thread creates meanwhile is
+ * only more private than it would have been. */
+static int bind_private(int fd, const struct sockaddr_un *addr)
+{
+    mode_t old = umask(077);
+    int rc = bind(fd, (const struct sockaddr *)addr, sizeof(*addr));
+    umask(old);
+    return rc;
+}
+
+/* Bind path, replacing a socket file nobody listens on.  Returns the
+ * listening fd or -1. */
+static int listen_unix(const char *path)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Warning: IPC socket path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    int rc = bind_private(fd, &addr);
+    struct stat st;
+    if (rc != 0 && errno == EADDRINUSE && lstat(path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+        /* Left over from a crash, or another azmap's? */
+        int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        int live = probe >= 0 && connect(probe, (struct sockaddr *)&addr, sizeof(addr)) == 0;
+        if (probe >= 0) close(probe);
+        if (live) {
+            fprintf(stderr, "Warning: %s is in use by another azmap\n", path);
+            close(fd);
+            return -1;
+        }
+        unlink(path);
+        rc = bind_private(fd, &addr);
+    }
+    if (rc != 0 || listen(fd, 16) != 0) {
+        fprintf(stderr, "Warning: cannot listen on %s: %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    return fd;
+}
+
+int ipc_server_start(IpcServer *s, const char *sock_path, const char *fifo_path,
+                     void (*wake)(void))
+{
+    memset(s, 0, sizeof(*s));
+    s->listen_fd = -1;
+    for (int i = 0; i <= IPC_CLIENTS_MAX; i++)
+        s->inputs[i].fd = -1;
+    s->wake = wake;
+
+    if (sock_path && sock_path[0]) {
+        s->listen_fd = listen_unix(sock_path);
+        if (s->listen_fd >= 0)
+            snprintf(s->path, sizeof(s->path), "%s", sock_path);
+    }
+    if (fifo_path && fifo_path[0]) {
+        mkfifo(fifo_path, 0600);            /* no-op if it already exists */
+        /* O_RDWR: never EOF when a writer closes */
+        int fd = open(fifo_path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (fd >= 0) {
+            s->inputs[IPC_FIFO].fd = fd;
+            s->inputs[IPC_FIFO].is_fifo = 1;
+        } else {
+            fprintf(stderr, "Warning: cannot open %s: %s\n", fifo_path, strerror(errno));
+        }
+    }
+    if (s->listen_fd < 0 && s->inputs[IPC_FIFO].fd < 0)
+        return -1;
+
+    s->queue = malloc(sizeof(*s->queue) * IPC_QUEUE_MAX);
+    s->front = malloc(sizeof(*s->front) * IPC_QUEUE_MAX);
+    s->slots = malloc(sizeof(*s->slots) * IPC_SLOTS);
+    if (!s->queue || !s->front || !s->slots) {
+        fprintf(stderr, "Warning: out of memory, IPC disabled\n");
+        goto fail;
+    }
+    memset(s->slots, 0xff, sizeof(*s->slots) * IPC_SLOTS);
+    json_pull_init(&s->jp);
+    pthread_mutex_init(&s->mutex, NULL);
+    if (pthread_create(&s->thread, NULL, reader_thread, s) != 0) {
+        fprintf(stderr, "Warning: IPC reader thread failed: %s\n", strerror(errno));
+        pthread_mutex_destroy(&s->mutex);
+        goto fail;
+    }
+    s->started = 1;
+    return 0;
+
+fail:
+    free(s->queue);
+    free(s->front);
+    free(s->slots);
+    s->queue = s->front = NULL;
+    s->slots = NULL;
+    if (s->listen_fd >= 0) {
+        close(s->listen_fd);
+        unlink(s->path);
+        s->listen_fd = -1;
+    }
+    if (s->inputs[IPC_FIFO].fd >= 0) {
+        close(s->inputs[IPC_FIFO].fd);
+        s->inputs[IPC_FIFO].fd = -1;
+    }
+    return -1;
+}
+
+void ipc_server_stop(IpcServer *s)
+{
+    if (!s->started) return;
+    atomic_store(&s->stop, 1);
+    pthread_join(s->thread, NULL);
+    for (int i = 0; i <= IPC_CLIENTS_MAX; i++)
+        if (s->inputs[i].fd >= 0) {
+            close(s->inputs[i].fd);
+            s->inputs[i].fd = -1;
+        }
+    if (s->listen_fd >= 0) {
+        close(s->listen_fd);
+        unlink(s->path);
+        s->listen_fd = -1;
+    }
+    pthread_mutex_destroy(&s->mutex);
+    json_pull_free(&s->jp);
+    free(s->queue);
+    free(s->front);
+    free(s->slots);
+    s->queue = s->front = NULL;
+    s->slots = NULL;
+    s->started = 0;
+}
@@ -0,0 +1,122 @@
+/* ipc.h — Unix domain socket server for target, station and spot updates.
+ *
+ * Clients (the swl dashboard, loggers, scripts) connect to a stream socket
+ * and write one JSON object per line:
+ *   {"type":"target","lat":40.42,"lon":-3.70,"name":"RNE",
+ *    "station":"...","freq":"...","country":"...","site":"...",
+ *    "lang":"...","target":"..."}       station fields are optional
+ *   {"type":"station","station":"...","freq":"...",...}
+ *   {"type":"spot","key":"EA4ABC","lat":40.4,"lon":-3.7,"pinned":false}
+ *   {"type":"unspot","key":"EA4ABC"}
+ *   {"type":"stats"}
+ * Any number of clients may be connected at once.  The legacy named pipe
+ * is served by the same thread as one more input: each of its lines
+ * ("lat,lon,name|station|freq|country|site|lang|target") is a target
+ * update.
+ *
+ * A reader thread parses the lines and queues updates for the main thread,
+ * coalesced by key: one slot for the target, one for the station info and
+ * one per spot, so a client can send thousands of updates per second and
+ * the main loop still applies at most one per key each frame.  The main
+ * thread takes everything queued at once (the queue is double-buffered).
+ *
+ * Nothing is dropped silently.  The server answers on the same socket, one
+ * JSON object per line, only when there is something to report:
+ *   {"status":"full","dropped":N}        N updates did not fit the queue
+ *   {"status":"error","reason":"..."}    a line was not a valid update
+ *   {"status":"ok","clients":C,"received":R,"coalesced":K,
+ *    "dropped":D,"errors":E}             reply to "stats"
+ * A reply that does not fit the client's socket buffer is lost; the
+ * counters still have it. */
+
+#ifndef IPC_H
+#define IPC_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include "json_pull.h"
+
+#define IPC_SOCKET_NAME  "azmap.sock"   /* in $XDG_RUNTIME_DIR */
+#define IPC_CLIENTS_MAX  32
+#define IPC_LINE_MAX     1024           /* longer lines are rejected */
+#define IPC_QUEUE_MAX    2048           /* distinct keys queued per take */
+#define IPC_KEY_MAX      32
+
+typedef enum {
+    IPC_TARGET,             /* lat, lon, name */
+    IPC_STATION,            /* detail */
+    IPC_SPOT,               /* key, lat, lon, pinned */
+    IPC_UNSPOT,             /* key */
+} IpcKind;
+
+typedef struct {
+    IpcKind kind;
+    char    key[IPC_KEY_MAX];   /* spot key */
+    double  lat, lon;
+    int     pinned;             /* spot never fades */
+    char    name[64];           /* target label */
+    char    detail[256];        /* "station|freq|country|site|lang|target" */
+} IpcUpdate;
+
+/* Running totals */
+typedef struct {
+    int  clients;           /* connected now */
+    long received;          /* valid updates (pipe lines included) */
+    long coalesced;         /* replaced an update of the same key still queued */
+    long dropped;           /* did not fit the queue (reported to the client) */
+    long errors;            /* invalid lines */
+} IpcStats;
+
+/* One input: a socket client or the pipe (reader thread only) */
+typedef struct {
+    int  fd;                        /* -1 = free */
+    int  is_fifo;                   /* legacy line format, no replies */
+    char buf[IPC_LINE_MAX];         /* partial line */
+    int  len;
+    int  skipping;                  /* discarding the rest of a long line */
+} IpcClient;
+
+typedef struct {
+    int             listen_fd;      /* -1 without a socket */
+    char            path[108];      /* socket path, unlinked on stop */
+    pthread_t       thread;
+    int             started;
+    atomic_int      stop;
+    void          (*wake)(void);
+    IpcClient       inputs[IPC_CLIENTS_MAX + 1];   /* clients, then the pipe */
+    JsonPull        jp;             /* reused for every line */
+
+    pthread_mutex_t mutex;          /* everything below */
+    IpcUpdate      *queue;          /* filled by the reader */
+    IpcUpdate      *front;          /* taken by the main thread */
+    int             queued;
+    int            *slots;          /* key hash -> queue index, -1 = empty */
+    int             clients;
+    long            received, coalesced, dropped, errors;
+} IpcServer;
+
+/* Default socket path: $XDG_RUNTIME_DIR/azmap.sock, or
+ * /tmp/azmap-<uid>.sock without one. */
+void ipc_default_path(char *out, int out_sz);
+
+/* Listen on the Unix socket sock_path (NULL: no socket; a stale socket
+ * file is replaced, a live one left to its owner) and read the legacy pipe
+ * fifo_path (NULL: none; created if needed).  wake (thread-safe, e.g.
+ * glfwPostEmptyEvent, or NULL) is called when updates are queued for an
+ * empty queue.  Returns 0 if at least one input is open, -1 otherwise. */
+int  ipc_server_start(IpcServer *s, const char *sock_path, const char *fifo_path,
+                      void (*wake)(void));
+
+/* Take every queued update (main thread), in the order their keys were
+ * first queued.  *out is valid until the next call.  Returns the number
+ * taken. */
+int  ipc_take(IpcServer *s, const IpcUpdate **out);
+
+/* Copy the running totals (any thread). */
+void ipc_get_stats(IpcServer *s, IpcStats *out);
+
+/* Stop the thread, disconnect the clients, close the inputs and remove the
+ * socket file.  No-op if it never started. */
+void ipc_server_stop(IpcServer *s);
+
+#endif
@@ -0,0 +1,374 @@
+/* json_pull.c — Incremental pull parser for JSON documents.
+ *
+ * Structural characters are single bytes and never span chunks; strings,
+ * numbers and literals that reach the end of a chunk go to the carry
+ * buffer and are completed from the next one.  Numbers with up to 15
+ * significant digits and no exponent are converted exactly without
+ * strtod() (mantissa / 10^k, both exact doubles); the rest use strtod(). */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "json_pull.h"
+
+/* Grammar state: what may come next */
+enum {
+    EXP_VALUE,           /* root, after ':' or after ',' in an array */
+    EXP_VALUE_OR_CLOSE,  /* after '[' */
+    EXP_KEY_OR_CLOSE,    /* after '{' */
+    EXP_KEY,             /* after ',' in an object */
+    EXP_COLON,
+    EXP_COMMA_OR_CLOSE,
+    EXP_DONE,            /* root value complete */
+};
+
+void json_pull_init(JsonPull *p)
+{
+    memset(p, 0, sizeof(*p));
+    p->expect = EXP_VALUE;
+}
+
+void json_pull_free(JsonPull *p)
+{
+    free(p->str);
+    free(p->carry);
+    json_pull_init(p);
+}
+
+void json_pull_reset(JsonPull *p)
+{
+    char *str = p->str, *carry = p->carry;
+    size_t str_cap = p->str_cap, carry_cap = p->carry_cap;
+    json_pull_init(p);
+    p->str = str;
+    p->str_cap = str_cap;
+    p->carry = carry;
+    p->carry_cap = carry_cap;
+}
+
+void json_pull_feed(JsonPull *p, const char *data, size_t len)
+{
+    p->in = data;
+    p->in_len = len;
+    p->in_pos = 0;
+}
+
+void json_pull_end(JsonPull *p)
+{
+    json_pull_feed(p, "", 0);
+    p->eof = 1;
+}
+
+static JsonToken fail(JsonPull *p)
+{
+    p->error = 1;
+    return JSON_TOK_ERROR;
+}
+
+static int grow(char **buf, size_t *cap, size_t need)
+{
+    if (need <= *cap) return 0;
+    size_t ncap = *cap ? *cap : 256;
+    while (ncap < need) ncap *= 2;
+    char *b = realloc(*buf, ncap);
+    if (!b) return -1;
+    *buf = b;
+    *cap = ncap;
+    return 0;
+}
+
+static int carry_append(JsonPull *p, const char *s, size_t n)
+{
+    if (n == 0) return 0;
+    if (grow(&p->carry, &p->carry_cap, p->carry_len + n) != 0) return -1;
+    memcpy(p->carry + p->carry_len, s, n);
+    p->carry_len += n;
+    return 0;
+}
+
+/* Characters that continue a number or literal */
+static int is_word(char c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') ||
+           (c >= 'A' && c <= 'Z') || c == '+' || c == '-' || c == '.';
+}
+
+static int is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/* Length of the string token at s (including both quotes), scanning from
+ * offset i with escape state *esc; 0 if it doesn't end within n bytes. */
+static size_t string_end(const char *s, size_t n, size_t i, int *esc)
+{
+    for (; i < n; i++) {
+        if (*esc) *esc = 0;
+        else if (s[i] == '\\') *esc = 1;
+        else if (s[i] == '"') return i + 1;
+    }
+    return 0;
+}
+
+/* ── Scalars ───────────────────────────────────────────────────── */
+
+static int hex4(const char *s, unsigned *out)
+{
+    unsigned v = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = s[i];
+        v <<= 4;
+        if (c >= '0' && c <= '9') v |= c - '0';
+        else if (c >= 'a' && c <= 'f') v |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') v |= c - 'A' + 10;
+        else return -1;
+    }
+    *out = v;
+    return 0;
+}
+
+/* Unescape the string token s[0..n) (quotes included) into p->str. */
+static int parse_string(JsonPull *p, const char *s, size_t n)
+{
+    if (grow(&p->str, &p->str_cap, n) != 0) return -1;
+    char *o = p->str;
+    const char *end = s + n - 1;
+    for (s++; s < end; s++) {
+        if (*s != '\\') {
+            *o++ = *s;
+            continue;
+        }
+        s++;
+        switch (*s) {
+        case '"':  *o++ = '"';  break;
+        case '\\': *o++ = '\\'; break;
+        case '/':  *o++ = '/';  break;
+        case 'b':  *o++ = '\b'; break;
+        case 'f':  *o++ = '\f'; break;
+        case 'n':  *o++ = '\n'; break;
+        case 'r':  *o++ = '\r'; break;
+        case 't':  *o++ = '\t'; break;
+        case 'u': {
+            unsigned cp, lo;
+            if (end - s < 5 || hex4(s + 1, &cp) != 0) return -1;
+            s += 4;
+            if (cp >= 0xD800 && cp < 0xDC00 && end - s >= 7 && s[1] == '\\' &&
+                s[2] == 'u' && hex4(s + 3, &lo) == 0 && lo >= 0xDC00 && lo < 0xE000) {
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                s += 6;
+            }
+            /* UTF-8: at most 4 bytes for the 6 or 12 escape bytes read */
+            if (cp < 0x80) {
+                *o++ = (char)cp;
+            } else if (cp < 0x800) {
+                *o++ = (char)(0xC0 | cp >> 6);
+                *o++ = (char)(0x80 | (cp & 0x3F));
+            } else if (cp < 0x10000) {
+                *o++ = (char)(0xE0 | cp >> 12);
+                *o++ = (char)(0x80 | (cp >> 6 & 0x3F));
+                *o++ = (char)(0x80 | (cp & 0x3F));
+            } else {
+                *o++ = (char)(0xF0 | cp >> 18);
+                *o++ = (char)(0x80 | (cp >> 12 & 0x3F));
+                *o++ = (char)(0x80 | (cp >> 6 & 0x3F));
+                *o++ = (char)(0x80 | (cp & 0x3F));
+            }
+            break;
+        }
+        default:
+            return -1;
+        }
+    }
+    *o = '\0';
+    p->str_len = (size_t)(o - p->str);
+    return 0;
+}
+
+static int parse_number(const char *s, size_t n, double *out)
+{
+    static const double pow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+        1e13, 1e14, 1e15,
+    };
+    size_t i = 0;
+    int neg = 0, digits = 0, frac = 0;
+    uint64_t mant = 0;
+
+    if (s[i] == '-') { neg = 1; i++; }
+    if (i >= n || s[i] < '0' || s[i] > '9') return -1;
+    for (; i < n && s[i] >= '0' && s[i] <= '9'; i++, digits++)
+        if (digits < 19) mant = mant * 10 + (uint64_t)(s[i] - '0');
+    if (i < n && s[i] == '.') {
+        i++;
+        if (i >= n || s[i] < '0' || s[i] > '9') return -1;
+        for (; i < n && s[i] >= '0' && s[i] <= '9'; i++, digits++, frac++)
+            if (digits < 19) mant = mant * 10 + (uint64_t)(s[i] - '0');
+    }
+    if (i == n && digits <= 15) {
+        double v = (double)mant / pow10[frac];
+        *out = neg ? -v : v;
+        return 0;
+    }
+
+    /* Exponent or long mantissa */
+    if (i < n && (s[i] == 'e' || s[i] == 'E')) {
+        i++;
+        if (i < n && (s[i] == '+' || s[i] == '-')) i++;
+        if (i >= n || s[i] < '0' || s[i] > '9') return -1;
+        while (i < n && s[i] >= '0' && s[i] <= '9') i++;
+    }
+    char buf[64];
+    if (i != n || n >= sizeof(buf)) return -1;
+    memcpy(buf, s, n);
+    buf[n] = '\0';
+    *out = strtod(buf, NULL);
+    return 0;
+}
+
+/* A value starts: check the grammar and count it in its array. */
+static int value_start(JsonPull *p)
+{
+    if (p->expect != EXP_VALUE && p->expect != EXP_VALUE_OR_CLOSE) return -1;
+    if (p->depth > 0 && p->levels[p->depth - 1].kind == '[')
+        p->levels[p->depth - 1].index++;
+    return 0;
+}
+
+static void value_done(JsonPull *p)
+{
+    p->expect = p->depth == 0 ? EXP_DONE : EXP_COMMA_OR_CLOSE;
+}
+
+/* Complete string / number / literal token s[0..n). */
+static JsonToken scalar(JsonPull *p, const char *s, size_t n)
+{
+    if (s[0] == '"') {
+        if (parse_string(p, s, n) != 0) return fail(p);
+        if (p->expect == EXP_KEY_OR_CLOSE || p->expect == EXP_KEY) {
+            JsonLevel *l = &p->levels[p->depth - 1];
+            l->index++;
+            size_t k = p->str_len < JSON_PULL_KEY_MAX ? p->str_len : JSON_PULL_KEY_MAX - 1;
+            memcpy(l->key, p->str, k);
+            l->key[k] = '\0';
+            p->expect = EXP_COLON;
+            return JSON_TOK_KEY;
+        }
+        if (value_start(p) != 0) return fail(p);
+        value_done(p);
+        return JSON_TOK_STRING;
+    }
+
+    if (value_start(p) != 0) return fail(p);
+    value_done(p);
+    if (n == 4 && memcmp(s, "true", 4) == 0)  return JSON_TOK_TRUE;
+    if (n == 5 && memcmp(s, "false", 5) == 0) return JSON_TOK_FALSE;
+    if (n == 4 && memcmp(s, "null", 4) == 0)  return JSON_TOK_NULL;
+    if (parse_number(s, n, &p->num) != 0) return fail(p);
+    return JSON_TOK_NUMBER;
+}
+
+/* Extend the carried token from the current chunk.  Returns 1 when it is
+ * complete, 0 if it needs more input, -1 on error. */
+static int finish_carry(JsonPull *p)
+{
+    const char *s = p->in + p->in_pos;
+    size_t n = p->in_len - p->in_pos;
+    size_t used = n;
+    int done = 0;
+
+    if (p->carry[0] == '"') {
+        int esc = 0;
+        string_end(p->carry, p->carry_len, 1, &esc);   /* escape state only */
+        size_t e = string_end(s, n, 0, &esc);
+        if (e > 0) { used = e; done = 1; }
+    } else {
+        size_t i = 0;
+        while (i < n && is_word(s[i])) i++;
+        if (i < n) { used = i; done = 1; }
+    }
+    if (carry_append(p, s, used) != 0) return -1;
+    p->in_pos += used;
+    if (done) return 1;
+    if (p->eof) return p->carry[0] == '"' ? -1 : 1;
+    return 0;
+}
+
+JsonToken json_pull_next(JsonPull *p)
+{
+    if (p->error) return JSON_TOK_ERROR;
+
+    if (p->carry_len > 0) {
+        int r = finish_carry(p);
+        if (r < 0) return fail(p);
+        if (r == 0) return JSON_TOK_MORE;
+        JsonToken t = scalar(p, p->carry, p->carry_len);
+        p->carry_len = 0;
+        return t;
+    }
+
+    while (p->in_pos < p->in_len && is_space(p->in[p->in_pos])) p->in_pos++;
+    if (p->in_pos == p->in_len) {
+        if (!p->eof) return JSON_TOK_MORE;
+        return p->expect == EXP_DONE ? JSON_TOK_END : fail(p);
+    }
+
+    const char *s = p->in + p->in_pos;
+    size_t n = p->in_len - p->in_pos;
+    switch (s[0]) {
+    case '{':
+    case '[':
+        if (value_start(p) != 0 || p->depth == JSON_PULL_MAX_DEPTH) return fail(p);
+        p->levels[p->depth].kind = s[0];
+        p->levels[p->depth].index = -1;
+        p->levels[p->depth].key[0] = '\0';
+        p->depth++;
+        p->in_pos++;
+        p->expect = s[0] == '{' ? EXP_KEY_OR_CLOSE : EXP_VALUE_OR_CLOSE;
+        return s[0] == '{' ? JSON_TOK_OBJECT : JSON_TOK_ARRAY;
+
+    case '}':
+    case ']': {
+        char open = s[0] == '}' ? '{' : '[';
+        if (p->depth == 0 || p->levels[p->depth - 1].kind != open) return fail(p);
+        if (p->expect != EXP_COMMA_OR_CLOSE &&
+            p->expect != (open == '{' ? EXP_KEY_OR_CLOSE : EXP_VALUE_OR_CLOSE))
+            return fail(p);
+        p->depth--;
+        p->in_pos++;
+        value_done(p);
+        return open == '{' ? JSON_TOK_OBJECT_END : JSON_TOK_ARRAY_END;
+    }
+
+    case ',':
+        if (p->expect != EXP_COMMA_OR_CLOSE) return fail(p);
+        p->expect = p->levels[p->depth - 1].kind == '{' ? EXP_KEY : EXP_VALUE;
+        p->in_pos++;
+        return json_pull_next(p);
+
+    case ':':
+        if (p->expect != EXP_COLON) return fail(p);
+        p->expect = EXP_VALUE;
+        p->in_pos++;
+        return json_pull_next(p);
+    }
+
+    /* String, number or literal: complete within this chunk? */
+    size_t len = 0;
+    if (s[0] == '"') {
+        int esc = 0;
+        len = string_end(s, n, 1, &esc);
+    } else if (is_word(s[0])) {
+        while (len < n && is_word(s[len])) len++;
+        if (len == n && !p->eof) len = 0;
+    } else {
+        return fail(p);
+    }
+    if (len == 0) {
+        if (p->eof) return fail(p);
+        if (carry_append(p, s, n) != 0) return fail(p);
+        p->in_pos = p->in_len;
+        return JSON_TOK_MORE;
+    }
+    p->in_pos += len;
+    return scalar(p, s, len);
+}
@@ -0,0 +1,89 @@
+/* json_pull.h — Incremental pull parser for JSON documents.
+ *
+ * Returns one token at a time (object / array bounds, keys, scalars)
+ * without building a tree, so a feed parser can copy values straight into
+ * its own arrays.  Input can arrive in chunks of any size, e.g. from a
+ * curl write callback: a token cut at the end of a chunk is carried over
+ * and json_pull_next() asks for more.  Only the current string and the
+ * open containers (with their current key / element index) are kept.
+ *
+ * Usage:
+ *   json_pull_init(&p);
+ *   for each chunk:  json_pull_feed(&p, data, len);
+ *                    while ((t = json_pull_next(&p)) > JSON_TOK_END) ...;
+ *   at the end:      json_pull_end(&p); and drain again (JSON_TOK_END)
+ *   json_pull_free(&p); */
+
+#ifndef JSON_PULL_H
+#define JSON_PULL_H
+
+#include <stddef.h>
+
+#define JSON_PULL_MAX_DEPTH 32
+#define JSON_PULL_KEY_MAX   32   /* longer keys are truncated in levels[] */
+
+typedef enum {
+    JSON_TOK_ERROR = -2,    /* malformed input (sticky) */
+    JSON_TOK_MORE  = -1,    /* chunk used up: feed more, or end */
+    JSON_TOK_END   = 0,     /* document complete */
+    JSON_TOK_OBJECT,        /* '{' (depth already includes it) */
+    JSON_TOK_OBJECT_END,    /* '}' (depth already excludes it) */
+    JSON_TOK_ARRAY,
+    JSON_TOK_ARRAY_END,
+    JSON_TOK_KEY,           /* member name in str */
+    JSON_TOK_STRING,        /* value in str */
+    JSON_TOK_NUMBER,        /* value in num */
+    JSON_TOK_TRUE,
+    JSON_TOK_FALSE,
+    JSON_TOK_NULL,
+} JsonToken;
+
+/* An open object or array */
+typedef struct {
+    char kind;                       /* '{' or '[' */
+    int  index;                      /* current member / element, -1 before the first */
+    char key[JSON_PULL_KEY_MAX];     /* current member name (objects) */
+} JsonLevel;
+
+typedef struct {
+    /* Current token */
+    char     *str;         /* unescaped, NUL-terminated (KEY / STRING) */
+    size_t    str_len;
+    double    num;         /* NUMBER */
+
+    /* Open containers: levels[0] is the root, scalars belong to
+     * levels[depth - 1] */
+    JsonLevel levels[JSON_PULL_MAX_DEPTH];
+    int       depth;
+
+    /* Input */
+    const char *in;
+    size_t    in_len, in_pos;
+    int       eof;
+    char     *carry;       /* token cut at the end of the previous chunk */
+    size_t    carry_len, carry_cap;
+    size_t    str_cap;
+    int       expect;      /* grammar state (json_pull.c) */
+    int       error;
+} JsonPull;
+
+void json_pull_init(JsonPull *p);
+void json_pull_free(JsonPull *p);
+
+/* Start a new document, keeping the buffers of the previous one (many
+ * small documents, e.g. one per line, without an allocation each). */
+void json_pull_reset(JsonPull *p);
+
+/* Supply the next chunk.  data must stay valid until json_pull_next()
+ * returns JSON_TOK_MORE (anything still needed is copied by then). */
+void json_pull_feed(JsonPull *p, const char *data, size_t len);
+
+/* No more input after the current chunk. */
+void json_pull_end(JsonPull *p);
+
+/* Next token, JSON_TOK_MORE when the chunk is used up, JSON_TOK_END once
+ * the root value is complete and the input ended, JSON_TOK_ERROR on
+ * malformed input or out of memory. */
+JsonToken json_pull_next(JsonPull *p);
+
+#endif
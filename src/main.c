@@ -1,13 +1,20 @@
 /* main.c — Entry point, GLFW window, main loop, CLI arg parsing, label building.
  *
  * Sets up the OpenGL window, loads shapefiles & config, parses CLI arguments,
- * creates the FIFO for IPC, and runs the main render loop.  Each frame:
- * - polls FIFO for target updates from the swl dashboard
+ * starts the IPC server, and runs the main render loop.  Each iteration:
+ * - sleeps in glfwWaitEventsTimeout() until input, an IPC update, a finished
+ *   fetch, LOD or reprojection job, or the next clock second (render on demand)
+ * - takes target/station/spot updates from IPC clients (the swl dashboard)
+ *   and the legacy FIFO, and WSJT-X decodes
+ *   (spots) and logged QSOs (target) from its UDP listener
  * - checks async fetch results for overlay data (MUF, Es, Aurora, DRAP, Kp/Bz)
- * - handles projection center changes (reprojection of all geometry)
- * - rebuilds HUD text, labels, and sidebar content
- * - renders all layers via the renderer
- * - triggers periodic overlay refresh (every 15 min) and night mesh update (every 60s) */
+ * - queues projection center changes for the reprojection worker and
+ *   switches to the new center once its geometry is ready
+ * - rebuilds labels and button geometry only when their dirty bit is set,
+ *   and HUD/sidebar text once per second
+ * - renders and presents a frame only when something visible changed
+ * - triggers periodic overlay refresh (every 15 min); the night overlay is
+ *   shaded per pixel from the current subsolar point on every drawn frame */
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -17,8 +24,6 @@
 #include <limits.h>
 #include <unistd.h>
 #include <errno.h>
-#include <fcntl.h>
-#include <sys/stat.h>
 #include <math.h>
 #include <time.h>
 #include <GL/glew.h>
@@ -26,6 +31,9 @@
 
 #include "projection.h"
 #include "map_data.h"
+#include "map_lod.h"
+#include "reproj.h"
+#include "threadpool.h"
 #include "renderer.h"
 #include "camera.h"
 #include "input.h"
@@ -33,11 +41,16 @@
 #include "grid.h"
 #include "config.h"
 #include "solar.h"
-#include "nightmesh.h"
 #include "ui.h"
 #include "qrz.h"
 #include "overlay.h"
 #include "fetch.h"
+#include "feedcache.h"
+#include "feedbuild.h"
+#include "ipc.h"
+#include "spots.h"
+#include "wsjtx.h"
+#include "profiler.h"
 #include "icon.h"
 
 #define DEFAULT_WIDTH  800
@@ -45,10 +58,20 @@
 #define SIDEBAR_WIDTH_PX 300.0f
 #define MARKER_ZOOM_FACTOR 0.005f
 #define BUTTON_HEIGHT 28.0f
-#define NIGHT_UPDATE_SEC 60
+/* Render-on-demand dirty bits (main loop) */
+#define DIRTY_VIEW  0x1u   /* markers, marker labels, distance labels */
+#define DIRTY_UI    0x2u   /* buttons, legend, popup */
+#define DIRTY_FRAME 0x4u   /* draw and present a frame */
+#define DIRTY_ALL   (DIRTY_VIEW | DIRTY_UI | DIRTY_FRAME)
+/* Slack past the next clock second so the HUD tick lands after it */
+#define TICK_SLACK_SEC 0.005
+/* Longest idle wait while the profiler panel is shown */
+#define PROF_PANEL_WAIT_SEC 0.25
 #define DEFAULT_SHP_REL "data/ne_110m_coastline/ne_110m_coastline.shp"
-#define DEFAULT_BORDER_REL "data/ne_110m_admin_0_boundary_lines_land/ne_110m_admin_0_boundary_lines_land.shp"
-#define DEFAULT_LAND_REL "data/ne_110m_land/ne_110m_land.shp"
+/* Natural Earth layers by name; the finest installed scale is used */
+#define NE_COASTLINE "coastline"
+#define NE_BORDER    "admin_0_boundary_lines_land"
+#define NE_LAND      "land"
 #define DEFAULT_SHADER_REL "shaders"
 
 /* Resolve a path relative to the executable's directory.
@@ -70,6 +93,22 @@ static void resolve_path(const char *exe, const char *rel, char *out, size_t out
     snprintf(out, out_size, "%s/../share/azmap/%s", dir, rel);
 }
 
+/* Resolve the finest installed Natural Earth scale of a layer
+ * (data/ne_<scale>_<layer>/ne_<scale>_<layer>.shp).  Falls back to the
+ * 110m path so the "not found" messages point at the default download. */
+static void resolve_ne_path(const char *exe, const char *layer, char *out, size_t out_size)
+{
+    static const char *scales[] = { "10m", "50m", "110m" };
+    char rel[PATH_MAX];
+    for (int i = 0; i < 3; i++) {
+        snprintf(rel, sizeof(rel), "data/ne_%s_%s/ne_%s_%s.shp",
+                 scales[i], layer, scales[i], layer);
+        resolve_path(exe, rel, out, out_size);
+        if (access(out, F_OK) == 0)
+            return;
+    }
+}
+
 /* Format a coordinate as "12.34N" or "12.34S" / "1.23E" or "1.23W" */
 static int format_coord(char *buf, size_t sz, double lat, double lon)
 {
@@ -126,7 +165,7 @@ static int build_label_bg(float x, float y, float w, float h, float pad,
 }
 
 /* Build great circle path vertices between two lat/lon points.
- * Uses projection_forward_clamped so the path stays on/at the disc boundary.
+ * Projects with PROJ_BATCH_CLAMP so the path stays on/at the disc boundary.
  * Returns number of vertices written. */
 #define GC_LINE_POINTS 101
 static int build_gc_line(double lat1, double lon1, double lat2, double lon2,
@@ -150,6 +189,7 @@ static int build_gc_line(double lat1, double lon1, double lat2, double lon2,
 
     double sin_d = sin(d);
     int n = GC_LINE_POINTS - 1;
+    double lats[GC_LINE_POINTS], lons[GC_LINE_POINTS];
 
     for (int i = 0; i <= n; i++) {
         double t = (double)i / (double)n;
@@ -160,18 +200,47 @@ static int build_gc_line(double lat1, double lon1, double lat2, double lon2,
         double y3 = a * cos(phi1)*sin(lam1) + b * cos(phi2)*sin(lam2);
         double z3 = a * sin(phi1)            + b * sin(phi2);
 
-        double lat = atan2(z3, sqrt(x3*x3 + y3*y3)) * 180.0 / M_PI;
-        double lon = atan2(y3, x3) * 180.0 / M_PI;
-
-        double px, py;
-        projection_forward_clamped(lat, lon, &px, &py);
-        verts[i * 2]     = (float)px;
-        verts[i * 2 + 1] = (float)py;
+        lats[i] = atan2(z3, sqrt(x3*x3 + y3*y3)) * 180.0 / M_PI;
+        lons[i] = atan2(y3, x3) * 180.0 / M_PI;
     }
+    projection_forward_batch(lats, lons, n + 1, verts, NULL, PROJ_BATCH_CLAMP);
 
     return n + 1;
 }
 
+/* One line of the -m memory report: vertex/segment counts, CPU heap bytes
+ * (segment tables are shared with the renderer, so counted once) and the
+ * size of the layer's VBO (0 unless resident on the GPU). */
+static void mem_report_line(const char *name, const MapData *md, int gpu_raw,
+                            int resident, size_t *cpu_total, size_t *gpu_total)
+{
+    size_t cpu = map_data_mem_bytes(md);
+    int verts = gpu_raw ? md->raw_count : md->vertex_count;
+    const SegTable *segs = gpu_raw ? md->raw_segs : md->segs;
+    size_t gpu = resident ? (size_t)verts * 2 * sizeof(float) : 0;
+    printf("  %-14s %9d verts %7d segs %9.2f MB cpu %9.2f MB gpu\n", name,
+           verts, segs ? segs->num : 0,
+           cpu / (1024.0 * 1024.0), gpu / (1024.0 * 1024.0));
+    *cpu_total += cpu;
+    *gpu_total += gpu;
+}
+
+/* Memory report lines for every level of a LOD pyramid ("*" = shown),
+ * plus the mapped geometry cache file (page cache, not heap). */
+static void mem_report_lod(const char *name, const MapLod *lod, int gpu_raw,
+                           size_t *cpu_total, size_t *gpu_total)
+{
+    for (int i = 0; i < lod->num_levels; i++) {
+        char label[32];
+        snprintf(label, sizeof(label), "%s L%d%s", name, i, i == lod->shown ? "*" : "");
+        mem_report_line(label, &lod->levels[i], gpu_raw || lod->levels[i].vertices == NULL,
+                        i == lod->shown, cpu_total, gpu_total);
+    }
+    if (lod->cache_map)
+        printf("  %-14s %42.2f MB mapped\n", name,
+               lod->cache_len / (1024.0 * 1024.0));
+}
+
 /* Uppercase a string into dst (always null-terminated). */
 static void str_upper(char *dst, size_t dst_sz, const char *src)
 {
@@ -193,20 +262,161 @@ static void clear_target_state(UI *ui, double *dist, double *az_to, double *az_f
     *last_text_update = 0;
 }
 
-/* Reproject all map geometry after projection center or mode change. */
-static void reproject_all(MapData *map, MapData *borders, int has_borders,
-                          MapData *land, int has_land, Renderer *renderer)
+/* Upload the shown LOD level of the coastline / border / land layers.
+ * With gpu_proj set, coastlines and borders go up as raw lat/lon. */
+static void upload_coastlines(Renderer *renderer, const MapLod *map, int gpu_proj)
 {
-    map_data_reproject(map);
-    renderer_upload_map(renderer, map);
-    if (has_borders) {
-        map_data_reproject(borders);
-        renderer_upload_borders(renderer, borders);
-    }
-    if (has_land) {
-        map_data_reproject_nosplit(land);
-        renderer_upload_land(renderer, land);
+    if (gpu_proj)
+        renderer_upload_map_geo(renderer, map_lod_current(map));
+    else
+        renderer_upload_map(renderer, map_lod_current(map));
+}
+
+static void upload_borders(Renderer *renderer, const MapLod *borders, int gpu_proj)
+{
+    if (gpu_proj)
+        renderer_upload_borders_geo(renderer, map_lod_current(borders));
+    else
+        renderer_upload_borders(renderer, map_lod_current(borders));
+}
+
+/* Spherical cap of the part of the globe inside the map viewport. */
+static void view_cap_from_camera(const Camera *cam, float cap[4])
+{
+    double half_h = cam->zoom_km * 0.5;
+    projection_view_cap(cam->pan_x, cam->pan_y, half_h * cam->aspect, half_h, cap);
+}
+
+/* Adopt the center of a collected reprojection job and upload what it
+ * rebuilt.  With gpu_proj set, coastlines and borders live on the GPU as
+ * raw lat/lon and are projected in geo.vert, so the job left them alone. */
+static void apply_reprojection(const Reprojector *rp, Renderer *renderer,
+                               int gpu_proj, int muf_active, int spore_active)
+{
+    const ReprojLayers *l = &rp->layers;
+    projection_set_state(&rp->job_proj);
+    renderer_set_view_cap(renderer, rp->job_cap);
+    if (!gpu_proj) {
+        upload_coastlines(renderer, l->map, gpu_proj);
+        if (l->borders) upload_borders(renderer, l->borders, gpu_proj);
     }
+    if (l->land) renderer_upload_land(renderer, map_lod_current(l->land));
+    if (rp->job_grid) renderer_upload_grid(renderer, l->grid);
+    renderer_upload_dist_circles(renderer, l->dist_circles);
+    if (muf_active && l->muf->raw_count > 0)
+        renderer_upload_muf(renderer, l->muf);
+    if (spore_active && l->spore->raw_count > 0)
+        renderer_upload_spore(renderer, l->spore);
+    if (renderer->aurora.visible && l->aurora_lines->raw_count > 0)
+        renderer_upload_aurora_lines(renderer, l->aurora_lines);
+    if (renderer->drap.visible && l->drap_lines->raw_count > 0)
+        renderer_upload_drap_lines(renderer, l->drap_lines);
+}
+
+/* Show the aurora heatmap, plus its isolines when there are any (built
+ * by the feed builder, reprojected with the other lines). */
+static void show_aurora(Renderer *renderer, const HeatGrid *heat, const MufData *lines)
+{
+    if (!heat->texels) return;
+    renderer_upload_aurora(renderer, heat);
+    if (lines->raw_count > 0)
+        renderer_upload_aurora_lines(renderer, lines);
+}
+
+/* Same for the DRAP heatmap and isolines. */
+static void show_drap(Renderer *renderer, const HeatGrid *heat, const MufData *lines)
+{
+    if (!heat->texels) return;
+    renderer_upload_drap(renderer, heat);
+    if (lines->raw_count > 0)
+        renderer_upload_drap_lines(renderer, lines);
+}
+
+static int same_proj(const ProjState *a, const ProjState *b)
+{
+    return a->mode == b->mode && a->lat_deg == b->lat_deg && a->lon_deg == b->lon_deg;
+}
+
+/* Move a built layer's lines into place (the old ones are freed).
+ * Returns 1 if they were projected at the current center, 0 if they
+ * still need a reprojection job. */
+static int adopt_lines(MufData *dst, FeedResult *r)
+{
+    muf_data_free(dst);
+    *dst = r->lines;
+    muf_data_init(&r->lines);
+    ProjState cur;
+    projection_get_state(&cur);
+    return same_proj(&r->proj, &cur);
+}
+
+/* Hand a finished fetch's stream to the feed builder, at the current
+ * projection */
+static void build_stream(FeedBuilder *fb, FeedBuildKind kind, OverlayStream *s)
+{
+    ProjState cur;
+    projection_get_state(&cur);
+    feedbuild_submit_stream(fb, kind, s, &cur);
+}
+
+/* Fetch sink: parse an overlay response as it arrives (fetch thread) */
+static int stream_sink(void *ctx, const char *data, size_t len)
+{
+    return overlay_stream_feed(ctx, data, len);
+}
+
+/* Feed cache name of each streamed feed */
+static const char *const feed_cache[] = {
+    [OVERLAY_FEED_MUF]    = "muf",
+    [OVERLAY_FEED_SPORE]  = "spore",
+    [OVERLAY_FEED_AURORA] = "aurora",
+    [OVERLAY_FEED_KP]     = "kp",
+    [OVERLAY_FEED_BZ]     = "bz",
+};
+
+/* Feed cache name of each build, dropped when the build fails */
+static const char *const build_cache[] = {
+    [FEED_BUILD_MUF]    = "muf",
+    [FEED_BUILD_SPORE]  = "spore",
+    [FEED_BUILD_AURORA] = "aurora",
+    [FEED_BUILD_DRAP]   = "drap",
+};
+
+/* Start fetching url, parsing it into s on the fly.  With have_data set
+ * the overlay holds the cached copy and the fetch revalidates it. */
+static void start_stream(FetchRequest *req, OverlayStream *s, OverlayFeed feed,
+                         const char *url, int have_data)
+{
+    overlay_stream_init(s, feed);
+    fetch_start_cached(req, url, feed_cache[feed], have_data, stream_sink, s);
+}
+
+/* Drop the fetch of a layer that was switched off (s: its stream, or
+ * NULL for a buffered fetch); the layer refetches when it comes back. */
+static void cancel_fetch(FetchRequest *req, OverlayStream *s, int *fetching,
+                         time_t *last_fetch)
+{
+    if (!*fetching) return;
+    fetch_cleanup(req);
+    if (s) overlay_stream_free(s);
+    *fetching = 0;
+    *last_fetch = 0;
+}
+
+/* Parse the cached copy of a feed into s (main thread, at startup).
+ * Returns 0 if there was a complete one; s must be freed either way.  A
+ * copy that does not parse is dropped. */
+static int load_cached_stream(OverlayStream *s, OverlayFeed feed)
+{
+    overlay_stream_init(s, feed);
+    size_t len;
+    char *body = feedcache_load(feed_cache[feed], &len);
+    if (!body) return -1;
+    int rc = overlay_stream_feed(s, body, len) == 0 &&
+             overlay_stream_feed(s, NULL, 0) == 0 ? 0 : -1;
+    free(body);
+    if (rc != 0) feedcache_drop(feed_cache[feed]);
+    return rc;
 }
 
 /* Recompute distance/azimuth and rebuild target geometry (gc line + projections).
@@ -253,6 +463,168 @@ static void parse_station_detail(UI *ui, const char *detail_str)
     }
 }
 
+/* WSJT popup: listener state, own station and dial frequency from the
+ * latest Status message (status NULL before the first one), spot totals. */
+static void fill_wsjtx_popup(UI *ui, WsjtxListener *wl, int port,
+                             const WsjtxEvent *status)
+{
+    WsjtxStats st;
+    wsjtx_get_stats(wl, &st);
+    int n = 0;
+    if (port <= 0)
+        snprintf(ui->popup_result[n++], sizeof(ui->popup_result[0]), "DISABLED (WSJTX_PORT = 0)");
+    else if (wl->fd < 0)
+        snprintf(ui->popup_result[n++], sizeof(ui->popup_result[0]), "CANNOT LISTEN ON UDP %d", port);
+    else
+        snprintf(ui->popup_result[n++], sizeof(ui->popup_result[0]), "LISTENING ON UDP %d", port);
+    if (status) {
+        char de[40];
+        str_upper(de, sizeof(de), status->call[0] ? status->call : "?");
+        snprintf(ui->popup_result[n++], sizeof(ui->popup_result[0]), "DE %s %s  %s",
+                 de, status->grid, status->mode);
+        snprintf(ui->popup_result[n++], sizeof(ui->popup_result[0]), "DIAL %.6f MHZ",
+                 status->freq_hz / 1e6);
+    } else if (wl->fd >= 0) {
+        snprintf(ui->popup_result[n++], sizeof(ui->popup_result[0]), "WAITING FOR WSJT-X");
+    }
+    snprintf(ui->popup_result[n++], sizeof(ui->popup_result[0]), "%ld SPOTS, %ld DECODES",
+             st.spots, st.decodes);
+    ui->popup_result_lines = n;
+    ui->popup_input_active = 0;
+}
+
+/* Idle wait for the render-on-demand loop: until just past the next
+ * wall-clock second (HUD clocks), shorter while the profiler panel is up.
+ * Input, IPC updates, WSJT-X events and finished fetches/LOD jobs wake the
+ * loop earlier. */
+static double idle_wait_timeout(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    double t = 1.0 - ts.tv_nsec / 1e9 + TICK_SLACK_SEC;
+    if (profiler_panel_visible() && t > PROF_PANEL_WAIT_SEC)
+        t = PROF_PANEL_WAIT_SEC;
+    return t;
+}
+
+/* --targets: add the targets in path to spots as pinned spots.  A line
+ * is "lat lon [label]" (blank or comma separated) or a callsign; the
+ * callsigns are returned in *calls (strdup'd) for a QRZ batch.  Blank
+ * lines and '#' comments are skipped.  Returns 0, or -1 if path cannot
+ * be read. */
+static int load_targets(const char *path, SpotSet *spots, char ***calls, int *ncalls)
+{
+    *calls = NULL;
+    *ncalls = 0;
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "Error: cannot open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    int cap = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        char *p = line + strspn(line, " \t\r\n");
+        if (*p == '\0' || *p == '#') continue;
+        double lat, lon;
+        int used = 0;
+        if (sscanf(p, "%lf%*[ \t,]%lf%n", &lat, &lon, &used) == 2) {
+            char *label = p + used + strspn(p + used, " \t,");
+            label[strcspn(label, "\r\n")] = '\0';
+            char key[SPOT_KEY_MAX];
+            if (*label)
+                snprintf(key, sizeof(key), "%s", label);
+            else
+                snprintf(key, sizeof(key), "%.4f,%.4f", lat, lon);
+            if (lat >= -90.0 && lat <= 90.0)
+                spots_add(spots, key, lat, lon, SPOT_PINNED);
+            continue;
+        }
+        p[strcspn(p, " \t\r\n,")] = '\0';
+        if (*ncalls == cap) {
+            cap = cap ? cap * 2 : 64;
+            char **tmp = realloc(*calls, sizeof(**calls) * (size_t)cap);
+            if (!tmp) break;
+            *calls = tmp;
+        }
+        if (!((*calls)[*ncalls] = strdup(p))) break;
+        (*ncalls)++;
+    }
+    fclose(f);
+    return 0;
+}
+
+/* --resolve: look up every callsign in path (separated by blanks, commas
+ * or newlines) as one QRZ batch and print "CALL lat lon grid source name"
+ * per result, then the batch statistics.  Runs without a window. */
+static int resolve_callsigns(const Config *cfg, const char *path, int offline)
+{
+    if (!cfg->qrz_user[0] || !cfg->qrz_pass[0]) {
+        fprintf(stderr, "Error: --resolve needs qrz_user and qrz_pass in the config file\n");
+        return 1;
+    }
+    FILE *f = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "Error: cannot open %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    char **calls = NULL;
+    int n = 0, cap = 0;
+    char word[64];
+    while (fscanf(f, " %63[^ \t\r\n,]%*[ \t\r\n,]", word) == 1) {
+        if (n == cap) {
+            cap = cap ? cap * 2 : 64;
+            char **tmp = realloc(calls, sizeof(*calls) * (size_t)cap);
+            if (!tmp) break;
+            calls = tmp;
+        }
+        if (!(calls[n] = strdup(word))) break;
+        n++;
+    }
+    if (f != stdin) fclose(f);
+
+    if (qrz_init(cfg->qrz_user, cfg->qrz_pass) != 0) {
+        for (int i = 0; i < n; i++) free(calls[i]);
+        free(calls);
+        return 1;
+    }
+    qrz_set_offline(offline);
+    qrz_batch_submit((const char *const *)calls, n);
+
+    QRZBatchResult r;
+    QRZBatchStats st;
+    for (;;) {
+        /* Stats first: a worker queues its result and lowers pending in
+         * one step, so pending == 0 here means the drain below sees all */
+        qrz_batch_stats(&st);
+        int got = 0;
+        while (qrz_batch_take(&r)) {
+            got = 1;
+            if (r.status == 1 && r.result.valid)
+                printf("%s\t%.4f\t%.4f\t%s\t%s\t%s\n", r.call, r.result.lat, r.result.lon,
+                       r.result.grid[0] ? r.result.grid : "-",
+                       r.cached ? "cache" : "qrz", r.result.name);
+            else
+                fprintf(stderr, "%s: %s\n", r.call,
+                        r.status == 1 ? "no location" : r.err);
+        }
+        if (!got && st.pending == 0) break;
+        if (!got) {
+            struct timespec ts = { 0, 5000000 };
+            nanosleep(&ts, NULL);
+        }
+    }
+    fprintf(stderr, "resolve: %d callsigns, %d unique, %d cache hits (%.0f%%), "
+                    "%d looked up (%d failed) in %.2f s, %.1f lookups/s\n",
+            st.submitted, st.unique, st.cache_hits, st.hit_rate * 100.0,
+            st.resolved + st.failed, st.failed, st.elapsed_ms / 1e3, st.lookups_per_sec);
+
+    qrz_cleanup();
+    for (int i = 0; i < n; i++) free(calls[i]);
+    free(calls);
+    return 0;
+}
+
 static void print_usage(const char *prog)
 {
     fprintf(stderr,
@@ -267,6 +639,12 @@ static void print_usage(const char *prog)
         "  -c NAME    Center location name\n"
         "  -t NAME    Target location name\n"
         "  -s PATH    Shapefile path override (default: %s)\n"
+        "  -m         Print a memory report after loading map data\n"
+        "  --profile PATH  Dump per-frame phase timings on exit (JSON, or CSV for *.csv)\n"
+        "  --threads N     Threads for map reprojection (default: one per CPU, 1 = no pool)\n"
+        "  --offline       Show overlays from the feed cache only, no network\n"
+        "  --resolve FILE  Look up the callsigns in FILE (- for stdin) on QRZ.com and exit\n"
+        "  --targets FILE  Show every target in FILE (\"lat lon [label]\" or a callsign per line)\n"
         "\n"
         "Config file: ~/.config/azmap.conf\n"
         "  name = Madrid\n"
@@ -278,21 +656,42 @@ static void print_usage(const char *prog)
         "  Drag         Pan the map\n"
         "  Arrow keys   Pan the map\n"
         "  R            Reset view\n"
+        "  P            Toggle the frame profiler panel\n"
         "  Q / Esc      Quit\n",
         prog, prog, prog, DEFAULT_SHP_REL);
 }
 
 int main(int argc, char **argv)
 {
+    /* Startup time is reported after the first frame */
+    struct timespec t_start;
+    clock_gettime(CLOCK_MONOTONIC, &t_start);
+    int first_frame_done = 0;
+
     /* Load config file (optional) */
     Config cfg;
     int has_config = (config_load(&cfg) == 0 && cfg.valid);
 
+    /* --resolve FILE runs a QRZ batch and exits, no window */
+    for (int j = 1; j + 1 < argc; j++) {
+        if (strcmp(argv[j], "--resolve") == 0) {
+            int offline = cfg.offline;
+            for (int k = 1; k < argc; k++)
+                if (strcmp(argv[k], "--offline") == 0) offline = 1;
+            return resolve_callsigns(&cfg, argv[j + 1], offline);
+        }
+    }
+
     double center_lat, center_lon, target_lat, target_lon;
     const char *center_name = NULL;
     const char *target_name = NULL;
     char target_name_buf[64] = {0}; /* mutable buffer for QRZ-updated target name */
+    int  qrz_pending = 0;           /* popup lookup running on the QRZ worker */
     const char *shp_override = NULL;
+    int mem_report = 0;
+    const char *profile_path = NULL;
+    const char *targets_path = NULL;
+    int num_threads = 0;
 
     /* Determine how many positional args we have (before any -flag).
      * Negative numbers (e.g. -3.7038) are positional, not flags. */
@@ -354,6 +753,20 @@ int main(int argc, char **argv)
             detail_arg = argv[++argi];
         } else if (strcmp(argv[argi], "-s") == 0 && argi + 1 < argc) {
             shp_override = argv[++argi];
+        } else if (strcmp(argv[argi], "-m") == 0) {
+            mem_report = 1;
+        } else if (strcmp(argv[argi], "--profile") == 0 && argi + 1 < argc) {
+            profile_path = argv[++argi];
+        } else if (strcmp(argv[argi], "--threads") == 0 && argi + 1 < argc) {
+            num_threads = atoi(argv[++argi]);
+            if (num_threads < 1) {
+                fprintf(stderr, "Error: --threads needs a positive count\n");
+                return 1;
+            }
+        } else if (strcmp(argv[argi], "--offline") == 0) {
+            cfg.offline = 1;
+        } else if (strcmp(argv[argi], "--targets") == 0 && argi + 1 < argc) {
+            targets_path = argv[++argi];
         } else if (argv[argi][0] != '-' && !shp_override) {
             /* Backward compat: bare arg = shapefile path */
             shp_override = argv[argi];
@@ -376,9 +789,9 @@ int main(int argc, char **argv)
     }
 
     char default_shp[PATH_MAX], default_border[PATH_MAX], default_land[PATH_MAX], shader_dir[PATH_MAX];
-    resolve_path(exe_path, DEFAULT_SHP_REL, default_shp, sizeof(default_shp));
-    resolve_path(exe_path, DEFAULT_BORDER_REL, default_border, sizeof(default_border));
-    resolve_path(exe_path, DEFAULT_LAND_REL, default_land, sizeof(default_land));
+    resolve_ne_path(exe_path, NE_COASTLINE, default_shp, sizeof(default_shp));
+    resolve_ne_path(exe_path, NE_BORDER, default_border, sizeof(default_border));
+    resolve_ne_path(exe_path, NE_LAND, default_land, sizeof(default_land));
     resolve_path(exe_path, DEFAULT_SHADER_REL, shader_dir, sizeof(shader_dir));
 
     const char *shp_path = shp_override ? shp_override : default_shp;
@@ -395,6 +808,7 @@ int main(int argc, char **argv)
 
     /* Set up projection */
     projection_set_center(center_lat, center_lon);
+    projection_set_batch_fast(cfg.fast_projection);
 
     /* Project original center and target points */
     double cx = 0.0, cy = 0.0;  /* original center in projected space */
@@ -418,8 +832,10 @@ int main(int argc, char **argv)
     /* QRZ API init */
     int has_qrz = 0;
     if (cfg.qrz_user[0] && cfg.qrz_pass[0]) {
-        if (qrz_init(cfg.qrz_user, cfg.qrz_pass) == 0)
+        if (qrz_init(cfg.qrz_user, cfg.qrz_pass) == 0) {
             has_qrz = 1;
+            qrz_set_offline(cfg.offline);
+        }
     }
 
     /* Init GLFW */
@@ -485,26 +901,38 @@ int main(int argc, char **argv)
         return 1;
     }
 
-    /* Load map data */
-    MapData map;
-    if (map_data_load(&map, shp_path) != 0) {
+    /* Coastlines and borders go up once as raw lat/lon when GPU projection
+     * is available; otherwise they are reprojected on the CPU on every
+     * center/mode change. */
+    int gpu_proj = (cfg.gpu_projection && renderer.geo_program);
+
+    /* Frame profiler (GL_TIME_ELAPSED queries are core in GL 3.3) */
+    profiler_init(profile_path, GLEW_VERSION_3_3 || GLEW_ARB_timer_query);
+
+    /* Worker pool for projecting and clipping large layers */
+    threadpool_init(num_threads);
+
+    /* Load map data and build LOD pyramids (level chosen per frame by zoom).
+     * Preprocessed levels are cached in ~/.cache/azmap, keyed by the
+     * shapefile's size and mtime. */
+    int use_cache = cfg.geometry_cache;
+    MapLod map;
+    if (map_lod_load(&map, shp_path, 0, !gpu_proj, use_cache) != 0) {
         fprintf(stderr, "Error: failed to load shapefile: %s\n", shp_path);
         glfwTerminate();
         return 1;
     }
 
     /* Load country borders (optional) */
-    MapData borders;
-    int has_borders = (map_data_load(&borders, default_border) == 0);
+    MapLod borders;
+    int has_borders = (map_lod_load(&borders, default_border, 0, !gpu_proj, use_cache) == 0);
     if (!has_borders)
         printf("Note: country borders not found, skipping. Download ne_110m_admin_0_boundary_lines_land.\n");
 
     /* Load land polygons (optional — no segment splitting for stencil fill) */
-    MapData land;
-    int has_land = (map_data_load(&land, default_land) == 0);
-    if (has_land)
-        map_data_reproject_nosplit(&land);
-    else
+    MapLod land;
+    int has_land = (map_lod_load(&land, default_land, 1, 1, use_cache) == 0);
+    if (!has_land)
         printf("Note: land polygons not found, skipping. Download ne_110m_land.\n");
 
     /* Build grid (graticule) — mode-appropriate */
@@ -520,28 +948,25 @@ int main(int argc, char **argv)
     memset(&dist_circles, 0, sizeof(dist_circles));
     grid_build_dist_circles(&dist_circles, center_lat, center_lon);
 
-    /* Night overlay */
-    NightMesh nightmesh;
-    nightmesh_init(&nightmesh);
-
     /* MUF / Aurora / Sporadic E overlays */
     MufData muf_data;
     muf_data_init(&muf_data);
     MufData spore_data;
     muf_data_init(&spore_data);
-    AuroraGrid aurora_grid;
-    aurora_grid_init(&aurora_grid);
-    AuroraMesh aurora_mesh;
-    aurora_mesh_init(&aurora_mesh);
-    DrapGrid drap_grid;
-    drap_grid_init(&drap_grid);
-    AuroraMesh drap_mesh;
-    aurora_mesh_init(&drap_mesh);
+    HeatGrid aurora_heat;
+    heat_grid_init(&aurora_heat);
+    HeatGrid drap_heat;
+    heat_grid_init(&drap_heat);
+    float drap_peak = 0.0f;             /* peak HAF of the shown DRAP grid */
+    MufData aurora_lines, drap_lines;   /* optional isolines of the two rasters */
+    muf_data_init(&aurora_lines);
+    muf_data_init(&drap_lines);
     FetchRequest muf_fetch, aurora_fetch, spore_fetch, drap_fetch;
     memset(&muf_fetch, 0, sizeof(muf_fetch));
     memset(&aurora_fetch, 0, sizeof(aurora_fetch));
     memset(&spore_fetch, 0, sizeof(spore_fetch));
     memset(&drap_fetch, 0, sizeof(drap_fetch));
+    OverlayStream muf_stream, aurora_stream, spore_stream;  /* parsers fed by the fetches */
     int muf_active = 0, aurora_active = 0, spore_active = 0, drap_active = 0;
     int muf_fetching = 0, aurora_fetching = 0, spore_fetching = 0, drap_fetching = 0;
     time_t last_muf_fetch = 0, last_aurora_fetch = 0, last_spore_fetch = 0, last_drap_fetch = 0;
@@ -550,17 +975,72 @@ int main(int argc, char **argv)
     FetchRequest kp_fetch, bz_fetch;
     memset(&kp_fetch, 0, sizeof(kp_fetch));
     memset(&bz_fetch, 0, sizeof(bz_fetch));
+    OverlayStream kp_stream, bz_stream;
     int kp_fetching = 0, bz_fetching = 0;
+    int have_kp = 0, have_bz = 0;   /* index loaded: its refresh revalidates */
     time_t last_geomag_fetch = 0;
 
+    /* Finished MUF / Es / aurora / DRAP responses are parsed, contoured
+     * and projected on the feed builder's thread */
+    FeedBuilder feeds;
+    feedbuild_init(&feeds, cfg.spore_grid_step, cfg.aurora_contours, cfg.drap_contours);
+    if (feeds.spore.step != cfg.spore_grid_step)
+        fprintf(stderr, "Warning: spore_grid_step must be 2, 1 or 0.5; using 2\n");
+    feedbuild_set_wake(glfwPostEmptyEvent);
+
+    /* Start from the feed cache: a layer shows its last copy as soon as it
+     * is switched on, and the first refresh only revalidates it.  The
+     * builds land through the handoff queue like refreshes do. */
+    fetch_set_offline(cfg.offline);
+    {
+        OverlayStream s;
+        if (load_cached_stream(&s, OVERLAY_FEED_MUF) == 0)
+            build_stream(&feeds, FEED_BUILD_MUF, &s);
+        overlay_stream_free(&s);
+        if (load_cached_stream(&s, OVERLAY_FEED_SPORE) == 0)
+            build_stream(&feeds, FEED_BUILD_SPORE, &s);
+        overlay_stream_free(&s);
+        if (load_cached_stream(&s, OVERLAY_FEED_AURORA) == 0)
+            build_stream(&feeds, FEED_BUILD_AURORA, &s);
+        overlay_stream_free(&s);
+        if (load_cached_stream(&s, OVERLAY_FEED_KP) == 0 &&
+            !(have_kp = geomag_take_kp(&geomag, &s) == 0))
+            feedcache_drop(feed_cache[OVERLAY_FEED_KP]);
+        overlay_stream_free(&s);
+        if (load_cached_stream(&s, OVERLAY_FEED_BZ) == 0 &&
+            !(have_bz = geomag_take_bz(&geomag, &s) == 0))
+            feedcache_drop(feed_cache[OVERLAY_FEED_BZ]);
+        overlay_stream_free(&s);
+        char *text = feedcache_load("drap", NULL);
+        if (text) {
+            ProjState cur;
+            projection_get_state(&cur);
+            feedbuild_submit_text(&feeds, text, &cur);
+        }
+    }
+
     /* Upload geometry to GPU */
-    renderer_upload_map(&renderer, &map);
+    upload_coastlines(&renderer, &map, gpu_proj);
     if (has_borders)
-        renderer_upload_borders(&renderer, &borders);
+        upload_borders(&renderer, &borders, gpu_proj);
     if (has_land)
-        renderer_upload_land(&renderer, &land);
+        renderer_upload_land(&renderer, map_lod_current(&land));
     renderer_upload_grid(&renderer, &grid);
     renderer_upload_dist_circles(&renderer, &dist_circles);
+
+    if (mem_report) {
+        size_t cpu = 0, gpu = 0;
+        printf("Memory report:\n");
+        mem_report_lod("coastlines", &map, gpu_proj, &cpu, &gpu);
+        if (has_borders)
+            mem_report_lod("borders", &borders, gpu_proj, &cpu, &gpu);
+        if (has_land)
+            mem_report_lod("land", &land, 0, &cpu, &gpu);
+        mem_report_line("grid", &grid, 0, 1, &cpu, &gpu);
+        mem_report_line("dist circles", &dist_circles, 0, 1, &cpu, &gpu);
+        printf("  %-14s %42.2f MB cpu %9.2f MB gpu\n", "total",
+               cpu / (1024.0 * 1024.0), gpu / (1024.0 * 1024.0));
+    }
     {
         float gc_verts[GC_LINE_POINTS * 2];
         int gc_n = build_gc_line(center_lat, center_lon, target_lat, target_lon, gc_verts);
@@ -626,129 +1106,222 @@ int main(int argc, char **argv)
     /* Label vertex buffer (rebuilt each frame) */
     float label_verts[8192];
 
-    /* Night overlay timer (outside loop so center-dirty can reset it) */
-    time_t last_sun_update = 0;
     /* HUD text timer (outside loop so QRZ can force rebuild) */
     time_t last_text_update = 0;
 
-    /* Named pipe for IPC (swl dashboard → azMap target updates) */
+    /* IPC (swl dashboard, loggers → azMap target, station and spot
+     * updates): a Unix socket for any number of clients, and the named
+     * pipe older dashboards write to.  One reader thread serves both and
+     * wakes the main loop when updates are queued. */
     #define FIFO_PATH "/tmp/azmap-target.fifo"
-    mkfifo(FIFO_PATH, 0600); /* no-op if already exists */
-    int fifo_fd = open(FIFO_PATH, O_RDWR | O_NONBLOCK);
-    /* O_RDWR keeps fd alive even when writer closes */
-    char fifo_buf[512];
-    int fifo_buf_len = 0;
+    char ipc_path[108] = "";
+    if (strcmp(cfg.ipc_socket, "off") != 0) {
+        if (cfg.ipc_socket[0])
+            snprintf(ipc_path, sizeof(ipc_path), "%s", cfg.ipc_socket);
+        else
+            ipc_default_path(ipc_path, sizeof(ipc_path));
+    }
+    IpcServer ipc;
+    if (ipc_server_start(&ipc, ipc_path, FIFO_PATH, glfwPostEmptyEvent) != 0)
+        fprintf(stderr, "Warning: no IPC socket or %s, target updates disabled\n", FIFO_PATH);
+    else if (ipc.listen_fd >= 0)
+        printf("IPC: listening on %s\n", ipc.path);
+
+    /* WSJT-X UDP messages: decodes become spots, a logged QSO the target.
+     * The listener hands events over through a lock-free ring and wakes
+     * the main loop once per datagram burst. */
+    WsjtxListener wsjtx;
+    WsjtxEvent wsjtx_status;            /* latest Status message */
+    int wsjtx_has_status = 0;
+    if (wsjtx_listen_start(&wsjtx, cfg.wsjtx_port, cfg.wsjtx_group, glfwPostEmptyEvent) == 0)
+        printf("WSJT-X: listening on UDP %d%s%s\n", cfg.wsjtx_port,
+               cfg.wsjtx_group[0] ? ", group " : "", cfg.wsjtx_group);
+
+    /* Background completions wake the main loop out of its idle wait */
+    fetch_set_wake(glfwPostEmptyEvent);
+    fetch_init();
+    map_lod_set_wake(glfwPostEmptyEvent);
+    reproj_set_wake(glfwPostEmptyEvent);
+    if (has_qrz) qrz_set_wake(glfwPostEmptyEvent);
+
+    /* Many-target mode: spots are drawn instanced from one buffer, which
+     * is uploaded only when the set changes.  --targets callsigns are
+     * resolved as one QRZ batch and show up as their results arrive. */
+    SpotSet spots;
+    if (spots_init(&spots) != 0)
+        fprintf(stderr, "Warning: out of memory, spots disabled\n");
+    unsigned spots_uploaded = spots.version;
+    float spot_max_age = cfg.spot_max_age > 0.0 ? (float)cfg.spot_max_age : 900.0f;
+    int targets_pending = 0;        /* --targets QRZ batch running */
+    if (targets_path) {
+        char **calls;
+        int ncalls;
+        if (load_targets(targets_path, &spots, &calls, &ncalls) == 0) {
+            if (ncalls > 0 && has_qrz)
+                targets_pending = qrz_batch_submit((const char *const *)calls, ncalls) >= 0;
+            else if (ncalls > 0)
+                fprintf(stderr, "Warning: %d callsigns in %s need qrz_user and qrz_pass\n",
+                        ncalls, targets_path);
+            printf("Targets: %d spots, %d callsigns to resolve\n", spots.count,
+                   has_qrz ? ncalls : 0);
+            for (int i = 0; i < ncalls; i++) free(calls[i]);
+            free(calls);
+        }
+    }
+
+    /* Center changes are reprojected off the main thread */
+    ReprojLayers reproj_layers = {
+        .map = &map,
+        .borders = has_borders ? &borders : NULL,
+        .land = has_land ? &land : NULL,
+        .project_lines = !gpu_proj,
+        .grid = &grid,
+        .dist_circles = &dist_circles,
+        .home_lat = center_lat, .home_lon = center_lon,
+        .muf = &muf_data,
+        .spore = &spore_data,
+        .aurora_lines = &aurora_lines,
+        .drap_lines = &drap_lines,
+    };
+    Reprojector reproj;
+    reproj_init(&reproj, &reproj_layers);
+
+    /* Render on demand: what must be rebuilt / drawn this iteration, and
+     * the view the current label geometry was built for */
+    unsigned dirty = DIRTY_ALL;
+    Camera last_cam = cam;
+    int last_fb_w = -1, last_fb_h = -1, last_map_fb_w = -1;
 
     /* Main loop */
     while (!glfwWindowShouldClose(window)) {
+        /* Sleep until something happens (not part of any profiled phase) */
+        if (!dirty)
+            glfwWaitEventsTimeout(idle_wait_timeout());
+        profiler_frame_begin();
+
+        profiler_begin(PROF_EVENTS);
         glfwPollEvents();
+        if (input.redraw) {
+            input.redraw = 0;
+            dirty = DIRTY_ALL;
+        }
+        profiler_end(PROF_EVENTS);
 
-        /* Check named pipe for target updates from swl dashboard */
-        if (fifo_fd >= 0) {
-            ssize_t nr = read(fifo_fd, fifo_buf + fifo_buf_len,
-                              sizeof(fifo_buf) - 1 - fifo_buf_len);
-            if (nr > 0) {
-                fifo_buf_len += (int)nr;
-                fifo_buf[fifo_buf_len] = '\0';
-                /* Process last complete line (delimited by newline) */
-                char *last_nl = strrchr(fifo_buf, '\n');
-                if (!last_nl && fifo_buf_len >= (int)sizeof(fifo_buf) - 2) {
-                    /* Buffer full with no newline — discard to avoid stall */
-                    fifo_buf_len = 0;
-                } else if (last_nl) {
-                    *last_nl = '\0';
-                    /* Find start of last complete line */
-                    char *line = strrchr(fifo_buf, '\n');
-                    line = line ? line + 1 : fifo_buf;
-                    /* Parse "lat,lon,name|station|freq|country|site|lang|target" */
-                    double new_lat, new_lon;
-                    char new_name[64] = {0};
-                    if (sscanf(line, "%lf,%lf,", &new_lat, &new_lon) == 2) {
-                        /* Extract name after second comma (up to first '|') */
-                        char *p = strchr(line, ',');
-                        if (p) p = strchr(p + 1, ',');
-                        if (p && *(p + 1)) {
-                            p++; /* skip comma */
-                            char *pipe = strchr(p, '|');
-                            if (pipe) {
-                                size_t nlen = (size_t)(pipe - p);
-                                if (nlen >= sizeof(new_name)) nlen = sizeof(new_name) - 1;
-                                memcpy(new_name, p, nlen);
-                                new_name[nlen] = '\0';
-                                /* Parse station detail fields after first '|' */
-                                parse_station_detail(&ui, pipe + 1);
-                            } else {
-                                strncpy(new_name, p, sizeof(new_name) - 1);
-                                new_name[sizeof(new_name) - 1] = '\0';
-                            }
-                        }
-                        /* Update target */
-                        target_lat = new_lat;
-                        target_lon = new_lon;
-                        strncpy(target_name_buf, new_name, sizeof(target_name_buf) - 1);
-                        target_name_buf[sizeof(target_name_buf) - 1] = '\0';
-                        target_name = target_name_buf;
-                        build_label(target_label, sizeof(target_label),
-                                    target_name, target_lat, target_lon);
-                        update_target_geometry(center_lat, center_lon,
-                                               target_lat, target_lon,
-                                               &dist, &az_to, &az_from,
-                                               &cx, &cy, &tx, &ty,
-                                               &renderer, 1);
-                        last_text_update = 0; /* force HUD refresh */
-                    }
-                    /* Discard processed data */
-                    fifo_buf_len = 0;
+        /* Take target, station and spot updates (IPC socket clients such
+         * as the swl dashboard, and the legacy pipe).  The reader thread
+         * has parsed and coalesced them: at most one target move per frame. */
+        profiler_begin(PROF_IPC);
+        {
+            const IpcUpdate *upd;
+            int n = ipc_take(&ipc, &upd);
+            const IpcUpdate *new_target = NULL;
+            float heard = (float)glfwGetTime();
+            for (int i = 0; i < n; i++) {
+                const IpcUpdate *u = &upd[i];
+                if (u->kind == IPC_TARGET) {
+                    new_target = u;
+                } else if (u->kind == IPC_STATION) {
+                    parse_station_detail(&ui, u->detail);
+                    last_text_update = 0; /* force HUD refresh */
+                    dirty |= DIRTY_UI | DIRTY_FRAME;
+                } else if (u->kind == IPC_SPOT) {
+                    spots_add(&spots, u->key, u->lat, u->lon, u->pinned ? SPOT_PINNED : heard);
+                } else {
+                    spots_remove(&spots, u->key);
                 }
             }
+            if (new_target) {
+                target_lat = new_target->lat;
+                target_lon = new_target->lon;
+                snprintf(target_name_buf, sizeof(target_name_buf), "%s", new_target->name);
+                target_name = target_name_buf;
+                build_label(target_label, sizeof(target_label),
+                            target_name, target_lat, target_lon);
+                update_target_geometry(center_lat, center_lon,
+                                       target_lat, target_lon,
+                                       &dist, &az_to, &az_from,
+                                       &cx, &cy, &tx, &ty,
+                                       &renderer, 1);
+                last_text_update = 0; /* force HUD refresh */
+                dirty = DIRTY_ALL;
+            }
+        }
+        profiler_end(PROF_IPC);
+
+        /* Take WSJT-X events.  Stations heard with a grid become fading
+         * spots (heard again without one: refreshed); --targets spots stay
+         * pinned where QRZ put them.  A logged QSO becomes the target. */
+        profiler_begin(PROF_WSJTX);
+        {
+            WsjtxEvent ev;
+            int taken = 0;
+            float heard = (float)glfwGetTime();
+            while (wsjtx_take(&wsjtx, &ev)) {
+                taken = 1;
+                if (ev.kind == WSJTX_EV_DECODE) {
+                    int i = spots_find(&spots, ev.call);
+                    if (i >= 0 && spots.inst[i].born == SPOT_PINNED)
+                        continue;
+                    if (ev.has_pos)
+                        spots_add(&spots, ev.call, ev.lat, ev.lon, heard);
+                    else
+                        spots_touch(&spots, ev.call, heard);
+                } else if (ev.kind == WSJTX_EV_STATUS) {
+                    wsjtx_status = ev;
+                    wsjtx_has_status = 1;
+                } else if (ev.kind == WSJTX_EV_LOGGED && ev.has_pos) {
+                    target_lat = ev.lat;
+                    target_lon = ev.lon;
+                    snprintf(target_name_buf, sizeof(target_name_buf), "%s", ev.call);
+                    target_name = target_name_buf;
+                    build_label(target_label, sizeof(target_label),
+                                target_name, target_lat, target_lon);
+                    update_target_geometry(center_lat, center_lon,
+                                           target_lat, target_lon,
+                                           &dist, &az_to, &az_from,
+                                           &cx, &cy, &tx, &ty,
+                                           &renderer, 1);
+                    ui.station_info_lines = 0;
+                    snprintf(ui.station_info[ui.station_info_lines++],
+                             sizeof(ui.station_info[0]), "CALL: %s", ev.call);
+                    snprintf(ui.station_info[ui.station_info_lines++],
+                             sizeof(ui.station_info[0]), "GRID: %s", ev.grid);
+                    snprintf(ui.station_info[ui.station_info_lines++],
+                             sizeof(ui.station_info[0]), "FREQ: %.6f MHZ", ev.freq_hz / 1e6);
+                    snprintf(ui.station_info[ui.station_info_lines++],
+                             sizeof(ui.station_info[0]), "MODE: %s", ev.mode);
+                    last_text_update = 0; /* force HUD refresh */
+                    dirty = DIRTY_ALL;
+                }
+            }
+            if (taken && ui.popup.visible && strcmp(ui.popup.title, "WSJT") == 0) {
+                fill_wsjtx_popup(&ui, &wsjtx, cfg.wsjtx_port,
+                                 wsjtx_has_status ? &wsjtx_status : NULL);
+                dirty |= DIRTY_UI | DIRTY_FRAME;
+            }
         }
+        profiler_end(PROF_WSJTX);
 
-        /* Handle projection center change (drag / arrow keys) */
+        /* Projection center change (drag / arrow keys): queue it for the
+         * worker, replacing any change it has not started on yet.  Until
+         * its job is collected the previous geometry keeps being drawn. */
+        profiler_begin(PROF_REPROJECT);
         if (input.center_dirty) {
             input.center_dirty = 0;
-            projection_set_center(input.center_lat, input.center_lon);
-            reproject_all(&map, &borders, has_borders, &land, has_land, &renderer);
+            reproj_request(&reproj, input.center_lat, input.center_lon, &cam);
+        }
+        /* A click may toggle layers the worker owns: let its job finish */
+        if (reproj_collect(&reproj, ui.clicked >= 0)) {
+            apply_reprojection(&reproj, &renderer, gpu_proj, muf_active, spore_active);
             update_target_geometry(center_lat, center_lon,
                                    target_lat, target_lon,
                                    &dist, &az_to, &az_from,
                                    &cx, &cy, &tx, &ty,
                                    &renderer, 0);
             projection_forward(90.0, 0.0, &npx, &npy);
-            /* In ortho mode, grid depends on projection center */
-            if (projection_get_mode() == PROJ_ORTHO) {
-                grid_build_geo(&grid);
-                renderer_upload_grid(&renderer, &grid);
-            }
-            /* Distance circles depend on projection center */
-            grid_build_dist_circles(&dist_circles, center_lat, center_lon);
-            renderer_upload_dist_circles(&renderer, &dist_circles);
-            last_sun_update = 0; /* force night mesh rebuild */
-            /* Reproject overlays */
-            if (muf_active && muf_data.raw_count > 0) {
-                muf_reproject(&muf_data);
-                renderer_upload_muf(&renderer, &muf_data);
-            }
-            if (spore_active && spore_data.raw_count > 0) {
-                muf_reproject(&spore_data);
-                renderer_upload_spore(&renderer, &spore_data);
-            }
-            if (aurora_active && aurora_grid.valid) {
-                aurora_mesh_build(&aurora_mesh, &aurora_grid);
-                renderer_upload_aurora(&renderer, &aurora_mesh);
-            }
-            if (drap_active && drap_grid.valid) {
-                drap_mesh_build(&drap_mesh, &drap_grid);
-                renderer_upload_drap(&renderer, &drap_mesh);
-            }
+            dirty = DIRTY_ALL;
         }
-
-        /* Update marker size relative to zoom */
-        float ms = cam.zoom_km * MARKER_ZOOM_FACTOR;
-        if (dist > 0.0)
-            renderer_upload_markers(&renderer, (float)cx, (float)cy, (float)tx, (float)ty, ms);
-        else
-            renderer_upload_markers(&renderer, (float)cx, (float)cy, (float)cx, (float)cy, 0.0f);
-        renderer_upload_npole(&renderer, (float)npx, (float)npy, ms);
+        profiler_end(PROF_REPROJECT);
 
         glfwGetFramebufferSize(window, &fb_w, &fb_h);
 
@@ -764,376 +1337,458 @@ int main(int argc, char **argv)
         glViewport(0, 0, map_fb_w, fb_h);
         cam.aspect = (float)map_fb_w / (float)fb_h;
 
+        /* A resize moves everything; zoom and pan move the map-anchored
+         * labels.  Everything else that changes the view sets dirty itself. */
+        if (fb_w != last_fb_w || fb_h != last_fb_h || map_fb_w != last_map_fb_w) {
+            last_fb_w = fb_w;
+            last_fb_h = fb_h;
+            last_map_fb_w = map_fb_w;
+            last_text_update = 0;
+            dirty = DIRTY_ALL;
+        }
+        if (cam.zoom_km != last_cam.zoom_km || cam.pan_x != last_cam.pan_x ||
+            cam.pan_y != last_cam.pan_y || cam.aspect != last_cam.aspect) {
+            last_cam = cam;
+            dirty |= DIRTY_VIEW | DIRTY_FRAME;
+        }
+
+        /* Update marker size relative to zoom */
+        if (dirty & DIRTY_VIEW) {
+            float ms = cam.zoom_km * MARKER_ZOOM_FACTOR;
+            if (dist > 0.0)
+                renderer_upload_markers(&renderer, (float)cx, (float)cy, (float)tx, (float)ty, ms);
+            else
+                renderer_upload_markers(&renderer, (float)cx, (float)cy, (float)cx, (float)cy, 0.0f);
+            renderer_upload_npole(&renderer, (float)npx, (float)npy, ms);
+        }
+
+        /* Swap LOD levels for the current zoom (zoom_km spans fb_h pixels)
+         * and re-cull once the view leaves the projected area */
+        profiler_begin(PROF_LOD);
+        {
+            float km_per_px = cam.zoom_km / (float)fb_h;
+            float view_cap[4];
+            view_cap_from_camera(&cam, view_cap);
+            renderer_set_view_cap(&renderer, view_cap);
+            /* The reprojection worker owns the pyramids while it runs */
+            int lod_free = !reproj_busy(&reproj);
+            if (lod_free && map_lod_update(&map, km_per_px, view_cap)) {
+                upload_coastlines(&renderer, &map, gpu_proj);
+                dirty |= DIRTY_FRAME;
+            }
+            if (lod_free && has_borders && map_lod_update(&borders, km_per_px, view_cap)) {
+                upload_borders(&renderer, &borders, gpu_proj);
+                dirty |= DIRTY_FRAME;
+            }
+            if (lod_free && has_land && map_lod_update(&land, km_per_px, view_cap)) {
+                renderer_upload_land(&renderer, map_lod_current(&land));
+                dirty |= DIRTY_FRAME;
+            }
+        }
+        profiler_end(PROF_LOD);
+
         float mvp[16];
         camera_get_mvp(&cam, mvp);
 
-        /* Build labels at screen positions of center and target markers */
-        float label_size = 14.0f;
-        float cpx, cpy, tpx, tpy;
-        km_to_pixel(mvp, (float)cx, (float)cy, map_fb_w, fb_h, &cpx, &cpy);
-        km_to_pixel(mvp, (float)tx, (float)ty, map_fb_w, fb_h, &tpx, &tpy);
-
-        /* Center label: offset above center marker */
-        float cw = text_width(center_label, label_size);
-        float clx = cpx - cw * 0.5f;
-        float cly = cpy - label_size * 1.8f;
-        int center_vcount = text_build(center_label, clx, cly,
-            label_size, label_verts, 4096);
-        /* Target label: offset below target crosshair (only if target active) */
-        int target_vcount = 0;
-        float tw = 0, tlx = 0, tly = 0;
-        if (dist > 0.0) {
-            tw = text_width(target_label, label_size);
-            tlx = tpx - tw * 0.5f;
-            tly = tpy + label_size * 0.8f;
-            target_vcount = text_build(target_label, tlx, tly,
-                label_size, label_verts + center_vcount * 2, 4096 - center_vcount);
-        }
+        /* Marker and distance labels follow the view */
+        if (dirty & DIRTY_VIEW) {
+            /* Build labels at screen positions of center and target markers */
+            profiler_begin(PROF_LABELS);
+            float label_size = 14.0f;
+            float cpx, cpy, tpx, tpy;
+            km_to_pixel(mvp, (float)cx, (float)cy, map_fb_w, fb_h, &cpx, &cpy);
+            km_to_pixel(mvp, (float)tx, (float)ty, map_fb_w, fb_h, &tpx, &tpy);
+
+            /* Center label: offset above center marker */
+            float cw = text_width(center_label, label_size);
+            float clx = cpx - cw * 0.5f;
+            float cly = cpy - label_size * 1.8f;
+            int center_vcount = text_build(center_label, clx, cly,
+                label_size, label_verts, 4096);
+            /* Target label: offset below target crosshair (only if target active) */
+            int target_vcount = 0;
+            float tw = 0, tlx = 0, tly = 0;
+            if (dist > 0.0) {
+                tw = text_width(target_label, label_size);
+                tlx = tpx - tw * 0.5f;
+                tly = tpy + label_size * 0.8f;
+                target_vcount = text_build(target_label, tlx, tly,
+                    label_size, label_verts + center_vcount * 2, 4096 - center_vcount);
+            }
 
-        renderer_upload_labels(&renderer, label_verts, center_vcount + target_vcount, center_vcount);
+            renderer_upload_labels(&renderer, label_verts, center_vcount + target_vcount, center_vcount);
 
-        /* Label backgrounds */
-        float bg_verts[24]; /* 2 quads * 6 verts * 2 floats */
-        float pad = 4.0f;
-        int cbg = build_label_bg(clx, cly, cw, label_size, pad, bg_verts);
-        int tbg = (dist > 0.0) ? build_label_bg(tlx, tly, tw, label_size, pad, bg_verts + cbg * 2) : 0;
-        renderer_upload_label_bgs(&renderer, bg_verts, cbg + tbg, cbg);
+            /* Label backgrounds */
+            float bg_verts[24]; /* 2 quads * 6 verts * 2 floats */
+            float pad = 4.0f;
+            int cbg = build_label_bg(clx, cly, cw, label_size, pad, bg_verts);
+            int tbg = (dist > 0.0) ? build_label_bg(tlx, tly, tw, label_size, pad, bg_verts + cbg * 2) : 0;
+            renderer_upload_label_bgs(&renderer, bg_verts, cbg + tbg, cbg);
+            profiler_end(PROF_LABELS);
 
-        /* Distance circle labels — positioned at the top of each circle */
-        {
-            float dl_verts[4096];
-            int dl_count = 0;
-            double max_dist_km = EARTH_MAX_PROJ_RADIUS;
-            int num_dc = (int)(max_dist_km / DIST_CIRCLE_STEP_KM);
-            float dl_size = 11.0f;
-
-            /* For AZEQ, the top of each circle is at (0, -radius) in km-space.
-             * For ORTHO, compute the destination point at bearing=0 (north). */
-            double clat_r = center_lat * M_PI / 180.0;
-            double clon_r = center_lon * M_PI / 180.0;
-
-            for (int ri = 1; ri <= num_dc; ri++) {
-                double dkm = ri * DIST_CIRCLE_STEP_KM;
-                /* Compute geographic point due north at this distance */
-                double d = dkm / EARTH_RADIUS_KM;
-                double lat2 = asin(sin(clat_r) * cos(d) + cos(clat_r) * sin(d));
-                double lon2 = clon_r + atan2(0.0, cos(d) - sin(clat_r) * sin(lat2));
-                double px_km, py_km;
-                if (projection_forward(lat2 * 180.0 / M_PI, lon2 * 180.0 / M_PI,
-                                       &px_km, &py_km) < 0)
-                    continue;
-
-                float spx, spy;
-                km_to_pixel(mvp, (float)px_km, (float)py_km, map_fb_w, fb_h, &spx, &spy);
-
-                /* Format label: "5000 km", "10000 km", etc. */
-                char dlbl[32];
-                snprintf(dlbl, sizeof(dlbl), "%d km", (int)dkm);
-                float lw = text_width(dlbl, dl_size);
-                float lx = spx - lw * 0.5f;
-                float ly = spy - dl_size * 0.3f;
-
-                int nv = text_build(dlbl, lx, ly, dl_size,
-                                    dl_verts + dl_count * 2,
-                                    (int)(sizeof(dl_verts) / (2 * sizeof(float))) - dl_count);
-                dl_count += nv;
+            /* Distance circle labels — positioned at the top of each circle */
+            profiler_begin(PROF_DIST_LABELS);
+            {
+                float dl_verts[4096];
+                int dl_count = 0;
+                double max_dist_km = EARTH_MAX_PROJ_RADIUS;
+                int num_dc = (int)(max_dist_km / DIST_CIRCLE_STEP_KM);
+                float dl_size = 11.0f;
+
+                /* For AZEQ, the top of each circle is at (0, -radius) in km-space.
+                 * For ORTHO, compute the destination point at bearing=0 (north). */
+                double clat_r = center_lat * M_PI / 180.0;
+                double clon_r = center_lon * M_PI / 180.0;
+
+                for (int ri = 1; ri <= num_dc; ri++) {
+                    double dkm = ri * DIST_CIRCLE_STEP_KM;
+                    /* Compute geographic point due north at this distance */
+                    double d = dkm / EARTH_RADIUS_KM;
+                    double lat2 = asin(sin(clat_r) * cos(d) + cos(clat_r) * sin(d));
+                    double lon2 = clon_r + atan2(0.0, cos(d) - sin(clat_r) * sin(lat2));
+                    double px_km, py_km;
+                    if (projection_forward(lat2 * 180.0 / M_PI, lon2 * 180.0 / M_PI,
+                                           &px_km, &py_km) < 0)
+                        continue;
+
+                    float spx, spy;
+                    km_to_pixel(mvp, (float)px_km, (float)py_km, map_fb_w, fb_h, &spx, &spy);
+
+                    /* Format label: "5000 km", "10000 km", etc. */
+                    char dlbl[32];
+                    snprintf(dlbl, sizeof(dlbl), "%d km", (int)dkm);
+                    float lw = text_width(dlbl, dl_size);
+                    float lx = spx - lw * 0.5f;
+                    float ly = spy - dl_size * 0.3f;
+
+                    int nv = text_build(dlbl, lx, ly, dl_size,
+                                        dl_verts + dl_count * 2,
+                                        (int)(sizeof(dl_verts) / (2 * sizeof(float))) - dl_count);
+                    dl_count += nv;
+                }
+                renderer_upload_dist_labels(&renderer, dl_verts, dl_count);
             }
-            renderer_upload_dist_labels(&renderer, dl_verts, dl_count);
+            profiler_end(PROF_DIST_LABELS);
         }
 
-        /* Update button positions */
-        {
-            float bh = BUTTON_HEIGHT, margin = 10.0f;
-
-            /* Proj button: upper-left corner of map */
-            ui.buttons[btn_proj].x = margin;
-            ui.buttons[btn_proj].y = margin;
-
-            /* Home button: below Proj button */
-            ui.buttons[btn_home].x = margin;
-            ui.buttons[btn_home].y = margin + bh + 6.0f;
-
-            /* Sidebar buttons: positioned in full-window framebuffer coords.
-             * Layout from bottom up:
-             *   SOURCE label + line + [QRZ] [WSJT] [BCB]
-             *   LAYERS label + line + [AURORA] [SPOR.E] [MUF]
-             */
-            if (sidebar_fb_w > 0) {
-                float sb_left = (float)map_fb_w;
-                float sbw = (float)sidebar_fb_w;
-                float sb_gap = 6.0f;
-                float sb_margin = 8.0f;
-                float label_h = 16.0f;  /* section label font size */
-                float line_gap = 4.0f;  /* gap between line and buttons */
-                float section_gap = 14.0f; /* gap between sections */
-
-                /* Start from bottom */
-                float by = (float)fb_h - bh - sb_margin;
-
-                /* Bottom row: QRZ, WSJT, BCB (SOURCE section) */
-                int bottom_btns[] = { btn_opt1, btn_opt2, btn_opt3 };
-                float row_w = 0;
-                for (int i = 0; i < 3; i++) row_w += ui.buttons[bottom_btns[i]].w;
-                row_w += 2 * sb_gap;
-                float rx = sb_left + (sbw - row_w) * 0.5f;
-                for (int i = 0; i < 3; i++) {
-                    ui.buttons[bottom_btns[i]].x = rx;
-                    ui.buttons[bottom_btns[i]].y = by;
-                    rx += ui.buttons[bottom_btns[i]].w + sb_gap;
-                }
-                /* SOURCE label + line sits above the buttons */
-                ui.section_modes_y = by - line_gap - 2.0f; /* line Y (full-window) */
-                ui.section_modes_label_y = ui.section_modes_y - label_h - 8.0f;
-
-                /* Upper row: Aurora, Spor.E, MUF, DRAP (LAYERS section) */
-                by = ui.section_modes_label_y - section_gap - bh;
-                int upper_btns[] = { btn_aurora, btn_spore, btn_muf, btn_drap };
-                row_w = 0;
-                for (int i = 0; i < 4; i++) row_w += ui.buttons[upper_btns[i]].w;
-                row_w += 3 * sb_gap;
-                rx = sb_left + (sbw - row_w) * 0.5f;
-                for (int i = 0; i < 4; i++) {
-                    ui.buttons[upper_btns[i]].x = rx;
-                    ui.buttons[upper_btns[i]].y = by;
-                    rx += ui.buttons[upper_btns[i]].w + sb_gap;
+        profiler_begin(PROF_BUTTONS);
+        if (dirty & DIRTY_UI) {
+            /* Update button positions */
+            {
+                float bh = BUTTON_HEIGHT, margin = 10.0f;
+
+                /* Proj button: upper-left corner of map */
+                ui.buttons[btn_proj].x = margin;
+                ui.buttons[btn_proj].y = margin;
+
+                /* Home button: below Proj button */
+                ui.buttons[btn_home].x = margin;
+                ui.buttons[btn_home].y = margin + bh + 6.0f;
+
+                /* Sidebar buttons: positioned in full-window framebuffer coords.
+                 * Layout from bottom up:
+                 *   SOURCE label + line + [QRZ] [WSJT] [BCB]
+                 *   LAYERS label + line + [AURORA] [SPOR.E] [MUF]
+                 */
+                if (sidebar_fb_w > 0) {
+                    float sb_left = (float)map_fb_w;
+                    float sbw = (float)sidebar_fb_w;
+                    float sb_gap = 6.0f;
+                    float sb_margin = 8.0f;
+                    float label_h = 16.0f;  /* section label font size */
+                    float line_gap = 4.0f;  /* gap between line and buttons */
+                    float section_gap = 14.0f; /* gap between sections */
+
+                    /* Start from bottom */
+                    float by = (float)fb_h - bh - sb_margin;
+
+                    /* Bottom row: QRZ, WSJT, BCB (SOURCE section) */
+                    int bottom_btns[] = { btn_opt1, btn_opt2, btn_opt3 };
+                    float row_w = 0;
+                    for (int i = 0; i < 3; i++) row_w += ui.buttons[bottom_btns[i]].w;
+                    row_w += 2 * sb_gap;
+                    float rx = sb_left + (sbw - row_w) * 0.5f;
+                    for (int i = 0; i < 3; i++) {
+                        ui.buttons[bottom_btns[i]].x = rx;
+                        ui.buttons[bottom_btns[i]].y = by;
+                        rx += ui.buttons[bottom_btns[i]].w + sb_gap;
+                    }
+                    /* SOURCE label + line sits above the buttons */
+                    ui.section_modes_y = by - line_gap - 2.0f; /* line Y (full-window) */
+                    ui.section_modes_label_y = ui.section_modes_y - label_h - 8.0f;
+
+                    /* Upper row: Aurora, Spor.E, MUF, DRAP (LAYERS section) */
+                    by = ui.section_modes_label_y - section_gap - bh;
+                    int upper_btns[] = { btn_aurora, btn_spore, btn_muf, btn_drap };
+                    row_w = 0;
+                    for (int i = 0; i < 4; i++) row_w += ui.buttons[upper_btns[i]].w;
+                    row_w += 3 * sb_gap;
+                    rx = sb_left + (sbw - row_w) * 0.5f;
+                    for (int i = 0; i < 4; i++) {
+                        ui.buttons[upper_btns[i]].x = rx;
+                        ui.buttons[upper_btns[i]].y = by;
+                        rx += ui.buttons[upper_btns[i]].w + sb_gap;
+                    }
+                    /* LAYERS label + line sits above the buttons */
+                    ui.section_layers_y = by - line_gap - 2.0f;
+                    ui.section_layers_label_y = ui.section_layers_y - label_h - 8.0f;
                 }
-                /* LAYERS label + line sits above the buttons */
-                ui.section_layers_y = by - line_gap - 2.0f;
-                ui.section_layers_label_y = ui.section_layers_y - label_h - 8.0f;
             }
-        }
 
-        /* Build and upload button geometry */
-        {
-            float btn_quads[16 * 84 * 2]; /* rounded rect: ~84 verts * 2 floats per button */
-            float btn_outlines[16 * 56 * 2]; /* outline: ~56 verts * 2 floats per button */
-            float btn_text[8192];
-            int quad_count, outline_count, text_count, hovered_quad;
-            int btn_offsets[16], btn_counts[16];
-            int ol_offsets[16], ol_counts[16];
-            ui_build_geometry(&ui, btn_quads, &quad_count,
-                              btn_offsets, btn_counts,
-                              btn_outlines, &outline_count,
-                              ol_offsets, ol_counts,
-                              btn_text, &text_count, &hovered_quad);
-
-            /* Add section labels and horizontal lines to button text buffer */
-            if (sidebar_fb_w > 0) {
-                float sb_left = (float)map_fb_w;
-                float sbw = (float)sidebar_fb_w;
-                float lsz = 14.0f;  /* label font size */
-                float line_inset = 12.0f;
-
-                /* "LAYERS" label */
-                float lw = text_width("LAYERS", lsz);
-                text_count += text_build("LAYERS",
-                    sb_left + (sbw - lw) * 0.5f, ui.section_layers_label_y,
-                    lsz, btn_text + text_count * 2, 8192 - text_count);
-                /* Horizontal line below LAYERS */
-                int li = text_count * 2;
-                btn_text[li+0] = sb_left + line_inset;
-                btn_text[li+1] = ui.section_layers_y;
-                btn_text[li+2] = sb_left + sbw - line_inset;
-                btn_text[li+3] = ui.section_layers_y;
-                text_count += 2;
-
-                /* "SOURCE" label */
-                lw = text_width("SOURCE", lsz);
-                text_count += text_build("SOURCE",
-                    sb_left + (sbw - lw) * 0.5f, ui.section_modes_label_y,
-                    lsz, btn_text + text_count * 2, 8192 - text_count);
-                /* Horizontal line below SOURCE */
-                li = text_count * 2;
-                btn_text[li+0] = sb_left + line_inset;
-                btn_text[li+1] = ui.section_modes_y;
-                btn_text[li+2] = sb_left + sbw - line_inset;
-                btn_text[li+3] = ui.section_modes_y;
-                text_count += 2;
-
-                /* MUF / Spor.E contour legend above LAYERS label */
-                int have_legend = (muf_active && muf_data.legend_count > 0);
-                int have_spore_legend = (spore_active && spore_data.legend_count > 0);
-                int have_geomag = (aurora_active && geomag.valid);
-                int have_drap = (drap_active && drap_grid.valid);
-                if (have_legend || have_spore_legend || have_geomag || have_drap) {
-                    float leg_sz = 14.0f;
-                    float swatch_w = 24.0f;
-                    float gap = 6.0f;
-                    float leg_line_h = leg_sz * 1.4f;
-                    float leg_line_verts[MUF_MAX_LEGEND * 4]; /* 2 verts * 2 floats */
-                    float leg_colors[MUF_MAX_LEGEND][4];
-                    float leg_text_verts[4096];
-                    int ltvc = 0;
-                    int nc = 0;
-                    float leg_left = sb_left + line_inset;
-                    float leg_y = ui.section_layers_label_y - leg_sz - 18.0f;
-
-                    float section_gap = leg_line_h * 1.5f;
-                    float leg_right = sb_left + sbw - line_inset;
-
-                    /* Macro: separator line then title (drawn bottom-to-top,
-                     * so separator is below the title visually) */
-                    #define LEG_HEADER(title) do { \
-                        if (ltvc + 2 <= 2048) { \
-                            leg_text_verts[ltvc * 2]     = leg_left; \
-                            leg_text_verts[ltvc * 2 + 1] = leg_y + leg_line_h * 0.4f; \
-                            ltvc++; \
-                            leg_text_verts[ltvc * 2]     = leg_right; \
-                            leg_text_verts[ltvc * 2 + 1] = leg_y + leg_line_h * 0.4f; \
-                            ltvc++; \
-                        } \
-                        leg_y -= leg_line_h * 0.6f; \
-                        ltvc += text_build((title), leg_left, leg_y, \
-                                           leg_sz, leg_text_verts + ltvc * 2, \
-                                           2048 - ltvc); \
-                        leg_y -= leg_line_h * 1.2f; \
-                    } while(0)
-
-                    /* Emit colored swatch + MHz label for each legend entry */
-                    #define LEG_ENTRIES(data) do { \
-                        for (int ei = 0; ei < (data).legend_count; ei++) { \
-                            char label[16]; \
-                            if ((data).legend[ei].mhz == (int)(data).legend[ei].mhz) \
-                                snprintf(label, sizeof(label), "%.0f MHz", \
-                                         (double)(data).legend[ei].mhz); \
-                            else \
-                                snprintf(label, sizeof(label), "%.1f MHz", \
-                                         (double)(data).legend[ei].mhz); \
-                            int vi = (nc + ei) * 4; \
-                            if (vi + 3 < MUF_MAX_LEGEND * 4) { \
-                                leg_line_verts[vi + 0] = leg_left; \
-                                leg_line_verts[vi + 1] = leg_y + leg_sz * 0.5f; \
-                                leg_line_verts[vi + 2] = leg_left + swatch_w; \
-                                leg_line_verts[vi + 3] = leg_y + leg_sz * 0.5f; \
-                                memcpy(leg_colors[nc + ei], (data).legend[ei].color, \
-                                       sizeof(float) * 4); \
+            /* Build and upload button geometry */
+            {
+                float btn_quads[16 * 84 * 2]; /* rounded rect: ~84 verts * 2 floats per button */
+                float btn_outlines[16 * 56 * 2]; /* outline: ~56 verts * 2 floats per button */
+                float btn_text[8192];
+                int quad_count, outline_count, text_count, hovered_quad;
+                int btn_offsets[16], btn_counts[16];
+                int ol_offsets[16], ol_counts[16];
+                ui_build_geometry(&ui, btn_quads, &quad_count,
+                                  btn_offsets, btn_counts,
+                                  btn_outlines, &outline_count,
+                                  ol_offsets, ol_counts,
+                                  btn_text, &text_count, &hovered_quad);
+
+                /* Add section labels and horizontal lines to button text buffer */
+                if (sidebar_fb_w > 0) {
+                    float sb_left = (float)map_fb_w;
+                    float sbw = (float)sidebar_fb_w;
+                    float lsz = 14.0f;  /* label font size */
+                    float line_inset = 12.0f;
+
+                    /* "LAYERS" label */
+                    float lw = text_width("LAYERS", lsz);
+                    text_count += text_build("LAYERS",
+                        sb_left + (sbw - lw) * 0.5f, ui.section_layers_label_y,
+                        lsz, btn_text + text_count * 2, 8192 - text_count);
+                    /* Horizontal line below LAYERS */
+                    int li = text_count * 2;
+                    btn_text[li+0] = sb_left + line_inset;
+                    btn_text[li+1] = ui.section_layers_y;
+                    btn_text[li+2] = sb_left + sbw - line_inset;
+                    btn_text[li+3] = ui.section_layers_y;
+                    text_count += 2;
+
+                    /* "SOURCE" label */
+                    lw = text_width("SOURCE", lsz);
+                    text_count += text_build("SOURCE",
+                        sb_left + (sbw - lw) * 0.5f, ui.section_modes_label_y,
+                        lsz, btn_text + text_count * 2, 8192 - text_count);
+                    /* Horizontal line below SOURCE */
+                    li = text_count * 2;
+                    btn_text[li+0] = sb_left + line_inset;
+                    btn_text[li+1] = ui.section_modes_y;
+                    btn_text[li+2] = sb_left + sbw - line_inset;
+                    btn_text[li+3] = ui.section_modes_y;
+                    text_count += 2;
+
+                    /* MUF / Spor.E contour legend above LAYERS label */
+                    int have_legend = (muf_active && muf_data.legend_count > 0);
+                    int have_spore_legend = (spore_active && spore_data.legend_count > 0);
+                    int have_geomag = (aurora_active && geomag.valid);
+                    int have_drap = (drap_active && drap_heat.texels);
+                    if (have_legend || have_spore_legend || have_geomag || have_drap) {
+                        float leg_sz = 14.0f;
+                        float swatch_w = 24.0f;
+                        float gap = 6.0f;
+                        float leg_line_h = leg_sz * 1.4f;
+                        float leg_line_verts[MUF_MAX_LEGEND * 4]; /* 2 verts * 2 floats */
+                        float leg_colors[MUF_MAX_LEGEND][4];
+                        float leg_text_verts[4096];
+                        int ltvc = 0;
+                        int nc = 0;
+                        float leg_left = sb_left + line_inset;
+                        float leg_y = ui.section_layers_label_y - leg_sz - 18.0f;
+
+                        float section_gap = leg_line_h * 1.5f;
+                        float leg_right = sb_left + sbw - line_inset;
+
+                        /* Macro: separator line then title (drawn bottom-to-top,
+                         * so separator is below the title visually) */
+                        #define LEG_HEADER(title) do { \
+                            if (ltvc + 2 <= 2048) { \
+                                leg_text_verts[ltvc * 2]     = leg_left; \
+                                leg_text_verts[ltvc * 2 + 1] = leg_y + leg_line_h * 0.4f; \
+                                ltvc++; \
+                                leg_text_verts[ltvc * 2]     = leg_right; \
+                                leg_text_verts[ltvc * 2 + 1] = leg_y + leg_line_h * 0.4f; \
+                                ltvc++; \
                             } \
-                            ltvc += text_build(label, leg_left + swatch_w + gap, leg_y, \
+                            leg_y -= leg_line_h * 0.6f; \
+                            ltvc += text_build((title), leg_left, leg_y, \
                                                leg_sz, leg_text_verts + ltvc * 2, \
                                                2048 - ltvc); \
-                            leg_y -= leg_line_h; \
-                        } \
-                        nc += (data).legend_count; \
-                    } while(0)
-
-                    /* Sections build bottom-to-top (leg_y decreases = moves up).
-                     * Within each section: entries first (bottom), then header (top).
-                     * Section order: MUF (bottom), foEs (middle), GEOMAG (top). */
-
-                    /* MUF legend entries (bottom section, closest to LAYERS) */
-                    if (have_legend) {
-                        LEG_ENTRIES(muf_data);
-                        LEG_HEADER("MUF");
-                        if (have_spore_legend || have_geomag)
-                            leg_y -= section_gap;
-                    }
+                            leg_y -= leg_line_h * 1.2f; \
+                        } while(0)
+
+                        /* Emit colored swatch + MHz label for each legend entry */
+                        #define LEG_ENTRIES(data) do { \
+                            for (int ei = 0; ei < (data).legend_count; ei++) { \
+                                char label[16]; \
+                                if ((data).legend[ei].mhz == (int)(data).legend[ei].mhz) \
+                                    snprintf(label, sizeof(label), "%.0f MHz", \
+                                             (double)(data).legend[ei].mhz); \
+                                else \
+                                    snprintf(label, sizeof(label), "%.1f MHz", \
+                                             (double)(data).legend[ei].mhz); \
+                                int vi = (nc + ei) * 4; \
+                                if (vi + 3 < MUF_MAX_LEGEND * 4) { \
+                                    leg_line_verts[vi + 0] = leg_left; \
+                                    leg_line_verts[vi + 1] = leg_y + leg_sz * 0.5f; \
+                                    leg_line_verts[vi + 2] = leg_left + swatch_w; \
+                                    leg_line_verts[vi + 3] = leg_y + leg_sz * 0.5f; \
+                                    memcpy(leg_colors[nc + ei], (data).legend[ei].color, \
+                                           sizeof(float) * 4); \
+                                } \
+                                ltvc += text_build(label, leg_left + swatch_w + gap, leg_y, \
+                                                   leg_sz, leg_text_verts + ltvc * 2, \
+                                                   2048 - ltvc); \
+                                leg_y -= leg_line_h; \
+                            } \
+                            nc += (data).legend_count; \
+                        } while(0)
+
+                        /* Sections build bottom-to-top (leg_y decreases = moves up).
+                         * Within each section: entries first (bottom), then header (top).
+                         * Section order: MUF (bottom), foEs (middle), GEOMAG (top). */
+
+                        /* MUF legend entries (bottom section, closest to LAYERS) */
+                        if (have_legend) {
+                            LEG_ENTRIES(muf_data);
+                            LEG_HEADER("MUF");
+                            if (have_spore_legend || have_geomag)
+                                leg_y -= section_gap;
+                        }
 
-                    /* Sporadic E legend entries (middle section) */
-                    if (have_spore_legend) {
-                        LEG_ENTRIES(spore_data);
-                        LEG_HEADER("foEs");
-                        if (have_geomag || have_drap)
-                            leg_y -= section_gap;
-                    }
+                        /* Sporadic E legend entries (middle section) */
+                        if (have_spore_legend) {
+                            LEG_ENTRIES(spore_data);
+                            LEG_HEADER("foEs");
+                            if (have_geomag || have_drap)
+                                leg_y -= section_gap;
+                        }
 
-                    /* Kp/Bz indices */
-                    if (have_geomag) {
-                        char kp_label[32], bz_label[32];
-                        snprintf(kp_label, sizeof(kp_label), "Kp %.1f",
-                                 (double)geomag.kp);
-                        snprintf(bz_label, sizeof(bz_label), "Bz %.1f nT",
-                                 (double)geomag.bz);
-                        ltvc += text_build(bz_label, leg_left, leg_y,
-                                           leg_sz, leg_text_verts + ltvc * 2,
-                                           2048 - ltvc);
-                        leg_y -= leg_line_h;
-                        ltvc += text_build(kp_label, leg_left, leg_y,
-                                           leg_sz, leg_text_verts + ltvc * 2,
-                                           2048 - ltvc);
-                        leg_y -= leg_line_h;
-
-                        LEG_HEADER("GEOMAG");
-                        if (have_drap)
-                            leg_y -= section_gap;
-                    }
+                        /* Kp/Bz indices */
+                        if (have_geomag) {
+                            char kp_label[32], bz_label[32];
+                            snprintf(kp_label, sizeof(kp_label), "Kp %.1f",
+                                     (double)geomag.kp);
+                            snprintf(bz_label, sizeof(bz_label), "Bz %.1f nT",
+                                     (double)geomag.bz);
+                            ltvc += text_build(bz_label, leg_left, leg_y,
+                                               leg_sz, leg_text_verts + ltvc * 2,
+                                               2048 - ltvc);
+                            leg_y -= leg_line_h;
+                            ltvc += text_build(kp_label, leg_left, leg_y,
+                                               leg_sz, leg_text_verts + ltvc * 2,
+                                               2048 - ltvc);
+                            leg_y -= leg_line_h;
+
+                            LEG_HEADER("GEOMAG");
+                            if (have_drap)
+                                leg_y -= section_gap;
+                        }
 
-                    /* DRAP absorption (top section) */
-                    if (have_drap) {
-                        char haf_label[32];
-                        snprintf(haf_label, sizeof(haf_label), "HAF %.1f MHz",
-                                 (double)drap_grid.peak_mhz);
-                        ltvc += text_build(haf_label, leg_left, leg_y,
-                                           leg_sz, leg_text_verts + ltvc * 2,
-                                           2048 - ltvc);
-                        leg_y -= leg_line_h;
-
-                        LEG_HEADER("DRAP");
-                    }
+                        /* DRAP absorption (top section) */
+                        if (have_drap) {
+                            char haf_label[32];
+                            snprintf(haf_label, sizeof(haf_label), "HAF %.1f MHz",
+                                     (double)drap_peak);
+                            ltvc += text_build(haf_label, leg_left, leg_y,
+                                               leg_sz, leg_text_verts + ltvc * 2,
+                                               2048 - ltvc);
+                            leg_y -= leg_line_h;
+
+                            LEG_HEADER("DRAP");
+                        }
 
-                    #undef LEG_ENTRIES
-                    #undef LEG_HEADER
+                        #undef LEG_ENTRIES
+                        #undef LEG_HEADER
 
-                    renderer_upload_legend(&renderer, leg_line_verts, leg_colors,
-                                           nc, leg_text_verts, ltvc);
-                } else {
-                    renderer.legend_line_count = 0;
-                    renderer.legend_text_vertex_count = 0;
+                        renderer_upload_legend(&renderer, leg_line_verts, leg_colors,
+                                               nc, leg_text_verts, ltvc);
+                    } else {
+                        renderer.legend_line_count = 0;
+                        renderer.legend_text_vertex_count = 0;
+                    }
                 }
-            }
 
-            /* Compute active button mask (bitmask by visible-button index) */
-            unsigned int active_mask = 0;
-            {
-                int vis = 0;
-                for (int bi = 0; bi < ui.count; bi++) {
-                    if (!ui.buttons[bi].visible) continue;
-                    if ((bi == btn_proj && projection_get_mode() == PROJ_ORTHO) ||
-                        (bi == btn_aurora && aurora_active) ||
-                        (bi == btn_spore && spore_active) ||
-                        (bi == btn_muf && muf_active) ||
-                        (bi == btn_drap && drap_active))
-                        active_mask |= (1u << vis);
-                    vis++;
+                /* Compute active button mask (bitmask by visible-button index) */
+                unsigned int active_mask = 0;
+                {
+                    int vis = 0;
+                    for (int bi = 0; bi < ui.count; bi++) {
+                        if (!ui.buttons[bi].visible) continue;
+                        if ((bi == btn_proj && projection_get_mode() == PROJ_ORTHO) ||
+                            (bi == btn_aurora && aurora_active) ||
+                            (bi == btn_spore && spore_active) ||
+                            (bi == btn_muf && muf_active) ||
+                            (bi == btn_drap && drap_active))
+                            active_mask |= (1u << vis);
+                        vis++;
+                    }
                 }
+                /* Count visible buttons */
+                int nvis = 0;
+                for (int bi = 0; bi < ui.count; bi++)
+                    if (ui.buttons[bi].visible) nvis++;
+                if (quad_count > 0 || text_count > 0)
+                    renderer_upload_buttons(&renderer, btn_quads, quad_count,
+                                            btn_offsets, btn_counts,
+                                            btn_outlines, outline_count,
+                                            ol_offsets, ol_counts,
+                                            btn_text, text_count,
+                                            nvis, hovered_quad, active_mask);
+            }
+
+            /* Build and upload popup geometry */
+            if (ui.popup.visible) {
+                float popup_quads[5 * 12]; /* up to 5 quads * 6 verts * 2 floats */
+                float popup_text[8192];
+                int pq_count, pt_count;
+                ui_build_popup_geometry(&ui, map_fb_w, fb_h,
+                                        popup_quads, &pq_count,
+                                        popup_text, &pt_count);
+                renderer_upload_popup(&renderer, popup_quads, pq_count,
+                                      popup_text, pt_count,
+                                      ui.popup_close_hovered);
+            } else {
+                renderer.popup_bg_vertex_count = 0;
+                renderer.popup_text_vertex_count = 0;
             }
-            /* Count visible buttons */
-            int nvis = 0;
-            for (int bi = 0; bi < ui.count; bi++)
-                if (ui.buttons[bi].visible) nvis++;
-            if (quad_count > 0 || text_count > 0)
-                renderer_upload_buttons(&renderer, btn_quads, quad_count,
-                                        btn_offsets, btn_counts,
-                                        btn_outlines, outline_count,
-                                        ol_offsets, ol_counts,
-                                        btn_text, text_count,
-                                        nvis, hovered_quad, active_mask);
         }
 
-        /* Build and upload popup geometry */
-        if (ui.popup.visible) {
-            float popup_quads[5 * 12]; /* up to 5 quads * 6 verts * 2 floats */
-            float popup_text[8192];
-            int pq_count, pt_count;
-            ui_build_popup_geometry(&ui, map_fb_w, fb_h,
-                                    popup_quads, &pq_count,
-                                    popup_text, &pt_count);
-            renderer_upload_popup(&renderer, popup_quads, pq_count,
-                                  popup_text, pt_count,
-                                  ui.popup_close_hovered);
+        /* Profiler panel (top-right corner of the map, refreshed a few
+         * times per second) */
+        if (profiler_panel_visible()) {
+            static float prof_text[16384];
+            float prof_bg[12];
+            int pn = profiler_build_panel((float)map_fb_w - 10.0f, 10.0f,
+                                          prof_text, 8192, prof_bg);
+            if (pn >= 0) {
+                renderer_upload_profile(&renderer, prof_bg, prof_text, pn);
+                dirty |= DIRTY_FRAME;
+            }
         } else {
-            renderer.popup_bg_vertex_count = 0;
-            renderer.popup_text_vertex_count = 0;
+            renderer.prof_text_vertex_count = 0;
         }
+        profiler_end(PROF_BUTTONS);
 
         /* Poll button clicks */
+        profiler_begin(PROF_ACTIONS);
         if (ui.clicked >= 0) {
             printf("Button clicked: %s\n", ui.buttons[ui.clicked].label);
             if (ui.clicked == btn_proj) {
                 /* Toggle projection mode */
                 ProjMode cur = projection_get_mode();
                 ProjMode nxt = (cur == PROJ_AZEQ) ? PROJ_ORTHO : PROJ_AZEQ;
+                /* No job is running (clicks are collected above); rebuild
+                 * everything for the new mode at the latest center now */
                 projection_set_mode(nxt);
-                reproject_all(&map, &borders, has_borders, &land, has_land, &renderer);
+                reproj_request(&reproj, input.center_lat, input.center_lon, &cam);
+                reproj_kick(&reproj);
+                reproj_collect(&reproj, 1);
+                apply_reprojection(&reproj, &renderer, gpu_proj, muf_active, spore_active);
                 /* Re-project key points */
                 update_target_geometry(center_lat, center_lon,
                                        target_lat, target_lon,
@@ -1141,42 +1796,15 @@ int main(int argc, char **argv)
                                        &cx, &cy, &tx, &ty,
                                        &renderer, 0);
                 projection_forward(90.0, 0.0, &npx, &npy);
-                /* Rebuild grid for new mode */
-                if (nxt == PROJ_ORTHO)
-                    grid_build_geo(&grid);
-                else
-                    grid_build(&grid);
-                renderer_upload_grid(&renderer, &grid);
-                /* Rebuild distance circles for new mode */
-                grid_build_dist_circles(&dist_circles, center_lat, center_lon);
-                renderer_upload_dist_circles(&renderer, &dist_circles);
                 /* Rebuild earth circle and disc */
                 renderer_upload_earth_circle(&renderer, projection_get_radius());
-                /* Force night mesh rebuild */
-                last_sun_update = 0;
-                /* Reproject overlays */
-                if (muf_active && muf_data.raw_count > 0) {
-                    muf_reproject(&muf_data);
-                    renderer_upload_muf(&renderer, &muf_data);
-                }
-                if (spore_active && spore_data.raw_count > 0) {
-                    muf_reproject(&spore_data);
-                    renderer_upload_spore(&renderer, &spore_data);
-                }
-                if (aurora_active && aurora_grid.valid) {
-                    aurora_mesh_build(&aurora_mesh, &aurora_grid);
-                    renderer_upload_aurora(&renderer, &aurora_mesh);
-                }
-                if (drap_active && drap_grid.valid) {
-                    drap_mesh_build(&drap_mesh, &drap_grid);
-                    renderer_upload_drap(&renderer, &drap_mesh);
-                }
                 /* Clamp zoom */
                 double max_diam = 2.0 * projection_get_radius();
                 if (cam.zoom_km > (float)max_diam)
                     cam.zoom_km = (float)max_diam;
             } else if (ui.clicked == btn_opt1) {
                 /* QRZ: clear info, open callsign lookup popup */
+                qrz_pending = 0;
                 clear_target_state(&ui, &dist, &az_to, &az_from,
                                    &renderer, &last_text_update);
                 if (!has_qrz) {
@@ -1189,10 +1817,13 @@ int main(int argc, char **argv)
                     ui_show_popup(&ui, "QRZ LOOKUP");
                 }
             } else if (ui.clicked == btn_opt2) {
-                /* WSJT: clear info, show popup */
+                /* WSJT: clear info, show listener status */
+                qrz_pending = 0;
                 clear_target_state(&ui, &dist, &az_to, &az_from,
                                    &renderer, &last_text_update);
                 ui_show_popup(&ui, "WSJT");
+                fill_wsjtx_popup(&ui, &wsjtx, cfg.wsjtx_port,
+                                 wsjtx_has_status ? &wsjtx_status : NULL);
             } else if (ui.clicked == btn_opt3) {
                 /* BCB: just clear info */
                 clear_target_state(&ui, &dist, &az_to, &az_from,
@@ -1200,27 +1831,31 @@ int main(int argc, char **argv)
             } else if (ui.clicked == btn_aurora) {
                 aurora_active = !aurora_active;
                 if (aurora_active) {
-                    if (aurora_grid.valid) {
+                    if (aurora_heat.texels) {
                         /* Re-upload existing data */
-                        aurora_mesh_build(&aurora_mesh, &aurora_grid);
-                        renderer_upload_aurora(&renderer, &aurora_mesh);
+                        show_aurora(&renderer, &aurora_heat, &aurora_lines);
                     } else if (!aurora_fetching) {
-                        fetch_start(&aurora_fetch, AURORA_URL);
+                        start_stream(&aurora_fetch, &aurora_stream, OVERLAY_FEED_AURORA, AURORA_URL, 0);
                         aurora_fetching = 1;
                         last_aurora_fetch = time(NULL);
                     }
                     /* Fetch Kp/Bz indices if not already fetched */
                     if (!geomag.valid && !kp_fetching) {
-                        fetch_start(&kp_fetch, KP_URL);
+                        start_stream(&kp_fetch, &kp_stream, OVERLAY_FEED_KP, KP_URL, 0);
                         kp_fetching = 1;
                     }
                     if (!geomag.valid && !bz_fetching) {
-                        fetch_start(&bz_fetch, BZ_URL);
+                        start_stream(&bz_fetch, &bz_stream, OVERLAY_FEED_BZ, BZ_URL, 0);
                         bz_fetching = 1;
                     }
                     last_geomag_fetch = time(NULL);
                 } else {
-                    renderer.aurora_vertex_count = 0;
+                    renderer_clear_aurora(&renderer);
+                    cancel_fetch(&aurora_fetch, &aurora_stream, &aurora_fetching,
+                                 &last_aurora_fetch);
+                    cancel_fetch(&kp_fetch, &kp_stream, &kp_fetching, &last_geomag_fetch);
+                    cancel_fetch(&bz_fetch, &bz_stream, &bz_fetching, &last_geomag_fetch);
+                    renderer_clear_aurora_lines(&renderer);
                 }
             } else if (ui.clicked == btn_muf) {
                 muf_active = !muf_active;
@@ -1229,12 +1864,13 @@ int main(int argc, char **argv)
                         /* Re-upload existing data */
                         renderer_upload_muf(&renderer, &muf_data);
                     } else if (!muf_fetching) {
-                        fetch_start(&muf_fetch, MUF_URL);
+                        start_stream(&muf_fetch, &muf_stream, OVERLAY_FEED_MUF, MUF_URL, 0);
                         muf_fetching = 1;
                         last_muf_fetch = time(NULL);
                     }
                 } else {
-                    renderer.muf_num_segments = 0;
+                    renderer_clear_muf(&renderer);
+                    cancel_fetch(&muf_fetch, &muf_stream, &muf_fetching, &last_muf_fetch);
                 }
             } else if (ui.clicked == btn_spore) {
                 spore_active = !spore_active;
@@ -1242,26 +1878,29 @@ int main(int argc, char **argv)
                     if (spore_data.raw_count > 0) {
                         renderer_upload_spore(&renderer, &spore_data);
                     } else if (!spore_fetching) {
-                        fetch_start(&spore_fetch, SPORE_URL);
+                        start_stream(&spore_fetch, &spore_stream, OVERLAY_FEED_SPORE, SPORE_URL, 0);
                         spore_fetching = 1;
                         last_spore_fetch = time(NULL);
                     }
                 } else {
-                    renderer.spore_num_segments = 0;
+                    renderer_clear_spore(&renderer);
+                    cancel_fetch(&spore_fetch, &spore_stream, &spore_fetching,
+                                 &last_spore_fetch);
                 }
             } else if (ui.clicked == btn_drap) {
                 drap_active = !drap_active;
                 if (drap_active) {
-                    if (drap_grid.valid) {
-                        drap_mesh_build(&drap_mesh, &drap_grid);
-                        renderer_upload_drap(&renderer, &drap_mesh);
+                    if (drap_heat.texels) {
+                        show_drap(&renderer, &drap_heat, &drap_lines);
                     } else if (!drap_fetching) {
-                        fetch_start(&drap_fetch, DRAP_URL);
+                        fetch_start_cached(&drap_fetch, DRAP_URL, "drap", 0, NULL, NULL);
                         drap_fetching = 1;
                         last_drap_fetch = time(NULL);
                     }
                 } else {
-                    renderer.drap_vertex_count = 0;
+                    renderer_clear_drap(&renderer);
+                    cancel_fetch(&drap_fetch, NULL, &drap_fetching, &last_drap_fetch);
+                    renderer_clear_drap_lines(&renderer);
                 }
             } else if (ui.clicked == btn_home) {
                 /* Recenter map on original location, keep zoom level */
@@ -1272,68 +1911,121 @@ int main(int argc, char **argv)
                 cam.pan_y = 0.0f;
             }
             ui.clicked = -1;
+            dirty = DIRTY_ALL;
         }
 
-        /* Handle QRZ popup submission */
+        /* Handle QRZ popup submission: a cached callsign is answered at
+         * once, others are looked up on the QRZ worker while the popup
+         * shows a pending line */
+        int qrz_status = 0;             /* 1 = result, -1 = error */
+        QRZResult qrz_result;
+        char err_buf[128] = "";
         if (ui.popup_submitted) {
             ui.popup_submitted = 0;
-            QRZResult qrz_result;
-            char err_buf[128];
-            if (qrz_lookup(ui.popup_input, &qrz_result, err_buf, sizeof(err_buf)) == 0
-                && qrz_result.valid) {
-                /* Update target */
-                target_lat = qrz_result.lat;
-                target_lon = qrz_result.lon;
-                strncpy(target_name_buf, qrz_result.call, sizeof(target_name_buf) - 1);
-                target_name = target_name_buf;
-                build_label(target_label, sizeof(target_label),
-                            target_name, target_lat, target_lon);
-                update_target_geometry(center_lat, center_lon,
-                                       target_lat, target_lon,
-                                       &dist, &az_to, &az_from,
-                                       &cx, &cy, &tx, &ty,
-                                       &renderer, 1);
-                /* Close popup and show results in sidebar */
-                ui_hide_popup(&ui);
-                last_text_update = 0;
+            dirty = DIRTY_ALL;
+            int q = qrz_lookup_async(ui.popup_input, &qrz_result);
+            if (q == 1) {
+                qrz_status = 1;
+                qrz_pending = 0;
+            } else if (q == 0) {
+                qrz_pending = 1;
+                char call[32];
+                qrz_normalize(ui.popup_input, call, sizeof(call));
+                snprintf(ui.popup_result[0], sizeof(ui.popup_result[0]),
+                         "LOOKING UP %s...", call);
+                ui.popup_result_lines = 1;
+            } else {
+                qrz_pending = 0;
+                qrz_status = -1;
+                snprintf(err_buf, sizeof(err_buf), "ENTER A CALLSIGN");
+            }
+        }
+        if (qrz_pending && !ui.popup.visible)
+            qrz_pending = 0;            /* popup closed: drop the result */
+        if (qrz_pending) {
+            int q = qrz_poll(&qrz_result, err_buf, sizeof(err_buf));
+            if (q != 0) {
+                qrz_pending = 0;
+                qrz_status = q;
+                dirty = DIRTY_ALL;
+            }
+        }
+        if (qrz_status == 1 && qrz_result.valid) {
+            /* Update target */
+            target_lat = qrz_result.lat;
+            target_lon = qrz_result.lon;
+            strncpy(target_name_buf, qrz_result.call, sizeof(target_name_buf) - 1);
+            target_name = target_name_buf;
+            build_label(target_label, sizeof(target_label),
+                        target_name, target_lat, target_lon);
+            update_target_geometry(center_lat, center_lon,
+                                   target_lat, target_lon,
+                                   &dist, &az_to, &az_from,
+                                   &cx, &cy, &tx, &ty,
+                                   &renderer, 1);
+            /* Close popup and show results in sidebar */
+            ui_hide_popup(&ui);
+            last_text_update = 0;
 
-                /* Fill station_info for sidebar display */
-                ui.station_info_lines = 0;
+            /* Fill station_info for sidebar display */
+            ui.station_info_lines = 0;
+            snprintf(ui.station_info[ui.station_info_lines++],
+                     sizeof(ui.station_info[0]), "CALL: %s", qrz_result.call);
+            {
+                char upper[40];
+                str_upper(upper, sizeof(upper), qrz_result.name);
                 snprintf(ui.station_info[ui.station_info_lines++],
-                         sizeof(ui.station_info[0]), "CALL: %s", qrz_result.call);
-                {
-                    char upper[40];
-                    str_upper(upper, sizeof(upper), qrz_result.name);
-                    snprintf(ui.station_info[ui.station_info_lines++],
-                             sizeof(ui.station_info[0]), "NAME: %s", upper);
-                    str_upper(upper, sizeof(upper), qrz_result.location);
-                    snprintf(ui.station_info[ui.station_info_lines++],
-                             sizeof(ui.station_info[0]), "LOC: %s", upper);
-                    char upper_grid[16];
-                    str_upper(upper_grid, sizeof(upper_grid), qrz_result.grid);
-                    snprintf(ui.station_info[ui.station_info_lines++],
-                             sizeof(ui.station_info[0]), "GRID: %s", upper_grid);
-                    char coord[64];
-                    format_coord(coord, sizeof(coord), qrz_result.lat, qrz_result.lon);
-                    snprintf(ui.station_info[ui.station_info_lines++],
-                             sizeof(ui.station_info[0]), "%.47s", coord);
-                }
-            } else {
-                /* Error */
-                str_upper(ui.popup_result[0], sizeof(ui.popup_result[0]), err_buf);
-                ui.popup_result_lines = 1;
+                         sizeof(ui.station_info[0]), "NAME: %s", upper);
+                str_upper(upper, sizeof(upper), qrz_result.location);
+                snprintf(ui.station_info[ui.station_info_lines++],
+                         sizeof(ui.station_info[0]), "LOC: %s", upper);
+                char upper_grid[16];
+                str_upper(upper_grid, sizeof(upper_grid), qrz_result.grid);
+                snprintf(ui.station_info[ui.station_info_lines++],
+                         sizeof(ui.station_info[0]), "GRID: %s", upper_grid);
+                char coord[64];
+                format_coord(coord, sizeof(coord), qrz_result.lat, qrz_result.lon);
+                snprintf(ui.station_info[ui.station_info_lines++],
+                         sizeof(ui.station_info[0]), "%.47s", coord);
+            }
+        } else if (qrz_status != 0) {
+            /* Error */
+            if (qrz_status == 1)
+                snprintf(err_buf, sizeof(err_buf), "NO LOCATION FOR %s", qrz_result.call);
+            str_upper(ui.popup_result[0], sizeof(ui.popup_result[0]), err_buf);
+            ui.popup_result_lines = 1;
+        }
+
+        /* Resolved --targets callsigns become spots (stats first: with
+         * nothing pending, every result is already queued) */
+        if (targets_pending) {
+            QRZBatchStats st;
+            QRZBatchResult br;
+            qrz_batch_stats(&st);
+            while (qrz_batch_take(&br))
+                if (br.status == 1 && br.result.valid)
+                    spots_add(&spots, br.call, br.result.lat, br.result.lon, SPOT_PINNED);
+            if (st.pending == 0) {
+                targets_pending = 0;
+                printf("Targets: %d spots (%d resolved, %d cached, %d failed)\n",
+                       spots.count, st.resolved, st.cache_hits, st.failed);
             }
         }
 
-        /* Force text rebuild every frame when popup input is active (cursor blink) */
-        if (ui.popup.visible && ui.popup_input_active)
+        profiler_end(PROF_ACTIONS);
+
+        /* Force text rebuild when popup input changed */
+        if (ui.popup.visible && ui.popup_input_active && (dirty & DIRTY_UI))
             last_text_update = 0;
 
         /* Rebuild HUD text every second */
+        profiler_begin(PROF_HUD);
         {
             time_t now = time(NULL);
             if (now != last_text_update) {
                 last_text_update = now;
+                dirty |= DIRTY_FRAME;
+                spots_expire(&spots, (float)glfwGetTime(), spot_max_age);
                 struct tm gt_buf, lt_buf;
                 struct tm *gt = gmtime_r(&now, &gt_buf);
                 struct tm *lt = localtime_r(&now, &lt_buf);
@@ -1417,125 +2109,157 @@ int main(int argc, char **argv)
                 }
             }
         }
-
-        /* Update night overlay periodically */
-        {
-            time_t now = time(NULL);
-            if (now - last_sun_update >= NIGHT_UPDATE_SEC) {
-                last_sun_update = now;
-                SubsolarPoint sun = solar_subsolar_point(now);
-                nightmesh_build(&nightmesh, &sun);
-                renderer_upload_night(&renderer, nightmesh.vertices,
-                                      nightmesh.vertex_count);
-            }
-        }
+        profiler_end(PROF_HUD);
 
         /* MUF / Aurora overlay: poll fetches and auto-refresh */
+        profiler_begin(PROF_OVERLAYS);
         {
             time_t now = time(NULL);
 
-            /* Poll MUF fetch completion */
+            /* Poll overlay fetch completion: a complete response goes to
+             * the feed builder, its result is taken below */
             if (muf_fetching) {
                 int s = fetch_check(&muf_fetch);
                 if (s != 0) {
+                    profiler_fetch("muf", s, muf_fetch.ms,
+                                   muf_fetch.wire_bytes, muf_fetch.body_bytes);
                     muf_fetching = 0;
-                    if (s == 1) {
-                        char *json = fetch_take_response(&muf_fetch);
-                        if (json) {
-                            muf_data_free(&muf_data);
-                            muf_data_init(&muf_data);
-                            muf_parse_geojson(json, &muf_data);
-                            free(json);
-                            if (muf_active && muf_data.num_segments > 0)
-                                renderer_upload_muf(&renderer, &muf_data);
-                        }
-                    }
+                    dirty |= DIRTY_UI | DIRTY_FRAME;
+                    if (s == 1)
+                        build_stream(&feeds, FEED_BUILD_MUF, &muf_stream);
+                    overlay_stream_free(&muf_stream);
                     fetch_cleanup(&muf_fetch);
                 }
             }
 
-            /* Poll Sporadic E fetch completion */
             if (spore_fetching) {
                 int s = fetch_check(&spore_fetch);
                 if (s != 0) {
+                    profiler_fetch("spore", s, spore_fetch.ms,
+                                   spore_fetch.wire_bytes, spore_fetch.body_bytes);
                     spore_fetching = 0;
-                    if (s == 1) {
-                        char *json = fetch_take_response(&spore_fetch);
-                        if (json) {
-                            muf_data_free(&spore_data);
-                            muf_data_init(&spore_data);
-                            spore_parse_json(json, &spore_data);
-                            free(json);
-                            if (spore_active && spore_data.num_segments > 0)
-                                renderer_upload_spore(&renderer, &spore_data);
-                        }
-                    }
+                    dirty |= DIRTY_UI | DIRTY_FRAME;
+                    if (s == 1)
+                        build_stream(&feeds, FEED_BUILD_SPORE, &spore_stream);
+                    overlay_stream_free(&spore_stream);
                     fetch_cleanup(&spore_fetch);
                 }
             }
 
-            /* Poll aurora fetch completion */
             if (aurora_fetching) {
                 int s = fetch_check(&aurora_fetch);
                 if (s != 0) {
+                    profiler_fetch("aurora", s, aurora_fetch.ms,
+                                   aurora_fetch.wire_bytes, aurora_fetch.body_bytes);
                     aurora_fetching = 0;
-                    if (s == 1) {
-                        char *json = fetch_take_response(&aurora_fetch);
-                        if (json) {
-                            aurora_parse_json(json, &aurora_grid);
-                            free(json);
-                            if (aurora_active && aurora_grid.valid) {
-                                aurora_mesh_build(&aurora_mesh, &aurora_grid);
-                                renderer_upload_aurora(&renderer, &aurora_mesh);
-                            }
-                        }
-                    }
+                    dirty |= DIRTY_UI | DIRTY_FRAME;
+                    if (s == 1)
+                        build_stream(&feeds, FEED_BUILD_AURORA, &aurora_stream);
+                    overlay_stream_free(&aurora_stream);
                     fetch_cleanup(&aurora_fetch);
                 }
             }
 
-            /* Poll DRAP fetch completion */
             if (drap_fetching) {
                 int s = fetch_check(&drap_fetch);
                 if (s != 0) {
+                    profiler_fetch("drap", s, drap_fetch.ms,
+                                   drap_fetch.wire_bytes, drap_fetch.body_bytes);
                     drap_fetching = 0;
+                    dirty |= DIRTY_UI | DIRTY_FRAME;
                     if (s == 1) {
                         char *text = fetch_take_response(&drap_fetch);
                         if (text) {
-                            drap_parse_text(text, &drap_grid);
-                            free(text);
-                            if (drap_active && drap_grid.valid) {
-                                drap_mesh_build(&drap_mesh, &drap_grid);
-                                renderer_upload_drap(&renderer, &drap_mesh);
-                            }
+                            ProjState cur;
+                            projection_get_state(&cur);
+                            feedbuild_submit_text(&feeds, text, &cur);
                         }
                     }
                     fetch_cleanup(&drap_fetch);
                 }
             }
 
+            /* Take finished builds: swap the buffers in and upload them.
+             * The lines are the reprojection worker's while it runs, so
+             * results wait for its job to be collected; lines built at a
+             * center the view has since left get a job of their own. */
+            if (!reproj_busy(&reproj)) {
+                FeedResult *r;
+                while ((r = feedbuild_take(&feeds))) {
+                    if (!r->ok) {
+                        /* Its body is cached: without this every refresh
+                         * would revalidate it and get a 304 */
+                        feedcache_drop(build_cache[r->kind]);
+                        feedbuild_result_free(r);
+                        continue;
+                    }
+                    int current = 1;
+                    switch (r->kind) {
+                    case FEED_BUILD_MUF:
+                        current = adopt_lines(&muf_data, r);
+                        if (current && muf_active && muf_data.raw_count > 0)
+                            renderer_upload_muf(&renderer, &muf_data);
+                        break;
+                    case FEED_BUILD_SPORE:
+                        current = adopt_lines(&spore_data, r);
+                        if (current && spore_active && spore_data.raw_count > 0)
+                            renderer_upload_spore(&renderer, &spore_data);
+                        break;
+                    case FEED_BUILD_AURORA:
+                        current = adopt_lines(&aurora_lines, r);
+                        heat_grid_free(&aurora_heat);
+                        aurora_heat = r->heat;
+                        heat_grid_init(&r->heat);
+                        if (aurora_active)
+                            renderer_upload_aurora(&renderer, &aurora_heat);
+                        if (current && aurora_active && aurora_lines.raw_count > 0)
+                            renderer_upload_aurora_lines(&renderer, &aurora_lines);
+                        break;
+                    case FEED_BUILD_DRAP:
+                        current = adopt_lines(&drap_lines, r);
+                        heat_grid_free(&drap_heat);
+                        drap_heat = r->heat;
+                        heat_grid_init(&r->heat);
+                        drap_peak = r->drap_peak;
+                        if (drap_active)
+                            renderer_upload_drap(&renderer, &drap_heat);
+                        if (current && drap_active && drap_lines.raw_count > 0)
+                            renderer_upload_drap_lines(&renderer, &drap_lines);
+                        break;
+                    }
+                    if (!current)
+                        reproj_request(&reproj, input.center_lat, input.center_lon, &cam);
+                    feedbuild_result_free(r);
+                    dirty |= DIRTY_UI | DIRTY_FRAME;
+                }
+            }
+
             /* Auto-refresh every OVERLAY_UPDATE_SEC while active */
             if (muf_active && !muf_fetching &&
                 now - last_muf_fetch >= OVERLAY_UPDATE_SEC) {
-                fetch_start(&muf_fetch, MUF_URL);
+                start_stream(&muf_fetch, &muf_stream, OVERLAY_FEED_MUF, MUF_URL,
+                             muf_data.raw_count > 0);
                 muf_fetching = 1;
                 last_muf_fetch = now;
             }
             if (spore_active && !spore_fetching &&
                 now - last_spore_fetch >= OVERLAY_UPDATE_SEC) {
-                fetch_start(&spore_fetch, SPORE_URL);
+                start_stream(&spore_fetch, &spore_stream, OVERLAY_FEED_SPORE, SPORE_URL,
+                             spore_data.raw_count > 0);
                 spore_fetching = 1;
                 last_spore_fetch = now;
             }
             if (aurora_active && !aurora_fetching &&
                 now - last_aurora_fetch >= OVERLAY_UPDATE_SEC) {
-                fetch_start(&aurora_fetch, AURORA_URL);
+                start_stream(&aurora_fetch, &aurora_stream, OVERLAY_FEED_AURORA, AURORA_URL,
+                             aurora_heat.texels != NULL);
                 aurora_fetching = 1;
                 last_aurora_fetch = now;
             }
             if (drap_active && !drap_fetching &&
                 now - last_drap_fetch >= OVERLAY_UPDATE_SEC) {
-                fetch_start(&drap_fetch, DRAP_URL);
+                fetch_start_cached(&drap_fetch, DRAP_URL, "drap", drap_heat.texels != NULL,
+                                   NULL, NULL);
                 drap_fetching = 1;
                 last_drap_fetch = now;
             }
@@ -1544,28 +2268,26 @@ int main(int argc, char **argv)
             if (kp_fetching) {
                 int s = fetch_check(&kp_fetch);
                 if (s != 0) {
+                    profiler_fetch("kp", s, kp_fetch.ms,
+                                   kp_fetch.wire_bytes, kp_fetch.body_bytes);
                     kp_fetching = 0;
-                    if (s == 1) {
-                        char *json = fetch_take_response(&kp_fetch);
-                        if (json) {
-                            geomag_parse_kp(json, &geomag);
-                            free(json);
-                        }
-                    }
+                    dirty |= DIRTY_UI | DIRTY_FRAME;
+                    if (s == 1 && !(have_kp = geomag_take_kp(&geomag, &kp_stream) == 0))
+                        feedcache_drop(feed_cache[OVERLAY_FEED_KP]);
+                    overlay_stream_free(&kp_stream);
                     fetch_cleanup(&kp_fetch);
                 }
             }
             if (bz_fetching) {
                 int s = fetch_check(&bz_fetch);
                 if (s != 0) {
+                    profiler_fetch("bz", s, bz_fetch.ms,
+                                   bz_fetch.wire_bytes, bz_fetch.body_bytes);
                     bz_fetching = 0;
-                    if (s == 1) {
-                        char *json = fetch_take_response(&bz_fetch);
-                        if (json) {
-                            geomag_parse_bz(json, &geomag);
-                            free(json);
-                        }
-                    }
+                    dirty |= DIRTY_UI | DIRTY_FRAME;
+                    if (s == 1 && !(have_bz = geomag_take_bz(&geomag, &bz_stream) == 0))
+                        feedcache_drop(feed_cache[OVERLAY_FEED_BZ]);
+                    overlay_stream_free(&bz_stream);
                     fetch_cleanup(&bz_fetch);
                 }
             }
@@ -1573,14 +2295,41 @@ int main(int argc, char **argv)
             /* Auto-refresh Kp/Bz every OVERLAY_UPDATE_SEC while Aurora active */
             if (aurora_active && !kp_fetching && !bz_fetching &&
                 now - last_geomag_fetch >= OVERLAY_UPDATE_SEC) {
-                fetch_start(&kp_fetch, KP_URL);
+                start_stream(&kp_fetch, &kp_stream, OVERLAY_FEED_KP, KP_URL, have_kp);
                 kp_fetching = 1;
-                fetch_start(&bz_fetch, BZ_URL);
+                start_stream(&bz_fetch, &bz_stream, OVERLAY_FEED_BZ, BZ_URL, have_bz);
                 bz_fetching = 1;
                 last_geomag_fetch = now;
             }
         }
 
+        profiler_end(PROF_OVERLAYS);
+
+        /* Spots changed (added, resolved, expired): one upload for all */
+        if (spots.version != spots_uploaded) {
+            spots_uploaded = spots.version;
+            renderer_upload_spots(&renderer, spots.inst, spots.count);
+            dirty |= DIRTY_FRAME;
+        }
+
+        /* Start the queued center change now that this iteration is done
+         * with the layers */
+        reproj_kick(&reproj);
+
+        /* Nothing visible changed: keep the presented frame */
+        unsigned frame = dirty & DIRTY_FRAME;
+        dirty = 0;
+        if (!frame)
+            continue;
+
+        profiler_begin(PROF_DRAW);
+        /* The night overlay follows the sun on every drawn frame */
+        SubsolarPoint sun = solar_subsolar_point(time(NULL));
+        renderer_set_sun(&renderer, sun.lat_deg, sun.lon_deg);
+        /* Spots fade with the clock, paths start at home */
+        renderer_set_spot_view(&renderer, center_lat, center_lon,
+                               cam.zoom_km * MARKER_ZOOM_FACTOR * 0.5f,
+                               (float)glfwGetTime(), spot_max_age);
         renderer_draw(&renderer, mvp, map_fb_w, fb_h);
 
         /* Draw sidebar */
@@ -1592,8 +2341,25 @@ int main(int argc, char **argv)
 
         /* Draw buttons in full-window viewport (spans map + sidebar) */
         renderer_draw_buttons(&renderer, fb_w, fb_h);
+        profiler_end(PROF_DRAW);
 
+        profiler_begin(PROF_SWAP);
         glfwSwapBuffers(window);
+        profiler_end(PROF_SWAP);
+        profiler_frame_end();
+
+        if (!first_frame_done) {
+            first_frame_done = 1;
+            struct timespec t_now;
+            clock_gettime(CLOCK_MONOTONIC, &t_now);
+            int layers = 1 + has_borders + has_land;
+            int cached = map.cached + (has_borders && borders.cached) +
+                         (has_land && land.cached);
+            printf("First frame: %.0f ms (geometry cache: %d/%d layers)\n",
+                   (t_now.tv_sec - t_start.tv_sec) * 1e3 +
+                   (t_now.tv_nsec - t_start.tv_nsec) / 1e6,
+                   cached, layers);
+        }
     }
 
     /* Save session state — use window (screen) size, not framebuffer size */
@@ -1605,33 +2371,67 @@ int main(int argc, char **argv)
                       input.center_lat, input.center_lon,
                       save_ww, save_wh, ui.sidebar_visible);
 
-    /* Cleanup FIFO */
-    if (fifo_fd >= 0) close(fifo_fd);
+    /* Cleanup IPC; background threads must not wake a terminated GLFW */
+    fetch_set_wake(NULL);
+    feedbuild_set_wake(NULL);
+    if (has_qrz) qrz_set_wake(NULL);
+    map_lod_set_wake(NULL);
+    reproj_set_wake(NULL);
+    reproj_free(&reproj);
+    wsjtx_listen_stop(&wsjtx);
+    {
+        WsjtxStats st;
+        wsjtx_get_stats(&wsjtx, &st);
+        if (st.datagrams > 0)
+            printf("WSJT-X: %ld datagrams, %ld decodes, %ld spots (%ld invalid, %ld dropped)\n",
+                   st.datagrams, st.decodes, st.spots, st.bad, st.dropped);
+    }
+    {
+        IpcStats st;
+        ipc_get_stats(&ipc, &st);
+        if (st.received + st.errors > 0)
+            printf("IPC: %ld updates (%ld coalesced, %ld dropped, %ld invalid)\n",
+                   st.received, st.coalesced, st.dropped, st.errors);
+    }
+    ipc_server_stop(&ipc);
     unlink(FIFO_PATH);
 
-    /* Cleanup in-flight fetches */
+    /* Cleanup in-flight fetches (their streams are still being fed) */
     if (muf_fetching) fetch_cleanup(&muf_fetch);
     if (spore_fetching) fetch_cleanup(&spore_fetch);
     if (aurora_fetching) fetch_cleanup(&aurora_fetch);
     if (drap_fetching) fetch_cleanup(&drap_fetch);
     if (kp_fetching) fetch_cleanup(&kp_fetch);
     if (bz_fetching) fetch_cleanup(&bz_fetch);
+    fetch_shutdown();
+    {
+        FetchStats st;
+        fetch_get_stats(&st);
+        if (st.requests > 0)
+            printf("Fetch: %ld requests (%ld not modified, %ld failed, %ld cancelled) "
+                   "on %ld connections, %.0f KiB on the wire, %.0f KiB decoded\n",
+                   st.requests, st.not_modified, st.failed, st.cancelled,
+                   st.connections, st.wire_bytes / 1024.0, st.body_bytes / 1024.0);
+    }
+    feedbuild_free(&feeds);     /* before the pool its Es scatter uses */
+    spots_free(&spots);
 
     /* Cleanup */
     if (has_qrz) qrz_cleanup();
+    profiler_shutdown();
     renderer_destroy(&renderer);
-    map_data_free(&map);
-    if (has_borders) map_data_free(&borders);
-    if (has_land) map_data_free(&land);
-    free(grid.vertices);
-    free(dist_circles.vertices);
-    nightmesh_free(&nightmesh);
+    map_lod_free(&map);
+    if (has_borders) map_lod_free(&borders);
+    if (has_land) map_lod_free(&land);
+    threadpool_shutdown();
+    map_data_free(&grid);
+    map_data_free(&dist_circles);
     muf_data_free(&muf_data);
     muf_data_free(&spore_data);
-    aurora_grid_free(&aurora_grid);
-    aurora_mesh_free(&aurora_mesh);
-    drap_grid_free(&drap_grid);
-    aurora_mesh_free(&drap_mesh);
+    heat_grid_free(&aurora_heat);
+    heat_grid_free(&drap_heat);
+    muf_data_free(&aurora_lines);
+    muf_data_free(&drap_lines);
     glfwDestroyWindow(window);
     glfwTerminate();
     return 0;
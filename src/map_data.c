@@ -4,7 +4,12 @@
  * - project_all(): splits segments at large projected-space jumps (for lines)
  * - project_nosplit(): clips polygon rings at the projection boundary using
  *   bisection, then inserts arc segments along the boundary circle (for
- *   stencil-based polygon fill) */
+ *   stencil-based polygon fill)
+ * Both split the raw segments into tasks of similar vertex count for the
+ * thread pool (threadpool.h) and stitch the per-task output back together
+ * in segment order, so the result is the same for any thread count.
+ * map_data_simplify() derives coarser copies (Douglas-Peucker on the unit
+ * sphere) for the level-of-detail pyramids in map_lod.c. */
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -13,8 +18,11 @@
 #include <shapefil.h>
 #include "map_data.h"
 #include "projection.h"
+#include "threadpool.h"
 
-/* Load raw lat/lon vertices from a shapefile into md->raw_* fields. */
+/* Load raw lat/lon vertices from a shapefile into md->raw_* fields.
+ * Single pass: each SHPObject is read once and the vertex arrays grow by
+ * doubling, so 10m layers are not parsed twice. */
 static int load_raw(MapData *md, const char *shp_path)
 {
     SHPHandle shp = SHPOpen(shp_path, "rb");
@@ -26,54 +34,41 @@ static int load_raw(MapData *md, const char *shp_path)
     int num_entities, shape_type;
     SHPGetInfo(shp, &num_entities, &shape_type, NULL, NULL);
 
-    /* First pass: count total vertices */
-    int total = 0;
-    int seg_count = 0;
-    for (int i = 0; i < num_entities; i++) {
-        SHPObject *obj = SHPReadObject(shp, i);
-        if (!obj) continue;
-        for (int p = 0; p < obj->nParts; p++) {
-            int start = obj->panPartStart[p];
-            int end = (p + 1 < obj->nParts) ? obj->panPartStart[p + 1] : obj->nVertices;
-            int count = end - start;
-            if (count > 1) {
-                total += count;
-                seg_count++;
-            }
-        }
-        SHPDestroyObject(obj);
-    }
-
-    if (seg_count > MAX_SEGMENTS) {
-        fprintf(stderr, "Warning: truncating to %d segments\n", MAX_SEGMENTS);
-        seg_count = MAX_SEGMENTS;
-    }
-
-    /* Allocate raw storage */
     free(md->raw_lats);
     free(md->raw_lons);
-    md->raw_lats = malloc(total * sizeof(double));
-    md->raw_lons = malloc(total * sizeof(double));
-    if (!md->raw_lats || !md->raw_lons) {
-        SHPClose(shp);
-        return -1;
-    }
-
-    /* Second pass: read vertices */
+    md->raw_lats = NULL;
+    md->raw_lons = NULL;
     md->raw_count = 0;
-    md->raw_num_segments = 0;
-    for (int i = 0; i < num_entities && md->raw_num_segments < MAX_SEGMENTS; i++) {
+    int cap = 0;
+    if (segtable_reset(&md->raw_segs, SEG_CAPS) != 0)
+        goto oom;
+
+    for (int i = 0; i < num_entities; i++) {
         SHPObject *obj = SHPReadObject(shp, i);
         if (!obj) continue;
-        for (int p = 0; p < obj->nParts && md->raw_num_segments < MAX_SEGMENTS; p++) {
+        for (int p = 0; p < obj->nParts; p++) {
             int start = obj->panPartStart[p];
             int end = (p + 1 < obj->nParts) ? obj->panPartStart[p + 1] : obj->nVertices;
             int count = end - start;
             if (count <= 1) continue;
 
-            md->raw_seg_starts[md->raw_num_segments] = md->raw_count;
-            md->raw_seg_counts[md->raw_num_segments] = count;
-            md->raw_num_segments++;
+            if (md->raw_count + count > cap) {
+                int ncap = cap ? cap : 4096;
+                while (ncap < md->raw_count + count) ncap *= 2;
+                double *lats = realloc(md->raw_lats, ncap * sizeof(double));
+                if (lats) md->raw_lats = lats;
+                double *lons = realloc(md->raw_lons, ncap * sizeof(double));
+                if (lons) md->raw_lons = lons;
+                if (!lats || !lons) {
+                    SHPDestroyObject(obj);
+                    goto oom;
+                }
+                cap = ncap;
+            }
+            if (segtable_push(md->raw_segs, md->raw_count, count) < 0) {
+                SHPDestroyObject(obj);
+                goto oom;
+            }
 
             for (int v = start; v < end; v++) {
                 md->raw_lons[md->raw_count] = obj->padfX[v];
@@ -86,35 +81,160 @@ static int load_raw(MapData *md, const char *shp_path)
 
     SHPClose(shp);
     return 0;
+
+oom:
+    fprintf(stderr, "Error: out of memory loading %s (%d vertices)\n",
+            shp_path, md->raw_count);
+    SHPClose(shp);
+    return -1;
 }
 
 /* Max distance (km) between consecutive projected vertices before splitting.
  * Segments crossing near the antipodal point produce huge jumps. */
 #define SPLIT_THRESHOLD_KM 5000.0f
 
-static void project_all(MapData *md)
+/* 1 if raw segment s may reach the cull cap (always, when not culling). */
+static int seg_visible(const MapData *md, int s)
+{
+    const SegTable *raw = md->raw_segs;
+    return !md->cull || !raw->caps || projection_caps_overlap(raw->caps[s], md->cull_cap);
+}
+
+/* Project raw vertices [start, start + n) into xy (and back[]). */
+static void project_range(const MapData *md, int start, int n,
+                          float *xy, unsigned char *back)
 {
-    /* First pass: project all raw vertices */
-    float *proj = malloc(md->raw_count * 2 * sizeof(float));
-    if (!proj) return;
-    for (int i = 0; i < md->raw_count; i++) {
-        double x, y;
-        projection_forward(md->raw_lats[i], md->raw_lons[i], &x, &y);
-        proj[i * 2]     = (float)x;
-        proj[i * 2 + 1] = (float)y;
+    if (md->raw_unit)
+        projection_forward_unit_batch(md->raw_unit + start, md->raw_count, n, xy, back, 0);
+    else
+        projection_forward_batch(md->raw_lats + start, md->raw_lons + start, n, xy, back, 0);
+}
+
+/* Append a segment that inherits bounding cap s of the raw table. */
+static void push_with_cap(SegTable *segs, int start, int count,
+                          const SegTable *raw, int s)
+{
+    int i = segtable_push(segs, start, count);
+    if (i >= 0 && segs->caps && raw->caps)
+        memcpy(segs->caps[i], raw->caps[s], sizeof(segs->caps[i]));
+}
+
+/* ── Parallel reprojection ───────────────────────────────────────── */
+
+/* Pool tasks cover consecutive raw segments with about the same number of
+ * visible vertices: ~8 per thread so that stealing can even out the few
+ * huge rings, but never so small that task overhead shows. */
+#define TASKS_PER_THREAD 8
+#define TASK_MIN_VERTS   4096
+
+/* Raw segments [seg0, seg1) of one task.  Each task writes its visible
+ * vertices at vert0 of the packed per-call arrays, and its output to a
+ * region of its own; the caller then stitches the regions together in
+ * task order, so the result does not depend on the thread count. */
+typedef struct {
+    int  seg0, seg1;
+    int  vert0;         /* first visible vertex (packed) */
+    int  out0, out;     /* output vertices: compacted start, count */
+    int  arc0, extra;   /* nosplit: start after arc insertion, arc vertices */
+    int *subs;          /* project_all: (start, count, raw segment) triples */
+    int  nsubs, subs_cap;
+} SegRange;
+
+typedef struct {
+    MapData       *md;
+    ProjState      proj;     /* the caller's; pool workers adopt it */
+    SegRange      *ranges;
+    /* project_nosplit() only */
+    unsigned char *back;
+    float         *xy;
+    double        *clip_lats, *clip_lons;
+    float         *arc_verts;
+    int            is_azeq;
+    double         clat, clon, max_dist;
+    float          Rf, min_r, max_edge_sq;
+} ProjectJob;
+
+/* Split md's raw segments into pool tasks.  Returns the task count (0 if
+ * out of memory); *total gets the number of visible vertices. */
+static int plan_ranges(const MapData *md, SegRange **ranges, int *total)
+{
+    const SegTable *raw = md->raw_segs;
+    int vis = 0;
+    for (int s = 0; s < raw->num; s++)
+        if (seg_visible(md, s)) vis += raw->counts[s];
+    *total = vis;
+
+    int threads = threadpool_size();
+    int grain = vis + 1;
+    if (threads > 1) {
+        grain = vis / (threads * TASKS_PER_THREAD);
+        if (grain < TASK_MIN_VERTS) grain = TASK_MIN_VERTS;
+    }
+    int n = vis / grain + 1;
+    SegRange *r = calloc(n, sizeof(SegRange));
+    if (!r) return 0;
+
+    int t = 0, acc = 0, off = 0;
+    for (int s = 0; s < raw->num; s++) {
+        if (!seg_visible(md, s)) continue;
+        off += raw->counts[s];
+        acc += raw->counts[s];
+        if (acc >= grain && t < n - 1) {
+            r[t].seg1 = s + 1;
+            r[t + 1].seg0 = s + 1;
+            r[t + 1].vert0 = off;
+            t++;
+            acc = 0;
+        }
     }
+    r[t].seg1 = raw->num;
+    *ranges = r;
+    return t + 1;
+}
 
-    /* Second pass: split segments where consecutive points jump too far.
-     * Output may have more segments than input (but same vertex count). */
-    free(md->vertices);
-    md->vertices = proj;
-    md->vertex_count = md->raw_count;
-    md->num_segments = 0;
+static void free_ranges(SegRange *r, int n)
+{
+    for (int t = 0; t < n; t++)
+        free(r[t].subs);
+    free(r);
+}
 
-    for (int s = 0; s < md->raw_num_segments && md->num_segments < MAX_SEGMENTS; s++) {
-        int base = md->raw_seg_starts[s];
-        int count = md->raw_seg_counts[s];
+/* Record sub-segment (start, count) of raw segment s.  Out of memory
+ * drops it, like a failed segtable_push(). */
+static void range_push_sub(SegRange *r, int start, int count, int s)
+{
+    if (r->nsubs == r->subs_cap) {
+        int ncap = r->subs_cap ? r->subs_cap * 2 : 64;
+        int *subs = realloc(r->subs, (size_t)ncap * 3 * sizeof(int));
+        if (!subs) return;
+        r->subs = subs;
+        r->subs_cap = ncap;
+    }
+    int *p = r->subs + r->nsubs++ * 3;
+    p[0] = start;
+    p[1] = count;
+    p[2] = s;
+}
+
+/* Project the task's visible segments in place and split them where
+ * consecutive points jump too far. */
+static void project_all_task(void *arg, int t)
+{
+    ProjectJob *job = arg;
+    const MapData *md = job->md;
+    const SegTable *raw = md->raw_segs;
+    SegRange *r = &job->ranges[t];
+    float *proj = md->vertices;
+    projection_set_state(&job->proj);
+
+    int out = r->vert0;
+    for (int s = r->seg0; s < r->seg1; s++) {
+        if (!seg_visible(md, s)) continue;
+        int base = out;
+        int count = raw->counts[s];
         int seg_start = base;
+        project_range(md, raw->starts[s], count, proj + base * 2, NULL);
+        out += count;
 
         for (int v = 1; v < count; v++) {
             int idx = base + v;
@@ -126,46 +246,126 @@ static void project_all(MapData *md)
             if (dist > SPLIT_THRESHOLD_KM * SPLIT_THRESHOLD_KM) {
                 /* End current sub-segment before the jump */
                 int sub_count = (base + v) - seg_start;
-                if (sub_count >= 2 && md->num_segments < MAX_SEGMENTS) {
-                    md->segment_starts[md->num_segments] = seg_start;
-                    md->segment_counts[md->num_segments] = sub_count;
-                    md->num_segments++;
-                }
+                if (sub_count >= 2)
+                    range_push_sub(r, seg_start, sub_count, s);
                 seg_start = base + v; /* Start new sub-segment after the jump */
             }
         }
 
         /* Flush remaining sub-segment */
         int sub_count = (base + count) - seg_start;
-        if (sub_count >= 2 && md->num_segments < MAX_SEGMENTS) {
-            md->segment_starts[md->num_segments] = seg_start;
-            md->segment_counts[md->num_segments] = sub_count;
-            md->num_segments++;
+        if (sub_count >= 2)
+            range_push_sub(r, seg_start, sub_count, s);
+    }
+}
+
+static void project_all(MapData *md)
+{
+    const SegTable *raw = md->raw_segs;
+    ProjectJob job = { .md = md };
+    projection_get_state(&job.proj);
+
+    /* Pack the raw segments that pass the cull test in raw order (all of
+     * them when md->cull is 0) */
+    int total;
+    int ntasks = plan_ranges(md, &job.ranges, &total);
+    if (ntasks == 0) return;
+
+    float *proj = malloc((size_t)(total > 0 ? total : 1) * 2 * sizeof(float));
+    if (!proj) {
+        free_ranges(job.ranges, ntasks);
+        return;
+    }
+    free(md->vertices);
+    md->vertices = proj;
+    md->vertex_count = total;
+    if (segtable_reset(&md->segs, SEG_CAPS) != 0) {
+        free_ranges(job.ranges, ntasks);
+        return;
+    }
+
+    threadpool_run(ntasks, project_all_task, &job);
+
+    /* Output may have more segments than input (but same vertex count) */
+    int nsubs = 0;
+    for (int t = 0; t < ntasks; t++)
+        nsubs += job.ranges[t].nsubs;
+    segtable_reserve(md->segs, nsubs);
+    for (int t = 0; t < ntasks; t++) {
+        const int *p = job.ranges[t].subs;
+        for (int i = 0; i < job.ranges[t].nsubs; i++, p += 3)
+            push_with_cap(md->segs, p[0], p[1], raw, p[2]);
+    }
+    free_ranges(job.ranges, ntasks);
+}
+
+/* ── Spatial index ───────────────────────────────────────────────── */
+
+/* Fill the bounding cap of every raw segment (needs raw_unit). */
+static void build_caps(MapData *md)
+{
+    SegTable *raw = md->raw_segs;
+    if (!md->raw_unit || !raw->caps) return;
+    for (int s = 0; s < raw->num; s++)
+        projection_bound_cap(md->raw_unit + raw->starts[s], md->raw_count,
+                             raw->counts[s], raw->caps[s]);
+}
+
+int map_data_chunk(MapData *md, int max_pts)
+{
+    const SegTable *raw = md->raw_segs;
+    if (!raw || max_pts < 2) return -1;
+
+    int n = 0;
+    for (int s = 0; s < raw->num; s++)
+        n += (raw->counts[s] - 2) / (max_pts - 1) + 1;
+    SegTable *chunks = segtable_new(SEG_CAPS);
+    if (!chunks || segtable_reserve(chunks, n) != 0) {
+        segtable_unref(chunks);
+        return -1;
+    }
+
+    /* Consecutive chunks share their boundary vertex so strips stay joined */
+    for (int s = 0; s < raw->num; s++) {
+        int end = raw->starts[s] + raw->counts[s];
+        for (int st = raw->starts[s]; st < end - 1; st += max_pts - 1) {
+            int count = end - st < max_pts ? end - st : max_pts;
+            segtable_push(chunks, st, count);
         }
     }
+    segtable_unref(md->raw_segs);
+    md->raw_segs = chunks;
+    build_caps(md);
+    return 0;
 }
 
 int map_data_load(MapData *md, const char *shp_path)
 {
-    md->vertices = NULL;
-    md->vertex_count = 0;
-    md->num_segments = 0;
-    md->raw_lats = NULL;
-    md->raw_lons = NULL;
-    md->raw_count = 0;
-    md->raw_num_segments = 0;
+    memset(md, 0, sizeof(*md));
+
+    if (load_raw(md, shp_path) != 0) {
+        map_data_free(md);
+        return -1;
+    }
+
+    /* Unit vectors are optional: without them reprojection uses lat/lon */
+    md->raw_unit = malloc(md->raw_count * 3 * sizeof(float));
+    if (md->raw_unit)
+        projection_to_unit(md->raw_lats, md->raw_lons, md->raw_count, md->raw_unit);
+    build_caps(md);
 
-    if (load_raw(md, shp_path) != 0) return -1;
     project_all(md);
     return 0;
 }
 
 /* Distance-based clipping state for AZEQ mode.
  * In AZEQ there is no hemisphere boundary, so we clip at a max angular
- * distance from the center instead.  These statics are set once per
- * project_nosplit() call and read by is_back_vertex / find_boundary_crossing. */
-static int  clip_use_dist;
-static double clip_clat, clip_clon, clip_max_dist;
+ * distance from the center instead.  These statics are set by every
+ * project_nosplit() task (adopt_clip) and read by is_back_vertex /
+ * find_boundary_crossing.  Thread-local because the tasks run on pool
+ * workers, and map_lod.c may run project_nosplit() on a worker too. */
+static _Thread_local int    clip_use_dist;
+static _Thread_local double clip_clat, clip_clon, clip_max_dist;
 
 /* Unified back-vertex test: hemisphere boundary (ORTHO) or distance (AZEQ). */
 static int is_back_vertex(double lat, double lon)
@@ -198,58 +398,99 @@ static void find_boundary_crossing(double lat_a, double lon_a, int a_back,
     *out_lon = lon_a + t * (lon_b - lon_a);
 }
 
-static void project_nosplit(MapData *md)
+/* Insert boundary arc vertices for "shortcut" edges created by clipping.
+ * When clipping cuts a polygon ring at the boundary, it creates direct
+ * edges between crossing points that don't follow the boundary arc.
+ * These shortcut edges cause the GL_TRIANGLE_FAN stencil inversion to
+ * cover the wrong area.  Fix by detecting edges where both endpoints
+ * are near the boundary and the edge is long, then inserting
+ * intermediate points along the boundary arc.
+ * For ORTHO the boundary is the hemisphere circle at EARTH_RADIUS_KM.
+ * For AZEQ  the boundary is the clip circle at clip_max_dist. */
+#define ARC_PTS 12
+
+/* 1 if projected edge a→b is a shortcut that needs a boundary arc. */
+static int is_shortcut(const ProjectJob *job, const float *a, const float *b)
 {
-    free(md->vertices);
+    float r0 = sqrtf(a[0] * a[0] + a[1] * a[1]);
+    float r1 = sqrtf(b[0] * b[0] + b[1] * b[1]);
+    float dx = b[0] - a[0], dy = b[1] - a[1];
+    return r0 > job->min_r && r1 > job->min_r && dx * dx + dy * dy > job->max_edge_sq;
+}
 
-    /* Set up clipping mode: ORTHO clips at hemisphere boundary,
-     * AZEQ clips at 175° angular distance from center. */
-    int is_azeq = (projection_get_mode() == PROJ_AZEQ);
-    clip_use_dist = is_azeq;
-    if (is_azeq) {
-        projection_get_center(&clip_clat, &clip_clon);
-        clip_max_dist = 175.0 / 180.0 * M_PI * EARTH_RADIUS_KM;
-    }
+/* Adopt the caller's projection and clipping state on this thread. */
+static void adopt_clip(const ProjectJob *job)
+{
+    projection_set_state(&job->proj);
+    clip_use_dist = job->is_azeq;
+    clip_clat = job->clat;
+    clip_clon = job->clon;
+    clip_max_dist = job->max_dist;
+}
 
-    /* Mark each vertex as inside (0) or outside (1) the clipping boundary */
-    int *back = malloc(md->raw_count * sizeof(int));
-    if (!back) { md->vertices = NULL; md->vertex_count = 0; md->num_segments = 0; return; }
-    for (int i = 0; i < md->raw_count; i++)
-        back[i] = is_back_vertex(md->raw_lats[i], md->raw_lons[i]);
-
-    /* Build clipped rings — each edge can add one intersection vertex */
-    int max_out = md->raw_count * 2;
-    double *clip_lats = malloc(max_out * sizeof(double));
-    double *clip_lons = malloc(max_out * sizeof(double));
-    if (!clip_lats || !clip_lons) {
-        free(clip_lats); free(clip_lons); free(back);
-        md->vertices = NULL; md->vertex_count = 0; md->num_segments = 0;
-        return;
+/* First pass: project the task's visible rings, mark each vertex inside
+ * (0) or outside (1) the clipping boundary, and write the clipped rings
+ * as lat/lon at 2 * vert0 (each edge adds at most one crossing). */
+static void clip_task(void *arg, int t)
+{
+    ProjectJob *job = arg;
+    const MapData *md = job->md;
+    const SegTable *raw = md->raw_segs;
+    SegTable *segs = md->segs;
+    SegRange *r = &job->ranges[t];
+    adopt_clip(job);
+
+    /* One batch projection gives both tests: the ORTHO back flag directly,
+     * and for AZEQ the projected radius, which equals the angular distance
+     * from center in km.  Culled rings are never projected. */
+    unsigned char *back = job->back + r->vert0;
+    float *xy = job->xy + (size_t)r->vert0 * 2;
+    int n = 0;
+    for (int s = r->seg0; s < r->seg1; s++) {
+        if (!seg_visible(md, s)) continue;
+        project_range(md, raw->starts[s], raw->counts[s], xy + n * 2, back + n);
+        n += raw->counts[s];
+    }
+    if (job->is_azeq) {
+        for (int i = 0; i < n; i++)
+            back[i] = (hypot(xy[i * 2], xy[i * 2 + 1]) > clip_max_dist);
     }
-    int clip_count = 0;
 
-    md->num_segments = md->raw_num_segments;
+    double *clip_lats = job->clip_lats + (size_t)r->vert0 * 2;
+    double *clip_lons = job->clip_lons + (size_t)r->vert0 * 2;
+    int clip_count = 0;
 
-    for (int s = 0; s < md->raw_num_segments; s++) {
-        int base = md->raw_seg_starts[s];
-        int count = md->raw_seg_counts[s];
+    /* Output segment s is the clipped version of raw ring s */
+    for (int s = r->seg0, off = 0; s < r->seg1; s++) {
+        int base = raw->starts[s];
+        int count = raw->counts[s];
         int ring_start = clip_count;
 
+        if (!seg_visible(md, s)) {
+            /* Outside the cull cap — skip without projecting */
+            segs->starts[s] = ring_start;
+            segs->counts[s] = 0;
+            segs->clamped[s] = 1;
+            continue;
+        }
+        const unsigned char *ring_back = back + off;
+        off += count;
+
         /* Check for outside-boundary vertices */
         int has_back = 0, has_front = 0;
         for (int v = 0; v < count; v++) {
-            if (back[base + v]) has_back = 1; else has_front = 1;
+            if (ring_back[v]) has_back = 1; else has_front = 1;
         }
 
         if (!has_front) {
             /* Entirely back-hemisphere — skip */
-            md->segment_starts[s] = ring_start;
-            md->segment_counts[s] = 0;
-            md->segment_clamped[s] = 1;
+            segs->starts[s] = ring_start;
+            segs->counts[s] = 0;
+            segs->clamped[s] = 1;
             continue;
         }
 
-        md->segment_clamped[s] = 0;
+        segs->clamped[s] = 0;
 
         if (!has_back) {
             /* Entirely front-hemisphere — copy as-is */
@@ -263,17 +504,18 @@ static void project_nosplit(MapData *md)
             for (int v = 0; v < count; v++) {
                 int ci = base + v;
                 int ni = base + (v + 1) % count;
+                int c_back = ring_back[v], n_back = ring_back[(v + 1) % count];
 
-                if (!back[ci]) {
+                if (!c_back) {
                     clip_lats[clip_count] = md->raw_lats[ci];
                     clip_lons[clip_count] = md->raw_lons[ci];
                     clip_count++;
                 }
 
-                if (back[ci] != back[ni]) {
+                if (c_back != n_back) {
                     double blat, blon;
                     find_boundary_crossing(
-                        md->raw_lats[ci], md->raw_lons[ci], back[ci],
+                        md->raw_lats[ci], md->raw_lons[ci], c_back,
                         md->raw_lats[ni], md->raw_lons[ni],
                         &blat, &blon);
                     clip_lats[clip_count] = blat;
@@ -287,115 +529,177 @@ static void project_nosplit(MapData *md)
         if (seg_count < 3) {
             /* Too few vertices for a triangle fan — discard */
             clip_count = ring_start;
-            md->segment_starts[s] = ring_start;
-            md->segment_counts[s] = 0;
-            md->segment_clamped[s] = 1;
+            segs->starts[s] = ring_start;
+            segs->counts[s] = 0;
+            segs->clamped[s] = 1;
         } else {
-            md->segment_starts[s] = ring_start;
-            md->segment_counts[s] = seg_count;
+            segs->starts[s] = ring_start;
+            segs->counts[s] = seg_count;
         }
     }
+    r->out = clip_count;
+}
 
-    /* Project clipped vertices */
-    md->vertices = malloc(clip_count * 2 * sizeof(float));
-    if (!md->vertices) {
-        free(clip_lats); free(clip_lons); free(back);
-        md->vertex_count = 0; md->num_segments = 0;
-        return;
-    }
-    for (int i = 0; i < clip_count; i++) {
-        double x, y;
-        projection_forward_clamped(clip_lats[i], clip_lons[i], &x, &y);
-        md->vertices[i * 2]     = (float)x;
-        md->vertices[i * 2 + 1] = (float)y;
+/* Second pass: project the clipped rings to their compacted place (out0)
+ * and count the arc vertices they need. */
+static void clip_project_task(void *arg, int t)
+{
+    ProjectJob *job = arg;
+    MapData *md = job->md;
+    SegTable *segs = md->segs;
+    SegRange *r = &job->ranges[t];
+    adopt_clip(job);
+
+    projection_forward_batch(job->clip_lats + (size_t)r->vert0 * 2,
+                             job->clip_lons + (size_t)r->vert0 * 2, r->out,
+                             md->vertices + (size_t)r->out0 * 2, NULL,
+                             PROJ_BATCH_CLAMP);
+
+    int extra = 0;
+    for (int s = r->seg0; s < r->seg1; s++) {
+        segs->starts[s] += r->out0;
+        if (segs->clamped[s] || segs->counts[s] < 3) continue;
+        int st = segs->starts[s], cnt = segs->counts[s];
+        for (int v = 0; v < cnt; v++) {
+            int ci = st + v, ni = st + (v + 1) % cnt;
+            if (is_shortcut(job, md->vertices + ci * 2, md->vertices + ni * 2))
+                extra += ARC_PTS;
+        }
     }
-    md->vertex_count = clip_count;
+    r->extra = extra;
+}
 
-    /* Insert boundary arc vertices for "shortcut" edges created by clipping.
-     * When clipping cuts a polygon ring at the boundary, it creates direct
-     * edges between crossing points that don't follow the boundary arc.
-     * These shortcut edges cause the GL_TRIANGLE_FAN stencil inversion to
-     * cover the wrong area.  Fix by detecting edges where both endpoints
-     * are near the boundary and the edge is long, then inserting
-     * intermediate points along the boundary arc.
-     * For ORTHO the boundary is the hemisphere circle at EARTH_RADIUS_KM.
-     * For AZEQ  the boundary is the clip circle at clip_max_dist. */
-    {
-        float Rf = is_azeq ? (float)clip_max_dist
-                           : (float)projection_get_radius();
-        float min_r = Rf * 0.85f;          /* endpoints must be near boundary */
-        float max_edge_sq = Rf * Rf * 0.25f; /* edge > 0.5*R triggers arc */
-        #define ARC_PTS 12
-
-        /* Count extra vertices needed */
-        int extra = 0;
-        for (int s = 0; s < md->num_segments; s++) {
-            if (md->segment_clamped[s] || md->segment_counts[s] < 3) continue;
-            int st = md->segment_starts[s], cnt = md->segment_counts[s];
+/* Third pass (only if some ring needs arcs): copy the task's rings to
+ * arc0 of the new vertex array, inserting arcs along the boundary. */
+static void arc_task(void *arg, int t)
+{
+    ProjectJob *job = arg;
+    const float *vt = job->md->vertices;
+    SegTable *segs = job->md->segs;
+    const SegRange *r = &job->ranges[t];
+    float *nv = job->arc_verts;
+    float Rf = job->Rf;
+
+    int nc = r->arc0;
+    for (int s = r->seg0; s < r->seg1; s++) {
+        int st = segs->starts[s], cnt = segs->counts[s];
+        int ns = nc;
+        if (segs->clamped[s] || cnt < 3) {
+            memcpy(nv + nc*2, vt + st*2, cnt * 2 * sizeof(float));
+            nc += cnt;
+        } else {
             for (int v = 0; v < cnt; v++) {
                 int ci = st + v, ni = st + (v + 1) % cnt;
-                float x0 = md->vertices[ci*2], y0 = md->vertices[ci*2+1];
-                float x1 = md->vertices[ni*2], y1 = md->vertices[ni*2+1];
-                float r0 = sqrtf(x0*x0 + y0*y0);
-                float r1 = sqrtf(x1*x1 + y1*y1);
-                float dx = x1-x0, dy = y1-y0;
-                if (r0 > min_r && r1 > min_r && dx*dx+dy*dy > max_edge_sq)
-                    extra += ARC_PTS;
-            }
-        }
-
-        if (extra > 0) {
-            float *nv = malloc((md->vertex_count + extra) * 2 * sizeof(float));
-            if (nv) {
-                int nc = 0;
-                for (int s = 0; s < md->num_segments; s++) {
-                    int st = md->segment_starts[s], cnt = md->segment_counts[s];
-                    int ns = nc;
-                    if (md->segment_clamped[s] || cnt < 3) {
-                        memcpy(nv + nc*2, md->vertices + st*2,
-                               cnt * 2 * sizeof(float));
-                        nc += cnt;
-                    } else {
-                        for (int v = 0; v < cnt; v++) {
-                            int ci = st + v, ni = st + (v + 1) % cnt;
-                            nv[nc*2]   = md->vertices[ci*2];
-                            nv[nc*2+1] = md->vertices[ci*2+1];
-                            nc++;
-
-                            float x0 = md->vertices[ci*2], y0 = md->vertices[ci*2+1];
-                            float x1 = md->vertices[ni*2], y1 = md->vertices[ni*2+1];
-                            float r0 = sqrtf(x0*x0 + y0*y0);
-                            float r1 = sqrtf(x1*x1 + y1*y1);
-                            float dx = x1-x0, dy = y1-y0;
-                            if (r0 > min_r && r1 > min_r && dx*dx+dy*dy > max_edge_sq) {
-                                /* Insert arc along boundary circle */
-                                float a0 = atan2f(y0, x0);
-                                float a1 = atan2f(y1, x1);
-                                float da = a1 - a0;
-                                if (da >  (float)M_PI) da -= 2.0f*(float)M_PI;
-                                if (da < -(float)M_PI) da += 2.0f*(float)M_PI;
-                                for (int k = 1; k <= ARC_PTS; k++) {
-                                    float t = a0 + da * (float)k / (float)(ARC_PTS + 1);
-                                    nv[nc*2]   = Rf * cosf(t);
-                                    nv[nc*2+1] = Rf * sinf(t);
-                                    nc++;
-                                }
-                            }
-                        }
+                nv[nc*2]   = vt[ci*2];
+                nv[nc*2+1] = vt[ci*2+1];
+                nc++;
+
+                if (is_shortcut(job, vt + ci*2, vt + ni*2)) {
+                    /* Insert arc along boundary circle */
+                    float x0 = vt[ci*2], y0 = vt[ci*2+1];
+                    float x1 = vt[ni*2], y1 = vt[ni*2+1];
+                    float a0 = atan2f(y0, x0);
+                    float a1 = atan2f(y1, x1);
+                    float da = a1 - a0;
+                    if (da >  (float)M_PI) da -= 2.0f*(float)M_PI;
+                    if (da < -(float)M_PI) da += 2.0f*(float)M_PI;
+                    for (int k = 1; k <= ARC_PTS; k++) {
+                        float a = a0 + da * (float)k / (float)(ARC_PTS + 1);
+                        nv[nc*2]   = Rf * cosf(a);
+                        nv[nc*2+1] = Rf * sinf(a);
+                        nc++;
                     }
-                    md->segment_starts[s] = ns;
-                    md->segment_counts[s] = nc - ns;
                 }
-                free(md->vertices);
-                md->vertices = nv;
-                md->vertex_count = nc;
             }
         }
+        segs->starts[s] = ns;
+        segs->counts[s] = nc - ns;
+    }
+}
+
+static void project_nosplit(MapData *md)
+{
+    free(md->vertices);
+    md->vertices = NULL;
+    md->vertex_count = 0;
+    if (segtable_reset(&md->segs, SEG_CLAMPED | SEG_CAPS) != 0) return;
+    SegTable *segs = md->segs;
+    const SegTable *raw = md->raw_segs;
+
+    /* Set up clipping mode: ORTHO clips at hemisphere boundary,
+     * AZEQ clips at 175° angular distance from center. */
+    ProjectJob job = { .md = md };
+    projection_get_state(&job.proj);
+    job.is_azeq = (job.proj.mode == PROJ_AZEQ);
+    if (job.is_azeq) {
+        projection_get_center(&job.clat, &job.clon);
+        job.max_dist = 175.0 / 180.0 * M_PI * EARTH_RADIUS_KM;
+    }
+    job.Rf = job.is_azeq ? (float)job.max_dist : (float)projection_get_radius();
+    job.min_r = job.Rf * 0.85f;                  /* endpoints must be near boundary */
+    job.max_edge_sq = job.Rf * job.Rf * 0.25f;   /* edge > 0.5*R triggers arc */
+
+    /* Per-vertex inside/outside flags and projections of the rings that
+     * pass the cull test, packed in ring order, and room for the clipped
+     * rings of every task */
+    int vis_total;
+    int ntasks = plan_ranges(md, &job.ranges, &vis_total);
+    if (ntasks == 0) return;
+    size_t max_out = (size_t)vis_total * 2 + 1;
+    job.back = malloc(vis_total + 1);
+    job.xy = malloc((size_t)(vis_total + 1) * 2 * sizeof(float));
+    job.clip_lats = malloc(max_out * sizeof(double));
+    job.clip_lons = malloc(max_out * sizeof(double));
+    if (!job.back || !job.xy || !job.clip_lats || !job.clip_lons ||
+        segtable_reserve(segs, raw->num) != 0)
+        goto done;
+
+    segs->num = raw->num;
+    if (raw->caps)
+        memcpy(segs->caps, raw->caps, raw->num * sizeof(segs->caps[0]));
+    else
+        for (int s = 0; s < raw->num; s++)
+            segs->caps[s][3] = SEG_CAP_ALL;
+
+    threadpool_run(ntasks, clip_task, &job);
+    free(job.xy);
+    job.xy = NULL;
+
+    /* Stitch: task t's clipped rings follow those of tasks before it */
+    int clip_count = 0;
+    for (int t = 0; t < ntasks; t++) {
+        job.ranges[t].out0 = clip_count;
+        clip_count += job.ranges[t].out;
+    }
+    md->vertices = malloc((size_t)(clip_count + 1) * 2 * sizeof(float));
+    if (!md->vertices) {
+        segs->num = 0;
+        goto done;
+    }
+    threadpool_run(ntasks, clip_project_task, &job);
+    md->vertex_count = clip_count;
+
+    int extra = 0;
+    for (int t = 0; t < ntasks; t++) {
+        job.ranges[t].arc0 = job.ranges[t].out0 + extra;
+        extra += job.ranges[t].extra;
+    }
+    if (extra > 0) {
+        job.arc_verts = malloc((size_t)(md->vertex_count + extra) * 2 * sizeof(float));
+        if (job.arc_verts) {
+            threadpool_run(ntasks, arc_task, &job);
+            free(md->vertices);
+            md->vertices = job.arc_verts;
+            md->vertex_count += extra;
+        }
     }
 
-    free(clip_lats);
-    free(clip_lons);
-    free(back);
+done:
+    free(job.clip_lats);
+    free(job.clip_lons);
+    free(job.xy);
+    free(job.back);
+    free_ranges(job.ranges, ntasks);
 }
 
 void map_data_reproject_nosplit(MapData *md)
@@ -411,16 +715,143 @@ void map_data_reproject(MapData *md)
     }
 }
 
+/* ── Simplification ──────────────────────────────────────────────── */
+
+/* Offset of unit vector p from the great circle through a and b, as the
+ * sine of the angular distance.  When a and b coincide (start/end of a
+ * closed ring) the chord |p - a| is used instead. */
+static double gc_offset(const double *p, const double *a, const double *n, double n_len)
+{
+    if (n_len < 1e-12) {
+        double dx = p[0] - a[0], dy = p[1] - a[1], dz = p[2] - a[2];
+        return sqrt(dx * dx + dy * dy + dz * dz);
+    }
+    return fabs(p[0] * n[0] + p[1] * n[1] + p[2] * n[2]) / n_len;
+}
+
+int map_data_simplify(MapData *dst, const MapData *src, double tol_km)
+{
+    memset(dst, 0, sizeof(*dst));
+    if (!src->raw_unit || !src->raw_segs || src->raw_count == 0)
+        return -1;
+
+    int n = src->raw_count;
+    const float *ux = src->raw_unit, *uy = ux + n, *uz = uy + n;
+    const SegTable *raw = src->raw_segs;
+    double tol = sin(tol_km / EARTH_RADIUS_KM);
+
+    /* keep[] marks surviving vertices; stack holds (first, last) intervals.
+     * Each interval splits into two, so n pairs always suffice. */
+    unsigned char *keep = calloc(n, 1);
+    int *stack = malloc((size_t)n * 2 * sizeof(int));
+    if (!keep || !stack) {
+        free(keep); free(stack);
+        return -1;
+    }
+
+    int total = 0, seg_total = 0;
+    for (int s = 0; s < raw->num; s++) {
+        int base = raw->starts[s], count = raw->counts[s];
+        int last = base + count - 1;
+        keep[base] = keep[last] = 1;
+
+        int sp = 0;
+        stack[sp++] = base;
+        stack[sp++] = last;
+        while (sp > 0) {
+            int j = stack[--sp], i = stack[--sp];
+            if (j - i < 2) continue;
+            double a[3] = { ux[i], uy[i], uz[i] };
+            double b[3] = { ux[j], uy[j], uz[j] };
+            double nrm[3] = { a[1] * b[2] - a[2] * b[1],
+                              a[2] * b[0] - a[0] * b[2],
+                              a[0] * b[1] - a[1] * b[0] };
+            double n_len = sqrt(nrm[0] * nrm[0] + nrm[1] * nrm[1] + nrm[2] * nrm[2]);
+            double d_max = -1.0;
+            int k_max = i;
+            for (int k = i + 1; k < j; k++) {
+                double p[3] = { ux[k], uy[k], uz[k] };
+                double d = gc_offset(p, a, nrm, n_len);
+                if (d > d_max) { d_max = d; k_max = k; }
+            }
+            if (d_max > tol) {
+                keep[k_max] = 1;
+                stack[sp++] = i;     stack[sp++] = k_max;
+                stack[sp++] = k_max; stack[sp++] = j;
+            }
+        }
+
+        /* Closed rings need 3 distinct vertices plus the closing one */
+        int kept = 0;
+        for (int v = base; v <= last; v++) kept += keep[v];
+        int closed = (src->raw_lats[base] == src->raw_lats[last] &&
+                      src->raw_lons[base] == src->raw_lons[last]);
+        if (closed && kept < 4) {
+            memset(keep + base, 0, count);
+            continue;
+        }
+        total += kept;
+        seg_total++;
+    }
+    free(stack);
+
+    dst->raw_lats = malloc(total * sizeof(double));
+    dst->raw_lons = malloc(total * sizeof(double));
+    dst->raw_unit = malloc(total * 3 * sizeof(float));
+    if (!dst->raw_lats || !dst->raw_lons || !dst->raw_unit ||
+        segtable_reset(&dst->raw_segs, SEG_CAPS) != 0 ||
+        segtable_reserve(dst->raw_segs, seg_total) != 0) {
+        free(keep);
+        map_data_free(dst);
+        return -1;
+    }
+
+    float *dx = dst->raw_unit, *dy = dx + total, *dz = dy + total;
+    for (int s = 0; s < raw->num; s++) {
+        int base = raw->starts[s], count = raw->counts[s];
+        int start = dst->raw_count;
+        for (int v = base; v < base + count; v++) {
+            if (!keep[v]) continue;
+            int o = dst->raw_count++;
+            dst->raw_lats[o] = src->raw_lats[v];
+            dst->raw_lons[o] = src->raw_lons[v];
+            dx[o] = ux[v];
+            dy[o] = uy[v];
+            dz[o] = uz[v];
+        }
+        if (dst->raw_count > start)
+            segtable_push(dst->raw_segs, start, dst->raw_count - start);
+    }
+    free(keep);
+    build_caps(dst);
+    return 0;
+}
+
 void map_data_free(MapData *md)
 {
     free(md->vertices);
     md->vertices = NULL;
     md->vertex_count = 0;
-    md->num_segments = 0;
-    free(md->raw_lats);
-    free(md->raw_lons);
+    segtable_unref(md->segs);
+    md->segs = NULL;
+    if (!md->raw_borrowed) {
+        free(md->raw_lats);
+        free(md->raw_lons);
+        free(md->raw_unit);
+    }
+    md->raw_borrowed = 0;
     md->raw_lats = NULL;
     md->raw_lons = NULL;
+    md->raw_unit = NULL;
     md->raw_count = 0;
-    md->raw_num_segments = 0;
+    segtable_unref(md->raw_segs);
+    md->raw_segs = NULL;
+}
+
+size_t map_data_mem_bytes(const MapData *md)
+{
+    size_t bytes = (size_t)md->vertex_count * 2 * sizeof(float);
+    if (md->raw_lats && !md->raw_borrowed) bytes += (size_t)md->raw_count * 2 * sizeof(double);
+    if (md->raw_unit && !md->raw_borrowed) bytes += (size_t)md->raw_count * 3 * sizeof(float);
+    return bytes + segtable_bytes(md->segs) + segtable_bytes(md->raw_segs);
 }
@@ -1,30 +1,36 @@
 /* map_data.h — Shapefile loading and projected vertex management.
  *
  * Loads Natural Earth shapefiles (coastlines, borders, land polygons) via
- * shapelib, stores raw lat/lon, and projects vertices into km-space.
+ * shapelib, stores raw lat/lon (plus precomputed unit vectors so that
+ * reprojection is a rotation), and projects vertices into km-space.
  * Supports reprojection on center/mode change, with two strategies:
  * split-at-jumps (for line features) and nosplit with boundary clipping
- * (for polygon fill via stencil buffer). */
+ * (for polygon fill via stencil buffer).
+ * Every raw segment carries a spherical bounding cap (raw_segs->caps);
+ * with cull set, reprojection only visits segments whose cap meets
+ * cull_cap, so the cost follows what is on screen. */
 
 #ifndef MAP_DATA_H
 #define MAP_DATA_H
 
-#define MAX_SEGMENTS 4096
+#include <stddef.h>
+#include "segtable.h"
 
 typedef struct {
-    float *vertices;       /* Interleaved x,y pairs in km (projected) */
-    int    vertex_count;   /* Total number of vertices */
-    int    segment_starts[MAX_SEGMENTS]; /* Start index of each polyline */
-    int    segment_counts[MAX_SEGMENTS]; /* Vertex count per polyline */
-    int    segment_clamped[MAX_SEGMENTS]; /* 1 if any vertex was back-hemisphere */
-    int    num_segments;
+    float    *vertices;      /* Interleaved x,y pairs in km (projected) */
+    int       vertex_count;  /* Total number of vertices */
+    SegTable *segs;          /* Projected polylines (clamped[] set by nosplit);
+                              * shared with the Renderer on upload */
     /* Raw lat/lon for reprojection */
-    double *raw_lats;
-    double *raw_lons;
-    int     raw_count;
-    int     raw_seg_starts[MAX_SEGMENTS];
-    int     raw_seg_counts[MAX_SEGMENTS];
-    int     raw_num_segments;
+    double   *raw_lats;
+    double   *raw_lons;
+    float    *raw_unit;      /* Unit vectors, 3 planes of raw_count (projection_to_unit) */
+    int       raw_count;
+    SegTable *raw_segs;      /* Source polylines/rings as loaded (with caps) */
+    int       raw_borrowed;  /* raw_* arrays live in a geocache mapping (not freed) */
+    /* Culling: reprojection skips raw segments outside cull_cap */
+    int       cull;          /* 0 = project everything */
+    float     cull_cap[4];   /* unit center x,y,z + radius (rad), see projection.h */
 } MapData;
 
 /* Load shapefile and project all vertices. Returns 0 on success. */
@@ -36,7 +42,23 @@ void map_data_reproject(MapData *md);
 /* Re-project without splitting segments (preserves ring topology for polygon fill). */
 void map_data_reproject_nosplit(MapData *md);
 
-/* Free allocated memory. */
+/* Build a simplified copy of src's raw polylines (Douglas-Peucker on the
+ * unit sphere, max deviation tol_km).  Closed rings that collapse below
+ * four vertices are dropped.  dst gets raw_* fields only; project it with
+ * map_data_reproject*().  Needs src->raw_unit.  Returns 0 on success. */
+int map_data_simplify(MapData *dst, const MapData *src, double tol_km);
+
+/* Split raw polylines into chunks of at most max_pts vertices (adjacent
+ * chunks share a vertex) so that culling works below whole-coastline
+ * granularity.  Line layers only — rings must stay whole for the stencil
+ * fill.  Returns 0 on success. */
+int map_data_chunk(MapData *md, int max_pts);
+
+/* Free allocated memory (drops this MapData's segment table references). */
 void map_data_free(MapData *md);
 
+/* Heap bytes held by md: vertices, raw lat/lon, unit vectors, segment tables
+ * (borrowed raw arrays are not counted). */
+size_t map_data_mem_bytes(const MapData *md);
+
 #endif
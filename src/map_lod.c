@@ -0,0 +1,255 @@
+/* map_lod.c — Level-of-detail pyramids for map layers.
+ *
+ * Tolerances step by 4x so that each level roughly halves the vertex
+ * count of a Natural Earth line layer.  Background projection uses one
+ * joinable thread per job; the main loop polls job_done under the mutex. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "map_lod.h"
+#include "geocache.h"
+#include "projection.h"
+
+/* Simplification tolerance of levels 1.. (km) */
+static const double lod_tol_km[MAP_LOD_MAX_LEVELS - 1] = { 0.5, 2.0, 8.0, 32.0 };
+
+/* Allowed simplification error in framebuffer pixels */
+#define MAP_LOD_PX_TOL 1.0
+
+/* A level must keep at most this fraction of the finer level's vertices */
+#define MAP_LOD_MIN_GAIN 0.8
+
+/* Projected area around the view: radius x2 plus ~60 km, capped at a
+ * hemisphere (wider views project everything) */
+#define MAP_CULL_GUARD   2.0f
+#define MAP_CULL_PAD_RAD 0.01f
+#define MAP_CULL_MAX_RAD 1.5708f
+
+/* Widen a view cap into the cap a projection job covers. */
+static void guard_cap(const float *view, float *guard)
+{
+    memcpy(guard, view, 4 * sizeof(float));
+    if (view[3] < MAP_CULL_MAX_RAD) {
+        guard[3] = view[3] * MAP_CULL_GUARD + MAP_CULL_PAD_RAD;
+        if (guard[3] > MAP_CULL_MAX_RAD) guard[3] = SEG_CAP_ALL;
+    }
+}
+
+/* 1 if the level's projection is current and covers the view. */
+static int level_ready(const MapLod *lod, int level, const float *view_cap)
+{
+    const MapData *md = &lod->levels[level];
+    if (lod->proj_gen[level] != lod->gen) return 0;
+    return !md->cull || projection_cap_covers(md->cull_cap, view_cap);
+}
+
+static void project_level(MapLod *lod, int level, const float *cap)
+{
+    MapData *md = &lod->levels[level];
+    md->cull = (cap[3] < (float)M_PI);
+    memcpy(md->cull_cap, cap, sizeof(md->cull_cap));
+    if (lod->nosplit)
+        map_data_reproject_nosplit(md);
+    else
+        map_data_reproject(md);
+}
+
+static void lod_init(MapLod *lod, int nosplit, int project)
+{
+    memset(lod, 0, sizeof(*lod));
+    lod->nosplit = nosplit;
+    lod->project = project;
+    lod->job_level = -1;
+    pthread_mutex_init(&lod->mutex, NULL);
+}
+
+/* Simplify levels[0] into the coarser levels and chunk line layers. */
+static void build_levels(MapLod *lod)
+{
+    lod->num_levels = 1;
+    for (int i = 0; i < MAP_LOD_MAX_LEVELS - 1; i++) {
+        MapData *finer = &lod->levels[lod->num_levels - 1];
+        MapData *md = &lod->levels[lod->num_levels];
+        if (map_data_simplify(md, &lod->levels[0], lod_tol_km[i]) != 0)
+            break;
+        if (md->raw_count == 0 ||
+            md->raw_count > finer->raw_count * MAP_LOD_MIN_GAIN) {
+            map_data_free(md);
+            continue;
+        }
+        lod->tol_km[lod->num_levels++] = lod_tol_km[i];
+    }
+    if (!lod->nosplit)
+        for (int i = 0; i < lod->num_levels; i++)
+            map_data_chunk(&lod->levels[i], MAP_LOD_CHUNK_PTS);
+}
+
+/* Show the coarsest level, projecting it when the layer is CPU-projected. */
+static void finish_levels(MapLod *lod)
+{
+    for (int i = 0; i < MAP_LOD_MAX_LEVELS; i++)
+        lod->proj_gen[i] = -1;
+
+    /* map_data_load() already split-projected the source; keep that only
+     * where it is the projection this layer uses */
+    if (lod->levels[0].vertices && lod->project && !lod->nosplit) {
+        lod->proj_gen[0] = lod->gen;
+    } else {
+        free(lod->levels[0].vertices);
+        lod->levels[0].vertices = NULL;
+        lod->levels[0].vertex_count = 0;
+        segtable_unref(lod->levels[0].segs);
+        lod->levels[0].segs = NULL;
+    }
+    lod->shown = lod->num_levels - 1;
+    if (lod->project) {
+        float all[4] = { 0.0f, 0.0f, 1.0f, SEG_CAP_ALL };
+        project_level(lod, lod->shown, all);
+        lod->proj_gen[lod->shown] = lod->gen;
+    }
+}
+
+int map_lod_build(MapLod *lod, MapData *src, int nosplit, int project)
+{
+    lod_init(lod, nosplit, project);
+    lod->levels[0] = *src;
+    memset(src, 0, sizeof(*src));
+    build_levels(lod);
+    finish_levels(lod);
+    return 0;
+}
+
+int map_lod_load(MapLod *lod, const char *shp_path, int nosplit, int project,
+                 int use_cache)
+{
+    lod_init(lod, nosplit, project);
+    if (use_cache && geocache_load(lod, shp_path, nosplit) == 0) {
+        lod->cached = 1;
+    } else {
+        if (map_data_load(&lod->levels[0], shp_path) != 0) {
+            map_lod_free(lod);
+            return -1;
+        }
+        build_levels(lod);
+        if (use_cache)
+            geocache_save(lod, shp_path);
+    }
+    finish_levels(lod);
+    return 0;
+}
+
+/* Called from the job thread when a projection finishes */
+static void (*lod_wake)(void);
+
+void map_lod_set_wake(void (*wake)(void))
+{
+    lod_wake = wake;
+}
+
+static int level_for(const MapLod *lod, float km_per_px)
+{
+    double max_err = km_per_px * MAP_LOD_PX_TOL;
+    for (int i = lod->num_levels - 1; i > 0; i--)
+        if (lod->tol_km[i] <= max_err)
+            return i;
+    return 0;
+}
+
+static void *lod_thread(void *arg)
+{
+    MapLod *lod = arg;
+    projection_set_state(&lod->job_proj);
+    project_level(lod, lod->job_level, lod->job_cap);
+    pthread_mutex_lock(&lod->mutex);
+    lod->job_done = 1;
+    pthread_mutex_unlock(&lod->mutex);
+    if (lod_wake) lod_wake();
+    return NULL;
+}
+
+/* Join a running job; returns 0 if it is still running and block is 0. */
+static int collect_job(MapLod *lod, int block)
+{
+    if (lod->job_level < 0) return 1;
+    if (!block) {
+        pthread_mutex_lock(&lod->mutex);
+        int done = lod->job_done;
+        pthread_mutex_unlock(&lod->mutex);
+        if (!done) return 0;
+    }
+    pthread_join(lod->thread, NULL);
+    lod->proj_gen[lod->job_level] = lod->job_gen;
+    lod->job_level = -1;
+    return 1;
+}
+
+int map_lod_update(MapLod *lod, float km_per_px, const float *view_cap)
+{
+    int finished = (lod->job_level >= 0);
+    if (!collect_job(lod, 0))
+        return 0;
+
+    int want = level_for(lod, km_per_px);
+    if (!lod->project) {
+        if (want == lod->shown) return 0;
+        lod->shown = want;
+        return 1;
+    }
+    if (level_ready(lod, want, view_cap)) {
+        /* A finished re-cull of the shown level also needs an upload */
+        int changed = (want != lod->shown) || finished;
+        lod->shown = want;
+        return changed;
+    }
+
+    /* Project the wanted level off the main thread; keep drawing the
+     * current projection until it is ready.  The main thread must not read
+     * the job's level meanwhile; if it is the shown level, segtable_reset()
+     * detaches from the table the renderer still holds. */
+    lod->job_level = want;
+    lod->job_gen = lod->gen;
+    guard_cap(view_cap, lod->job_cap);
+    projection_get_state(&lod->job_proj);
+    lod->job_done = 0;
+    if (pthread_create(&lod->thread, NULL, lod_thread, lod) != 0) {
+        fprintf(stderr, "Warning: LOD worker thread failed, projecting inline\n");
+        lod->job_level = -1;
+        project_level(lod, want, lod->job_cap);
+        lod->proj_gen[want] = lod->gen;
+        lod->shown = want;
+        return 1;
+    }
+    return 0;
+}
+
+const MapData *map_lod_current(const MapLod *lod)
+{
+    return &lod->levels[lod->shown];
+}
+
+void map_lod_wait(MapLod *lod)
+{
+    collect_job(lod, 1);
+}
+
+void map_lod_reproject(MapLod *lod, const float *view_cap)
+{
+    float cap[4];
+    map_lod_wait(lod);
+    lod->gen++;
+    if (!lod->project) return;
+    guard_cap(view_cap, cap);
+    project_level(lod, lod->shown, cap);
+    lod->proj_gen[lod->shown] = lod->gen;
+}
+
+void map_lod_free(MapLod *lod)
+{
+    map_lod_wait(lod);
+    for (int i = 0; i < lod->num_levels; i++)
+        map_data_free(&lod->levels[i]);
+    lod->num_levels = 0;
+    geocache_release(lod);
+    pthread_mutex_destroy(&lod->mutex);
+}
@@ -0,0 +1,91 @@
+/* map_lod.h — Level-of-detail pyramids for map layers.
+ *
+ * A MapLod holds the source MapData (level 0) plus coarser copies built
+ * with map_data_simplify() at load time.  Each frame map_lod_update()
+ * picks the coarsest level whose simplification error stays below about
+ * one pixel at the current zoom, so the vertex count drawn stays roughly
+ * constant from full-Earth view down to ZOOM_MIN_KM.
+ *
+ * Levels are projected lazily and only around the view: each projection
+ * covers a guard cap (the view cap widened 2x) and is redone once the view
+ * leaves it.  A level that is not yet projected for the current
+ * center/mode/view is projected on a background thread while the previous
+ * projection keeps being drawn; the swap happens on the first
+ * map_lod_update() after the job finishes.  A job projects with the
+ * projection state (ProjState) of the thread that started it, so that
+ * thread may move on to a new center meanwhile; only one thread at a time
+ * may call into a given MapLod. */
+
+#ifndef MAP_LOD_H
+#define MAP_LOD_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include "map_data.h"
+#include "projection.h"
+
+#define MAP_LOD_MAX_LEVELS 5
+#define MAP_LOD_CHUNK_PTS  256
+
+typedef struct {
+    MapData levels[MAP_LOD_MAX_LEVELS];   /* [0] = source, coarser upward */
+    double  tol_km[MAP_LOD_MAX_LEVELS];   /* simplification tolerance (0 = source) */
+    int     proj_gen[MAP_LOD_MAX_LEVELS]; /* gen the level was projected at (-1 = never) */
+    int     num_levels;
+    int     shown;     /* level the renderer currently draws */
+    int     gen;       /* bumped by map_lod_reproject() */
+    int     nosplit;   /* 1 = polygon rings (map_data_reproject_nosplit) */
+    int     project;   /* 0 = drawn from raw lat/lon (GPU projection), no CPU work */
+    int     cached;    /* 1 = levels were loaded from the geometry cache */
+    void   *cache_map; /* geocache mapping the levels' raw arrays point into */
+    size_t  cache_len;
+
+    /* Background projection job (one at a time) */
+    pthread_t       thread;
+    pthread_mutex_t mutex;
+    int             job_level;  /* level being projected, -1 = idle */
+    int             job_gen;
+    float           job_cap[4];
+    ProjState       job_proj;   /* starting thread's mode/center */
+    int             job_done;
+} MapLod;
+
+/* Build the pyramid from src, taking ownership of it (src is zeroed).
+ * Levels that would not save at least a fifth of the vertices of the next
+ * finer level are skipped.  Line layers (nosplit 0) are split into
+ * MAP_LOD_CHUNK_PTS-vertex chunks for culling.  The coarsest level is
+ * projected immediately (when project is set) and shown first.
+ * Returns 0 on success. */
+int map_lod_build(MapLod *lod, MapData *src, int nosplit, int project);
+
+/* Load a shapefile layer and build its pyramid.  With use_cache set the
+ * finished levels come from the geometry cache (geocache.h) when it is
+ * current for shp_path, and are written to it after a fresh build.
+ * Returns 0 on success. */
+int map_lod_load(MapLod *lod, const char *shp_path, int nosplit, int project,
+                 int use_cache);
+
+/* Choose the level for the given view scale (km per framebuffer pixel),
+ * collect a finished background job and start a new one if the level or
+ * the view cap (projection_view_cap) needs it.  Returns 1 if the shown
+ * geometry changed and must be uploaded. */
+int map_lod_update(MapLod *lod, float km_per_px, const float *view_cap);
+
+/* The level the renderer should draw. */
+const MapData *map_lod_current(const MapLod *lod);
+
+/* Call wake (must be thread-safe, e.g. glfwPostEmptyEvent) when a
+ * background projection job finishes.  NULL disables it. */
+void map_lod_set_wake(void (*wake)(void));
+
+/* Block until any background projection job has finished. */
+void map_lod_wait(MapLod *lod);
+
+/* Re-project the shown level around view_cap after a center/mode change
+ * (waits for a running job first); other levels follow when next needed. */
+void map_lod_reproject(MapLod *lod, const float *view_cap);
+
+/* Free all levels and unmap the cache file (waits for a running job). */
+void map_lod_free(MapLod *lod);
+
+#endif
@@ -3,34 +3,24 @@
  * Four overlay types, each with parse → store → project → render pipeline:
  * - MUF: GeoJSON LineStrings with per-feature color/level, split at jumps
  * - Sporadic E: station foEs values → IDW grid → marching squares contours
- * - Aurora: OVATION probability grid → polar mesh with alpha mapping
- * - DRAP: HAF text grid → bilinear lookup → polar mesh with alpha mapping
+ * - Aurora: OVATION probability grid → lat/lon raster + alpha ramp
+ * - DRAP: HAF text grid → lat/lon raster + alpha ramp
+ * The two rasters can also be contoured (contour.c) into isoline layers.
  *
- * MUF and Sporadic E share the MufData struct; Aurora and DRAP share the
- * AuroraMesh struct (same polar mesh generation pattern as nightmesh). */
+ * MUF, Sporadic E and the isolines share the MufData struct; Aurora and DRAP share the
+ * HeatGrid struct, which the renderer samples as a texture with bilinear
+ * filtering after inverse-projecting each pixel (no per-center work). */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include "overlay.h"
+#include "contour.h"
 #include "projection.h"
-#include "cJSON.h"
+#include "threadpool.h"
 
-/* ── MUF contour lines ─────────────────────────────────────────── */
-
-void muf_data_init(MufData *m)
-{
-    memset(m, 0, sizeof(*m));
-}
-
-void muf_data_free(MufData *m)
-{
-    free(m->raw_lats);
-    free(m->raw_lons);
-    free(m->vertices);
-    memset(m, 0, sizeof(*m));
-}
+/* ── Streaming JSON feeds ──────────────────────────────────────── */
 
 /* Parse hex color string "#RRGGBB" → RGBA float (alpha=1) */
 static void hex_to_rgba(const char *hex, float rgba[4])
@@ -44,113 +34,324 @@ static void hex_to_rgba(const char *hex, float rgba[4])
     rgba[3] = 1.0f;
 }
 
-int muf_parse_geojson(const char *json_str, MufData *m)
+/* 1 if open container `level` is an object whose current member is key */
+static int key_is(const JsonPull *p, int level, const char *key)
 {
-    cJSON *root = cJSON_Parse(json_str);
-    if (!root) return -1;
-
-    cJSON *features = cJSON_GetObjectItem(root, "features");
-    if (!cJSON_IsArray(features)) { cJSON_Delete(root); return -1; }
-
-    /* First pass: count total coordinates across all LineString features */
-    int total_coords = 0;
-    int total_segs = 0;
-    cJSON *feat;
-    cJSON_ArrayForEach(feat, features) {
-        cJSON *geom = cJSON_GetObjectItem(feat, "geometry");
-        if (!geom) continue;
-        cJSON *type = cJSON_GetObjectItem(geom, "type");
-        if (!type || !cJSON_IsString(type)) continue;
-        if (strcmp(type->valuestring, "LineString") != 0) continue;
-        cJSON *coords = cJSON_GetObjectItem(geom, "coordinates");
-        if (!cJSON_IsArray(coords)) continue;
-        int n = cJSON_GetArraySize(coords);
-        if (n < 2) continue;
-        total_coords += n;
-        total_segs++;
-    }
-
-    if (total_coords == 0 || total_segs == 0) {
-        cJSON_Delete(root);
-        return -1;
-    }
+    return p->levels[level].kind == '{' && strcmp(p->levels[level].key, key) == 0;
+}
 
-    /* Allocate raw storage */
-    free(m->raw_lats);
-    free(m->raw_lons);
-    m->raw_lats = malloc(total_coords * sizeof(double));
-    m->raw_lons = malloc(total_coords * sizeof(double));
-    if (!m->raw_lats || !m->raw_lons) {
-        cJSON_Delete(root);
-        return -1;
-    }
+void overlay_stream_init(OverlayStream *s, OverlayFeed feed)
+{
+    memset(s, 0, sizeof(*s));
+    s->feed = feed;
+    json_pull_init(&s->jp);
+}
 
-    /* Second pass: extract coordinates, colors, and legend entries */
-    m->raw_count = 0;
-    m->raw_num_segments = 0;
-    m->legend_count = 0;
+void overlay_stream_free(OverlayStream *s)
+{
+    json_pull_free(&s->jp);
+    free(s->lats);
+    free(s->lons);
+    segtable_unref(s->segs);
+    free(s->aurora);
+    overlay_stream_init(s, s->feed);
+}
 
-    cJSON_ArrayForEach(feat, features) {
-        if (m->raw_num_segments >= MUF_MAX_SEGMENTS) break;
-
-        cJSON *geom = cJSON_GetObjectItem(feat, "geometry");
-        if (!geom) continue;
-        cJSON *type = cJSON_GetObjectItem(geom, "type");
-        if (!type || !cJSON_IsString(type) ||
-            strcmp(type->valuestring, "LineString") != 0) continue;
-        cJSON *coords = cJSON_GetObjectItem(geom, "coordinates");
-        if (!cJSON_IsArray(coords)) continue;
-        int n = cJSON_GetArraySize(coords);
-        if (n < 2) continue;
-
-        /* Get stroke color and level-value from properties */
-        float color[4] = { 1.0f, 1.0f, 0.0f, 1.0f }; /* default yellow */
-        float mhz = 0.0f;
-        cJSON *props = cJSON_GetObjectItem(feat, "properties");
-        if (props) {
-            cJSON *stroke = cJSON_GetObjectItem(props, "stroke");
-            if (stroke && cJSON_IsString(stroke))
-                hex_to_rgba(stroke->valuestring, color);
-            cJSON *level = cJSON_GetObjectItem(props, "level-value");
-            if (level && cJSON_IsNumber(level))
-                mhz = (float)level->valuedouble;
+/* MUF GeoJSON: features[i].geometry {type, coordinates [[lon, lat], ...]}
+ * and features[i].properties {stroke, level-value}.  Levels: 0 root,
+ * 1 features, 2 feature, 3 geometry / properties, 4 coordinates, 5 point. */
+static int muf_token(OverlayStream *s, JsonToken t)
+{
+    const JsonPull *p = &s->jp;
+    int d = p->depth;
+    if (d < 2 || !key_is(p, 0, "features") || p->levels[1].kind != '[') return 0;
+
+    if (t == JSON_TOK_OBJECT && d == 3) {
+        s->feat_start = s->count;
+        s->feat_line = 0;
+        s->feat_mhz = 0.0f;
+        memcpy(s->feat_color, (float[4]){ 1.0f, 1.0f, 0.0f, 1.0f }, /* default yellow */
+               sizeof(s->feat_color));
+        return 0;
+    }
+    if (t == JSON_TOK_OBJECT_END && d == 2) {
+        int n = s->count - s->feat_start;
+        if (!s->feat_line || n < 2) {
+            s->count = s->feat_start;
+            return 0;
         }
+        if (!s->segs && !(s->segs = segtable_new(SEG_COLORS))) return -1;
+        int si = segtable_push(s->segs, s->feat_start, n);
+        if (si < 0) return -1;
+        memcpy(s->segs->colors[si], s->feat_color, sizeof(s->feat_color));
 
         /* Add unique legend entry (deduplicate by mhz value) */
-        if (mhz > 0.0f && m->legend_count < MUF_MAX_LEGEND) {
+        if (s->feat_mhz > 0.0f && s->legend_count < MUF_MAX_LEGEND) {
             int found = 0;
-            for (int li = 0; li < m->legend_count; li++) {
-                if (m->legend[li].mhz == mhz) { found = 1; break; }
-            }
+            for (int li = 0; li < s->legend_count; li++)
+                if (s->legend[li].mhz == s->feat_mhz) { found = 1; break; }
             if (!found) {
-                m->legend[m->legend_count].mhz = mhz;
-                memcpy(m->legend[m->legend_count].color, color, sizeof(color));
-                m->legend_count++;
+                s->legend[s->legend_count].mhz = s->feat_mhz;
+                memcpy(s->legend[s->legend_count].color, s->feat_color,
+                       sizeof(s->feat_color));
+                s->legend_count++;
             }
         }
+        return 0;
+    }
+    if (d < 4) return 0;
+
+    if (key_is(p, 2, "properties")) {
+        if (d == 4 && t == JSON_TOK_STRING && key_is(p, 3, "stroke"))
+            hex_to_rgba(p->str, s->feat_color);
+        else if (d == 4 && t == JSON_TOK_NUMBER && key_is(p, 3, "level-value"))
+            s->feat_mhz = (float)p->num;
+        return 0;
+    }
+    if (!key_is(p, 2, "geometry")) return 0;
+    if (d == 4 && t == JSON_TOK_STRING && key_is(p, 3, "type")) {
+        s->feat_line = strcmp(p->str, "LineString") == 0;
+        return 0;
+    }
+    if (!key_is(p, 3, "coordinates")) return 0;
+    if (t == JSON_TOK_ARRAY && d == 6) {
+        s->tuple_have = 0;
+    } else if (t == JSON_TOK_NUMBER && d == 6) {
+        int i = p->levels[5].index;
+        if (i < 2) {
+            s->tuple[i] = p->num;
+            s->tuple_have |= 1 << i;
+        }
+    } else if (t == JSON_TOK_ARRAY_END && d == 5 && s->tuple_have == 3) {
+        if (s->count == s->cap) {
+            int ncap = s->cap ? s->cap * 2 : 4096;
+            double *lats = realloc(s->lats, ncap * sizeof(double));
+            if (!lats) return -1;
+            s->lats = lats;
+            double *lons = realloc(s->lons, ncap * sizeof(double));
+            if (!lons) return -1;
+            s->lons = lons;
+            s->cap = ncap;
+        }
+        s->lons[s->count] = s->tuple[0];
+        s->lats[s->count] = s->tuple[1];
+        s->count++;
+    }
+    return 0;
+}
 
-        int seg_idx = m->raw_num_segments;
-        m->raw_seg_starts[seg_idx] = m->raw_count;
-        memcpy(m->raw_seg_colors[seg_idx], color, sizeof(color));
-
-        cJSON *coord;
-        int count = 0;
-        cJSON_ArrayForEach(coord, coords) {
-            if (!cJSON_IsArray(coord) || cJSON_GetArraySize(coord) < 2) continue;
-            cJSON *lon_j = cJSON_GetArrayItem(coord, 0);
-            cJSON *lat_j = cJSON_GetArrayItem(coord, 1);
-            if (!cJSON_IsNumber(lon_j) || !cJSON_IsNumber(lat_j)) continue;
-            m->raw_lons[m->raw_count] = lon_j->valuedouble;
-            m->raw_lats[m->raw_count] = lat_j->valuedouble;
-            m->raw_count++;
-            count++;
+/* KC2G stations: [{foes, station {latitude, longitude}}, ...], lat/lon
+ * as strings with lon in 0-360.  Levels: 0 root, 1 entry, 2 station. */
+static int spore_token(OverlayStream *s, JsonToken t)
+{
+    const JsonPull *p = &s->jp;
+    int d = p->depth;
+
+    if (t == JSON_TOK_OBJECT && d == 2) {
+        s->tuple_have = 0;
+    } else if (t == JSON_TOK_NUMBER && d == 2 && key_is(p, 1, "foes")) {
+        s->tuple[2] = p->num;
+        s->tuple_have |= 4;
+    } else if ((t == JSON_TOK_NUMBER || t == JSON_TOK_STRING) && d == 3 &&
+               key_is(p, 1, "station")) {
+        double v = t == JSON_TOK_NUMBER ? p->num : strtod(p->str, NULL);
+        if (key_is(p, 2, "latitude"))  { s->tuple[0] = v; s->tuple_have |= 1; }
+        if (key_is(p, 2, "longitude")) { s->tuple[1] = v; s->tuple_have |= 2; }
+    } else if (t == JSON_TOK_OBJECT_END && d == 1) {
+        double lat = s->tuple[0], lon = s->tuple[1];
+        if (s->tuple_have != 7 || s->tuple[2] <= 0.0 || s->nsta >= SPORE_MAX_STATIONS)
+            return 0;
+        if (lat < -90.0 || lat > 90.0 || lon < -360.0 || lon > 360.0) return 0;
+        /* Convert 0-360 longitude to -180..+180 */
+        if (lon > 180.0) lon -= 360.0;
+        s->sta[s->nsta].lat = lat;
+        s->sta[s->nsta].lon = lon;
+        s->sta[s->nsta].foes = (float)s->tuple[2];
+        s->nsta++;
+    }
+    return 0;
+}
+
+/* OVATION: {"coordinates": [[lon, lat, probability], ...], ...}.
+ * Levels: 0 root, 1 coordinates, 2 triplet. */
+static int aurora_token(OverlayStream *s, JsonToken t)
+{
+    const JsonPull *p = &s->jp;
+    int d = p->depth;
+    if (d < 2 || !key_is(p, 0, "coordinates") || p->levels[1].kind != '[') return 0;
+
+    if (t == JSON_TOK_ARRAY && d == 2) {
+        if (!s->aurora && !(s->aurora = calloc(360 * 181, sizeof(int)))) return -1;
+    } else if (t == JSON_TOK_ARRAY && d == 3) {
+        s->tuple_have = 0;
+    } else if (t == JSON_TOK_NUMBER && d == 3) {
+        int i = p->levels[2].index;
+        if (i < 3) {
+            s->tuple[i] = p->num;
+            s->tuple_have |= 1 << i;
         }
+    } else if (t == JSON_TOK_ARRAY_END && d == 2 && s->tuple_have == 7) {
+        int lon = (int)s->tuple[0];
+        int lat = (int)s->tuple[1];
+        /* Normalize lon to 0-359 */
+        lon = ((lon % 360) + 360) % 360;
+        int lat_idx = lat + 90;
+        if (lat_idx >= 0 && lat_idx <= 180)
+            s->aurora[lon * 181 + lat_idx] = (int)s->tuple[2];
+    }
+    return 0;
+}
 
-        m->raw_seg_counts[seg_idx] = count;
-        m->raw_num_segments++;
+/* Kp: [["time_tag", "Kp", ...], [time, kp, ...], ...], the last row is
+ * the most recent.  Levels: 0 root, 1 row. */
+static int kp_token(OverlayStream *s, JsonToken t)
+{
+    const JsonPull *p = &s->jp;
+    /* Depth of the value the token starts (0 for keys and closes) */
+    int d = (t == JSON_TOK_ARRAY || t == JSON_TOK_OBJECT) ? p->depth - 1
+          : t >= JSON_TOK_STRING ? p->depth : 0;
+
+    if (d == 1) {
+        /* A new row: bit 0 = array, 1 = has element 1, 2 = numeric */
+        s->rows++;
+        s->tuple_have = t == JSON_TOK_ARRAY;
+        s->value_ok = 0;
+    } else if (d == 2 && p->levels[1].kind == '[' && p->levels[1].index == 1) {
+        s->tuple_have |= 2;
+        if (t == JSON_TOK_STRING) { s->value = (float)atof(p->str); s->tuple_have |= 4; }
+        if (t == JSON_TOK_NUMBER) { s->value = (float)p->num;       s->tuple_have |= 4; }
+    } else if (t == JSON_TOK_ARRAY_END && p->depth == 1) {
+        s->value_ok = s->tuple_have;
+    }
+    return 0;
+}
+
+/* Bz: {"Bt": "5", "Bz": "-2", "TimeStamp": "..."} */
+static int bz_token(OverlayStream *s, JsonToken t)
+{
+    const JsonPull *p = &s->jp;
+    if (p->depth != 1 || !key_is(p, 0, "Bz")) return 0;
+    if (t == JSON_TOK_STRING) { s->value = (float)atof(p->str); s->value_ok = 1; }
+    if (t == JSON_TOK_NUMBER) { s->value = (float)p->num;       s->value_ok = 1; }
+    return 0;
+}
+
+static int stream_token(OverlayStream *s, JsonToken t)
+{
+    if (!s->started) {
+        /* Root: an array of stations / rows, an object for MUF and aurora,
+         * anything for Bz (a missing "Bz" keeps the previous value) */
+        int want_array = s->feed == OVERLAY_FEED_SPORE || s->feed == OVERLAY_FEED_KP;
+        s->started = 1;
+        if (s->feed == OVERLAY_FEED_BZ) return 0;
+        return t == (want_array ? JSON_TOK_ARRAY : JSON_TOK_OBJECT) ? 0 : -1;
+    }
+    switch (s->feed) {
+    case OVERLAY_FEED_MUF:    return muf_token(s, t);
+    case OVERLAY_FEED_SPORE:  return spore_token(s, t);
+    case OVERLAY_FEED_AURORA: return aurora_token(s, t);
+    case OVERLAY_FEED_KP:     return kp_token(s, t);
+    case OVERLAY_FEED_BZ:     return bz_token(s, t);
+    }
+    return -1;
+}
+
+int overlay_stream_feed(OverlayStream *s, const char *data, size_t len)
+{
+    if (s->status != 0) return s->status < 0 ? -1 : 0;
+    if (data)
+        json_pull_feed(&s->jp, data, len);
+    else
+        json_pull_end(&s->jp);
+
+    for (;;) {
+        JsonToken t = json_pull_next(&s->jp);
+        if (t == JSON_TOK_MORE) return 0;
+        if (t == JSON_TOK_END) {
+            s->status = 1;
+            return 0;
+        }
+        if (t == JSON_TOK_ERROR || stream_token(s, t) != 0) {
+            s->status = -1;
+            return -1;
+        }
     }
+}
+
+/* Parse a whole response held in memory into s. */
+static void stream_parse(OverlayStream *s, OverlayFeed feed, const char *text)
+{
+    overlay_stream_init(s, feed);
+    overlay_stream_feed(s, text, strlen(text));
+    overlay_stream_feed(s, NULL, 0);
+}
+
+/* ── MUF contour lines ─────────────────────────────────────────── */
+
+void muf_data_init(MufData *m)
+{
+    memset(m, 0, sizeof(*m));
+}
+
+void muf_data_free(MufData *m)
+{
+    free(m->raw_lats);
+    free(m->raw_lons);
+    free(m->raw_unit);
+    free(m->vertices);
+    segtable_unref(m->raw_segs);
+    segtable_unref(m->segs);
+    memset(m, 0, sizeof(*m));
+}
+
+size_t muf_data_mem_bytes(const MufData *m)
+{
+    size_t bytes = (size_t)m->vertex_count * 2 * sizeof(float);
+    if (m->raw_lats) bytes += (size_t)m->raw_count * 2 * sizeof(double);
+    if (m->raw_unit) bytes += (size_t)m->raw_count * 3 * sizeof(float);
+    return bytes + segtable_bytes(m->segs) + segtable_bytes(m->raw_segs);
+}
+
+/* Precompute unit vectors for the freshly parsed raw lat/lon so that
+ * muf_reproject() is a rotation.  On allocation failure raw_unit stays
+ * NULL and reprojection falls back to the lat/lon path. */
+static void muf_build_unit(MufData *m)
+{
+    free(m->raw_unit);
+    m->raw_unit = NULL;
+    if (m->raw_count == 0) return;
+    m->raw_unit = malloc(m->raw_count * 3 * sizeof(float));
+    if (m->raw_unit)
+        projection_to_unit(m->raw_lats, m->raw_lons, m->raw_count, m->raw_unit);
+}
+
+int muf_parse_geojson(const char *json_str, MufData *m)
+{
+    OverlayStream s;
+    stream_parse(&s, OVERLAY_FEED_MUF, json_str);
+    int ret = muf_take_stream(m, &s);
+    overlay_stream_free(&s);
+    return ret;
+}
+
+int muf_take_stream(MufData *m, OverlayStream *s)
+{
+    if (s->status != 1 || !s->segs) return -1;
 
-    cJSON_Delete(root);
+    /* The stream's arrays become the raw storage */
+    free(m->raw_lats);
+    free(m->raw_lons);
+    segtable_unref(m->raw_segs);
+    m->raw_lats = s->lats;
+    m->raw_lons = s->lons;
+    m->raw_count = s->count;
+    m->raw_segs = s->segs;
+    s->lats = s->lons = NULL;
+    s->segs = NULL;
+    s->count = s->cap = 0;
+
+    memcpy(m->legend, s->legend, sizeof(s->legend));
+    m->legend_count = s->legend_count;
 
     /* Sort legend entries by MHz ascending */
     for (int i = 0; i < m->legend_count - 1; i++) {
@@ -164,6 +365,7 @@ int muf_parse_geojson(const char *json_str, MufData *m)
     }
 
     /* Project into km-space */
+    muf_build_unit(m);
     muf_reproject(m);
     return 0;
 }
@@ -177,22 +379,22 @@ void muf_reproject(MufData *m)
     /* Project all raw vertices */
     float *proj = malloc(m->raw_count * 2 * sizeof(float));
     if (!proj) return;
-    for (int i = 0; i < m->raw_count; i++) {
-        double x, y;
-        projection_forward(m->raw_lats[i], m->raw_lons[i], &x, &y);
-        proj[i * 2]     = (float)x;
-        proj[i * 2 + 1] = (float)y;
-    }
+    if (m->raw_unit)
+        projection_forward_unit_batch(m->raw_unit, m->raw_count, m->raw_count, proj, NULL, 0);
+    else
+        projection_forward_batch(m->raw_lats, m->raw_lons, m->raw_count, proj, NULL, 0);
 
     free(m->vertices);
     m->vertices = proj;
     m->vertex_count = m->raw_count;
-    m->num_segments = 0;
+    if (segtable_reset(&m->segs, SEG_COLORS) != 0) return;
+    SegTable *segs = m->segs;
+    const SegTable *raw = m->raw_segs;
 
     /* Split segments at large jumps (same as map_data.c) */
-    for (int s = 0; s < m->raw_num_segments && m->num_segments < MUF_MAX_SEGMENTS; s++) {
-        int base = m->raw_seg_starts[s];
-        int count = m->raw_seg_counts[s];
+    for (int s = 0; s < raw->num; s++) {
+        int base = raw->starts[s];
+        int count = raw->counts[s];
         int seg_start = base;
 
         for (int v = 1; v < count; v++) {
@@ -204,12 +406,10 @@ void muf_reproject(MufData *m)
 
             if (dist > MUF_SPLIT_THRESHOLD_KM * MUF_SPLIT_THRESHOLD_KM) {
                 int sub_count = (base + v) - seg_start;
-                if (sub_count >= 2 && m->num_segments < MUF_MAX_SEGMENTS) {
-                    int si = m->num_segments;
-                    m->segment_starts[si] = seg_start;
-                    m->segment_counts[si] = sub_count;
-                    memcpy(m->segment_colors[si], m->raw_seg_colors[s], 4 * sizeof(float));
-                    m->num_segments++;
+                if (sub_count >= 2) {
+                    int si = segtable_push(segs, seg_start, sub_count);
+                    if (si >= 0)
+                        memcpy(segs->colors[si], raw->colors[s], 4 * sizeof(float));
                 }
                 seg_start = base + v;
             }
@@ -217,23 +417,76 @@ void muf_reproject(MufData *m)
 
         /* Flush remaining */
         int sub_count = (base + count) - seg_start;
-        if (sub_count >= 2 && m->num_segments < MUF_MAX_SEGMENTS) {
-            int si = m->num_segments;
-            m->segment_starts[si] = seg_start;
-            m->segment_counts[si] = sub_count;
-            memcpy(m->segment_colors[si], m->raw_seg_colors[s], 4 * sizeof(float));
-            m->num_segments++;
+        if (sub_count >= 2) {
+            int si = segtable_push(segs, seg_start, sub_count);
+            if (si >= 0)
+                memcpy(segs->colors[si], raw->colors[s], 4 * sizeof(float));
+        }
+    }
+}
+
+/* ── Contour layers ────────────────────────────────────────────── */
+
+/* Replace m's lines with the isolines of cg at each level, colored and
+ * listed in the legend per level, and project them.  m is unchanged on
+ * failure. */
+static int contour_levels(MufData *m, const ContourGrid *cg, const float *levels,
+                          const float (*colors)[4], int nlevels)
+{
+    SegTable *segs = segtable_new(SEG_COLORS);
+    if (!segs) return -1;
+    Contour ct;
+    contour_init(&ct, segs);
+    for (int li = 0; li < nlevels; li++) {
+        int first = segs->num;
+        if (contour_trace(&ct, cg, levels[li]) < 0) {
+            contour_free(&ct);
+            segtable_unref(segs);
+            return -1;
         }
+        for (int s = first; s < segs->num; s++)
+            memcpy(segs->colors[s], colors[li], sizeof(float) * 4);
+    }
+
+    free(m->raw_lats);
+    free(m->raw_lons);
+    segtable_unref(m->raw_segs);
+    m->raw_lats = ct.lats;
+    m->raw_lons = ct.lons;
+    m->raw_count = ct.count;
+    m->raw_segs = segs;
+    ct.lats = ct.lons = NULL;
+    contour_free(&ct);
+
+    m->legend_count = 0;
+    for (int li = 0; li < nlevels && li < MUF_MAX_LEGEND; li++) {
+        m->legend[li].mhz = levels[li];
+        memcpy(m->legend[li].color, colors[li], sizeof(float) * 4);
+        m->legend_count++;
+    }
+
+    /* No crossings at all: drop the previous projection too */
+    if (m->raw_count == 0) {
+        m->vertex_count = 0;
+        segtable_reset(&m->segs, SEG_COLORS);
     }
+    muf_build_unit(m);
+    muf_reproject(m);
+    return 0;
 }
 
 /* ── Sporadic E (foEs) contour overlay ─────────────────────────── */
 
-/* IDW grid dimensions: 2° resolution */
-#define SPORE_GRID_COLS 180   /* -180 to +178 in 2° steps */
-#define SPORE_GRID_ROWS  91   /* -90 to +90 in 2° steps */
-#define SPORE_MAX_STATIONS 200
+/* IDW: weight 1/d² (d in km, at least 1), stations within 2500 km */
 #define SPORE_MAX_RADIUS_KM 2500.0
+#define SPORE_MAX_COLS      720     /* 0.5° grid */
+
+/* A refresh changing more than half the stations, or the 16th incremental
+ * one in a row (rounding in the add/subtract sums), does a full pass */
+#define SPORE_FULL_EVERY    16
+
+/* Grid rows per pool task */
+#define SPORE_TASK_ROWS     4
 
 /* Contour levels and colors for foEs */
 static const float spore_levels[] = { 3.0f, 5.0f, 7.0f, 10.0f, 14.0f };
@@ -246,611 +499,320 @@ static const float spore_colors[][4] = {
 };
 #define SPORE_NUM_LEVELS 5
 
-/* Haversine distance in km (inlined for IDW loop performance) */
-static double spore_dist_km(double lat1, double lon1, double lat2, double lon2)
+void spore_grid_init(SporeGrid *g, double step_deg)
 {
-    double dlat = (lat2 - lat1) * M_PI / 180.0;
-    double dlon = (lon2 - lon1) * M_PI / 180.0;
-    double a = sin(dlat / 2);
-    double b = sin(dlon / 2);
-    a = a * a + cos(lat1 * M_PI / 180.0) * cos(lat2 * M_PI / 180.0) * b * b;
-    return 2.0 * 6371.0 * asin(sqrt(a));
+    memset(g, 0, sizeof(*g));
+    g->step = (step_deg == 1.0 || step_deg == 0.5) ? step_deg : 2.0;
+    g->cols = (int)(360.0 / g->step + 0.5);
+    g->rows = (int)(180.0 / g->step + 0.5) + 1;
 }
 
-/* Marching squares edge table: for each of the 16 cases, pairs of edges to connect.
- * Edges: 0=bottom, 1=right, 2=top, 3=left. -1 terminates. */
-static const int ms_edges[16][5] = {
-    { -1, -1, -1, -1, -1 },  /* 0000 */
-    {  3,  0, -1, -1, -1 },  /* 0001 */
-    {  0,  1, -1, -1, -1 },  /* 0010 */
-    {  3,  1, -1, -1, -1 },  /* 0011 */
-    {  1,  2, -1, -1, -1 },  /* 0100 */
-    { -1, -1, -1, -1, -1 },  /* 0101 saddle — skip */
-    {  0,  2, -1, -1, -1 },  /* 0110 */
-    {  3,  2, -1, -1, -1 },  /* 0111 */
-    {  2,  3, -1, -1, -1 },  /* 1000 */
-    {  2,  0, -1, -1, -1 },  /* 1001 */
-    { -1, -1, -1, -1, -1 },  /* 1010 saddle — skip */
-    {  2,  1, -1, -1, -1 },  /* 1011 */
-    {  1,  3, -1, -1, -1 },  /* 1100 */
-    {  1,  0, -1, -1, -1 },  /* 1101 */
-    {  0,  3, -1, -1, -1 },  /* 1110 */
-    { -1, -1, -1, -1, -1 },  /* 1111 */
-};
-
-/* Interpolate edge crossing position. Returns lat,lon of the crossing point. */
-static void ms_edge_interp(int edge, int r, int c,
-                            float v00, float v10, float v01, float v11,
-                            float level, double *lat, double *lon)
+void spore_grid_free(SporeGrid *g)
 {
-    /* Grid cell corners in lat/lon:
-     * (r,c)=bottom-left  (r,c+1)=bottom-right
-     * (r+1,c)=top-left   (r+1,c+1)=top-right */
-    double lat0 = -90.0 + r * 2.0;
-    double lat1 = lat0 + 2.0;
-    double lon0 = -180.0 + c * 2.0;
-    double lon1 = lon0 + 2.0;
-
-    float t;
-    switch (edge) {
-    case 0: /* bottom: (r,c)→(r,c+1) */
-        t = (v00 == v10) ? 0.5f : (level - v00) / (v10 - v00);
-        *lat = lat0;
-        *lon = lon0 + t * 2.0;
-        break;
-    case 1: /* right: (r,c+1)→(r+1,c+1) */
-        t = (v10 == v11) ? 0.5f : (level - v10) / (v11 - v10);
-        *lat = lat0 + t * 2.0;
-        *lon = lon1;
-        break;
-    case 2: /* top: (r+1,c)→(r+1,c+1) */
-        t = (v01 == v11) ? 0.5f : (level - v01) / (v11 - v01);
-        *lat = lat1;
-        *lon = lon0 + t * 2.0;
-        break;
-    case 3: /* left: (r,c)→(r+1,c) */
-        t = (v00 == v01) ? 0.5f : (level - v00) / (v01 - v00);
-        *lat = lat0 + t * 2.0;
-        *lon = lon0;
-        break;
-    default:
-        *lat = lat0;
-        *lon = lon0;
-        break;
-    }
+    free(g->unit);
+    free(g->wsum);
+    free(g->vsum);
+    free(g->count);
+    spore_grid_init(g, g->step);
 }
 
-/* Parse KC2G stations JSON into Sporadic E contour lines.
- *
- * Pipeline: 1) Extract ionosonde stations with valid foEs readings
- *           2) IDW interpolation onto a 2° regular grid (power=2, radius 2500 km)
- *           3) Marching squares to extract contour line fragments
- *           4) Chain fragments into polylines by endpoint matching
- *           5) Project into km-space via muf_reproject() */
-int spore_parse_json(const char *json_str, MufData *m)
+void spore_grid_reset(SporeGrid *g)
 {
-    cJSON *root = cJSON_Parse(json_str);
-    if (!root || !cJSON_IsArray(root)) { cJSON_Delete(root); return -1; }
-
-    /* Step 1: Extract stations with valid foEs */
-    double sta_lat[SPORE_MAX_STATIONS], sta_lon[SPORE_MAX_STATIONS];
-    float sta_foes[SPORE_MAX_STATIONS];
-    int nsta = 0;
-
-    cJSON *item;
-    cJSON_ArrayForEach(item, root) {
-        if (nsta >= SPORE_MAX_STATIONS) break;
-        cJSON *foes = cJSON_GetObjectItem(item, "foes");
-        if (!foes || cJSON_IsNull(foes) || !cJSON_IsNumber(foes)) continue;
-        if (foes->valuedouble <= 0.0) continue;
-
-        /* lat/lon are inside nested "station" object, as strings, lon in 0-360 */
-        cJSON *station = cJSON_GetObjectItem(item, "station");
-        if (!station) continue;
-        cJSON *lat = cJSON_GetObjectItem(station, "latitude");
-        cJSON *lon = cJSON_GetObjectItem(station, "longitude");
-        if (!lat || !lon) continue;
-
-        double dlat = cJSON_IsNumber(lat) ? lat->valuedouble
-                    : (cJSON_IsString(lat) ? strtod(lat->valuestring, NULL) : 0.0);
-        double dlon = cJSON_IsNumber(lon) ? lon->valuedouble
-                    : (cJSON_IsString(lon) ? strtod(lon->valuestring, NULL) : 0.0);
-        if (dlat < -90.0 || dlat > 90.0 || dlon < -360.0 || dlon > 360.0) continue;
-        /* Convert 0-360 longitude to -180..+180 */
-        if (dlon > 180.0) dlon -= 360.0;
+    g->nsta = 0;
+}
 
-        sta_lat[nsta] = dlat;
-        sta_lon[nsta] = dlon;
-        sta_foes[nsta] = (float)foes->valuedouble;
-        nsta++;
+/* Allocate the sums and the grid point unit vectors (first parse only). */
+static int spore_grid_alloc(SporeGrid *g)
+{
+    if (g->unit) return 0;
+    int n = g->rows * g->cols;
+    double *lats = malloc(n * sizeof(double));
+    double *lons = malloc(n * sizeof(double));
+    g->unit = malloc((size_t)n * 3 * sizeof(float));
+    g->wsum = calloc(n, sizeof(double));
+    g->vsum = calloc(n, sizeof(double));
+    g->count = calloc(n, sizeof(int));
+    if (!lats || !lons || !g->unit || !g->wsum || !g->vsum || !g->count) {
+        free(lats); free(lons);
+        spore_grid_free(g);
+        return -1;
     }
-    cJSON_Delete(root);
-
-    if (nsta < 3) return -1; /* not enough data */
+    for (int r = 0; r < g->rows; r++)
+        for (int c = 0; c < g->cols; c++) {
+            lats[r * g->cols + c] = -90.0 + r * g->step;
+            lons[r * g->cols + c] = -180.0 + c * g->step;
+        }
+    projection_to_unit(lats, lons, n, g->unit);
+    free(lats);
+    free(lons);
+    g->nsta = 0;
+    return 0;
+}
 
-    /* Step 2: IDW (Inverse Distance Weighting) interpolation to regular grid.
-     * For each grid cell, weight = 1/d² where d = haversine distance to station.
-     * Only stations within SPORE_MAX_RADIUS_KM contribute. */
-    int grid_sz = SPORE_GRID_ROWS * SPORE_GRID_COLS;
-    float *grid = malloc(grid_sz * sizeof(float));
-    int *grid_valid = calloc(grid_sz, sizeof(int));
-    if (!grid || !grid_valid) { free(grid); free(grid_valid); return -1; }
+/* Stations to add to (sign 1) or take out of (sign -1) the sums */
+typedef struct {
+    SporeGrid          *g;
+    const SporeStation *sta;
+    const int          *sign;
+    int                 n;
+} SporeScatter;
+
+/* Add sign times station st's weights to grid points [c0, c0 + n) of row
+ * r.  Projected around the station, AZEQ radius is the great-circle
+ * distance in km, so the batch kernels give a whole run of distances in
+ * vector lanes (needs the station's center set on this thread). */
+static void spore_scatter_run(SporeGrid *g, const SporeStation *st, int sign,
+                              int r, int c0, int n)
+{
+    float xy[SPORE_MAX_COLS * 2];
+    int i0 = r * g->cols + c0;
+    projection_forward_unit_batch(g->unit + i0, g->rows * g->cols, n, xy, NULL, 0);
+    for (int j = 0; j < n; j++) {
+        double d = hypot(xy[j * 2], xy[j * 2 + 1]);
+        if (d > SPORE_MAX_RADIUS_KM) continue;
+        if (d < 1.0) d = 1.0; /* avoid div by zero */
+        double w = sign / (d * d);
+        g->wsum[i0 + j] += w;
+        g->vsum[i0 + j] += w * st->foes;
+        g->count[i0 + j] += sign;
+    }
+}
 
-    for (int r = 0; r < SPORE_GRID_ROWS; r++) {
-        double glat = -90.0 + r * 2.0;
-        for (int c = 0; c < SPORE_GRID_COLS; c++) {
-            double glon = -180.0 + c * 2.0;
-            double wsum = 0.0, vsum = 0.0;
-            int in_range = 0;
-
-            for (int s = 0; s < nsta; s++) {
-                double d = spore_dist_km(glat, glon, sta_lat[s], sta_lon[s]);
-                if (d > SPORE_MAX_RADIUS_KM) continue;
-                if (d < 1.0) d = 1.0; /* avoid div by zero */
-                double w = 1.0 / (d * d);
-                wsum += w;
-                vsum += w * sta_foes[s];
-                in_range = 1;
-            }
+/* Scatter every station into rows [t, t + 1) * SPORE_TASK_ROWS, visiting
+ * only the rows and columns of the bounding box of its 2500 km cap. */
+static void spore_scatter_task(void *arg, int t)
+{
+    const SporeScatter *sc = arg;
+    SporeGrid *g = sc->g;
+    int r_lo = t * SPORE_TASK_ROWS;
+    int r_hi = r_lo + SPORE_TASK_ROWS - 1;
+    if (r_hi > g->rows - 1) r_hi = g->rows - 1;
+    double cap_rad = SPORE_MAX_RADIUS_KM / EARTH_RADIUS_KM;
+    double cap_deg = cap_rad * 180.0 / M_PI;
+
+    for (int i = 0; i < sc->n; i++) {
+        const SporeStation *st = &sc->sta[i];
+        int a = (int)floor((st->lat - cap_deg + 90.0) / g->step);
+        int b = (int)ceil((st->lat + cap_deg + 90.0) / g->step);
+        if (a < r_lo) a = r_lo;
+        if (b > r_hi) b = r_hi;
+        if (a > b) continue;
+
+        /* Longitude extent of the cap, unless it reaches a pole */
+        int c0 = 0, nc = g->cols;
+        if (fabs(st->lat) + cap_deg < 90.0) {
+            double half = asin(sin(cap_rad) / cos(st->lat * M_PI / 180.0)) * 180.0 / M_PI;
+            c0 = (int)floor((st->lon - half + 180.0) / g->step);
+            nc = (int)ceil((st->lon + half + 180.0) / g->step) - c0 + 1;
+            if (nc > g->cols) nc = g->cols;
+            c0 = ((c0 % g->cols) + g->cols) % g->cols;
+        }
 
-            int idx = r * SPORE_GRID_COLS + c;
-            if (in_range) {
-                grid[idx] = (float)(vsum / wsum);
-                grid_valid[idx] = 1;
-            } else {
-                grid[idx] = 0.0f;
-            }
+        ProjState ps = { PROJ_AZEQ, st->lat, st->lon };
+        projection_set_state(&ps);
+        for (int r = a; r <= b; r++) {
+            /* The window may wrap across the dateline */
+            int n1 = nc < g->cols - c0 ? nc : g->cols - c0;
+            spore_scatter_run(g, st, sc->sign[i], r, c0, n1);
+            if (nc > n1)
+                spore_scatter_run(g, st, sc->sign[i], r, 0, nc - n1);
         }
     }
+}
 
-    /* Step 3: Marching squares — collect raw edge-crossing fragments.
-     * For each 2×2 cell, classify corners above/below the contour level
-     * into a 4-bit case index.  The ms_edges lookup table maps each case
-     * to a pair of edges to connect.  Saddle cases (0101, 1010) are
-     * disambiguated using the cell center average. */
-    #define MS_MAX_FRAGS 8000
-    typedef struct { double lat[2], lon[2]; } MsFrag;
-    MsFrag *frags = malloc(MS_MAX_FRAGS * sizeof(MsFrag));
-    if (!frags) { free(grid); free(grid_valid); return -1; }
-
-    /* Temporary output buffers — sized for chained polylines */
-    int max_pts = 60000;
-    double *lats = malloc(max_pts * sizeof(double));
-    double *lons = malloc(max_pts * sizeof(double));
-    if (!lats || !lons) { free(grid); free(grid_valid); free(frags); free(lats); free(lons); return -1; }
-
-    free(m->raw_lats);
-    free(m->raw_lons);
-    m->raw_lats = lats;
-    m->raw_lons = lons;
-    m->raw_count = 0;
-    m->raw_num_segments = 0;
-    m->legend_count = 0;
-
-    for (int li = 0; li < SPORE_NUM_LEVELS; li++) {
-        float level = spore_levels[li];
+/* Run a scatter over the thread pool, split by rows.  The tasks move the
+ * projection center around, so the caller's state is put back after. */
+static void spore_scatter(SporeGrid *g, const SporeStation *sta, const int *sign, int n)
+{
+    SporeScatter sc = { g, sta, sign, n };
+    ProjState own;
+    projection_get_state(&own);
+    threadpool_run((g->rows + SPORE_TASK_ROWS - 1) / SPORE_TASK_ROWS,
+                   spore_scatter_task, &sc);
+    projection_set_state(&own);
+}
 
-        /* Add legend entry */
-        if (m->legend_count < MUF_MAX_LEGEND) {
-            m->legend[m->legend_count].mhz = level;
-            memcpy(m->legend[m->legend_count].color, spore_colors[li], sizeof(float) * 4);
-            m->legend_count++;
+/* Bring g's sums from g->sta to sta[]: stations that moved, appeared,
+ * disappeared or changed value are taken out and scattered again.  Falls
+ * back to a full pass when that is not much cheaper, or to flush the
+ * rounding that the add/subtract sums accumulate. */
+static void spore_grid_update(SporeGrid *g, const SporeStation *sta, int nsta)
+{
+    SporeStation chg[2 * SPORE_MAX_STATIONS];
+    int sign[2 * SPORE_MAX_STATIONS];
+    int nchg = 0;
+    unsigned char kept[SPORE_MAX_STATIONS] = {0};
+
+    for (int i = 0; i < g->nsta; i++) {
+        const SporeStation *o = &g->sta[i];
+        int j = 0;
+        while (j < nsta && (kept[j] || sta[j].lat != o->lat || sta[j].lon != o->lon ||
+                            sta[j].foes != o->foes))
+            j++;
+        if (j < nsta) {
+            kept[j] = 1;
+        } else {
+            chg[nchg] = *o;
+            sign[nchg++] = -1;
         }
+    }
+    for (int j = 0; j < nsta; j++) {
+        if (kept[j]) continue;
+        chg[nchg] = sta[j];
+        sign[nchg++] = 1;
+    }
 
-        /* Phase 1: collect all edge-crossing fragments for this level */
-        int nfrags = 0;
-        for (int r = 0; r < SPORE_GRID_ROWS - 1; r++) {
-            for (int c = 0; c < SPORE_GRID_COLS - 1; c++) {
-                int i00 = r * SPORE_GRID_COLS + c;
-                int i10 = r * SPORE_GRID_COLS + c + 1;
-                int i01 = (r + 1) * SPORE_GRID_COLS + c;
-                int i11 = (r + 1) * SPORE_GRID_COLS + c + 1;
-
-                if (!grid_valid[i00] || !grid_valid[i10] ||
-                    !grid_valid[i01] || !grid_valid[i11]) continue;
-
-                float v00 = grid[i00], v10 = grid[i10];
-                float v01 = grid[i01], v11 = grid[i11];
-
-                int ci = 0;
-                if (v00 >= level) ci |= 1;
-                if (v10 >= level) ci |= 2;
-                if (v11 >= level) ci |= 4;
-                if (v01 >= level) ci |= 8;
-
-                /* Saddle cases: disambiguate using cell center average */
-                if (ci == 5 || ci == 10) {
-                    float center = (v00 + v10 + v01 + v11) * 0.25f;
-                    int center_above = (center >= level);
-                    if (ci == 5) {
-                        /* 0101: BL and TR above */
-                        if (center_above) {
-                            /* Connect: left→top, bottom→right (two segments) */
-                            if (nfrags + 1 < MS_MAX_FRAGS) {
-                                ms_edge_interp(3, r, c, v00, v10, v01, v11, level,
-                                               &frags[nfrags].lat[0], &frags[nfrags].lon[0]);
-                                ms_edge_interp(2, r, c, v00, v10, v01, v11, level,
-                                               &frags[nfrags].lat[1], &frags[nfrags].lon[1]);
-                                nfrags++;
-                                ms_edge_interp(0, r, c, v00, v10, v01, v11, level,
-                                               &frags[nfrags].lat[0], &frags[nfrags].lon[0]);
-                                ms_edge_interp(1, r, c, v00, v10, v01, v11, level,
-                                               &frags[nfrags].lat[1], &frags[nfrags].lon[1]);
-                                nfrags++;
-                            }
-                        } else {
-                            /* Connect: left→bottom, top→right */
-                            if (nfrags + 1 < MS_MAX_FRAGS) {
-                                ms_edge_interp(3, r, c, v00, v10, v01, v11, level,
-                                               &frags[nfrags].lat[0], &frags[nfrags].lon[0]);
-                                ms_edge_interp(0, r, c, v00, v10, v01, v11, level,
-                                               &frags[nfrags].lat[1], &frags[nfrags].lon[1]);
-                                nfrags++;
-                                ms_edge_interp(2, r, c, v00, v10, v01, v11, level,
-                                               &frags[nfrags].lat[0], &frags[nfrags].lon[0]);
-                                ms_edge_interp(1, r, c, v00, v10, v01, v11, level,
-                                               &frags[nfrags].lat[1], &frags[nfrags].lon[1]);
-                                nfrags++;
-                            }
-                        }
-                    } else { /* ci == 10: BR and TL above */
-                        if (center_above) {
-                            if (nfrags + 1 < MS_MAX_FRAGS) {
-                                ms_edge_interp(0, r, c, v00, v10, v01, v11, level,
-                                               &frags[nfrags].lat[0], &frags[nfrags].lon[0]);
-                                ms_edge_interp(3, r, c, v00, v10, v01, v11, level,
-                                               &frags[nfrags].lat[1], &frags[nfrags].lon[1]);
-                                nfrags++;
-                                ms_edge_interp(1, r, c, v00, v10, v01, v11, level,
-                                               &frags[nfrags].lat[0], &frags[nfrags].lon[0]);
-                                ms_edge_interp(2, r, c, v00, v10, v01, v11, level,
-                                               &frags[nfrags].lat[1], &frags[nfrags].lon[1]);
-                                nfrags++;
-                            }
-                        } else {
-                            if (nfrags + 1 < MS_MAX_FRAGS) {
-                                ms_edge_interp(0, r, c, v00, v10, v01, v11, level,
-                                               &frags[nfrags].lat[0], &frags[nfrags].lon[0]);
-                                ms_edge_interp(1, r, c, v00, v10, v01, v11, level,
-                                               &frags[nfrags].lat[1], &frags[nfrags].lon[1]);
-                                nfrags++;
-                                ms_edge_interp(2, r, c, v00, v10, v01, v11, level,
-                                               &frags[nfrags].lat[0], &frags[nfrags].lon[0]);
-                                ms_edge_interp(3, r, c, v00, v10, v01, v11, level,
-                                               &frags[nfrags].lat[1], &frags[nfrags].lon[1]);
-                                nfrags++;
-                            }
-                        }
-                    }
-                    continue;
-                }
+    if (g->nsta == 0 || nchg * 2 > nsta || g->updates >= SPORE_FULL_EVERY) {
+        int n = g->rows * g->cols;
+        memset(g->wsum, 0, n * sizeof(double));
+        memset(g->vsum, 0, n * sizeof(double));
+        memset(g->count, 0, n * sizeof(int));
+        for (int j = 0; j < nsta; j++) sign[j] = 1;
+        spore_scatter(g, sta, sign, nsta);
+        g->updates = 0;
+    } else if (nchg > 0) {
+        spore_scatter(g, chg, sign, nchg);
+        g->updates++;
+    }
+    memcpy(g->sta, sta, nsta * sizeof(SporeStation));
+    g->nsta = nsta;
+}
 
-                if (ms_edges[ci][0] < 0) continue;
-                if (nfrags >= MS_MAX_FRAGS) break;
+/* Parse KC2G stations JSON into Sporadic E contour lines.
+ *
+ * Pipeline: 1) Extract ionosonde stations with valid foEs readings
+ *           2) IDW interpolation onto g's regular grid (power=2, radius 2500 km)
+ *           3) Contour the grid points that have data (contour.c)
+ *           4) Project into km-space via muf_reproject() */
+int spore_parse_json(const char *json_str, SporeGrid *g, MufData *m)
+{
+    OverlayStream s;
+    stream_parse(&s, OVERLAY_FEED_SPORE, json_str);
+    int ret = spore_take_stream(g, m, &s);
+    overlay_stream_free(&s);
+    return ret;
+}
 
-                ms_edge_interp(ms_edges[ci][0], r, c, v00, v10, v01, v11, level,
-                               &frags[nfrags].lat[0], &frags[nfrags].lon[0]);
-                ms_edge_interp(ms_edges[ci][1], r, c, v00, v10, v01, v11, level,
-                               &frags[nfrags].lat[1], &frags[nfrags].lon[1]);
-                nfrags++;
-            }
-        }
+int spore_take_stream(SporeGrid *g, MufData *m, OverlayStream *s)
+{
+    /* Step 1: stations with valid foEs, extracted while streaming */
+    const SporeStation *sta = s->sta;
+    int nsta = s->nsta;
+    if (s->status != 1) return -1;
+    if (nsta < 3) return -1; /* not enough data */
 
-        /* Step 4: Chain fragments into polylines by endpoint matching.
-         * Two fragment endpoints match if within MS_EPS (~1°, half a grid cell).
-         * For each unchained seed fragment, extend forward (match tail) and
-         * backward (match head, prepending via memmove) greedily. */
-        #define MS_EPS 1.01  /* slightly over 1° — half of 2° grid */
-        int *used = calloc(nfrags, sizeof(int));
-        if (!used) continue;
-
-        for (int seed = 0; seed < nfrags; seed++) {
-            if (used[seed]) continue;
-            if (m->raw_num_segments >= MUF_MAX_SEGMENTS) break;
-
-            /* Start a new chain from this fragment */
-            used[seed] = 1;
-            int seg_start = m->raw_count;
-
-            /* Add seed's two points */
-            if (m->raw_count + 2 > max_pts) break;
-            lats[m->raw_count] = frags[seed].lat[0];
-            lons[m->raw_count] = frags[seed].lon[0];
-            m->raw_count++;
-            lats[m->raw_count] = frags[seed].lat[1];
-            lons[m->raw_count] = frags[seed].lon[1];
-            m->raw_count++;
-
-            /* Extend forward (match tail) */
-            int found;
-            do {
-                found = 0;
-                double tlat = lats[m->raw_count - 1];
-                double tlon = lons[m->raw_count - 1];
-                for (int f = 0; f < nfrags; f++) {
-                    if (used[f]) continue;
-                    if (m->raw_count + 1 > max_pts) break;
-                    /* Try matching fragment's start to our tail */
-                    if (fabs(frags[f].lat[0] - tlat) < MS_EPS &&
-                        fabs(frags[f].lon[0] - tlon) < MS_EPS) {
-                        lats[m->raw_count] = frags[f].lat[1];
-                        lons[m->raw_count] = frags[f].lon[1];
-                        m->raw_count++;
-                        used[f] = 1;
-                        found = 1;
-                        break;
-                    }
-                    /* Try matching fragment's end to our tail (reverse) */
-                    if (fabs(frags[f].lat[1] - tlat) < MS_EPS &&
-                        fabs(frags[f].lon[1] - tlon) < MS_EPS) {
-                        lats[m->raw_count] = frags[f].lat[0];
-                        lons[m->raw_count] = frags[f].lon[0];
-                        m->raw_count++;
-                        used[f] = 1;
-                        found = 1;
-                        break;
-                    }
-                }
-            } while (found);
-
-            /* Extend backward (match head) */
-            do {
-                found = 0;
-                double hlat = lats[seg_start];
-                double hlon = lons[seg_start];
-                for (int f = 0; f < nfrags; f++) {
-                    if (used[f]) continue;
-                    double append_lat, append_lon;
-                    int matched = 0;
-                    if (fabs(frags[f].lat[1] - hlat) < MS_EPS &&
-                        fabs(frags[f].lon[1] - hlon) < MS_EPS) {
-                        append_lat = frags[f].lat[0];
-                        append_lon = frags[f].lon[0];
-                        matched = 1;
-                    } else if (fabs(frags[f].lat[0] - hlat) < MS_EPS &&
-                               fabs(frags[f].lon[0] - hlon) < MS_EPS) {
-                        append_lat = frags[f].lat[1];
-                        append_lon = frags[f].lon[1];
-                        matched = 1;
-                    }
-                    if (matched) {
-                        if (m->raw_count + 1 > max_pts) break;
-                        /* Shift everything right by 1 to prepend */
-                        int chain_len = m->raw_count - seg_start;
-                        memmove(&lats[seg_start + 1], &lats[seg_start],
-                                chain_len * sizeof(double));
-                        memmove(&lons[seg_start + 1], &lons[seg_start],
-                                chain_len * sizeof(double));
-                        lats[seg_start] = append_lat;
-                        lons[seg_start] = append_lon;
-                        m->raw_count++;
-                        used[f] = 1;
-                        found = 1;
-                        break;
-                    }
-                }
-            } while (found);
-
-            int seg_len = m->raw_count - seg_start;
-            if (seg_len >= 2 && m->raw_num_segments < MUF_MAX_SEGMENTS) {
-                int si = m->raw_num_segments;
-                m->raw_seg_starts[si] = seg_start;
-                m->raw_seg_counts[si] = seg_len;
-                memcpy(m->raw_seg_colors[si], spore_colors[li], sizeof(float) * 4);
-                m->raw_num_segments++;
-            }
-        }
+    /* Step 2: IDW (Inverse Distance Weighting) interpolation to regular grid.
+     * For each grid point, weight = 1/d² where d = great-circle distance to
+     * station.  Only stations within SPORE_MAX_RADIUS_KM contribute. */
+    if (spore_grid_alloc(g) != 0) return -1;
+    spore_grid_update(g, sta, nsta);
 
-        free(used);
-        #undef MS_EPS
+    int rows = g->rows, cols = g->cols;
+    int grid_sz = rows * cols;
+    float *grid = malloc(grid_sz * sizeof(float));
+    unsigned char *grid_valid = calloc(grid_sz, 1);
+    if (!grid || !grid_valid) { free(grid); free(grid_valid); return -1; }
+    for (int i = 0; i < grid_sz; i++) {
+        if (g->count[i] > 0) {
+            grid[i] = (float)(g->vsum[i] / g->wsum[i]);
+            grid_valid[i] = 1;
+        } else {
+            grid[i] = 0.0f;
+        }
     }
 
-    free(frags);
+    /* Step 3: Isolines per level, colored per level.  The columns cover
+     * the whole circle, so lines continue across the antimeridian. */
+    ContourGrid cg = {
+        .values = grid, .valid = grid_valid, .rows = rows, .cols = cols,
+        .lat0 = -90.0, .dlat = g->step, .lon0 = -180.0, .dlon = g->step,
+        .wrap = 1,
+    };
+    int ret = contour_levels(m, &cg, spore_levels, spore_colors, SPORE_NUM_LEVELS);
     free(grid_valid);
     free(grid);
-    #undef MS_MAX_FRAGS
-
-    /* Project into km-space */
-    muf_reproject(m);
-    return 0;
+    return ret;
 }
 
 /* ── Aurora heatmap ────────────────────────────────────────────── */
 
-void aurora_grid_init(AuroraGrid *g)
+void heat_grid_init(HeatGrid *h)
 {
-    g->values = NULL;
-    g->valid = 0;
+    memset(h, 0, sizeof(*h));
 }
 
-void aurora_grid_free(AuroraGrid *g)
+void heat_grid_free(HeatGrid *h)
 {
-    free(g->values);
-    g->values = NULL;
-    g->valid = 0;
+    free(h->texels);
+    memset(h, 0, sizeof(*h));
 }
 
-int aurora_parse_json(const char *json_str, AuroraGrid *g)
+/* Size the texel buffer, reusing it when the dimensions match. */
+static int heat_grid_alloc(HeatGrid *h, int width, int height)
 {
-    cJSON *root = cJSON_Parse(json_str);
-    if (!root) return -1;
-
-    cJSON *coords = cJSON_GetObjectItem(root, "coordinates");
-    if (!cJSON_IsArray(coords)) { cJSON_Delete(root); return -1; }
-
-    /* Allocate grid: 360 lons × 181 lats (0-359 × -90 to 90) */
-    int grid_size = 360 * 181;
-    if (!g->values) {
-        g->values = calloc(grid_size, sizeof(int));
-        if (!g->values) { cJSON_Delete(root); return -1; }
-    } else {
-        memset(g->values, 0, grid_size * sizeof(int));
-    }
-
-    cJSON *triplet;
-    cJSON_ArrayForEach(triplet, coords) {
-        if (!cJSON_IsArray(triplet) || cJSON_GetArraySize(triplet) < 3) continue;
-        cJSON *j0 = cJSON_GetArrayItem(triplet, 0);
-        cJSON *j1 = cJSON_GetArrayItem(triplet, 1);
-        cJSON *j2 = cJSON_GetArrayItem(triplet, 2);
-        if (!j0 || !j1 || !j2) continue;
-        int lon = (int)j0->valuedouble;
-        int lat = (int)j1->valuedouble;
-        int val = (int)j2->valuedouble;
-
-        /* Normalize lon to 0-359 */
-        lon = ((lon % 360) + 360) % 360;
-        int lat_idx = lat + 90;
-        if (lat_idx < 0 || lat_idx > 180 || lon < 0 || lon >= 360) continue;
-        g->values[lon * 181 + lat_idx] = val;
-    }
-
-    g->valid = 1;
-    cJSON_Delete(root);
+    if (h->texels && h->width == width && h->height == height)
+        return 0;
+    float *t = realloc(h->texels, (size_t)width * height * sizeof(float));
+    if (!t) return -1;
+    h->texels = t;
+    h->width = width;
+    h->height = height;
     return 0;
 }
 
-void aurora_mesh_init(AuroraMesh *m)
+void aurora_grid_init(AuroraGrid *g)
 {
-    /* Same grid resolution as nightmesh */
-    #define AURORA_ANGULAR_DIVS  180
-    #define AURORA_RADIAL_DIVS    60
-    int max_verts = AURORA_ANGULAR_DIVS * 3 +
-                    AURORA_ANGULAR_DIVS * (AURORA_RADIAL_DIVS - 1) * 6;
-    m->vertices = malloc(max_verts * 3 * sizeof(float));
-    if (!m->vertices) { m->capacity = 0; m->vertex_count = 0; return; }
-    m->capacity = max_verts;
-    m->vertex_count = 0;
+    g->values = NULL;
+    g->valid = 0;
 }
 
-void aurora_mesh_free(AuroraMesh *m)
+void aurora_grid_free(AuroraGrid *g)
 {
-    free(m->vertices);
-    m->vertices = NULL;
-    m->vertex_count = 0;
-    m->capacity = 0;
+    free(g->values);
+    g->values = NULL;
+    g->valid = 0;
 }
 
-static void aurora_emit(AuroraMesh *m, float x, float y, float alpha)
+int aurora_parse_json(const char *json_str, AuroraGrid *g)
 {
-    if (m->vertex_count < m->capacity) {
-        int i = m->vertex_count * 3;
-        m->vertices[i]     = x;
-        m->vertices[i + 1] = y;
-        m->vertices[i + 2] = alpha;
-        m->vertex_count++;
-    }
+    OverlayStream s;
+    stream_parse(&s, OVERLAY_FEED_AURORA, json_str);
+    int ret = aurora_take_stream(g, &s);
+    overlay_stream_free(&s);
+    return ret;
 }
 
-/* Look up aurora probability at lat/lon in the grid, return alpha 0-1 */
-static float aurora_lookup(const AuroraGrid *g, double lat, double lon)
+int aurora_take_stream(AuroraGrid *g, OverlayStream *s)
 {
-    /* Normalize longitude to 0-359 */
-    if (lon < 0.0) lon += 360.0;
-    if (lon >= 360.0) lon -= 360.0;
-
-    int ilon = (int)(lon + 0.5);
-    if (ilon >= 360) ilon = 0;
-    int ilat = (int)(lat + 90.0 + 0.5);
-    if (ilat < 0) ilat = 0;
-    if (ilat > 180) ilat = 180;
-
-    int val = g->values[ilon * 181 + ilat];
-
-    /* Map probability to alpha:
-     * 0-5   → transparent (skip noise)
-     * 5-50  → ramp from 0.0 to 0.5
-     * 50-100 → ramp from 0.5 to 0.75 */
-    if (val <= 5) return 0.0f;
-    if (val <= 50) return (float)(val - 5) / 45.0f * 0.5f;
-    return 0.5f + (float)(val - 50) / 50.0f * 0.25f;
+    if (s->status != 1 || !s->aurora) return -1;
+    free(g->values);
+    g->values = s->aurora;
+    s->aurora = NULL;
+    g->valid = 1;
+    return 0;
 }
 
-void aurora_mesh_build(AuroraMesh *m, const AuroraGrid *g)
+int aurora_heat_build(HeatGrid *h, const AuroraGrid *g)
 {
-    if (!g || !g->valid || !m->vertices) return;
-
-    double max_r = projection_get_radius() - 0.5;
-    float dr = (float)(max_r / AURORA_RADIAL_DIVS);
-    float da = 2.0f * (float)M_PI / AURORA_ANGULAR_DIVS;
-
-    m->vertex_count = 0;
-
-    /* Precompute alpha grid */
-    int rows = AURORA_RADIAL_DIVS + 1;
-    int cols = AURORA_ANGULAR_DIVS;
-    float *alpha_grid = malloc(rows * cols * sizeof(float));
-    if (!alpha_grid) return;
-
-    for (int ri = 0; ri <= AURORA_RADIAL_DIVS; ri++) {
-        float r = ri * dr;
-        for (int ai = 0; ai < AURORA_ANGULAR_DIVS; ai++) {
-            float a = ai * da;
-            float x = r * cosf(a);
-            float y = r * sinf(a);
-            float av = 0.0f;
-
-            double lat, lon;
-            if (ri == 0) {
-                if (projection_inverse(0.0, 0.0, &lat, &lon) == 0)
-                    av = aurora_lookup(g, lat, lon);
-            } else {
-                if (projection_inverse((double)x, (double)y, &lat, &lon) == 0)
-                    av = aurora_lookup(g, lat, lon);
-                /* Outside globe: no aurora */
-            }
-            alpha_grid[ri * cols + ai] = av;
-        }
-    }
-
-    /* Generate triangles — same pattern as nightmesh */
-    float center_alpha = alpha_grid[0];
-
-    for (int ai = 0; ai < AURORA_ANGULAR_DIVS; ai++) {
-        int ai_next = (ai + 1) % AURORA_ANGULAR_DIVS;
-        float a0 = ai * da;
-        float a1 = (ai + 1) * da;
-
-        /* Inner ring */
-        {
-            float a_v0 = center_alpha;
-            float a_v1 = alpha_grid[1 * cols + ai];
-            float a_v2 = alpha_grid[1 * cols + ai_next];
-            if (a_v0 > 0.0f || a_v1 > 0.0f || a_v2 > 0.0f) {
-                float r1 = dr;
-                aurora_emit(m, 0.0f, 0.0f, a_v0);
-                aurora_emit(m, r1 * cosf(a0), r1 * sinf(a0), a_v1);
-                aurora_emit(m, r1 * cosf(a1), r1 * sinf(a1), a_v2);
-            }
-        }
-
-        /* Outer rings */
-        for (int ri = 1; ri < AURORA_RADIAL_DIVS; ri++) {
-            float r0 = ri * dr;
-            float r1 = (ri + 1) * dr;
-
-            float cos_a0 = cosf(a0), sin_a0 = sinf(a0);
-            float cos_a1 = cosf(a1), sin_a1 = sinf(a1);
-
-            float a00 = alpha_grid[ri * cols + ai];
-            float a01 = alpha_grid[ri * cols + ai_next];
-            float a10 = alpha_grid[(ri + 1) * cols + ai];
-            float a11 = alpha_grid[(ri + 1) * cols + ai_next];
-
-            if (a00 == 0.0f && a01 == 0.0f && a10 == 0.0f && a11 == 0.0f)
-                continue;
-
-            aurora_emit(m, r0 * cos_a0, r0 * sin_a0, a00);
-            aurora_emit(m, r1 * cos_a0, r1 * sin_a0, a10);
-            aurora_emit(m, r1 * cos_a1, r1 * sin_a1, a11);
-
-            aurora_emit(m, r0 * cos_a0, r0 * sin_a0, a00);
-            aurora_emit(m, r1 * cos_a1, r1 * sin_a1, a11);
-            aurora_emit(m, r0 * cos_a1, r0 * sin_a1, a01);
-        }
-    }
-
-    free(alpha_grid);
+    if (!g || !g->valid) return -1;
+    if (heat_grid_alloc(h, 360, 181) != 0) return -1;
+
+    /* Transpose lon-major [lon * 181 + lat] into rows of latitude */
+    for (int lat = 0; lat < 181; lat++)
+        for (int lon = 0; lon < 360; lon++)
+            h->texels[lat * 360 + lon] = (float)g->values[lon * 181 + lat];
+    h->lon0 = 0.0f;   h->dlon = 1.0f;
+    h->lat0 = -90.0f; h->dlat = 1.0f;
+
+    /* Probability to alpha:
+     * 0-5    → transparent (skip noise)
+     * 5-50   → ramp from 0.0 to 0.5
+     * 50-100 → ramp from 0.5 to 0.75 */
+    static const float ramp[HEAT_RAMP_STOPS][2] = {
+        { 5.0f, 0.0f }, { 50.0f, 0.5f }, { 100.0f, 0.75f }, { 150.0f, 1.0f }
+    };
+    memcpy(h->ramp, ramp, sizeof(ramp));
+    return 0;
 }
 
 /* ── DRAP (D-Region Absorption Prediction) ─────────────────────── */
@@ -962,140 +924,71 @@ int drap_parse_text(const char *text, DrapGrid *g)
     return 0;
 }
 
-/* Bilinear lookup of DRAP HAF at lat/lon, returns alpha 0-1 */
-static float drap_lookup(const DrapGrid *g, double lat, double lon)
+int drap_heat_build(HeatGrid *h, const DrapGrid *g)
 {
-    /* Normalize longitude to -178..178 range */
-    if (lon > 180.0) lon -= 360.0;
-    if (lon < -180.0) lon += 360.0;
+    if (!g || !g->valid) return -1;
+    if (heat_grid_alloc(h, DRAP_GRID_COLS, DRAP_GRID_ROWS) != 0) return -1;
 
-    /* Grid indices (continuous) */
-    double col_f = (lon - (-178.0)) / 4.0;
-    double row_f = (89.0 - lat) / 2.0;
+    /* Already row-major from 89°N southward, 4° columns from 178°W */
+    memcpy(h->texels, g->values,
+           DRAP_GRID_ROWS * DRAP_GRID_COLS * sizeof(float));
+    h->lon0 = -178.0f; h->dlon = 4.0f;
+    h->lat0 = 89.0f;   h->dlat = -2.0f;
 
-    /* Clamp to grid bounds */
-    if (col_f < 0.0) col_f = 0.0;
-    if (col_f > DRAP_GRID_COLS - 1.001) col_f = DRAP_GRID_COLS - 1.001;
-    if (row_f < 0.0) row_f = 0.0;
-    if (row_f > DRAP_GRID_ROWS - 1.001) row_f = DRAP_GRID_ROWS - 1.001;
-
-    int c0 = (int)col_f, r0 = (int)row_f;
-    int c1 = c0 + 1, r1 = r0 + 1;
-    if (c1 >= DRAP_GRID_COLS) c1 = DRAP_GRID_COLS - 1;
-    if (r1 >= DRAP_GRID_ROWS) r1 = DRAP_GRID_ROWS - 1;
-
-    float fc = (float)(col_f - c0);
-    float fr = (float)(row_f - r0);
-
-    float v00 = g->values[r0 * DRAP_GRID_COLS + c0];
-    float v10 = g->values[r0 * DRAP_GRID_COLS + c1];
-    float v01 = g->values[r1 * DRAP_GRID_COLS + c0];
-    float v11 = g->values[r1 * DRAP_GRID_COLS + c1];
-
-    float val = v00 * (1 - fc) * (1 - fr) + v10 * fc * (1 - fr)
-              + v01 * (1 - fc) * fr + v11 * fc * fr;
-
-    /* Map HAF (MHz) to alpha:
+    /* HAF (MHz) to alpha:
      * 0-0.5 → 0 (baseline noise, ignore)
      * 0.5-3 → ramp 0.0 to 0.2  (quiet-time absorption)
      * 3-10  → ramp 0.2 to 0.45 (moderate event)
      * 10-30 → ramp 0.45 to 0.7 (major event / blackout) */
-    if (val <= 0.5f) return 0.0f;
-    if (val <= 3.0f) return (val - 0.5f) / 2.5f * 0.2f;
-    if (val <= 10.0f) return 0.2f + (val - 3.0f) / 7.0f * 0.25f;
-    return 0.45f + (val - 10.0f) / 20.0f * 0.25f;
+    static const float ramp[HEAT_RAMP_STOPS][2] = {
+        { 0.5f, 0.0f }, { 3.0f, 0.2f }, { 10.0f, 0.45f }, { 30.0f, 0.7f }
+    };
+    memcpy(h->ramp, ramp, sizeof(ramp));
+    return 0;
 }
 
-void drap_mesh_build(AuroraMesh *m, const DrapGrid *g)
-{
-    if (!g || !g->valid || !m->vertices) return;
-
-    #define DRAP_ANGULAR_DIVS  180
-    #define DRAP_RADIAL_DIVS    60
-
-    double max_r = projection_get_radius() - 0.5;
-    float dr = (float)(max_r / DRAP_RADIAL_DIVS);
-    float da = 2.0f * (float)M_PI / DRAP_ANGULAR_DIVS;
-
-    m->vertex_count = 0;
-
-    /* Precompute alpha grid */
-    int rows = DRAP_RADIAL_DIVS + 1;
-    int cols = DRAP_ANGULAR_DIVS;
-    float *alpha_grid = malloc(rows * cols * sizeof(float));
-    if (!alpha_grid) return;
-
-    for (int ri = 0; ri <= DRAP_RADIAL_DIVS; ri++) {
-        float r = ri * dr;
-        for (int ai = 0; ai < DRAP_ANGULAR_DIVS; ai++) {
-            float a = ai * da;
-            float x = r * cosf(a);
-            float y = r * sinf(a);
-            float av = 0.0f;
-
-            double lat, lon;
-            if (ri == 0) {
-                if (projection_inverse(0.0, 0.0, &lat, &lon) == 0)
-                    av = drap_lookup(g, lat, lon);
-            } else {
-                if (projection_inverse((double)x, (double)y, &lat, &lon) == 0)
-                    av = drap_lookup(g, lat, lon);
-            }
-            alpha_grid[ri * cols + ai] = av;
-        }
-    }
-
-    /* Generate triangles — same pattern as aurora/nightmesh */
-    float center_alpha = alpha_grid[0];
-
-    for (int ai = 0; ai < DRAP_ANGULAR_DIVS; ai++) {
-        int ai_next = (ai + 1) % DRAP_ANGULAR_DIVS;
-        float a0 = ai * da;
-        float a1 = (ai + 1) * da;
-
-        /* Inner ring */
-        {
-            float a_v0 = center_alpha;
-            float a_v1 = alpha_grid[1 * cols + ai];
-            float a_v2 = alpha_grid[1 * cols + ai_next];
-            if (a_v0 > 0.0f || a_v1 > 0.0f || a_v2 > 0.0f) {
-                float r1 = dr;
-                aurora_emit(m, 0.0f, 0.0f, a_v0);
-                aurora_emit(m, r1 * cosf(a0), r1 * sinf(a0), a_v1);
-                aurora_emit(m, r1 * cosf(a1), r1 * sinf(a1), a_v2);
-            }
-        }
+/* ── Aurora / DRAP isolines ────────────────────────────────────── */
 
-        /* Outer rings */
-        for (int ri = 1; ri < DRAP_RADIAL_DIVS; ri++) {
-            float r0 = ri * dr;
-            float r1 = (ri + 1) * dr;
-
-            float cos_a0 = cosf(a0), sin_a0 = sinf(a0);
-            float cos_a1 = cosf(a1), sin_a1 = sinf(a1);
-
-            float a00 = alpha_grid[ri * cols + ai];
-            float a01 = alpha_grid[ri * cols + ai_next];
-            float a10 = alpha_grid[(ri + 1) * cols + ai];
-            float a11 = alpha_grid[(ri + 1) * cols + ai_next];
-
-            if (a00 == 0.0f && a01 == 0.0f && a10 == 0.0f && a11 == 0.0f)
-                continue;
+/* Aurora probability (%): green at the visible-oval edge up to red */
+static const float aurora_levels[] = { 10.0f, 30.0f, 50.0f, 70.0f };
+static const float aurora_colors[][4] = {
+    { 0.2f, 0.8f, 0.3f, 1.0f },   /* 10 % green        */
+    { 0.6f, 0.9f, 0.2f, 1.0f },   /* 30 % yellow-green */
+    { 1.0f, 0.85f, 0.1f, 1.0f },  /* 50 % yellow       */
+    { 1.0f, 0.3f, 0.2f, 1.0f },   /* 70 % red          */
+};
 
-            aurora_emit(m, r0 * cos_a0, r0 * sin_a0, a00);
-            aurora_emit(m, r1 * cos_a0, r1 * sin_a0, a10);
-            aurora_emit(m, r1 * cos_a1, r1 * sin_a1, a11);
+/* DRAP highest affected frequency (MHz), following the heatmap ramp */
+static const float drap_levels[] = { 1.0f, 5.0f, 10.0f, 20.0f };
+static const float drap_colors[][4] = {
+    { 1.0f, 0.75f, 0.2f, 1.0f },  /* 1 MHz  amber  */
+    { 1.0f, 0.5f, 0.1f, 1.0f },   /* 5 MHz  orange */
+    { 0.9f, 0.2f, 0.1f, 1.0f },   /* 10 MHz red    */
+    { 0.7f, 0.1f, 0.5f, 1.0f },   /* 20 MHz purple */
+};
 
-            aurora_emit(m, r0 * cos_a0, r0 * sin_a0, a00);
-            aurora_emit(m, r1 * cos_a1, r1 * sin_a1, a11);
-            aurora_emit(m, r0 * cos_a1, r0 * sin_a1, a01);
-        }
-    }
+static int heat_contours_build(MufData *m, const HeatGrid *h, const float *levels,
+                               const float (*colors)[4], int nlevels)
+{
+    if (!h->texels) return -1;
+    ContourGrid cg = {
+        .values = h->texels, .rows = h->height, .cols = h->width,
+        .lat0 = h->lat0, .dlat = h->dlat, .lon0 = h->lon0, .dlon = h->dlon,
+        .wrap = 1,
+    };
+    return contour_levels(m, &cg, levels, colors, nlevels);
+}
 
-    free(alpha_grid);
+int aurora_contours_build(MufData *m, const HeatGrid *h)
+{
+    return heat_contours_build(m, h, aurora_levels, aurora_colors,
+                               sizeof(aurora_levels) / sizeof(aurora_levels[0]));
+}
 
-    #undef DRAP_ANGULAR_DIVS
-    #undef DRAP_RADIAL_DIVS
+int drap_contours_build(MufData *m, const HeatGrid *h)
+{
+    return heat_contours_build(m, h, drap_levels, drap_colors,
+                               sizeof(drap_levels) / sizeof(drap_levels[0]));
 }
 
 /* ── Geomagnetic indices (Kp + Bz) ────────────────────────────── */
@@ -1109,45 +1002,38 @@ void geomag_init(GeomagIndices *g)
 
 int geomag_parse_kp(const char *json_str, GeomagIndices *g)
 {
-    /* Format: array of arrays, first row is header, last row is most recent.
-     * Each row: ["time_tag", "Kp", "a_running", "station_count"] */
-    cJSON *root = cJSON_Parse(json_str);
-    if (!root || !cJSON_IsArray(root)) { cJSON_Delete(root); return -1; }
-
-    int n = cJSON_GetArraySize(root);
-    if (n < 2) { cJSON_Delete(root); return -1; } /* need header + at least 1 data row */
-
-    /* Last entry is the most recent */
-    cJSON *last = cJSON_GetArrayItem(root, n - 1);
-    if (!last || !cJSON_IsArray(last) || cJSON_GetArraySize(last) < 2) {
-        cJSON_Delete(root);
-        return -1;
-    }
-
-    cJSON *kp_val = cJSON_GetArrayItem(last, 1);
-    if (kp_val && cJSON_IsString(kp_val))
-        g->kp = (float)atof(kp_val->valuestring);
-    else if (kp_val && cJSON_IsNumber(kp_val))
-        g->kp = (float)kp_val->valuedouble;
+    OverlayStream s;
+    stream_parse(&s, OVERLAY_FEED_KP, json_str);
+    int ret = geomag_take_kp(g, &s);
+    overlay_stream_free(&s);
+    return ret;
+}
 
+int geomag_take_kp(GeomagIndices *g, OverlayStream *s)
+{
+    /* Need the header + at least 1 data row, the last one an array of
+     * at least 2 elements */
+    if (s->status != 1 || s->rows < 2 || !(s->value_ok & 2)) return -1;
+    if (s->value_ok & 4)
+        g->kp = s->value;
     g->valid = 1;
-    cJSON_Delete(root);
     return 0;
 }
 
 int geomag_parse_bz(const char *json_str, GeomagIndices *g)
 {
-    /* Format: {"Bt": "5", "Bz": "-2", "TimeStamp": "..."} */
-    cJSON *root = cJSON_Parse(json_str);
-    if (!root) return -1;
-
-    cJSON *bz_val = cJSON_GetObjectItem(root, "Bz");
-    if (bz_val && cJSON_IsString(bz_val))
-        g->bz = (float)atof(bz_val->valuestring);
-    else if (bz_val && cJSON_IsNumber(bz_val))
-        g->bz = (float)bz_val->valuedouble;
+    OverlayStream s;
+    stream_parse(&s, OVERLAY_FEED_BZ, json_str);
+    int ret = geomag_take_bz(g, &s);
+    overlay_stream_free(&s);
+    return ret;
+}
 
+int geomag_take_bz(GeomagIndices *g, OverlayStream *s)
+{
+    if (s->status != 1) return -1;
+    if (s->value_ok)
+        g->bz = s->value;
     g->valid = 1;
-    cJSON_Delete(root);
     return 0;
 }
@@ -3,14 +3,22 @@
  * Manages four overlay layers parsed from external data sources:
  * - MUF contour lines (KC2G GeoJSON, frequency-colored polylines)
  * - Sporadic E contours (KC2G stations JSON, IDW interpolation + marching squares)
- * - Aurora heatmap (NOAA OVATION JSON, probability-to-alpha polar mesh)
- * - DRAP absorption (NOAA SWPC text, HAF-to-alpha polar mesh)
+ * - Aurora heatmap (NOAA OVATION JSON, probability raster)
+ * - DRAP absorption (NOAA SWPC text, HAF raster)
+ * The two rasters are handed to the renderer as HeatGrids (texture + value
+ * to alpha ramp) and shaded per pixel, so they don't depend on the center.
+ * Optionally they are also contoured into isolines, drawn like MUF lines.
  * Plus geomagnetic indices (Kp + Bz) for the sidebar legend.
- * All overlays auto-refresh every 15 minutes via async fetch. */
+ * All overlays auto-refresh every 15 minutes via async fetch; the JSON
+ * feeds are parsed while they download (OverlayStream). */
 
 #ifndef OVERLAY_H
 #define OVERLAY_H
 
+#include <stddef.h>
+#include "json_pull.h"
+#include "segtable.h"
+
 #define OVERLAY_UPDATE_SEC  900  /* 15 minutes */
 #define MUF_URL    "https://prop.kc2g.com/renders/current/mufd-normal-now.geojson"
 #define SPORE_URL  "https://prop.kc2g.com/api/stations.json"
@@ -19,7 +27,6 @@
 #define BZ_URL     "https://services.swpc.noaa.gov/products/summary/solar-wind-mag-field.json"
 #define DRAP_URL   "https://services.swpc.noaa.gov/text/drap_global_frequencies.txt"
 
-#define MUF_MAX_SEGMENTS 256
 #define MUF_MAX_LEGEND   16
 
 /* MUF legend entry: MHz level + color */
@@ -33,33 +40,39 @@ typedef struct {
     /* Raw lat/lon for reprojection */
     double *raw_lats;
     double *raw_lons;
+    float  *raw_unit;      /* Unit vectors, 3 planes of raw_count (projection_to_unit) */
     int     raw_count;
-    int     raw_seg_starts[MUF_MAX_SEGMENTS];
-    int     raw_seg_counts[MUF_MAX_SEGMENTS];
-    float   raw_seg_colors[MUF_MAX_SEGMENTS][4]; /* RGBA per raw segment */
-    int     raw_num_segments;
+    SegTable *raw_segs;            /* raw polylines, RGBA per segment */
 
     /* Projected vertices (after split at large jumps) */
     float  *vertices;              /* x,y pairs in km-space */
     int     vertex_count;
-    int     segment_starts[MUF_MAX_SEGMENTS];
-    int     segment_counts[MUF_MAX_SEGMENTS];
-    float   segment_colors[MUF_MAX_SEGMENTS][4]; /* RGBA per projected segment */
-    int     num_segments;
+    SegTable *segs;                /* projected polylines, RGBA per segment;
+                                    * shared with the Renderer on upload */
 
     /* Legend: unique (mhz, color) pairs for sidebar display */
     MufLegendEntry legend[MUF_MAX_LEGEND];
     int            legend_count;
 } MufData;
 
-/* Aurora heatmap mesh (same vertex format as NightMesh: x, y, alpha) */
+/* Lat/lon raster ready for upload as a single-channel float texture.
+ * Rows run along latitude, columns along longitude and wrap around the
+ * globe (width * dlon == 360).  Values map to alpha through a piecewise
+ * linear ramp: 0 below the first stop, last segment extrapolated. */
+#define HEAT_RAMP_STOPS 4
+
 typedef struct {
-    float *vertices;    /* interleaved x, y, alpha */
-    int    vertex_count;
-    int    capacity;
-} AuroraMesh;
+    float *texels;      /* width * height values, row-major */
+    int    width, height;
+    float  lon0, dlon;  /* longitude of column 0 centre, column step (deg) */
+    float  lat0, dlat;  /* latitude of row 0 centre, row step (deg, signed) */
+    float  ramp[HEAT_RAMP_STOPS][2]; /* (value, alpha), ascending values */
+} HeatGrid;
+
+void  heat_grid_init(HeatGrid *h);
+void  heat_grid_free(HeatGrid *h);
 
-/* Aurora raw grid (parsed from JSON, used to build mesh) */
+/* Aurora raw grid (parsed from JSON) */
 typedef struct {
     int    *values;     /* aurora probability 0-100, indexed [lon * 181 + (lat+90)] */
     int     valid;      /* 1 if data loaded successfully */
@@ -69,16 +82,47 @@ void  muf_data_init(MufData *m);
 void  muf_data_free(MufData *m);
 int   muf_parse_geojson(const char *json_str, MufData *m);
 void  muf_reproject(MufData *m);
+size_t muf_data_mem_bytes(const MufData *m);  /* heap bytes incl. segment tables */
+
+/* Sporadic E IDW raster.  Kept between refreshes: the sums hold the
+ * contributions of every station in sta[], so a refresh in which only a
+ * few stations changed re-scatters just those. */
+#define SPORE_MAX_STATIONS 200
+
+typedef struct {
+    double lat, lon;    /* degrees, lon in -180..180 */
+    float  foes;        /* MHz */
+} SporeStation;
 
-int   spore_parse_json(const char *json_str, MufData *m);
+typedef struct {
+    double  step;         /* grid spacing (deg): 2, 1 or 0.5 */
+    int     rows, cols;   /* rows from -90° north, columns from -180° east */
+    float  *unit;         /* grid point unit vectors, 3 planes of rows * cols */
+    double *wsum, *vsum;  /* per grid point: sum of weights, of weight * foEs */
+    int    *count;        /* per grid point: stations in range */
+    SporeStation sta[SPORE_MAX_STATIONS];
+    int     nsta;
+    int     updates;      /* incremental refreshes since the last full pass */
+} SporeGrid;
+
+/* step_deg is the grid spacing: 2, 1 or 0.5 (anything else becomes 2).
+ * Buffers are allocated by the first spore_parse_json(). */
+void  spore_grid_init(SporeGrid *g, double step_deg);
+void  spore_grid_free(SporeGrid *g);
+/* Forget the stations in the sums, so the next parse does a full pass. */
+void  spore_grid_reset(SporeGrid *g);
+
+/* Parse KC2G stations JSON into foEs contour lines in m, updating g.
+ * Returns 0 on success, -1 (g and m unchanged) on bad JSON or when fewer
+ * than 3 stations report. */
+int   spore_parse_json(const char *json_str, SporeGrid *g, MufData *m);
 
 void  aurora_grid_init(AuroraGrid *g);
 void  aurora_grid_free(AuroraGrid *g);
 int   aurora_parse_json(const char *json_str, AuroraGrid *g);
 
-void  aurora_mesh_init(AuroraMesh *m);
-void  aurora_mesh_free(AuroraMesh *m);
-void  aurora_mesh_build(AuroraMesh *m, const AuroraGrid *g);
+/* Fill h from the aurora grid (360 x 181, probability %).  Returns 0 on success. */
+int   aurora_heat_build(HeatGrid *h, const AuroraGrid *g);
 
 /* DRAP grid (D-Region Absorption Prediction — HAF in MHz) */
 #define DRAP_GRID_ROWS 90   /* lat: 89 to -89, step -2 */
@@ -93,7 +137,14 @@ typedef struct {
 void  drap_grid_init(DrapGrid *g);
 void  drap_grid_free(DrapGrid *g);
 int   drap_parse_text(const char *text, DrapGrid *g);
-void  drap_mesh_build(AuroraMesh *m, const DrapGrid *g);
+/* Fill h from the DRAP grid (90 x 90, HAF MHz).  Returns 0 on success. */
+int   drap_heat_build(HeatGrid *h, const DrapGrid *g);
+
+/* Isolines of a raster filled by aurora_heat_build() (10/30/50/70 %) or
+ * drap_heat_build() (1/5/10/20 MHz) into m, colored per level and
+ * projected like MUF lines.  Returns 0 on success (m unchanged otherwise). */
+int   aurora_contours_build(MufData *m, const HeatGrid *h);
+int   drap_contours_build(MufData *m, const HeatGrid *h);
 
 /* Geomagnetic indices (Kp + Bz) */
 typedef struct {
@@ -106,4 +157,65 @@ void  geomag_init(GeomagIndices *g);
 int   geomag_parse_kp(const char *json_str, GeomagIndices *g);
 int   geomag_parse_bz(const char *json_str, GeomagIndices *g);
 
+/* Streaming parse of a JSON feed.  Chunks are fed as they arrive (e.g.
+ * from the fetch thread) and values go straight into the staging arrays
+ * below, without a document tree; once the response is complete the
+ * matching *_take_stream() moves them into the overlay.  The
+ * *_parse_json() functions above do the same on a whole response. */
+typedef enum {
+    OVERLAY_FEED_MUF,
+    OVERLAY_FEED_SPORE,
+    OVERLAY_FEED_AURORA,
+    OVERLAY_FEED_KP,
+    OVERLAY_FEED_BZ,
+} OverlayFeed;
+
+typedef struct {
+    OverlayFeed feed;
+    JsonPull    jp;
+    int         status;     /* 0 = in progress, 1 = complete, -1 = failed */
+    int         started;    /* root container seen */
+
+    /* MUF: LineString vertices and segments, grown as needed */
+    double     *lats, *lons;
+    int         count, cap;
+    SegTable   *segs;
+    MufLegendEntry legend[MUF_MAX_LEGEND];
+    int         legend_count;
+    int         feat_start; /* first vertex of the current feature */
+    int         feat_line;  /* current feature is a LineString */
+    float       feat_color[4];
+    float       feat_mhz;
+
+    /* Sporadic E: stations with a valid foEs reading */
+    SporeStation sta[SPORE_MAX_STATIONS];
+    int         nsta;
+
+    /* Aurora: probabilities, [lon * 181 + (lat+90)] */
+    int        *aurora;
+
+    /* Current coordinate tuple / station / Kp row, and the Kp/Bz result */
+    double      tuple[3];
+    int         tuple_have; /* bit per tuple element */
+    int         rows;
+    float       value;
+    int         value_ok;
+} OverlayStream;
+
+void  overlay_stream_init(OverlayStream *s, OverlayFeed feed);
+void  overlay_stream_free(OverlayStream *s);
+
+/* Parse the next chunk of the response; data NULL marks its end.
+ * Returns 0, or -1 once the response turned out malformed. */
+int   overlay_stream_feed(OverlayStream *s, const char *data, size_t len);
+
+/* Move a complete response into the overlay (same results as the
+ * *_parse_json() functions).  Return 0 on success, -1 if the response
+ * failed or lacks the data. */
+int   muf_take_stream(MufData *m, OverlayStream *s);
+int   spore_take_stream(SporeGrid *g, MufData *m, OverlayStream *s);
+int   aurora_take_stream(AuroraGrid *g, OverlayStream *s);
+int   geomag_take_kp(GeomagIndices *g, OverlayStream *s);
+int   geomag_take_bz(GeomagIndices *g, OverlayStream *s);
+
 #endif
@@ -0,0 +1,452 @@
+/* profiler.c — Per-phase frame profiler.
+ *
+ * Every frame becomes one ProfRow.  Rows go into a PROF_WINDOW ring for the
+ * panel and, when a dump was requested, into a growable series.  GPU queries
+ * use PROF_GPU_LATENCY sets of query objects in rotation; a set is read back
+ * (and its times stored into the row of the frame that issued it) just
+ * before it is reused, by which time the GPU has normally finished it.
+ * Fetches are kept apart from the frame rows: one slot per feed for the
+ * panel and, with a dump, a growable list. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <GL/glew.h>
+#include "profiler.h"
+#include "text.h"
+
+#define PROF_WINDOW      240        /* frames in the panel statistics */
+#define PROF_GPU_LATENCY 4          /* query sets in flight */
+#define PROF_MAX_FRAMES  (1 << 18)  /* dump series cap (~70 min at 60 fps) */
+#define PROF_PANEL_MS    250.0      /* panel refresh interval */
+#define PROF_TEXT_SIZE   12.0f
+#define PROF_FETCH_FEEDS 8          /* feeds listed in the panel */
+#define PROF_MAX_FETCHES (1 << 16)  /* dump fetch list cap */
+
+typedef struct {
+    float frame_ms;
+    float cpu[PROF_CPU_COUNT];
+    float gpu[PROF_GPU_COUNT];  /* -1 = layer not drawn / not measured */
+} ProfRow;
+
+typedef struct {
+    char  feed[16];
+    long  frame;        /* frame being recorded when it finished */
+    int   status;
+    float ms;
+    long  wire_bytes, body_bytes;
+} ProfFetch;
+
+static const char *cpu_names[PROF_CPU_COUNT] = {
+    "events", "ipc", "wsjtx", "reproject", "lod", "labels", "dist-labels",
+    "buttons", "actions", "hud", "overlays", "draw", "swap",
+};
+
+static const char *gpu_names[PROF_GPU_COUNT] = {
+    "disc", "land", "grid", "night", "aurora", "drap", "borders",
+    "coast", "muf", "spore", "isolines", "spots", "markers", "text",
+    "sidebar", "buttons",
+};
+
+static char   *dump_path;
+static int     use_gpu;
+static int     panel_visible;
+static int     active;
+
+static double  frame_start;
+static double  phase_start[PROF_CPU_COUNT];
+static float   cur_cpu[PROF_CPU_COUNT];
+static long    frame;              /* index of the frame being recorded */
+
+static ProfRow window[PROF_WINDOW];
+static ProfRow *series;
+static long    series_len;         /* rows recorded (contiguous from frame 0) */
+static long    series_cap;
+
+static GLuint        queries[PROF_GPU_LATENCY][PROF_GPU_COUNT];
+static unsigned char query_pending[PROF_GPU_LATENCY][PROF_GPU_COUNT];
+static long          query_frame[PROF_GPU_LATENCY];
+
+static double  last_panel;
+static int     panel_dirty;
+
+static ProfFetch  last_fetch[PROF_FETCH_FEEDS];
+static int        n_last_fetch;
+static ProfFetch *fetches;
+static long       fetches_len, fetches_cap;
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/* Start recording from a clean window (series continue from frame 0). */
+static void activate(void)
+{
+    active = 1;
+    frame = 0;
+    frame_start = now_ms();
+    memset(cur_cpu, 0, sizeof(cur_cpu));
+    memset(query_pending, 0, sizeof(query_pending));
+    panel_dirty = 1;
+}
+
+void profiler_init(const char *path, int gpu)
+{
+    use_gpu = gpu;
+    if (use_gpu)
+        glGenQueries(PROF_GPU_LATENCY * PROF_GPU_COUNT, &queries[0][0]);
+    if (path) {
+        dump_path = strdup(path);
+        activate();
+    }
+}
+
+void profiler_set_panel(int visible)
+{
+    panel_visible = visible;
+    if (visible && !active)
+        activate();
+    else if (!visible && !dump_path)
+        active = 0;
+    panel_dirty = 1;
+}
+
+int profiler_panel_visible(void)
+{
+    return panel_visible;
+}
+
+/* ── Timing ───────────────────────────────────────────────────────── */
+
+void profiler_begin(ProfPhase p)
+{
+    if (active)
+        phase_start[p] = now_ms();
+}
+
+void profiler_end(ProfPhase p)
+{
+    if (active)
+        cur_cpu[p] += (float)(now_ms() - phase_start[p]);
+}
+
+void profiler_gpu_begin(ProfGpuPhase p)
+{
+    if (!active || !use_gpu) return;
+    int slot = (int)(frame % PROF_GPU_LATENCY);
+    glBeginQuery(GL_TIME_ELAPSED, queries[slot][p]);
+    query_pending[slot][p] = 1;
+}
+
+void profiler_gpu_end(ProfGpuPhase p)
+{
+    (void)p;
+    if (active && use_gpu)
+        glEndQuery(GL_TIME_ELAPSED);
+}
+
+/* Read back a query set and store its times into the issuing frame's row. */
+static void collect_slot(int slot)
+{
+    for (int p = 0; p < PROF_GPU_COUNT; p++) {
+        if (!query_pending[slot][p]) continue;
+        query_pending[slot][p] = 0;
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(queries[slot][p], GL_QUERY_RESULT, &ns);
+        float ms = (float)(ns / 1e6);
+        long f = query_frame[slot];
+        if (f > frame - PROF_WINDOW)
+            window[f % PROF_WINDOW].gpu[p] = ms;
+        if (f < series_len)
+            series[f].gpu[p] = ms;
+    }
+}
+
+void profiler_frame_begin(void)
+{
+    if (!active) return;
+    frame_start = now_ms();
+    memset(cur_cpu, 0, sizeof(cur_cpu));
+}
+
+void profiler_frame_end(void)
+{
+    if (!active) return;
+    double t = now_ms();
+
+    ProfRow row;
+    row.frame_ms = (float)(t - frame_start);
+    memcpy(row.cpu, cur_cpu, sizeof(row.cpu));
+    for (int p = 0; p < PROF_GPU_COUNT; p++)
+        row.gpu[p] = -1.0f;
+
+    window[frame % PROF_WINDOW] = row;
+    if (dump_path && series_len == frame && frame < PROF_MAX_FRAMES) {
+        if (series_len == series_cap) {
+            long cap = series_cap ? series_cap * 2 : 4096;
+            ProfRow *s = realloc(series, cap * sizeof(*s));
+            if (s) {
+                series = s;
+                series_cap = cap;
+            }
+        }
+        if (series_len < series_cap)
+            series[series_len++] = row;
+    }
+    query_frame[frame % PROF_GPU_LATENCY] = frame;
+
+    /* The next frame reuses the oldest query set: collect it first */
+    frame++;
+    if (use_gpu)
+        collect_slot((int)(frame % PROF_GPU_LATENCY));
+}
+
+void profiler_fetch(const char *feed, int status, double ms,
+                    long wire_bytes, long body_bytes)
+{
+    ProfFetch rec;
+    memset(&rec, 0, sizeof(rec));
+    snprintf(rec.feed, sizeof(rec.feed), "%s", feed);
+    rec.frame = active ? frame : -1;
+    rec.status = status;
+    rec.ms = (float)ms;
+    rec.wire_bytes = wire_bytes;
+    rec.body_bytes = body_bytes;
+
+    int i = 0;
+    while (i < n_last_fetch && strcmp(last_fetch[i].feed, rec.feed) != 0) i++;
+    if (i < PROF_FETCH_FEEDS) {
+        last_fetch[i] = rec;
+        if (i == n_last_fetch) n_last_fetch++;
+    }
+    panel_dirty = 1;
+
+    if (!dump_path || fetches_len >= PROF_MAX_FETCHES) return;
+    if (fetches_len == fetches_cap) {
+        long cap = fetches_cap ? fetches_cap * 2 : 64;
+        ProfFetch *f = realloc(fetches, cap * sizeof(*f));
+        if (!f) return;
+        fetches = f;
+        fetches_cap = cap;
+    }
+    fetches[fetches_len++] = rec;
+}
+
+/* ── Panel ────────────────────────────────────────────────────────── */
+
+static int cmp_float(const void *a, const void *b)
+{
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+/* min / avg / p99 of one column of the window; returns the sample count.
+ * GPU columns skip the frames whose queries are not read back yet. */
+static int window_stats(int col, float *mn, float *avg, float *p99)
+{
+    float v[PROF_WINDOW];
+    int n = 0;
+    int gpu_col = col > PROF_CPU_COUNT;
+    long newest = frame - (gpu_col ? PROF_GPU_LATENCY : 1);
+    for (long f = newest; f >= 0 && f > frame - 1 - PROF_WINDOW; f--) {
+        const ProfRow *r = &window[f % PROF_WINDOW];
+        float x = col == 0 ? r->frame_ms :
+                  col <= PROF_CPU_COUNT ? r->cpu[col - 1] :
+                  r->gpu[col - 1 - PROF_CPU_COUNT];
+        if (x >= 0.0f) v[n++] = x;
+    }
+    if (n == 0) return 0;
+    qsort(v, n, sizeof(float), cmp_float);
+    double sum = 0.0;
+    for (int i = 0; i < n; i++) sum += v[i];
+    *mn = v[0];
+    *avg = (float)(sum / n);
+    *p99 = v[(int)ceilf(0.99f * n) - 1];
+    return n;
+}
+
+int profiler_build_panel(float right, float top, float *text_verts, int max_verts,
+                         float *bg_verts)
+{
+    if (!panel_visible) return -1;
+    double t = now_ms();
+    if (!panel_dirty && t - last_panel < PROF_PANEL_MS) return -1;
+    panel_dirty = 0;
+    last_panel = t;
+
+    float sz = PROF_TEXT_SIZE, line_h = sz * 1.5f, pad = 8.0f;
+    float name_w = text_width("dist-labels", sz) + sz;
+    float col_w = text_width("000.00", sz) + sz;
+    float width = name_w + 3 * col_w;
+    float left = right - width - 2 * pad;
+    float x = left + pad, y = top + pad;
+    int n = 0;
+    char buf[32];
+
+    static const char *heads[3] = { "min", "avg", "p99" };
+    n += text_build("ms", x, y, sz, text_verts + n * 2, max_verts - n);
+    for (int c = 0; c < 3; c++)
+        n += text_build(heads[c], x + name_w + (c + 1) * col_w - sz - text_width(heads[c], sz),
+                        y, sz, text_verts + n * 2, max_verts - n);
+    y += line_h * 1.3f;
+
+    for (int col = 0; col < 1 + PROF_CPU_COUNT + PROF_GPU_COUNT; col++) {
+        float st[3];
+        if (col == 1 + PROF_CPU_COUNT) {
+            y += line_h * 0.3f;
+            n += text_build(use_gpu ? "gpu" : "gpu (no timer)", x, y, sz,
+                            text_verts + n * 2, max_verts - n);
+            y += line_h;
+        }
+        if (!window_stats(col, &st[0], &st[1], &st[2])) continue;
+        const char *name = col == 0 ? "frame" :
+                           col <= PROF_CPU_COUNT ? cpu_names[col - 1] :
+                           gpu_names[col - 1 - PROF_CPU_COUNT];
+        n += text_build(name, x, y, sz, text_verts + n * 2, max_verts - n);
+        for (int c = 0; c < 3; c++) {
+            snprintf(buf, sizeof(buf), "%.2f", (double)st[c]);
+            n += text_build(buf, x + name_w + (c + 1) * col_w - sz - text_width(buf, sz),
+                            y, sz, text_verts + n * 2, max_verts - n);
+        }
+        y += line_h;
+        if (col == 0) y += line_h * 0.3f;
+    }
+
+    /* Latest fetch per feed: time, then KiB received / decoded */
+    if (n_last_fetch > 0) {
+        static const char *fheads[3] = { "ms", "wire", "body" };
+        y += line_h * 0.3f;
+        n += text_build("fetch", x, y, sz, text_verts + n * 2, max_verts - n);
+        for (int c = 0; c < 3; c++)
+            n += text_build(fheads[c], x + name_w + (c + 1) * col_w - sz - text_width(fheads[c], sz),
+                            y, sz, text_verts + n * 2, max_verts - n);
+        y += line_h;
+    }
+    for (int i = 0; i < n_last_fetch; i++) {
+        const ProfFetch *r = &last_fetch[i];
+        char name[32];
+        snprintf(name, sizeof(name), "%s%s", r->feed,
+                 r->status == 2 ? " 304" : r->status < 0 ? " err" : "");
+        n += text_build(name, x, y, sz, text_verts + n * 2, max_verts - n);
+        double v[3] = { r->ms, r->wire_bytes / 1024.0, r->body_bytes / 1024.0 };
+        for (int c = 0; c < 3; c++) {
+            snprintf(buf, sizeof(buf), c == 0 ? "%.0f" : "%.1f", v[c]);
+            n += text_build(buf, x + name_w + (c + 1) * col_w - sz - text_width(buf, sz),
+                            y, sz, text_verts + n * 2, max_verts - n);
+        }
+        y += line_h;
+    }
+
+    float bottom = y + pad;
+    float quad[12] = { left, top,  right, top,  right, bottom,
+                       left, top,  right, bottom,  left, bottom };
+    memcpy(bg_verts, quad, sizeof(quad));
+    return n;
+}
+
+/* ── Dump ─────────────────────────────────────────────────────────── */
+
+static void write_value(FILE *f, float v)
+{
+    if (v < 0.0f) fputs("null", f);
+    else fprintf(f, "%.4f", (double)v);
+}
+
+static void write_json(FILE *f, long nf)
+{
+    fprintf(f, "{\n  \"frames\": %ld,\n  \"gpu_timer\": %s,\n", nf, use_gpu ? "true" : "false");
+    fputs("  \"frame_ms\": [", f);
+    for (long i = 0; i < nf; i++) {
+        if (i) fputc(',', f);
+        write_value(f, series[i].frame_ms);
+    }
+    fputs("],\n  \"cpu_ms\": {", f);
+    for (int p = 0; p < PROF_CPU_COUNT; p++) {
+        fprintf(f, "%s\n    \"%s\": [", p ? "," : "", cpu_names[p]);
+        for (long i = 0; i < nf; i++) {
+            if (i) fputc(',', f);
+            write_value(f, series[i].cpu[p]);
+        }
+        fputc(']', f);
+    }
+    fputs("\n  },\n  \"gpu_ms\": {", f);
+    for (int p = 0; p < PROF_GPU_COUNT; p++) {
+        fprintf(f, "%s\n    \"%s\": [", p ? "," : "", gpu_names[p]);
+        for (long i = 0; i < nf; i++) {
+            if (i) fputc(',', f);
+            write_value(f, series[i].gpu[p]);
+        }
+        fputc(']', f);
+    }
+    fputs("\n  },\n  \"fetches\": [", f);
+    for (long i = 0; i < fetches_len; i++) {
+        const ProfFetch *r = &fetches[i];
+        fprintf(f, "%s\n    {\"feed\": \"%s\", \"frame\": %ld, \"status\": %d, "
+                   "\"ms\": %.1f, \"wire_bytes\": %ld, \"body_bytes\": %ld}",
+                i ? "," : "", r->feed, r->frame, r->status, (double)r->ms,
+                r->wire_bytes, r->body_bytes);
+    }
+    fputs(fetches_len ? "\n  ]\n}\n" : "]\n}\n", f);
+}
+
+static void write_csv(FILE *f, long nf)
+{
+    fputs("frame,frame_ms", f);
+    for (int p = 0; p < PROF_CPU_COUNT; p++) fprintf(f, ",cpu_%s", cpu_names[p]);
+    for (int p = 0; p < PROF_GPU_COUNT; p++) fprintf(f, ",gpu_%s", gpu_names[p]);
+    fputc('\n', f);
+    for (long i = 0; i < nf; i++) {
+        fprintf(f, "%ld,%.4f", i, (double)series[i].frame_ms);
+        for (int p = 0; p < PROF_CPU_COUNT; p++)
+            fprintf(f, ",%.4f", (double)series[i].cpu[p]);
+        for (int p = 0; p < PROF_GPU_COUNT; p++) {
+            if (series[i].gpu[p] >= 0.0f) fprintf(f, ",%.4f", (double)series[i].gpu[p]);
+            else fputc(',', f);
+        }
+        fputc('\n', f);
+    }
+}
+
+void profiler_shutdown(void)
+{
+    /* Collect the query sets still in flight */
+    if (active && use_gpu)
+        for (long i = 0; i < PROF_GPU_LATENCY; i++)
+            collect_slot((int)((frame + i) % PROF_GPU_LATENCY));
+
+    if (dump_path) {
+        long nf = series_len;
+        FILE *f = fopen(dump_path, "w");
+        if (!f) {
+            fprintf(stderr, "Warning: cannot write profile %s\n", dump_path);
+        } else {
+            size_t len = strlen(dump_path);
+            if (len > 4 && strcmp(dump_path + len - 4, ".csv") == 0)
+                write_csv(f, nf);
+            else
+                write_json(f, nf);
+            fclose(f);
+            printf("Profile: %ld frames written to %s\n", nf, dump_path);
+        }
+        if (frame > series_len)
+            fprintf(stderr, "Warning: profile truncated to the first %ld frames\n",
+                    series_len);
+    }
+
+    if (use_gpu)
+        glDeleteQueries(PROF_GPU_LATENCY * PROF_GPU_COUNT, &queries[0][0]);
+    free(series);
+    free(fetches);
+    free(dump_path);
+    series = NULL;
+    series_len = series_cap = 0;
+    fetches = NULL;
+    fetches_len = fetches_cap = 0;
+    dump_path = NULL;
+    active = 0;
+}
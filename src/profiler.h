@@ -0,0 +1,98 @@
+/* profiler.h — Per-phase frame profiler.
+ *
+ * CPU phases of the main loop are timed with scoped begin/end pairs
+ * (CLOCK_MONOTONIC); layers drawn by the renderer are timed on the GPU with
+ * GL_TIME_ELAPSED queries, read back a few frames later so the pipeline is
+ * never stalled.  A rolling window of recent frames feeds an on-screen panel
+ * (min / avg / p99 per phase, stroke font); with a dump path the complete
+ * per-frame series is written as JSON (or CSV for *.csv) by
+ * profiler_shutdown().  All calls are cheap no-ops while the profiler is
+ * inactive (panel hidden and no dump requested).  Finished overlay fetches
+ * are recorded even then: the panel lists the latest one per feed, the
+ * JSON dump all of them. */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+/* Main loop phases (CPU wall time) */
+typedef enum {
+    PROF_EVENTS,       /* glfwPollEvents */
+    PROF_IPC,          /* IPC / named pipe target, station and spot updates */
+    PROF_WSJTX,        /* WSJT-X events into spots / target */
+    PROF_REPROJECT,    /* queue / apply center changes (worker time not included) */
+    PROF_LOD,          /* LOD selection, re-culling and map uploads */
+    PROF_LABELS,       /* marker labels and backgrounds */
+    PROF_DIST_LABELS,  /* distance circle labels */
+    PROF_BUTTONS,      /* button, legend and popup geometry */
+    PROF_ACTIONS,      /* button clicks and QRZ submission */
+    PROF_HUD,          /* HUD and sidebar text */
+    PROF_OVERLAYS,     /* overlay fetch polling and refresh */
+    PROF_DRAW,         /* draw call submission */
+    PROF_SWAP,         /* glfwSwapBuffers (includes vsync wait) */
+    PROF_CPU_COUNT
+} ProfPhase;
+
+/* Renderer layers (GPU time) */
+typedef enum {
+    PROF_GPU_DISC,
+    PROF_GPU_LAND,
+    PROF_GPU_GRID,     /* boundary circle, graticule, distance circles */
+    PROF_GPU_NIGHT,
+    PROF_GPU_AURORA,
+    PROF_GPU_DRAP,
+    PROF_GPU_BORDERS,
+    PROF_GPU_COAST,
+    PROF_GPU_MUF,
+    PROF_GPU_SPORE,
+    PROF_GPU_ISOLINES, /* aurora / DRAP contour lines */
+    PROF_GPU_SPOTS,    /* many-target paths and markers */
+    PROF_GPU_MARKERS,  /* target line, markers, north pole */
+    PROF_GPU_TEXT,     /* pixel-space labels and HUD */
+    PROF_GPU_SIDEBAR,
+    PROF_GPU_BUTTONS,  /* buttons, legend, popup */
+    PROF_GPU_COUNT
+} ProfGpuPhase;
+
+/* Set up the profiler.  dump_path: file written by profiler_shutdown()
+ * (NULL = none; a dump path keeps the profiler active).  gpu: 1 if a GL
+ * context is current and timer queries may be used. */
+void profiler_init(const char *dump_path, int gpu);
+
+/* Show or hide the on-screen panel (activates the profiler while shown). */
+void profiler_set_panel(int visible);
+int  profiler_panel_visible(void);
+
+/* Time a main loop phase; a phase may be entered several times per frame. */
+void profiler_begin(ProfPhase p);
+void profiler_end(ProfPhase p);
+
+/* Time a renderer layer (queries must not nest). */
+void profiler_gpu_begin(ProfGpuPhase p);
+void profiler_gpu_end(ProfGpuPhase p);
+
+/* Start timing a main loop iteration, after the loop woke up: the idle
+ * wait before it is not part of the frame.  Phase times of an iteration
+ * that drew nothing are discarded. */
+void profiler_frame_begin(void);
+
+/* Close the current frame: record its phase times and collect finished
+ * GPU queries.  Call once per frame after glfwSwapBuffers(). */
+void profiler_frame_end(void);
+
+/* Record a finished fetch of feed (main thread).  status as
+ * fetch_check(); ms: queueing + transfer time; wire_bytes / body_bytes:
+ * body size received and after decompression. */
+void profiler_fetch(const char *feed, int status, double ms,
+                    long wire_bytes, long body_bytes);
+
+/* Build the panel if it is visible and due for a refresh (a few times per
+ * second).  right/top: panel corner in pixels.  Writes GL_LINES text
+ * vertices and a 6-vertex background quad (12 floats).  Returns the text
+ * vertex count, or -1 when nothing changed. */
+int profiler_build_panel(float right, float top, float *text_verts, int max_verts,
+                         float *bg_verts);
+
+/* Write the dump (if requested) and free all resources. */
+void profiler_shutdown(void);
+
+#endif
@@ -8,22 +8,55 @@
  * clipping points where cos(c) ≤ 0 (back hemisphere).
  *
  * Azimuthal equidistant scales by k = c/sin(c) · R so that distances from
- * center are preserved (the entire Earth maps to a disc of radius π·R). */
+ * center are preserved (the entire Earth maps to a disc of radius π·R).
+ *
+ * projection_forward_batch() evaluates the same formulas over arrays with
+ * SIMD kernels (projection_simd.h), selected once at runtime: AVX2 when the
+ * CPU supports it, otherwise SSE2 (or the generic vector width elsewhere). */
 
 #include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
 #include "projection.h"
+#include "segtable.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PROJ_X86 1
+#endif
 
 #define DEG2RAD (M_PI / 180.0)
 #define RAD2DEG (180.0 / M_PI)
 
-static ProjMode proj_mode = PROJ_AZEQ;
+/* Mode and center are per thread (see ProjState in projection.h); every
+ * thread starts out AZEQ centered on 0°N 0°E. */
+static _Thread_local ProjMode proj_mode = PROJ_AZEQ;
 
 /* Precomputed center point in radians + trig values for projection formulas. */
-static double center_lat_rad;
-static double center_lon_rad;
-static double center_lat_deg_store;
-static double center_lon_deg_store;
-static double sin_clat, cos_clat;   /* sin/cos of center latitude */
+static _Thread_local double center_lat_rad;
+static _Thread_local double center_lon_rad;
+static _Thread_local double center_lat_deg_store;
+static _Thread_local double center_lon_deg_store;
+static _Thread_local double sin_clat, cos_clat = 1.0;  /* sin/cos of center latitude */
+
+/* Rotation from Earth-centered unit vectors into the center's local frame.
+ * Rows are the east, north and up directions at the center, so for a unit
+ * vector p: (east·p, north·p) are the ortho x,y / R and up·p = cos(c). */
+static _Thread_local double rot[9] = { 0.0, 1.0, 0.0,  0.0, 0.0, 1.0,  1.0, 0.0, 0.0 };
+
+void projection_get_state(ProjState *s)
+{
+    s->mode = proj_mode;
+    s->lat_deg = center_lat_deg_store;
+    s->lon_deg = center_lon_deg_store;
+}
+
+void projection_set_state(const ProjState *s)
+{
+    proj_mode = s->mode;
+    projection_set_center(s->lat_deg, s->lon_deg);
+}
 
 void projection_set_mode(ProjMode mode) { proj_mode = mode; }
 ProjMode projection_get_mode(void) { return proj_mode; }
@@ -41,6 +74,11 @@ void projection_set_center(double lat_deg, double lon_deg)
     center_lon_rad = lon_deg * DEG2RAD;
     sin_clat = sin(center_lat_rad);
     cos_clat = cos(center_lat_rad);
+
+    double sin_clon = sin(center_lon_rad), cos_clon = cos(center_lon_rad);
+    rot[0] = -sin_clon;            rot[1] = cos_clon;             rot[2] = 0.0;
+    rot[3] = -sin_clat * cos_clon; rot[4] = -sin_clat * sin_clon; rot[5] = cos_clat;
+    rot[6] =  cos_clat * cos_clon; rot[7] =  cos_clat * sin_clon; rot[8] = sin_clat;
 }
 
 void projection_get_center(double *lat_deg, double *lon_deg)
@@ -219,3 +257,352 @@ double projection_azimuth(double lat1, double lon1, double lat2, double lon2)
 
     return fmod(az + 360.0, 360.0);  /* normalize to [0, 360) */
 }
+
+/* ── Batch projection ────────────────────────────────────────────── */
+
+typedef struct {
+    double sin_clat, cos_clat, clon_rad;
+    double rot[9];
+    int    ortho;
+    int    clamp;
+} BatchParams;
+
+/* Instantiate the vector kernels.  Each returns how many leading points it
+ * processed (a multiple of its lane count); the scalar loop does the rest. */
+#ifdef PROJ_X86
+#define KERNEL_TARGET   __attribute__((target("sse2")))
+#define KERNEL_NAME     batch_sse2_f64
+#define KERNEL_FLOAT    0
+#define KERNEL_WIDTH    2
+#define KERNEL_SQRT(v)  ((__typeof__(v))_mm_sqrt_pd((__m128d)(v)))
+#include "projection_simd.h"
+#undef KERNEL_NAME
+#undef KERNEL_FLOAT
+#undef KERNEL_WIDTH
+#undef KERNEL_SQRT
+#define KERNEL_NAME     batch_sse2_f32
+#define KERNEL_FLOAT    1
+#define KERNEL_WIDTH    4
+#define KERNEL_SQRT(v)  ((__typeof__(v))_mm_sqrt_ps((__m128)(v)))
+#include "projection_simd.h"
+#undef KERNEL_TARGET
+#undef KERNEL_NAME
+#undef KERNEL_FLOAT
+#undef KERNEL_WIDTH
+#undef KERNEL_SQRT
+
+#define KERNEL_TARGET   __attribute__((target("avx2,fma")))
+#define KERNEL_NAME     batch_avx2_f64
+#define KERNEL_FLOAT    0
+#define KERNEL_WIDTH    4
+#define KERNEL_SQRT(v)  ((__typeof__(v))_mm256_sqrt_pd((__m256d)(v)))
+#include "projection_simd.h"
+#undef KERNEL_NAME
+#undef KERNEL_FLOAT
+#undef KERNEL_WIDTH
+#undef KERNEL_SQRT
+#define KERNEL_NAME     batch_avx2_f32
+#define KERNEL_FLOAT    1
+#define KERNEL_WIDTH    8
+#define KERNEL_SQRT(v)  ((__typeof__(v))_mm256_sqrt_ps((__m256)(v)))
+#include "projection_simd.h"
+#undef KERNEL_TARGET
+#undef KERNEL_NAME
+#undef KERNEL_FLOAT
+#undef KERNEL_WIDTH
+#undef KERNEL_SQRT
+#else
+/* Portable 128-bit vectors (NEON on aarch64); sqrt per lane. */
+#define KERNEL_TARGET
+#define KERNEL_NAME     batch_vec_f64
+#define KERNEL_FLOAT    0
+#define KERNEL_WIDTH    2
+#define KERNEL_SQRT(v)  ({ __typeof__(v) r_ = (v); \
+                           for (int l_ = 0; l_ < KERNEL_WIDTH; l_++) { r_[l_] = sqrt(r_[l_]); } \
+                           r_; })
+#include "projection_simd.h"
+#undef KERNEL_NAME
+#undef KERNEL_FLOAT
+#undef KERNEL_WIDTH
+#define KERNEL_NAME     batch_vec_f32
+#define KERNEL_FLOAT    1
+#define KERNEL_WIDTH    4
+#include "projection_simd.h"
+#undef KERNEL_TARGET
+#undef KERNEL_NAME
+#undef KERNEL_FLOAT
+#undef KERNEL_WIDTH
+#undef KERNEL_SQRT
+#endif
+
+typedef struct {
+    int (*latlon)(const double *, const double *, int,
+                  float *, unsigned char *, const BatchParams *);
+    int (*unit)(const float *, const float *, const float *, int,
+                float *, unsigned char *, const BatchParams *);
+} BatchKernels;
+
+static BatchKernels kern_precise, kern_fast;
+static const char *kern_isa = "scalar";
+static pthread_once_t kern_once = PTHREAD_ONCE_INIT;
+static int batch_fast_default;
+
+static void batch_select(void)
+{
+#ifdef PROJ_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        kern_precise = (BatchKernels){ batch_avx2_f64, batch_avx2_f64_unit };
+        kern_fast    = (BatchKernels){ batch_avx2_f32, batch_avx2_f32_unit };
+        kern_isa = "avx2";
+    } else if (__builtin_cpu_supports("sse2")) {
+        kern_precise = (BatchKernels){ batch_sse2_f64, batch_sse2_f64_unit };
+        kern_fast    = (BatchKernels){ batch_sse2_f32, batch_sse2_f32_unit };
+        kern_isa = "sse2";
+    }
+#else
+    kern_precise = (BatchKernels){ batch_vec_f64, batch_vec_f64_unit };
+    kern_fast    = (BatchKernels){ batch_vec_f32, batch_vec_f32_unit };
+    kern_isa = "vector";
+#endif
+}
+
+static BatchParams batch_params(int flags)
+{
+    BatchParams bp = {
+        .sin_clat = sin_clat,
+        .cos_clat = cos_clat,
+        .clon_rad = center_lon_rad,
+        .ortho = (proj_mode == PROJ_ORTHO),
+        .clamp = (flags & PROJ_BATCH_CLAMP) != 0,
+    };
+    for (int i = 0; i < 9; i++) bp.rot[i] = rot[i];
+    return bp;
+}
+
+static const BatchKernels *batch_kernels(int flags)
+{
+    pthread_once(&kern_once, batch_select);
+    return ((flags & PROJ_BATCH_FAST) || batch_fast_default) ? &kern_fast : &kern_precise;
+}
+
+/* Scalar reference for the tail (and CPUs without a vector kernel).
+ * Same radial step as the kernels, in double precision with libm. */
+static void scalar_radial(double px, double py, double cos_c, const BatchParams *bp,
+                          float *xy, unsigned char *back)
+{
+    double rho = sqrt(px * px + py * py);
+    double x, y;
+    int is_back = 0;
+
+    if (bp->ortho) {
+        x = EARTH_RADIUS_KM * px;
+        y = EARTH_RADIUS_KM * py;
+        if (cos_c <= 0.0) {
+            is_back = 1;
+            if (!bp->clamp) {
+                x = 1e6;
+                y = 1e6;
+            } else if (rho > 1e-12) {
+                x = px * (EARTH_RADIUS_KM / rho);
+                y = py * (EARTH_RADIUS_KM / rho);
+            } else {
+                x = EARTH_RADIUS_KM;
+                y = 0.0;
+            }
+        }
+    } else {
+        double k = (rho < 1e-12) ? EARTH_RADIUS_KM
+                                 : EARTH_RADIUS_KM * atan2(rho, cos_c) / rho;
+        x = k * px;
+        y = k * py;
+    }
+    xy[0] = (float)x;
+    xy[1] = (float)y;
+    if (back) *back = (unsigned char)is_back;
+}
+
+static void batch_scalar(const double *lats, const double *lons, int n,
+                         float *xy, unsigned char *back, const BatchParams *bp)
+{
+    for (int i = 0; i < n; i++) {
+        double lat = lats[i] * DEG2RAD;
+        double dlon = lons[i] * DEG2RAD - bp->clon_rad;
+        double sin_lat = sin(lat), cos_lat = cos(lat), cos_dlon = cos(dlon);
+        scalar_radial(cos_lat * sin(dlon),
+                      bp->cos_clat * sin_lat - bp->sin_clat * cos_lat * cos_dlon,
+                      bp->sin_clat * sin_lat + bp->cos_clat * cos_lat * cos_dlon,
+                      bp, xy + i * 2, back ? back + i : NULL);
+    }
+}
+
+static void batch_scalar_unit(const float *ux, const float *uy, const float *uz,
+                              int n, float *xy, unsigned char *back,
+                              const BatchParams *bp)
+{
+    const double *m = bp->rot;
+    for (int i = 0; i < n; i++) {
+        double vx = ux[i], vy = uy[i], vz = uz[i];
+        scalar_radial(m[0] * vx + m[1] * vy + m[2] * vz,
+                      m[3] * vx + m[4] * vy + m[5] * vz,
+                      m[6] * vx + m[7] * vy + m[8] * vz,
+                      bp, xy + i * 2, back ? back + i : NULL);
+    }
+}
+
+void projection_set_batch_fast(int enable) { batch_fast_default = enable; }
+
+const char *projection_batch_isa(void)
+{
+    pthread_once(&kern_once, batch_select);
+    return kern_isa;
+}
+
+void projection_forward_batch(const double *lats, const double *lons, int n,
+                              float *xy, unsigned char *back, int flags)
+{
+    if (n <= 0) return;
+    const BatchKernels *k = batch_kernels(flags);
+    BatchParams bp = batch_params(flags);
+
+    int done = k->latlon ? k->latlon(lats, lons, n, xy, back, &bp) : 0;
+    if (done < n)
+        batch_scalar(lats + done, lons + done, n - done,
+                     xy + done * 2, back ? back + done : NULL, &bp);
+}
+
+void projection_to_unit(const double *lats, const double *lons, int n, float *unit)
+{
+    float *ux = unit, *uy = unit + n, *uz = unit + 2 * n;
+    for (int i = 0; i < n; i++) {
+        double lat = lats[i] * DEG2RAD, lon = lons[i] * DEG2RAD;
+        double cos_lat = cos(lat);
+        ux[i] = (float)(cos_lat * cos(lon));
+        uy[i] = (float)(cos_lat * sin(lon));
+        uz[i] = (float)sin(lat);
+    }
+}
+
+void projection_forward_unit_batch(const float *unit, int stride, int n, float *xy,
+                                   unsigned char *back, int flags)
+{
+    if (n <= 0) return;
+    const BatchKernels *k = batch_kernels(flags);
+    BatchParams bp = batch_params(flags);
+    const float *ux = unit, *uy = unit + stride, *uz = unit + 2 * stride;
+
+    int done = k->unit ? k->unit(ux, uy, uz, n, xy, back, &bp) : 0;
+    if (done < n)
+        batch_scalar_unit(ux + done, uy + done, uz + done, n - done,
+                          xy + done * 2, back ? back + done : NULL, &bp);
+}
+
+/* ── Spherical caps ──────────────────────────────────────────────── */
+
+/* Slack added to cap radii: float unit vectors and chords between
+ * vertices drawn straight in km-space rather than along great circles */
+#define CAP_PAD_RAD 1e-4
+/* Widest view cap before culling is given up (~115°) */
+#define VIEW_CAP_MAX_RAD 2.0
+/* Outline samples per view edge */
+#define VIEW_CAP_SAMPLES 8
+
+static void cap_all(float cap[4])
+{
+    cap[0] = 0.0f; cap[1] = 0.0f; cap[2] = 1.0f;
+    cap[3] = SEG_CAP_ALL;
+}
+
+void projection_bound_cap(const float *unit, int stride, int n, float cap[4])
+{
+    const float *ux = unit, *uy = unit + stride, *uz = unit + 2 * stride;
+    double cx = 0.0, cy = 0.0, cz = 0.0;
+    for (int i = 0; i < n; i++) {
+        cx += ux[i]; cy += uy[i]; cz += uz[i];
+    }
+    double len = sqrt(cx * cx + cy * cy + cz * cz);
+    if (n <= 0 || len < 1e-9 * n) {
+        cap_all(cap);
+        return;
+    }
+    cx /= len; cy /= len; cz /= len;
+
+    double min_dot = 1.0;
+    for (int i = 0; i < n; i++) {
+        double d = cx * ux[i] + cy * uy[i] + cz * uz[i];
+        if (d < min_dot) min_dot = d;
+    }
+    if (min_dot > 1.0) min_dot = 1.0;
+    double r = acos(min_dot) + CAP_PAD_RAD;
+    if (r > M_PI / 2.0) {
+        cap_all(cap);
+        return;
+    }
+    cap[0] = (float)cx; cap[1] = (float)cy; cap[2] = (float)cz;
+    cap[3] = (float)r;
+}
+
+int projection_caps_overlap(const float *a, const float *b)
+{
+    float r = a[3] + b[3];
+    if (r >= (float)M_PI) return 1;
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2] >= cosf(r);
+}
+
+int projection_cap_covers(const float *outer, const float *inner)
+{
+    if (outer[3] >= (float)M_PI) return 1;
+    if (inner[3] >= (float)M_PI) return 0;
+    double d = outer[0] * inner[0] + outer[1] * inner[1] + outer[2] * inner[2];
+    if (d > 1.0) d = 1.0;
+    if (d < -1.0) d = -1.0;
+    return acos(d) + inner[3] <= outer[3];
+}
+
+static void latlon_unit(double lat_deg, double lon_deg, double *u)
+{
+    double lat = lat_deg * DEG2RAD, lon = lon_deg * DEG2RAD;
+    u[0] = cos(lat) * cos(lon);
+    u[1] = cos(lat) * sin(lon);
+    u[2] = sin(lat);
+}
+
+void projection_view_cap(double x, double y, double half_w, double half_h, float cap[4])
+{
+    double lat, lon, c[3], p[3];
+    double r = 0.0;
+    int ok = (projection_inverse(x, y, &lat, &lon) == 0);
+    if (ok)
+        latlon_unit(lat, lon, c);
+
+    /* Walk the outline; the farthest point of the region lies on it */
+    for (int e = 0; ok && e < 4; e++) {
+        for (int i = 0; i < VIEW_CAP_SAMPLES; i++) {
+            double t = -1.0 + 2.0 * i / VIEW_CAP_SAMPLES;
+            double sx = (e == 0) ? t : (e == 1) ? 1.0 : (e == 2) ? -t : -1.0;
+            double sy = (e == 0) ? -1.0 : (e == 1) ? t : (e == 2) ? 1.0 : -t;
+            if (projection_inverse(x + sx * half_w, y + sy * half_h, &lat, &lon) != 0) {
+                ok = 0;
+                break;
+            }
+            latlon_unit(lat, lon, p);
+            double d = c[0] * p[0] + c[1] * p[1] + c[2] * p[2];
+            if (d > 1.0) d = 1.0;
+            double a = acos(d);
+            if (a > r) r = a;
+        }
+    }
+    /* Margin for the outline bulging between samples */
+    r = r * 1.1 + CAP_PAD_RAD;
+
+    if (ok && r <= VIEW_CAP_MAX_RAD) {
+        cap[0] = (float)c[0]; cap[1] = (float)c[1]; cap[2] = (float)c[2];
+        cap[3] = (float)r;
+    } else if (proj_mode == PROJ_ORTHO) {
+        latlon_unit(center_lat_deg_store, center_lon_deg_store, c);
+        cap[0] = (float)c[0]; cap[1] = (float)c[1]; cap[2] = (float)c[2];
+        cap[3] = (float)(M_PI / 2.0 + CAP_PAD_RAD);
+    } else {
+        cap_all(cap);
+    }
+}
@@ -16,6 +16,17 @@
 
 typedef enum { PROJ_AZEQ, PROJ_ORTHO } ProjMode;
 
+/* Mode and center are thread-local, so a worker can project around a new
+ * center while the main thread keeps drawing the old one.  A thread that
+ * projects on another's behalf adopts its state with these. */
+typedef struct {
+    ProjMode mode;
+    double   lat_deg, lon_deg;   /* center */
+} ProjState;
+
+void projection_get_state(ProjState *s);
+void projection_set_state(const ProjState *s);
+
 /* Set/get projection mode (azimuthal equidistant or orthographic). */
 void projection_set_mode(ProjMode mode);
 ProjMode projection_get_mode(void);
@@ -37,6 +48,73 @@ int projection_forward(double lat_deg, double lon_deg, double *x, double *y);
  * boundary circle instead of returning (1e6,1e6). Always returns 0. */
 int projection_forward_clamped(double lat_deg, double lon_deg, double *x, double *y);
 
+/* Flags for projection_forward_batch(). */
+#define PROJ_BATCH_CLAMP 0x1  /* clamp ortho back-hemisphere points to the boundary */
+#define PROJ_BATCH_FAST  0x2  /* float32 kernels (see error bound below) */
+
+/* Batch forward projection: n lat/lon pairs (degrees, separate arrays) →
+ * interleaved x,y floats in km.  Semantics match projection_forward()
+ * (back-hemisphere ortho points written as 1e6,1e6) or, with
+ * PROJ_BATCH_CLAMP, projection_forward_clamped().  If back is non-NULL,
+ * back[i] is set to 1 for ortho back-hemisphere points, else 0.
+ *
+ * Uses SIMD kernels (AVX2 or SSE2, chosen at runtime) with a scalar tail.
+ * The default tier computes in double precision and agrees with
+ * projection_forward() to within float rounding of the output (< 2 m),
+ * and is more accurate near the center where acos(cos c) loses digits.
+ * PROJ_BATCH_FAST computes in float32: max error vs the double reference
+ * is 25 m for points within 170° of the center (AZEQ) or anywhere on the
+ * front hemisphere (ORTHO), growing to ~2 km toward the AZEQ antipode
+ * where the projection itself is singular. */
+void projection_forward_batch(const double *lats, const double *lons, int n,
+                              float *xy, unsigned char *back, int flags);
+
+/* Use the float32 tier for every batch call (as if PROJ_BATCH_FAST were set). */
+void projection_set_batch_fast(int enable);
+
+/* Name of the kernel selected at runtime ("avx2", "sse2", "vector", "scalar"). */
+const char *projection_batch_isa(void);
+
+/* Convert n lat/lon pairs (degrees) to Earth-centered unit vectors
+ * (x toward 0°N 0°E, z toward the north pole).  unit holds 3·n floats
+ * as three planes: x[0..n), y[0..n), z[0..n).  Loaders call this once so
+ * that reprojection needs no per-vertex trig. */
+void projection_to_unit(const double *lats, const double *lons, int n, float *unit);
+
+/* Batch forward projection from unit vectors (see projection_to_unit).
+ * Each point is rotated into the center's east/north/up frame with the
+ * matrix built by projection_set_center(), then scaled radially (c/sin c
+ * for AZEQ, hemisphere test for ORTHO).  Flags, back[] and the precision
+ * tiers are as for projection_forward_batch().  Float storage of the unit
+ * vectors adds < 5 m within 170° of the center; toward the AZEQ antipode
+ * the error grows to a few hundred metres.
+ * The three planes start at unit, unit + stride and unit + 2·stride, so a
+ * sub-range [start, start + n) of a store of N points is projected with
+ * (unit + start, N, n). */
+void projection_forward_unit_batch(const float *unit, int stride, int n, float *xy,
+                                   unsigned char *back, int flags);
+
+/* Spherical caps {x, y, z, r}: unit center and angular radius in radians.
+ * A radius >= π (SEG_CAP_ALL) covers the whole sphere.  Used to cull map
+ * segments against the visible part of the globe. */
+
+/* Smallest-ish cap around n unit vectors (planes stride apart).  Caps wider
+ * than a hemisphere are widened to the whole sphere, since great-circle
+ * edges between their points may leave them. */
+void projection_bound_cap(const float *unit, int stride, int n, float cap[4]);
+
+/* 1 if caps a and b intersect. */
+int projection_caps_overlap(const float *a, const float *b);
+
+/* 1 if cap outer contains cap inner. */
+int projection_cap_covers(const float *outer, const float *inner);
+
+/* Cap covering the km-space view rectangle centered on (x, y) with the
+ * given half extents, found by inverse-projecting its outline.  Falls back
+ * to the front hemisphere (ORTHO) or the whole sphere (AZEQ) when the view
+ * reaches past the globe or spans more than ~115°. */
+void projection_view_cap(double x, double y, double half_w, double half_h, float cap[4]);
+
 /* Inverse projection: x,y (km) → lat/lon (degrees).
  * Returns 0 on success, -1 if the point is outside the globe. */
 int projection_inverse(double x, double y, double *lat_deg, double *lon_deg);
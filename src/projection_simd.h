@@ -0,0 +1,237 @@
+/* projection_simd.h — Vector kernel template for projection_forward_batch().
+ *
+ * Included by projection.c once per (element type, lane count, target ISA)
+ * combination.  The kernel is written with GCC/Clang vector extensions so
+ * the same source compiles to SSE2, AVX2 or NEON depending on the target
+ * attribute; only the square root needs a per-ISA intrinsic.
+ *
+ * Before inclusion define:
+ *   KERNEL_NAME    function name to generate
+ *   KERNEL_TARGET  function attribute (e.g. __attribute__((target("avx2"))))
+ *   KERNEL_FLOAT   0 = double lanes (precise tier), 1 = float lanes (fast tier)
+ *   KERNEL_WIDTH   number of lanes
+ *   KERNEL_SQRT(v) lane-wise square root of a vector
+ *
+ * Two entry points are generated: KERNEL_NAME takes lat/lon arrays in
+ * degrees, KERNEL_NAME##_unit takes precomputed unit vectors (one plane
+ * per component, so lanes load contiguously) and replaces
+ * the sin/cos evaluation with the 3x3 rotation from BatchParams.  Both
+ * share the radial step (..._radial), which turns the rotated point
+ * (px, py, cos c) into km-space.
+ *
+ * sin/cos use Cody-Waite reduction by π/2 (quadrant taken from the low
+ * mantissa bits of a magic-number round) and fdlibm/Cephes minimax
+ * polynomials on [-π/4, π/4].  The angular distance c is computed as
+ * atan2(sin c, cos c) with sin c = |(x, y)|, which keeps full precision
+ * close to the projection center where acos(cos c) degrades. */
+
+#define KJOIN_(a, b) a##b
+#define KJOIN(a, b)  KJOIN_(a, b)
+#define VR KJOIN(KERNEL_NAME, _vr)
+#define VI KJOIN(KERNEL_NAME, _vi)
+
+#if KERNEL_FLOAT
+typedef float   VR __attribute__((vector_size(KERNEL_WIDTH * 4)));
+typedef int32_t VI __attribute__((vector_size(KERNEL_WIDTH * 4)));
+#define KREAL float
+#else
+typedef double  VR __attribute__((vector_size(KERNEL_WIDTH * 8)));
+typedef int64_t VI __attribute__((vector_size(KERNEL_WIDTH * 8)));
+#define KREAL double
+#endif
+
+#define K(c)          ((KREAL)(c))
+#define KSEL(m, a, b) ((VR)(((m) & (VI)(a)) | (~(m) & (VI)(b))))
+
+/* Local (east, north, up) components → projected x,y and back flags. */
+KERNEL_TARGET
+static inline void KJOIN(KERNEL_NAME, _radial)(VR px, VR py, VR cos_c,
+                                               const BatchParams *bp,
+                                               VR *out_x, VR *out_y, VI *out_back)
+{
+    const VR zero = { 0 };
+    const VI izero = { 0 };
+    const VI sign = (VI)(-zero);            /* sign bit in every lane */
+    const VR R = zero + K(EARTH_RADIUS_KM);
+
+    VR rho = KERNEL_SQRT(px * px + py * py);
+    VI tiny = rho < K(1e-12);
+    VR X, Y;
+    VI is_back = izero;
+
+    if (bp->ortho) {
+        is_back = cos_c <= zero;
+        X = R * px;
+        Y = R * py;
+        if (bp->clamp) {
+            /* Back hemisphere — clamp to the boundary circle */
+            VR scale = R / KSEL(tiny, zero + K(1.0), rho);
+            X = KSEL(is_back, KSEL(tiny, R, px * scale), X);
+            Y = KSEL(is_back, KSEL(tiny, zero, py * scale), Y);
+        } else {
+            X = KSEL(is_back, zero + K(1e6), X);
+            Y = KSEL(is_back, zero + K(1e6), Y);
+        }
+    } else {
+        /* c = atan2(rho, cos_c) on [0, π] via atan of min/max ratio */
+        VR ax = (VR)((VI)cos_c & ~sign);
+        VI steep = rho > ax;
+        VR hi = KSEL(steep, rho, ax);
+        VR lo = KSEL(steep, ax, rho);
+        VR ratio = lo / KSEL(hi > zero, hi, zero + K(1.0));
+#if KERNEL_FLOAT
+        VI big = ratio > K(0.4142135623730950);
+        VR u = KSEL(big, (ratio - K(1.0)) / (ratio + K(1.0)), ratio);
+        VR uz = u * u;
+        VR at = KSEL(big, zero + K(M_PI / 4.0), zero)
+              + ((((K(8.05374449538e-2) * uz - K(1.38776856032e-1)) * uz
+                   + K(1.99777106478e-1)) * uz - K(3.33329491539e-1)) * uz * u + u);
+#else
+        VI big = ratio > K(0.66);
+        VR u = KSEL(big, (ratio - K(1.0)) / (ratio + K(1.0)), ratio);
+        VR uz = u * u;
+        VR p = (((K(-8.750608600031904122785e-1) * uz + K(-1.615753718733365076637e1)) * uz
+                 + K(-7.500855792314704667340e1)) * uz + K(-1.228866684490136173410e2)) * uz
+                 + K(-6.485021904942025371773e1);
+        VR qq = ((((uz + K(2.485846490142306297962e1)) * uz + K(1.650270098316988542046e2)) * uz
+                  + K(4.328810604912902668951e2)) * uz + K(4.853903996359136964868e2)) * uz
+                  + K(1.945506571482613964425e2);
+        VR at = KSEL(big, zero + K(M_PI / 4.0 + 3.061616997868382943065e-17), zero)
+              + (u + u * uz * p / qq);
+#endif
+        at = KSEL(steep, K(M_PI / 2.0) - at, at);
+        VR c = KSEL(cos_c < zero, K(M_PI) - at, at);
+        VR k = R * KSEL(tiny, zero + K(1.0), c / KSEL(tiny, zero + K(1.0), rho));
+        X = k * px;
+        Y = k * py;
+    }
+
+    *out_x = X;
+    *out_y = Y;
+    *out_back = is_back;
+}
+
+KERNEL_TARGET
+static inline void KJOIN(KERNEL_NAME, _store)(int at, VR X, VR Y, VI is_back,
+                                              float *xy, unsigned char *back)
+{
+    for (int j = 0; j < KERNEL_WIDTH; j++) {
+        xy[(at + j) * 2]     = (float)X[j];
+        xy[(at + j) * 2 + 1] = (float)Y[j];
+        if (back) back[at + j] = is_back[j] ? 1 : 0;
+    }
+}
+
+KERNEL_TARGET
+static int KERNEL_NAME(const double *lats, const double *lons, int n,
+                       float *xy, unsigned char *back, const BatchParams *bp)
+{
+    const VR zero = { 0 };
+    const VI izero = { 0 };
+    const VI sign = (VI)(-zero);            /* sign bit in every lane */
+    const VR sin_clat = zero + K(bp->sin_clat);
+    const VR cos_clat = zero + K(bp->cos_clat);
+
+#if KERNEL_FLOAT
+    const VR magic = zero + K(12582912.0);          /* 1.5 * 2^23 */
+    const KREAL pio2_1 = 1.5703125f;
+    const KREAL pio2_2 = 4.837512969970703125e-4f;
+    const KREAL pio2_3 = 7.54978995489188216e-8f;
+#else
+    const VR magic = zero + K(6755399441055744.0);  /* 1.5 * 2^52 */
+    const KREAL pio2_1 = 1.57079632673412561417e+00;
+    const KREAL pio2_2 = 6.07710050650619224932e-11;
+#endif
+
+    int done = 0;
+    for (; done + KERNEL_WIDTH <= n; done += KERNEL_WIDTH) {
+        VR a[2];   /* a[0] = latitude, a[1] = longitude offset (radians) */
+        for (int j = 0; j < KERNEL_WIDTH; j++) {
+            a[0][j] = (KREAL)(lats[done + j] * (M_PI / 180.0));
+            a[1][j] = (KREAL)(lons[done + j] * (M_PI / 180.0) - bp->clon_rad);
+        }
+
+        VR sn[2], cs[2];
+        for (int k = 0; k < 2; k++) {
+            VR x = a[k];
+            VR t = x * K(2.0 / M_PI) + magic;
+            VI q = (VI)t & 3;
+            VR qd = t - magic;
+#if KERNEL_FLOAT
+            VR r = ((x - qd * pio2_1) - qd * pio2_2) - qd * pio2_3;
+            VR z = r * r;
+            VR s = r + r * z * (K(-1.6666654611e-1) + z * (K(8.3321608736e-3)
+                                + z * K(-1.9515295891e-4)));
+            VR c = K(1.0) - K(0.5) * z + z * z * (K(4.166664568298827e-2)
+                   + z * (K(-1.388731625493765e-3) + z * K(2.443315711809948e-5)));
+#else
+            VR r = (x - qd * pio2_1) - qd * pio2_2;
+            VR z = r * r;
+            VR s = r + r * z * (K(-1.66666666666666324348e-01) + z * (K(8.33333333332248946124e-03)
+                   + z * (K(-1.98412698298579493134e-04) + z * (K(2.75573137070700676789e-06)
+                   + z * (K(-2.50507602534068634195e-08) + z * K(1.58969099521155010221e-10))))));
+            VR c = K(1.0) - K(0.5) * z + z * z * (K(4.16666666666666019037e-02)
+                   + z * (K(-1.38888888888741095749e-03) + z * (K(2.48015872894767294178e-05)
+                   + z * (K(-2.75573143513906633035e-07) + z * (K(2.08757232129817482790e-09)
+                   + z * K(-1.13596475577881948265e-11))))));
+#endif
+            VI swap    = (q & 1) != izero;
+            VI sin_neg = (q & 2) != izero;
+            VI cos_neg = ((q + 1) & 2) != izero;
+            sn[k] = (VR)((VI)KSEL(swap, c, s) ^ (sin_neg & sign));
+            cs[k] = (VR)((VI)KSEL(swap, s, c) ^ (cos_neg & sign));
+        }
+
+        VR px = cs[0] * sn[1];
+        VR py = cos_clat * sn[0] - sin_clat * cs[0] * cs[1];
+        VR cos_c = sin_clat * sn[0] + cos_clat * cs[0] * cs[1];
+
+        VR X, Y;
+        VI is_back;
+        KJOIN(KERNEL_NAME, _radial)(px, py, cos_c, bp, &X, &Y, &is_back);
+        KJOIN(KERNEL_NAME, _store)(done, X, Y, is_back, xy, back);
+    }
+    return done;
+}
+
+KERNEL_TARGET
+static int KJOIN(KERNEL_NAME, _unit)(const float *ux, const float *uy, const float *uz,
+                                     int n, float *xy, unsigned char *back,
+                                     const BatchParams *bp)
+{
+    typedef float VF __attribute__((vector_size(KERNEL_WIDTH * 4)));
+    const VR zero = { 0 };
+    VR m[9];
+    for (int i = 0; i < 9; i++)
+        m[i] = zero + K(bp->rot[i]);
+
+    int done = 0;
+    for (; done + KERNEL_WIDTH <= n; done += KERNEL_WIDTH) {
+        VF fx, fy, fz;
+        memcpy(&fx, ux + done, sizeof(fx));
+        memcpy(&fy, uy + done, sizeof(fy));
+        memcpy(&fz, uz + done, sizeof(fz));
+        VR vx = __builtin_convertvector(fx, VR);
+        VR vy = __builtin_convertvector(fy, VR);
+        VR vz = __builtin_convertvector(fz, VR);
+
+        /* Rotate into the center's east/north/up frame */
+        VR px    = m[0] * vx + m[1] * vy + m[2] * vz;
+        VR py    = m[3] * vx + m[4] * vy + m[5] * vz;
+        VR cos_c = m[6] * vx + m[7] * vy + m[8] * vz;
+
+        VR X, Y;
+        VI is_back;
+        KJOIN(KERNEL_NAME, _radial)(px, py, cos_c, bp, &X, &Y, &is_back);
+        KJOIN(KERNEL_NAME, _store)(done, X, Y, is_back, xy, back);
+    }
+    return done;
+}
+
+#undef K
+#undef KSEL
+#undef KREAL
+#undef VR
+#undef VI
+#undef KJOIN
+#undef KJOIN_
@@ -4,18 +4,40 @@
  * (session key + callsign → XML with lat/lon/name/grid/etc).  Session keys
  * expire; on timeout the login is retried once automatically.  Uses a simple
  * strstr-based XML tag extractor (no full XML parser needed for QRZ's
- * flat response format). */
+ * flat response format).
+ *
+ * QRZ_WORKERS threads share the network side: the popup request slot, a
+ * batch queue and the session key.  Each keeps its own curl handle (its
+ * connection to xmldata.qrz.com stays open between lookups); DNS and TLS
+ * sessions are shared.  The cache is a fixed pool of entries on a hash
+ * table with chaining plus an LRU list; the mutex that guards it also
+ * guards the request slot, the batch and the result queue.  The cache file is plain
+ * text, written to a temporary file and renamed into place, mode 0600
+ * because it holds the session key. */
 
 #include "qrz.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <time.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
 #include <curl/curl.h>
+#include "cachedir.h"
+
+#ifndef QRZ_API_URL
+#define QRZ_API_URL        "https://xmldata.qrz.com/xml/current/"
+#endif
+#define QRZ_CACHE_MAGIC    "azmap-qrz 1"
+#define QRZ_CACHE_BUCKETS  2048      /* power of two, >= QRZ_CACHE_MAX */
 
 static char qrz_user[64];    /* QRZ.com username (callsign) */
 static char qrz_pass[64];    /* QRZ.com password */
 static char session_key[64]; /* current API session key (expires periodically) */
+static time_t session_time;  /* when session_key was issued */
 
 /* Dynamic buffer for curl response */
 typedef struct {
@@ -78,18 +100,112 @@ static int xml_extract(const char *xml, const char *tag, char *out, int out_sz)
     return 0;
 }
 
-static int http_get(const char *url, Buffer *buf)
+/* ── Worker state ─────────────────────────────────────────────────── */
+
+typedef struct {
+    char      key[32];       /* normalized callsign looked up */
+    QRZResult res;
+    time_t    fetched;
+    int       prev, next;    /* LRU list, most recent first */
+    int       hnext;         /* hash chain */
+} CacheEntry;
+
+typedef struct BatchNode {
+    QRZBatchResult     r;
+    struct BatchNode  *next;
+} BatchNode;
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;       /* a request was posted, or stop */
+    pthread_t       threads[QRZ_WORKERS];
+    int             running, stop, offline;
+
+    /* Popup request and result slots (latest lookup only) */
+    unsigned        seq;        /* id of the latest request */
+    char            req_call[32];
+    int             req_pending;
+    unsigned        res_seq;    /* id the result belongs to, 0 = none */
+    int             res_status;
+    QRZResult       res;
+    char            res_err[128];
+
+    /* Batch: callsigns still to look up, results not taken yet */
+    unsigned        batch_id;   /* id of the current batch */
+    char          (*batch)[32];
+    int             batch_n, batch_next;
+    int             batch_renewed;  /* its one session renewal is used */
+    int             batch_dead;     /* renewal failed: fail the rest */
+    char            batch_err[64];
+    BatchNode      *out_head, *out_tail;
+    QRZBatchStats   stats;
+    double          batch_start, batch_last;   /* ms */
+
+    /* Cache */
+    CacheEntry      entries[QRZ_CACHE_MAX];
+    int             bucket[QRZ_CACHE_BUCKETS];
+    int             count, head, tail;
+    int             dirty;      /* changed since the last save */
+} q;
+
+/* Session key shared by the workers.  Lock order: session_lock, then
+ * q.lock.  session_gen counts logins, so workers that all saw the same
+ * key expire renew it only once. */
+static pthread_mutex_t session_lock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned session_gen;
+
+/* TLS sessions and DNS shared by the workers' handles (each keeps its
+ * own connection) */
+static CURLSH *share;
+static pthread_mutex_t share_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void (*qrz_wake)(void);
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static void share_lock_cb(CURL *h, curl_lock_data data, curl_lock_access access, void *ctx)
+{
+    (void)h; (void)data; (void)access; (void)ctx;
+    pthread_mutex_lock(&share_lock);
+}
+
+static void share_unlock_cb(CURL *h, curl_lock_data data, void *ctx)
+{
+    (void)h; (void)data; (void)ctx;
+    pthread_mutex_unlock(&share_lock);
+}
+
+/* Abort a transfer in progress when the workers are told to stop */
+static int xfer_callback(void *clientp, curl_off_t dltotal, curl_off_t dlnow,
+                         curl_off_t ultotal, curl_off_t ulnow)
+{
+    (void)clientp; (void)dltotal; (void)dlnow; (void)ultotal; (void)ulnow;
+    pthread_mutex_lock(&q.lock);
+    int stop = q.stop;
+    pthread_mutex_unlock(&q.lock);
+    return stop;
+}
+
+/* GET url on the worker's handle (reused for keep-alive) */
+static int http_get(CURL *curl, const char *url, Buffer *buf)
 {
-    CURL *curl = curl_easy_init();
-    if (!curl) return -1;
     buf_init(buf);
+    if (!buf->data) return -1;
     curl_easy_setopt(curl, CURLOPT_URL, url);
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, buf);
     curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
     curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, xfer_callback);
+    if (share) curl_easy_setopt(curl, CURLOPT_SHARE, share);
     CURLcode res = curl_easy_perform(curl);
-    curl_easy_cleanup(curl);
     if (res != CURLE_OK) {
         buf_free(buf);
         return -1;
@@ -97,25 +213,20 @@ static int http_get(const char *url, Buffer *buf)
     return 0;
 }
 
-static int qrz_login(char *err_buf, int err_sz)
+/* Log in and store a new session key (session_lock held) */
+static int qrz_login(CURL *curl, char *err_buf, int err_sz)
 {
-    CURL *enc = curl_easy_init();
-    if (!enc) {
-        if (err_buf) snprintf(err_buf, err_sz, "CURL INIT FAILED");
-        return -1;
-    }
-    char *esc_user = curl_easy_escape(enc, qrz_user, 0);
-    char *esc_pass = curl_easy_escape(enc, qrz_pass, 0);
+    char *esc_user = curl_easy_escape(curl, qrz_user, 0);
+    char *esc_pass = curl_easy_escape(curl, qrz_pass, 0);
     char url[512];
     snprintf(url, sizeof(url),
-             "https://xmldata.qrz.com/xml/current/?username=%s;password=%s;agent=azmap1.0",
+             QRZ_API_URL "?username=%s;password=%s;agent=azmap1.0",
              esc_user ? esc_user : "", esc_pass ? esc_pass : "");
     curl_free(esc_user);
     curl_free(esc_pass);
-    curl_easy_cleanup(enc);
 
     Buffer buf;
-    if (http_get(url, &buf) != 0) {
+    if (http_get(curl, url, &buf) != 0) {
         if (err_buf) snprintf(err_buf, err_sz, "HTTP REQUEST FAILED");
         return -1;
     }
@@ -138,53 +249,91 @@ static int qrz_login(char *err_buf, int err_sz)
 
     strncpy(session_key, key, sizeof(session_key) - 1);
     session_key[sizeof(session_key) - 1] = '\0';
+    session_time = time(NULL);
+    session_gen++;
     buf_free(&buf);
+    pthread_mutex_lock(&q.lock);
+    q.dirty = 1;
+    pthread_mutex_unlock(&q.lock);
     return 0;
 }
 
-int qrz_init(const char *username, const char *password)
+/* Copy the session key and its generation, logging in first if there is
+ * none.  Returns 0, or -1 with err_buf filled. */
+static int get_session(CURL *curl, char *key, unsigned *gen, char *err_buf, int err_sz)
 {
-    strncpy(qrz_user, username, sizeof(qrz_user) - 1);
-    qrz_user[sizeof(qrz_user) - 1] = '\0';
-    strncpy(qrz_pass, password, sizeof(qrz_pass) - 1);
-    qrz_pass[sizeof(qrz_pass) - 1] = '\0';
-    session_key[0] = '\0';
-    curl_global_init(CURL_GLOBAL_DEFAULT);
-    return 0;
+    pthread_mutex_lock(&session_lock);
+    int rc = 0;
+    if (session_key[0] == '\0')
+        rc = qrz_login(curl, err_buf, err_sz);
+    memcpy(key, session_key, sizeof(session_key));
+    *gen = session_gen;
+    pthread_mutex_unlock(&session_lock);
+    return rc;
 }
 
-int qrz_lookup(const char *callsign, QRZResult *result, char *err_buf, int err_sz)
+/* The key of generation gen was rejected: log in again unless another
+ * worker already has.  A batch (batch_id != 0) gets one renewal; when it
+ * is used up or the login fails, the rest of the batch fails without
+ * going to the network.  Returns 0 with the new key copied, or -1 with
+ * err_buf filled. */
+static int renew_session(CURL *curl, unsigned gen, unsigned batch_id,
+                         char *key, char *err_buf, int err_sz)
 {
-    memset(result, 0, sizeof(*result));
-
-    /* Login if no session key */
-    if (session_key[0] == '\0') {
-        if (qrz_login(err_buf, err_sz) != 0)
-            return -1;
+    pthread_mutex_lock(&session_lock);
+    int rc = 0;
+    if (session_gen == gen) {
+        int allowed = 1;
+        pthread_mutex_lock(&q.lock);
+        if (batch_id && batch_id == q.batch_id) {
+            allowed = !q.batch_renewed;
+            q.batch_renewed = 1;
+        }
+        pthread_mutex_unlock(&q.lock);
+        if (allowed) {
+            session_key[0] = '\0';
+            rc = qrz_login(curl, err_buf, err_sz);
+        } else {
+            if (err_buf) snprintf(err_buf, err_sz, "SESSION RENEWAL FAILED");
+            rc = -1;
+        }
+        if (rc != 0 && batch_id) {
+            pthread_mutex_lock(&q.lock);
+            if (batch_id == q.batch_id) {
+                q.batch_dead = 1;
+                snprintf(q.batch_err, sizeof(q.batch_err), "%s", err_buf ? err_buf : "");
+            }
+            pthread_mutex_unlock(&q.lock);
+        }
     }
+    memcpy(key, session_key, sizeof(session_key));
+    pthread_mutex_unlock(&session_lock);
+    return rc;
+}
 
-    /* Build lookup URL */
-    char call_upper[32];
-    int ci = 0;
-    for (int i = 0; callsign[i] && ci < 31; i++)
-        call_upper[ci++] = (char)toupper((unsigned char)callsign[i]);
-    call_upper[ci] = '\0';
+/* Look up a normalized callsign over the network (worker thread).
+ * Returns 0 on success, -1 on error with err_buf filled. */
+static int lookup_net(CURL *curl, const char *call_upper, unsigned batch_id,
+                      QRZResult *result, char *err_buf, int err_sz)
+{
+    memset(result, 0, sizeof(*result));
+
+    char key[64];
+    unsigned gen;
+    if (get_session(curl, key, &gen, err_buf, err_sz) != 0)
+        return -1;
 
-    CURL *enc = curl_easy_init();
-    if (!enc) {
-        if (err_buf) snprintf(err_buf, err_sz, "CURL INIT FAILED");
+    char *esc_call = curl_easy_escape(curl, call_upper, 0);
+    if (!esc_call) {
+        if (err_buf) snprintf(err_buf, err_sz, "OUT OF MEMORY");
         return -1;
     }
-    char *esc_call = curl_easy_escape(enc, call_upper, 0);
     char url[512];
-    snprintf(url, sizeof(url),
-             "https://xmldata.qrz.com/xml/current/?s=%s;callsign=%s",
-             session_key, esc_call ? esc_call : "");
-    curl_free(esc_call);
-    curl_easy_cleanup(enc);
+    snprintf(url, sizeof(url), QRZ_API_URL "?s=%s;callsign=%s", key, esc_call);
 
     Buffer buf;
-    if (http_get(url, &buf) != 0) {
+    if (http_get(curl, url, &buf) != 0) {
+        curl_free(esc_call);
         if (err_buf) snprintf(err_buf, err_sz, "HTTP REQUEST FAILED");
         return -1;
     }
@@ -195,14 +344,14 @@ int qrz_lookup(const char *callsign, QRZResult *result, char *err_buf, int err_s
         if (strstr(errmsg, "Session Timeout") || strstr(errmsg, "Invalid session key") ||
             strstr(errmsg, "session")) {
             buf_free(&buf);
-            session_key[0] = '\0';
-            if (qrz_login(err_buf, err_sz) != 0)
+            if (renew_session(curl, gen, batch_id, key, err_buf, err_sz) != 0) {
+                curl_free(esc_call);
                 return -1;
+            }
             /* Retry lookup */
-            snprintf(url, sizeof(url),
-                     "https://xmldata.qrz.com/xml/current/?s=%s;callsign=%s",
-                     session_key, call_upper);
-            if (http_get(url, &buf) != 0) {
+            snprintf(url, sizeof(url), QRZ_API_URL "?s=%s;callsign=%s", key, esc_call);
+            curl_free(esc_call);
+            if (http_get(curl, url, &buf) != 0) {
                 if (err_buf) snprintf(err_buf, err_sz, "HTTP REQUEST FAILED");
                 return -1;
             }
@@ -212,10 +361,13 @@ int qrz_lookup(const char *callsign, QRZResult *result, char *err_buf, int err_s
                 return -1;
             }
         } else {
+            curl_free(esc_call);
             if (err_buf) snprintf(err_buf, err_sz, "%.63s", errmsg);
             buf_free(&buf);
             return -1;
         }
+    } else {
+        curl_free(esc_call);
     }
 
     /* Extract fields */
@@ -269,7 +421,546 @@ int qrz_lookup(const char *callsign, QRZResult *result, char *err_buf, int err_s
     return 0;
 }
 
+/* ── Cache ────────────────────────────────────────────────────────── */
+
+/* FNV-1a of a normalized callsign */
+static unsigned call_hash(const char *call)
+{
+    unsigned h = 2166136261u;
+    for (; *call; call++)
+        h = (h ^ (unsigned char)*call) * 16777619u;
+    return h & (QRZ_CACHE_BUCKETS - 1);
+}
+
+static void lru_unlink(int i)
+{
+    CacheEntry *e = &q.entries[i];
+    if (e->prev >= 0) q.entries[e->prev].next = e->next;
+    else q.head = e->next;
+    if (e->next >= 0) q.entries[e->next].prev = e->prev;
+    else q.tail = e->prev;
+}
+
+static void lru_push_front(int i)
+{
+    CacheEntry *e = &q.entries[i];
+    e->prev = -1;
+    e->next = q.head;
+    if (q.head >= 0) q.entries[q.head].prev = i;
+    q.head = i;
+    if (q.tail < 0) q.tail = i;
+}
+
+/* Index of the entry for call, or -1 (lock held) */
+static int cache_find(const char *call)
+{
+    for (int i = q.bucket[call_hash(call)]; i >= 0; i = q.entries[i].hnext)
+        if (strcmp(q.entries[i].key, call) == 0)
+            return i;
+    return -1;
+}
+
+static void chain_remove(int i)
+{
+    int *link = &q.bucket[call_hash(q.entries[i].key)];
+    while (*link != i) link = &q.entries[*link].hnext;
+    *link = q.entries[i].hnext;
+}
+
+/* Tabs and line breaks would break the cache file */
+static void sanitize(char *s)
+{
+    for (; *s; s++)
+        if (*s == '\t' || *s == '\n' || *s == '\r') *s = ' ';
+}
+
+/* Store res under call as fetched at time t, evicting the least recently
+ * used entry when full (lock held) */
+static void cache_put(const char *call, const QRZResult *res, time_t t)
+{
+    int i = cache_find(call);
+    if (i >= 0) {
+        lru_unlink(i);
+    } else {
+        if (q.count < QRZ_CACHE_MAX) {
+            i = q.count++;
+        } else {
+            i = q.tail;
+            lru_unlink(i);
+            chain_remove(i);
+        }
+        unsigned h = call_hash(call);
+        snprintf(q.entries[i].key, sizeof(q.entries[i].key), "%s", call);
+        q.entries[i].hnext = q.bucket[h];
+        q.bucket[h] = i;
+    }
+    CacheEntry *e = &q.entries[i];
+    e->res = *res;
+    if (!e->res.call[0])
+        snprintf(e->res.call, sizeof(e->res.call), "%s", call);
+    sanitize(e->res.call);
+    sanitize(e->res.name);
+    sanitize(e->res.location);
+    sanitize(e->res.grid);
+    e->fetched = t;
+    lru_push_front(i);
+}
+
+/* Split line at tabs into at most max fields (in place).  Returns the
+ * number of fields. */
+static int split_tabs(char *line, char **fields, int max)
+{
+    int n = 0;
+    line[strcspn(line, "\r\n")] = '\0';
+    while (n < max) {
+        fields[n++] = line;
+        char *tab = strchr(line, '\t');
+        if (!tab) break;
+        *tab = '\0';
+        line = tab + 1;
+    }
+    return n;
+}
+
+/* Load the cache file: the session key of the same user while it is
+ * young enough, and the results that have not expired (oldest first, so
+ * the LRU order comes back as it was saved) */
+static void cache_load(void)
+{
+    char dir[PATH_MAX], path[PATH_MAX + 8], line[512];
+    if (cache_dir(dir, sizeof(dir)) != 0) return;
+    snprintf(path, sizeof(path), "%s/qrz", dir);
+    FILE *f = fopen(path, "r");
+    if (!f) return;
+    if (!fgets(line, sizeof(line), f) ||
+        strncmp(line, QRZ_CACHE_MAGIC, strlen(QRZ_CACHE_MAGIC)) != 0) {
+        fclose(f);
+        return;
+    }
+
+    time_t now = time(NULL);
+    char *fld[9];
+    while (fgets(line, sizeof(line), f)) {
+        int n = split_tabs(line, fld, 9);
+        if (n == 4 && strcmp(fld[0], "session") == 0) {
+            time_t t = (time_t)strtoll(fld[3], NULL, 10);
+            if (strcmp(fld[1], qrz_user) == 0 && now - t < QRZ_SESSION_TTL_SEC) {
+                snprintf(session_key, sizeof(session_key), "%s", fld[2]);
+                session_time = t;
+            }
+        } else if (n == 9) {
+            /* key, fetched, valid, lat, lon, call, grid, name, location */
+            time_t t = (time_t)strtoll(fld[1], NULL, 10);
+            char call[32];
+            if (now - t >= QRZ_CACHE_TTL_SEC ||
+                qrz_normalize(fld[0], call, sizeof(call)) != 0)
+                continue;
+            QRZResult r;
+            memset(&r, 0, sizeof(r));
+            r.valid = atoi(fld[2]) != 0;
+            r.lat = strtod(fld[3], NULL);
+            r.lon = strtod(fld[4], NULL);
+            snprintf(r.call, sizeof(r.call), "%s", fld[5]);
+            snprintf(r.grid, sizeof(r.grid), "%s", fld[6]);
+            snprintf(r.name, sizeof(r.name), "%s", fld[7]);
+            snprintf(r.location, sizeof(r.location), "%s", fld[8]);
+            cache_put(call, &r, t);
+        }
+    }
+    fclose(f);
+}
+
+/* Write the cache file if anything changed (worker idle, or shutdown).
+ * The entries are copied out in LRU order first, so lookups never wait
+ * for the disk. */
+static void cache_save(void)
+{
+    char dir[PATH_MAX], path[PATH_MAX + 8], tmp[PATH_MAX + 32];
+    if (cache_dir(dir, sizeof(dir)) != 0) return;
+    snprintf(path, sizeof(path), "%s/qrz", dir);
+    snprintf(tmp, sizeof(tmp), "%s.tmp.%ld", path, (long)getpid());
+
+    /* One writer at a time: the workers share the temporary file */
+    static pthread_mutex_t save_lock = PTHREAD_MUTEX_INITIALIZER;
+    CacheEntry *snap = malloc(sizeof(CacheEntry) * QRZ_CACHE_MAX);
+    if (!snap) return;
+    pthread_mutex_lock(&save_lock);
+    char key[64];
+    time_t key_time;
+    int n = 0;
+    pthread_mutex_lock(&session_lock);
+    memcpy(key, session_key, sizeof(key));
+    key_time = session_time;
+    pthread_mutex_lock(&q.lock);
+    int dirty = q.dirty;
+    q.dirty = 0;
+    if (dirty)
+        for (int i = q.tail; i >= 0; i = q.entries[i].prev)
+            snap[n++] = q.entries[i];
+    pthread_mutex_unlock(&q.lock);
+    pthread_mutex_unlock(&session_lock);
+    if (!dirty) {
+        pthread_mutex_unlock(&save_lock);
+        free(snap);
+        return;
+    }
+
+    int fd = make_dirs(dir) == 0 ? open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0600) : -1;
+    FILE *f = fd >= 0 ? fdopen(fd, "w") : NULL;
+    if (!f) {
+        if (fd >= 0) close(fd);
+        fprintf(stderr, "Warning: cannot write QRZ cache %s\n", tmp);
+        pthread_mutex_unlock(&save_lock);
+        free(snap);
+        return;
+    }
+    fprintf(f, "%s\n", QRZ_CACHE_MAGIC);
+    if (key[0])
+        fprintf(f, "session\t%s\t%s\t%lld\n", qrz_user, key, (long long)key_time);
+    for (int i = 0; i < n; i++) {
+        const CacheEntry *e = &snap[i];
+        fprintf(f, "%s\t%lld\t%d\t%.6f\t%.6f\t%s\t%s\t%s\t%s\n",
+                e->key, (long long)e->fetched, e->res.valid, e->res.lat, e->res.lon,
+                e->res.call, e->res.grid, e->res.name, e->res.location);
+    }
+    free(snap);
+
+    if (fclose(f) != 0 || rename(tmp, path) != 0) {
+        fprintf(stderr, "Warning: cannot write QRZ cache %s\n", path);
+        unlink(tmp);
+    }
+    pthread_mutex_unlock(&save_lock);
+}
+
+int qrz_normalize(const char *callsign, char *out, int out_sz)
+{
+    while (isspace((unsigned char)*callsign)) callsign++;
+    int n = 0;
+    for (; callsign[n] && n < out_sz - 1; n++)
+        out[n] = (char)toupper((unsigned char)callsign[n]);
+    while (n > 0 && isspace((unsigned char)out[n - 1])) n--;
+    out[n] = '\0';
+    return n > 0 ? 0 : -1;
+}
+
+int qrz_cache_get(const char *callsign, QRZResult *result)
+{
+    char call[32];
+    if (qrz_normalize(callsign, call, sizeof(call)) != 0) return 0;
+    pthread_mutex_lock(&q.lock);
+    int i = cache_find(call);
+    int hit = i >= 0 && time(NULL) - q.entries[i].fetched < QRZ_CACHE_TTL_SEC;
+    if (hit) {
+        lru_unlink(i);
+        lru_push_front(i);
+        *result = q.entries[i].res;
+    }
+    pthread_mutex_unlock(&q.lock);
+    return hit;
+}
+
+/* ── Worker ─────────────────────────────────────────────────────── */
+
+/* Append a batch result and wake the main loop (q.lock held) */
+static void batch_push(const char *call, int status, int cached,
+                       const QRZResult *res, const char *err)
+{
+    BatchNode *node = calloc(1, sizeof(*node));
+    if (!node) return;
+    snprintf(node->r.call, sizeof(node->r.call), "%s", call);
+    node->r.status = status;
+    node->r.cached = cached;
+    if (res) node->r.result = *res;
+    snprintf(node->r.err, sizeof(node->r.err), "%s", err ? err : "");
+    if (q.out_tail) q.out_tail->next = node;
+    else q.out_head = node;
+    q.out_tail = node;
+    if (qrz_wake) qrz_wake();
+}
+
+/* Each worker takes the popup request first, then the next batch
+ * callsign, and looks it up on its own curl handle.  A worker that finds
+ * nothing to do persists the cache if it changed. */
+static void *worker(void *arg)
+{
+    (void)arg;
+    CURL *curl = curl_easy_init();
+    pthread_mutex_lock(&q.lock);
+    for (;;) {
+        while (!q.stop && !q.req_pending && q.batch_next >= q.batch_n) {
+            /* Idle: persist what the last lookups added */
+            if (q.dirty) {
+                pthread_mutex_unlock(&q.lock);
+                cache_save();
+                pthread_mutex_lock(&q.lock);
+                continue;
+            }
+            pthread_cond_wait(&q.cond, &q.lock);
+        }
+        if (q.stop) break;
+
+        char call[32];
+        unsigned seq = 0, batch_id = 0;
+        if (q.req_pending) {
+            memcpy(call, q.req_call, sizeof(call));
+            seq = q.seq;
+            q.req_pending = 0;
+        } else {
+            memcpy(call, q.batch[q.batch_next++], sizeof(call));
+            batch_id = q.batch_id;
+        }
+        int offline = q.offline;
+        int dead = batch_id && q.batch_dead;
+        char err[128] = "";
+        if (dead) snprintf(err, sizeof(err), "%s", q.batch_err);
+        pthread_mutex_unlock(&q.lock);
+
+        QRZResult res;
+        int rc = -1;
+        memset(&res, 0, sizeof(res));
+        if (offline)
+            snprintf(err, sizeof(err), "OFFLINE: %s NOT CACHED", call);
+        else if (dead)
+            ;
+        else if (!curl)
+            snprintf(err, sizeof(err), "CURL INIT FAILED");
+        else
+            rc = lookup_net(curl, call, batch_id, &res, err, sizeof(err));
+
+        pthread_mutex_lock(&q.lock);
+        if (rc == 0) {
+            cache_put(call, &res, time(NULL));
+            q.dirty = 1;
+        }
+        if (seq) {
+            /* Dropped if a newer lookup was started meanwhile */
+            if (seq == q.seq) {
+                q.res_seq = seq;
+                q.res_status = rc == 0 ? 1 : -1;
+                q.res = res;
+                memcpy(q.res_err, err, sizeof(q.res_err));
+                if (qrz_wake) qrz_wake();
+            }
+        } else if (batch_id == q.batch_id) {
+            if (rc == 0) q.stats.resolved++;
+            else q.stats.failed++;
+            q.stats.pending--;
+            q.batch_last = now_ms();
+            batch_push(call, rc == 0 ? 1 : -1, 0, &res, err);
+        }
+    }
+    pthread_mutex_unlock(&q.lock);
+    if (curl) curl_easy_cleanup(curl);
+    return NULL;
+}
+
+int qrz_init(const char *username, const char *password)
+{
+    strncpy(qrz_user, username, sizeof(qrz_user) - 1);
+    qrz_user[sizeof(qrz_user) - 1] = '\0';
+    strncpy(qrz_pass, password, sizeof(qrz_pass) - 1);
+    qrz_pass[sizeof(qrz_pass) - 1] = '\0';
+    session_key[0] = '\0';
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    share = curl_share_init();
+    if (share) {
+        curl_share_setopt(share, CURLSHOPT_LOCKFUNC, share_lock_cb);
+        curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, share_unlock_cb);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    }
+
+    pthread_mutex_init(&q.lock, NULL);
+    pthread_cond_init(&q.cond, NULL);
+    q.head = q.tail = -1;
+    for (int i = 0; i < QRZ_CACHE_BUCKETS; i++) q.bucket[i] = -1;
+    cache_load();
+
+    for (int i = 0; i < QRZ_WORKERS; i++) {
+        if (pthread_create(&q.threads[i], NULL, worker, NULL) != 0)
+            break;
+        q.running++;
+    }
+    if (q.running == 0) {
+        fprintf(stderr, "Warning: cannot start the QRZ lookup thread\n");
+        return -1;
+    }
+    return 0;
+}
+
+void qrz_set_offline(int offline)
+{
+    pthread_mutex_lock(&q.lock);
+    q.offline = offline;
+    pthread_mutex_unlock(&q.lock);
+}
+
+void qrz_set_wake(void (*wake)(void))
+{
+    pthread_mutex_lock(&q.lock);
+    qrz_wake = wake;
+    pthread_mutex_unlock(&q.lock);
+}
+
+int qrz_lookup_async(const char *callsign, QRZResult *result)
+{
+    char call[32];
+    if (qrz_normalize(callsign, call, sizeof(call)) != 0) return -1;
+    int hit = qrz_cache_get(call, result);
+
+    /* Either way the lookup still pending, if any, is superseded */
+    pthread_mutex_lock(&q.lock);
+    q.seq++;
+    if (q.seq == 0) q.seq = 1;
+    q.res_seq = 0;
+    q.req_pending = !hit;
+    if (!hit) {
+        memcpy(q.req_call, call, sizeof(call));
+        pthread_cond_signal(&q.cond);
+    }
+    pthread_mutex_unlock(&q.lock);
+    return hit ? 1 : 0;
+}
+
+int qrz_poll(QRZResult *result, char *err_buf, int err_sz)
+{
+    pthread_mutex_lock(&q.lock);
+    int status = 0;
+    if (q.res_seq != 0 && q.res_seq == q.seq) {
+        status = q.res_status;
+        *result = q.res;
+        if (err_buf) snprintf(err_buf, err_sz, "%s", q.res_err);
+        q.res_seq = 0;
+    }
+    pthread_mutex_unlock(&q.lock);
+    return status;
+}
+
+/* ── Batch ────────────────────────────────────────────────────────── */
+
+static void batch_clear_results(void)
+{
+    while (q.out_head) {
+        BatchNode *node = q.out_head;
+        q.out_head = node->next;
+        free(node);
+    }
+    q.out_tail = NULL;
+}
+
+int qrz_batch_submit(const char *const *calls, int n)
+{
+    if (n < 0) return -1;
+    char (*uniq)[32] = malloc(sizeof(*uniq) * (size_t)(n > 0 ? n : 1));
+    char (*miss)[32] = malloc(sizeof(*miss) * (size_t)(n > 0 ? n : 1));
+    QRZResult *hits = malloc(sizeof(*hits) * (size_t)(n > 0 ? n : 1));
+    unsigned char *is_hit = malloc((size_t)(n > 0 ? n : 1));
+    /* Open-addressed set of the callsigns seen so far */
+    int tbl_sz = 16;
+    while (tbl_sz < 2 * n) tbl_sz *= 2;
+    int *tbl = malloc(sizeof(int) * (size_t)tbl_sz);
+    if (!uniq || !miss || !hits || !is_hit || !tbl) {
+        free(uniq); free(miss); free(hits); free(is_hit); free(tbl);
+        return -1;
+    }
+    for (int i = 0; i < tbl_sz; i++) tbl[i] = -1;
+
+    /* Dedupe, then split into cache hits and misses */
+    int nu = 0, nmiss = 0, nhit = 0;
+    for (int i = 0; i < n; i++) {
+        char call[32];
+        if (!calls[i] || qrz_normalize(calls[i], call, sizeof(call)) != 0) continue;
+        unsigned h = 2166136261u;
+        for (const char *c = call; *c; c++)
+            h = (h ^ (unsigned char)*c) * 16777619u;
+        int slot = (int)(h & (unsigned)(tbl_sz - 1));
+        while (tbl[slot] >= 0 && strcmp(uniq[tbl[slot]], call) != 0)
+            slot = (slot + 1) & (tbl_sz - 1);
+        if (tbl[slot] >= 0) continue;
+        tbl[slot] = nu;
+        memcpy(uniq[nu], call, sizeof(call));
+        is_hit[nu] = (unsigned char)qrz_cache_get(call, &hits[nu]);
+        if (is_hit[nu]) nhit++;
+        else memcpy(miss[nmiss++], call, sizeof(call));
+        nu++;
+    }
+    free(tbl);
+
+    pthread_mutex_lock(&q.lock);
+    /* Replace the previous batch: its queued callsigns are dropped and
+     * results still in flight are discarded */
+    free(q.batch);
+    q.batch = miss;
+    q.batch_n = nmiss;
+    q.batch_next = 0;
+    q.batch_id++;
+    if (q.batch_id == 0) q.batch_id = 1;
+    q.batch_renewed = 0;
+    q.batch_dead = 0;
+    batch_clear_results();
+    memset(&q.stats, 0, sizeof(q.stats));
+    q.stats.submitted = n;
+    q.stats.unique = nu;
+    q.stats.cache_hits = nhit;
+    q.stats.pending = nmiss;
+    q.batch_start = q.batch_last = now_ms();
+    for (int i = 0; i < nu; i++)
+        if (is_hit[i])
+            batch_push(uniq[i], 1, 1, &hits[i], NULL);
+    pthread_cond_broadcast(&q.cond);
+    pthread_mutex_unlock(&q.lock);
+
+    free(uniq);
+    free(hits);
+    free(is_hit);
+    return nmiss;
+}
+
+int qrz_batch_take(QRZBatchResult *out)
+{
+    pthread_mutex_lock(&q.lock);
+    BatchNode *node = q.out_head;
+    if (node) {
+        q.out_head = node->next;
+        if (!q.out_head) q.out_tail = NULL;
+        *out = node->r;
+    }
+    pthread_mutex_unlock(&q.lock);
+    free(node);
+    return node != NULL;
+}
+
+void qrz_batch_stats(QRZBatchStats *out)
+{
+    pthread_mutex_lock(&q.lock);
+    *out = q.stats;
+    double end = q.stats.pending > 0 ? now_ms() : q.batch_last;
+    out->elapsed_ms = q.batch_id ? end - q.batch_start : 0.0;
+    int looked_up = q.stats.resolved + q.stats.failed;
+    out->lookups_per_sec = out->elapsed_ms > 0.0 ? looked_up * 1e3 / out->elapsed_ms : 0.0;
+    out->hit_rate = q.stats.unique > 0 ? (double)q.stats.cache_hits / q.stats.unique : 0.0;
+    pthread_mutex_unlock(&q.lock);
+}
+
 void qrz_cleanup(void)
 {
+    if (q.running) {
+        pthread_mutex_lock(&q.lock);
+        q.stop = 1;
+        pthread_cond_broadcast(&q.cond);
+        pthread_mutex_unlock(&q.lock);
+        for (int i = 0; i < q.running; i++)
+            pthread_join(q.threads[i], NULL);
+        q.running = 0;
+    }
+    cache_save();
+    batch_clear_results();
+    free(q.batch);
+    q.batch = NULL;
+    if (share) curl_share_cleanup(share);
+    share = NULL;
+    pthread_mutex_destroy(&q.lock);
+    pthread_cond_destroy(&q.cond);
     curl_global_cleanup();
 }
@@ -2,11 +2,26 @@
  *
  * Authenticates with QRZ.com credentials, then looks up callsigns to retrieve
  * name, location, Maidenhead grid square, and lat/lon coordinates.  Uses
- * libcurl for HTTP; sessions auto-renew on timeout. */
+ * libcurl for HTTP; sessions auto-renew on timeout.
+ *
+ * Lookups run on worker threads so the main loop never waits for the
+ * network.  Results are kept in an LRU cache keyed by normalized callsign
+ * and saved, with the session key, to $XDG_CACHE_HOME/azmap/qrz (default
+ * ~/.cache/azmap/qrz): a repeat lookup within QRZ_CACHE_TTL_SEC is
+ * answered at once, also across runs.
+ *
+ * A batch (a net roster, a cluster burst) is deduplicated against the
+ * cache; the misses are looked up QRZ_WORKERS at a time on one shared
+ * session, and results stream back as they arrive. */
 
 #ifndef QRZ_H
 #define QRZ_H
 
+#define QRZ_CACHE_MAX        1024               /* cached callsigns */
+#define QRZ_CACHE_TTL_SEC    (30L * 86400)      /* a cached result's lifetime */
+#define QRZ_SESSION_TTL_SEC  (20L * 3600)       /* reuse a saved session key */
+#define QRZ_WORKERS          4                  /* lookups on the wire at once */
+
 typedef struct {
     double lat, lon;
     char call[32];       /* normalized callsign */
@@ -16,14 +31,72 @@ typedef struct {
     int  valid;          /* 1 if lat/lon were found */
 } QRZResult;
 
-/* Initialize with credentials. Returns 0 on success. */
+/* One callsign of a batch */
+typedef struct {
+    char      call[32];     /* normalized callsign as submitted */
+    int       status;       /* 1 = found, -1 = failed */
+    int       cached;       /* 1 if answered from the cache */
+    QRZResult result;       /* status 1; valid is 0 without coordinates */
+    char      err[64];      /* status -1 */
+} QRZBatchResult;
+
+/* Progress of the current batch */
+typedef struct {
+    int    submitted;        /* callsigns passed in */
+    int    unique;           /* after normalizing and removing duplicates */
+    int    cache_hits;
+    int    resolved, failed; /* network lookups finished */
+    int    pending;          /* queued or on the wire */
+    double elapsed_ms;       /* from submission to the last result (or now) */
+    double lookups_per_sec;  /* network lookups finished per second */
+    double hit_rate;         /* cache_hits / unique */
+} QRZBatchStats;
+
+/* Initialize with credentials, load the saved cache and start the workers.
+ * Returns 0 on success. */
 int qrz_init(const char *username, const char *password);
 
-/* Lookup a callsign. Blocks during HTTP request.
- * Returns 0 on success, -1 on error. err_buf filled on error. */
-int qrz_lookup(const char *callsign, QRZResult *result, char *err_buf, int err_sz);
+/* 1 = offline: only the cache answers, misses fail.  Call after qrz_init(). */
+void qrz_set_offline(int offline);
+
+/* Call wake (must be thread-safe, e.g. glfwPostEmptyEvent) when a lookup
+ * finishes.  NULL disables it. */
+void qrz_set_wake(void (*wake)(void));
+
+/* Uppercase callsign with surrounding blanks removed into out.  Returns 0,
+ * or -1 if nothing is left. */
+int qrz_normalize(const char *callsign, char *out, int out_sz);
+
+/* Copy a fresh cached result for callsign.  Returns 1 on a hit, 0 on a
+ * miss. */
+int qrz_cache_get(const char *callsign, QRZResult *result);
+
+/* Start looking up callsign.  A cache hit fills result and returns 1;
+ * otherwise the lookup goes to the worker and 0 is returned (-1 if
+ * callsign is empty).  A new lookup supersedes one still pending. */
+int qrz_lookup_async(const char *callsign, QRZResult *result);
+
+/* Result of the latest qrz_lookup_async() that returned 0: 0 while
+ * pending (or if there is none), 1 with result filled, -1 with err_buf
+ * filled.  A result is returned once. */
+int qrz_poll(QRZResult *result, char *err_buf, int err_sz);
+
+/* Start resolving n callsigns.  Duplicates are dropped, cache hits are
+ * queued as results at once and the misses go to the workers, behind a
+ * popup lookup.  The session is renewed at most once for the batch; if
+ * that fails, its remaining callsigns fail too.  A new batch replaces
+ * the previous one (its pending callsigns and results are dropped).
+ * Returns the number of network lookups queued, or -1. */
+int  qrz_batch_submit(const char *const *calls, int n);
+
+/* Take the next result of the current batch in arrival order.  Returns 1
+ * if one was taken, 0 if none is ready. */
+int  qrz_batch_take(QRZBatchResult *out);
+
+/* Copy the current batch's progress, throughput and hit rate. */
+void qrz_batch_stats(QRZBatchStats *out);
 
-/* Free any resources (curl cleanup). */
+/* Stop the workers, save the cache and free resources (curl cleanup). */
 void qrz_cleanup(void);
 
 #endif
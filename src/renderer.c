@@ -1,9 +1,13 @@
 /* renderer.c — OpenGL shader compilation, VAO/VBO management, and draw calls.
  *
  * Uses a single shader program with two uniforms: u_mvp (4x4 matrix) and
- * u_color (RGBA).  Per-vertex alpha (attribute 1) is used by overlays
- * (night/aurora/DRAP) for smooth gradients; non-overlay geometry sets it
- * to 1.0 via glVertexAttrib1f.
+ * u_color (RGBA).  Per-vertex alpha (attribute 1) defaults to 1.0 via
+ * glVertexAttrib1f.  The night, aurora and DRAP overlays have their own
+ * programs that shade the Earth disc per pixel: night.frag from the
+ * subsolar point, heatmap.frag from a lat/lon float texture.  Many-target
+ * spots are drawn instanced from one lat/lon/time buffer: spot.vert places
+ * a marker disc per spot, path.vert interpolates the great circle from
+ * home per spot from gl_VertexID (slerp) and feeds geo.geom.
  *
  * Rendering is split into two coordinate spaces:
  * - km-space: map geometry transformed by the camera MVP matrix
@@ -17,6 +21,16 @@
 #include <math.h>
 #include "renderer.h"
 #include "projection.h"
+#include "profiler.h"
+
+/* Edge length (km) beyond which the geometry shader drops a line piece;
+ * matches SPLIT_THRESHOLD_KM in map_data.c. */
+#define GEO_SPLIT_THRESHOLD_KM 5000.0f
+
+/* Vertices per many-target great-circle path, and segments of a spot
+ * marker disc */
+#define SPOT_PATH_POINTS 65
+#define SPOT_MARKER_SEGS 10
 
 /* ── Shader loading helpers ──────────────────────────────────────── */
 
@@ -58,57 +72,135 @@ static unsigned int compile_shader(const char *src, GLenum type)
     return s;
 }
 
-/* ── Initialization ──────────────────────────────────────────────── */
-
-int renderer_init(Renderer *r, const char *shader_dir)
+/* Compile and link a program from files in shader_dir.  geom may be NULL.
+ * Returns the program handle or 0 on error. */
+static unsigned int build_program(const char *shader_dir, const char *vert,
+                                  const char *geom, const char *frag)
 {
-    memset(r, 0, sizeof(*r));
-
-    char vert_path[512], frag_path[512];
-    snprintf(vert_path, sizeof(vert_path), "%s/map.vert", shader_dir);
-    snprintf(frag_path, sizeof(frag_path), "%s/map.frag", shader_dir);
-
-    char *vert_src = read_file(vert_path);
-    char *frag_src = read_file(frag_path);
-    if (!vert_src || !frag_src) {
-        free(vert_src);
-        free(frag_src);
-        return -1;
-    }
-
-    unsigned int vs = compile_shader(vert_src, GL_VERTEX_SHADER);
-    unsigned int fs = compile_shader(frag_src, GL_FRAGMENT_SHADER);
-    free(vert_src);
-    free(frag_src);
-
-    if (!vs || !fs) {
-        if (vs) glDeleteShader(vs);
-        if (fs) glDeleteShader(fs);
-        return -1;
+    const char *names[3] = { vert, geom, frag };
+    const GLenum types[3] = { GL_VERTEX_SHADER, GL_GEOMETRY_SHADER, GL_FRAGMENT_SHADER };
+    unsigned int shaders[3] = { 0, 0, 0 };
+    int failed = 0;
+
+    for (int i = 0; i < 3 && !failed; i++) {
+        if (!names[i]) continue;
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s", shader_dir, names[i]);
+        char *src = read_file(path);
+        if (!src) { failed = 1; break; }
+        shaders[i] = compile_shader(src, types[i]);
+        free(src);
+        if (!shaders[i]) failed = 1;
+    }
+
+    if (failed) {
+        for (int i = 0; i < 3; i++)
+            if (shaders[i]) glDeleteShader(shaders[i]);
+        return 0;
     }
 
-    r->program = glCreateProgram();
-    glAttachShader(r->program, vs);
-    glAttachShader(r->program, fs);
-    glLinkProgram(r->program);
-
-    glDeleteShader(vs);
-    glDeleteShader(fs);
+    unsigned int prog = glCreateProgram();
+    for (int i = 0; i < 3; i++)
+        if (shaders[i]) glAttachShader(prog, shaders[i]);
+    glLinkProgram(prog);
+    for (int i = 0; i < 3; i++)
+        if (shaders[i]) glDeleteShader(shaders[i]);
 
     int ok;
-    glGetProgramiv(r->program, GL_LINK_STATUS, &ok);
+    glGetProgramiv(prog, GL_LINK_STATUS, &ok);
     if (!ok) {
         char log[512];
-        glGetProgramInfoLog(r->program, sizeof(log), NULL, log);
+        glGetProgramInfoLog(prog, sizeof(log), NULL, log);
         fprintf(stderr, "Program link error: %s\n", log);
-        glDeleteProgram(r->program);
-        r->program = 0;
-        return -1;
+        glDeleteProgram(prog);
+        return 0;
     }
+    return prog;
+}
+
+/* ── Initialization ──────────────────────────────────────────────── */
+
+int renderer_init(Renderer *r, const char *shader_dir)
+{
+    memset(r, 0, sizeof(*r));
+    r->view_cap[2] = 1.0f;
+    r->view_cap[3] = SEG_CAP_ALL;
+
+    r->program = build_program(shader_dir, "map.vert", NULL, "map.frag");
+    if (!r->program)
+        return -1;
 
     r->mvp_loc = glGetUniformLocation(r->program, "u_mvp");
     r->color_loc = glGetUniformLocation(r->program, "u_color");
 
+    /* GPU projection program for static lat/lon line geometry (optional —
+     * callers fall back to CPU reprojection when geo_program is 0). */
+    r->geo_program = build_program(shader_dir, "geo.vert", "geo.geom", "map.frag");
+    if (r->geo_program) {
+        r->geo_mvp_loc    = glGetUniformLocation(r->geo_program, "u_mvp");
+        r->geo_color_loc  = glGetUniformLocation(r->geo_program, "u_color");
+        r->geo_center_loc = glGetUniformLocation(r->geo_program, "u_center");
+        r->geo_mode_loc   = glGetUniformLocation(r->geo_program, "u_mode");
+        r->geo_split_loc  = glGetUniformLocation(r->geo_program, "u_split_km");
+    } else {
+        fprintf(stderr, "Warning: GPU projection shaders unavailable, using CPU reprojection\n");
+    }
+
+    /* Per-pixel day/night shading over the Earth disc */
+    r->night_program = build_program(shader_dir, "disc.vert", NULL, "night.frag");
+    if (r->night_program) {
+        r->night_mvp_loc    = glGetUniformLocation(r->night_program, "u_mvp");
+        r->night_color_loc  = glGetUniformLocation(r->night_program, "u_color");
+        r->night_center_loc = glGetUniformLocation(r->night_program, "u_center");
+        r->night_mode_loc   = glGetUniformLocation(r->night_program, "u_mode");
+        r->night_sun_loc    = glGetUniformLocation(r->night_program, "u_sun");
+    } else {
+        fprintf(stderr, "Warning: night shaders unavailable, day/night overlay disabled\n");
+    }
+
+    /* Aurora / DRAP rasters sampled per pixel over the Earth disc */
+    r->heat_program = build_program(shader_dir, "disc.vert", NULL, "heatmap.frag");
+    if (r->heat_program) {
+        r->heat_mvp_loc       = glGetUniformLocation(r->heat_program, "u_mvp");
+        r->heat_color_loc     = glGetUniformLocation(r->heat_program, "u_color");
+        r->heat_center_loc    = glGetUniformLocation(r->heat_program, "u_center");
+        r->heat_mode_loc      = glGetUniformLocation(r->heat_program, "u_mode");
+        r->heat_grid_loc      = glGetUniformLocation(r->heat_program, "u_grid");
+        r->heat_grid_map_loc  = glGetUniformLocation(r->heat_program, "u_grid_map");
+        r->heat_grid_size_loc = glGetUniformLocation(r->heat_program, "u_grid_size");
+        r->heat_ramp_loc      = glGetUniformLocation(r->heat_program, "u_ramp");
+    } else {
+        fprintf(stderr, "Warning: heatmap shaders unavailable, aurora/DRAP overlays disabled\n");
+    }
+
+    /* Many-target spots: instanced markers and GPU-interpolated paths */
+    r->spot_program = build_program(shader_dir, "spot.vert", NULL, "map.frag");
+    r->path_program = build_program(shader_dir, "path.vert", "geo.geom", "map.frag");
+    if (r->spot_program && r->path_program) {
+        r->spot_mvp_loc     = glGetUniformLocation(r->spot_program, "u_mvp");
+        r->spot_color_loc   = glGetUniformLocation(r->spot_program, "u_color");
+        r->spot_center_loc  = glGetUniformLocation(r->spot_program, "u_center");
+        r->spot_mode_loc    = glGetUniformLocation(r->spot_program, "u_mode");
+        r->spot_size_loc    = glGetUniformLocation(r->spot_program, "u_size_km");
+        r->spot_now_loc     = glGetUniformLocation(r->spot_program, "u_now");
+        r->spot_max_age_loc = glGetUniformLocation(r->spot_program, "u_max_age");
+        r->path_mvp_loc     = glGetUniformLocation(r->path_program, "u_mvp");
+        r->path_color_loc   = glGetUniformLocation(r->path_program, "u_color");
+        r->path_center_loc  = glGetUniformLocation(r->path_program, "u_center");
+        r->path_mode_loc    = glGetUniformLocation(r->path_program, "u_mode");
+        r->path_split_loc   = glGetUniformLocation(r->path_program, "u_split_km");
+        r->path_home_loc    = glGetUniformLocation(r->path_program, "u_home");
+        r->path_points_loc  = glGetUniformLocation(r->path_program, "u_points");
+        r->path_now_loc     = glGetUniformLocation(r->path_program, "u_now");
+        r->path_max_age_loc = glGetUniformLocation(r->path_program, "u_max_age");
+    } else {
+        if (r->spot_program) glDeleteProgram(r->spot_program);
+        if (r->path_program) glDeleteProgram(r->path_program);
+        r->spot_program = r->path_program = 0;
+        fprintf(stderr, "Warning: spot shaders unavailable, many-target spots disabled\n");
+    }
+    r->spot_max_age = 1.0f;
+
     /* GL state */
     glEnable(GL_LINE_SMOOTH);
     glEnable(GL_BLEND);
@@ -123,6 +215,45 @@ int renderer_init(Renderer *r, const char *shader_dir)
  * Each function creates (or reuses) a VAO/VBO pair, uploads vertex data
  * with GL_DYNAMIC_DRAW, and copies segment metadata into the Renderer. */
 
+/* Point a renderer slot at src's segment table (taking a reference) and
+ * release whatever it held before.  src may be NULL to clear the slot. */
+static void share_segs(SegTable **slot, SegTable *src)
+{
+    segtable_ref(src);
+    segtable_unref(*slot);
+    *slot = src;
+}
+
+/* Draw every segment of t as a line strip in its own color (r->program,
+ * VAO bound by the caller). */
+static void draw_colored_strips(const Renderer *r, const SegTable *t)
+{
+    for (int i = 0; i < t->num; i++) {
+        glUniform4fv(r->color_loc, 1, t->colors[i]);
+        glDrawArrays(GL_LINE_STRIP, t->starts[i], t->counts[i]);
+    }
+}
+
+/* 1 if segment i of t may be visible (no caps = always). */
+static int seg_in_view(const SegTable *t, int i, const float *view_cap)
+{
+    return !t->caps || projection_caps_overlap(t->caps[i], view_cap);
+}
+
+/* Draw each segment of t as a GL_LINE_STRIP from the bound VAO, skipping
+ * segments whose bounding cap lies outside the view. */
+static void draw_line_strips(const SegTable *t, const float *view_cap)
+{
+    for (int i = 0; t && i < t->num; i++)
+        if (seg_in_view(t, i, view_cap))
+            glDrawArrays(GL_LINE_STRIP, t->starts[i], t->counts[i]);
+}
+
+void renderer_set_view_cap(Renderer *r, const float *cap)
+{
+    memcpy(r->view_cap, cap, sizeof(r->view_cap));
+}
+
 void renderer_upload_map(Renderer *r, const MapData *md)
 {
     if (!r->map_vao) {
@@ -137,11 +268,8 @@ void renderer_upload_map(Renderer *r, const MapData *md)
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, NULL);
     glBindVertexArray(0);
 
-    r->map_num_segments = md->num_segments;
-    for (int i = 0; i < md->num_segments; i++) {
-        r->map_segment_starts[i] = md->segment_starts[i];
-        r->map_segment_counts[i] = md->segment_counts[i];
-    }
+    share_segs(&r->map_segs, md->segs);
+    r->map_geo = 0;
 }
 
 void renderer_upload_borders(Renderer *r, const MapData *md)
@@ -158,11 +286,48 @@ void renderer_upload_borders(Renderer *r, const MapData *md)
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, NULL);
     glBindVertexArray(0);
 
-    r->border_num_segments = md->num_segments;
-    for (int i = 0; i < md->num_segments; i++) {
-        r->border_segment_starts[i] = md->segment_starts[i];
-        r->border_segment_counts[i] = md->segment_counts[i];
-    }
+    share_segs(&r->border_segs, md->segs);
+    r->border_geo = 0;
+}
+
+/* Upload raw lat/lon of md as a static (lat, lon) float VBO for the GPU
+ * projection program.  The segment table is the raw (unsplit) one; the
+ * geometry shader drops edges that the CPU path would split. */
+static void upload_geo_lines(unsigned int *vao, unsigned int *vbo,
+                             const MapData *md, SegTable **segs)
+{
+    float *geo = malloc((size_t)md->raw_count * 2 * sizeof(float));
+    if (!geo) return;
+    for (int i = 0; i < md->raw_count; i++) {
+        geo[i * 2]     = (float)md->raw_lats[i];
+        geo[i * 2 + 1] = (float)md->raw_lons[i];
+    }
+    if (!*vao) {
+        glGenVertexArrays(1, vao);
+        glGenBuffers(1, vbo);
+    }
+    glBindVertexArray(*vao);
+    glBindBuffer(GL_ARRAY_BUFFER, *vbo);
+    glBufferData(GL_ARRAY_BUFFER, md->raw_count * 2 * sizeof(float),
+                 geo, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, NULL);
+    glBindVertexArray(0);
+    free(geo);
+
+    share_segs(segs, md->raw_segs);
+}
+
+void renderer_upload_map_geo(Renderer *r, const MapData *md)
+{
+    upload_geo_lines(&r->map_vao, &r->map_vbo, md, &r->map_segs);
+    r->map_geo = 1;
+}
+
+void renderer_upload_borders_geo(Renderer *r, const MapData *md)
+{
+    upload_geo_lines(&r->border_vao, &r->border_vbo, md, &r->border_segs);
+    r->border_geo = 1;
 }
 
 void renderer_upload_land(Renderer *r, const MapData *md)
@@ -179,12 +344,7 @@ void renderer_upload_land(Renderer *r, const MapData *md)
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, NULL);
     glBindVertexArray(0);
 
-    r->land_num_segments = md->num_segments;
-    for (int i = 0; i < md->num_segments; i++) {
-        r->land_segment_starts[i] = md->segment_starts[i];
-        r->land_segment_counts[i] = md->segment_counts[i];
-        r->land_segment_clamped[i] = md->segment_clamped[i];
-    }
+    share_segs(&r->land_segs, md->segs);
 }
 
 void renderer_upload_target_line(Renderer *r, const float *verts, int vertex_count)
@@ -254,6 +414,56 @@ void renderer_upload_markers(Renderer *r, float cx, float cy, float tx, float ty
     #undef MARKER_SEGS
 }
 
+void renderer_upload_spots(Renderer *r, const SpotInstance *inst, int count)
+{
+    if (!r->spot_program) return;
+    if (!r->spot_vao) {
+        /* Unit disc as a triangle fan: center, ring, closing vertex */
+        float corners[(SPOT_MARKER_SEGS + 2) * 2] = { 0.0f, 0.0f };
+        for (int i = 0; i <= SPOT_MARKER_SEGS; i++) {
+            float a = 2.0f * (float)M_PI * i / SPOT_MARKER_SEGS;
+            corners[(i + 1) * 2]     = cosf(a);
+            corners[(i + 1) * 2 + 1] = sinf(a);
+        }
+        glGenVertexArrays(1, &r->spot_vao);
+        glGenVertexArrays(1, &r->path_vao);
+        glGenBuffers(1, &r->spot_corner_vbo);
+        glGenBuffers(1, &r->spot_inst_vbo);
+
+        glBindVertexArray(r->spot_vao);
+        glBindBuffer(GL_ARRAY_BUFFER, r->spot_corner_vbo);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, NULL);
+        glBindBuffer(GL_ARRAY_BUFFER, r->spot_inst_vbo);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(SpotInstance), NULL);
+        glVertexAttribDivisor(1, 1);
+
+        /* Paths take their vertex position from gl_VertexID */
+        glBindVertexArray(r->path_vao);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(SpotInstance), NULL);
+        glVertexAttribDivisor(1, 1);
+        glBindVertexArray(0);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, r->spot_inst_vbo);
+    glBufferData(GL_ARRAY_BUFFER, (size_t)count * sizeof(SpotInstance), inst, GL_DYNAMIC_DRAW);
+    r->spot_count = count;
+}
+
+void renderer_set_spot_view(Renderer *r, double home_lat, double home_lon,
+                            float size_km, float now, float max_age)
+{
+    double lat = home_lat * M_PI / 180.0, lon = home_lon * M_PI / 180.0;
+    r->spot_home[0] = (float)(cos(lat) * cos(lon));
+    r->spot_home[1] = (float)(cos(lat) * sin(lon));
+    r->spot_home[2] = (float)sin(lat);
+    r->spot_size_km = size_km;
+    r->spot_now = now;
+    r->spot_max_age = max_age > 0.0f ? max_age : 1.0f;
+}
+
 void renderer_upload_npole(Renderer *r, float px, float py, float size_km)
 {
     float s = size_km;
@@ -338,11 +548,7 @@ void renderer_upload_grid(Renderer *r, const MapData *md)
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, NULL);
     glBindVertexArray(0);
 
-    r->grid_num_segments = md->num_segments;
-    for (int i = 0; i < md->num_segments; i++) {
-        r->grid_segment_starts[i] = md->segment_starts[i];
-        r->grid_segment_counts[i] = md->segment_counts[i];
-    }
+    share_segs(&r->grid_segs, md->segs);
 }
 
 void renderer_upload_dist_circles(Renderer *r, const MapData *md)
@@ -359,11 +565,7 @@ void renderer_upload_dist_circles(Renderer *r, const MapData *md)
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, NULL);
     glBindVertexArray(0);
 
-    r->dist_num_segments = md->num_segments;
-    for (int i = 0; i < md->num_segments; i++) {
-        r->dist_segment_starts[i] = md->segment_starts[i];
-        r->dist_segment_counts[i] = md->segment_counts[i];
-    }
+    share_segs(&r->dist_segs, md->segs);
 }
 
 void renderer_upload_dist_labels(Renderer *r, float *verts, int vertex_count)
@@ -382,111 +584,121 @@ void renderer_upload_dist_labels(Renderer *r, float *verts, int vertex_count)
     r->dist_label_vertex_count = vertex_count;
 }
 
-void renderer_upload_night(Renderer *r, const float *vertices, int vertex_count)
+void renderer_set_sun(Renderer *r, double lat_deg, double lon_deg)
 {
-    if (!r->night_vao) {
-        glGenVertexArrays(1, &r->night_vao);
-        glGenBuffers(1, &r->night_vbo);
-    }
-    glBindVertexArray(r->night_vao);
-    glBindBuffer(GL_ARRAY_BUFFER, r->night_vbo);
-    glBufferData(GL_ARRAY_BUFFER, vertex_count * 3 * sizeof(float),
-                 vertices, GL_DYNAMIC_DRAW);
-    /* attribute 0: position (x, y) */
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
-    /* attribute 1: alpha */
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, 3 * sizeof(float),
-                          (void *)(2 * sizeof(float)));
-    glBindVertexArray(0);
-    r->night_vertex_count = vertex_count;
+    double lat = lat_deg * M_PI / 180.0;
+    double lon = lon_deg * M_PI / 180.0;
+    r->sun_dir[0] = (float)(cos(lat) * cos(lon));
+    r->sun_dir[1] = (float)(cos(lat) * sin(lon));
+    r->sun_dir[2] = (float)sin(lat);
+    r->sun_valid = 1;
 }
 
-void renderer_upload_aurora(Renderer *r, const AuroraMesh *m)
+/* Upload h as an R32F texture: bilinear, longitude wraps, latitude clamps. */
+static void upload_heat(RenderHeat *rh, const HeatGrid *h)
 {
-    if (!r->aurora_vao) {
-        glGenVertexArrays(1, &r->aurora_vao);
-        glGenBuffers(1, &r->aurora_vbo);
-    }
-    glBindVertexArray(r->aurora_vao);
-    glBindBuffer(GL_ARRAY_BUFFER, r->aurora_vbo);
-    glBufferData(GL_ARRAY_BUFFER, m->vertex_count * 3 * sizeof(float),
-                 m->vertices, GL_DYNAMIC_DRAW);
-    /* attribute 0: position (x, y) */
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
-    /* attribute 1: alpha */
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, 3 * sizeof(float),
-                          (void *)(2 * sizeof(float)));
-    glBindVertexArray(0);
-    r->aurora_vertex_count = m->vertex_count;
+    if (!h->texels) return;
+    if (!rh->tex) {
+        glGenTextures(1, &rh->tex);
+        glBindTexture(GL_TEXTURE_2D, rh->tex);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    } else {
+        glBindTexture(GL_TEXTURE_2D, rh->tex);
+    }
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, h->width, h->height, 0,
+                 GL_RED, GL_FLOAT, h->texels);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    rh->grid_map[0] = h->lon0;
+    rh->grid_map[1] = h->dlon;
+    rh->grid_map[2] = h->lat0;
+    rh->grid_map[3] = h->dlat;
+    rh->grid_size[0] = (float)h->width;
+    rh->grid_size[1] = (float)h->height;
+    memcpy(rh->ramp, h->ramp, sizeof(rh->ramp));
+    rh->visible = 1;
 }
 
-void renderer_upload_drap(Renderer *r, const AuroraMesh *m)
+void renderer_upload_aurora(Renderer *r, const HeatGrid *h)
 {
-    if (!r->drap_vao) {
-        glGenVertexArrays(1, &r->drap_vao);
-        glGenBuffers(1, &r->drap_vbo);
-    }
-    glBindVertexArray(r->drap_vao);
-    glBindBuffer(GL_ARRAY_BUFFER, r->drap_vbo);
-    glBufferData(GL_ARRAY_BUFFER, m->vertex_count * 3 * sizeof(float),
-                 m->vertices, GL_DYNAMIC_DRAW);
-    /* attribute 0: position (x, y) */
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
-    /* attribute 1: alpha */
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, 3 * sizeof(float),
-                          (void *)(2 * sizeof(float)));
-    glBindVertexArray(0);
-    r->drap_vertex_count = m->vertex_count;
+    upload_heat(&r->aurora, h);
 }
 
-void renderer_upload_muf(Renderer *r, const MufData *m)
+void renderer_upload_drap(Renderer *r, const HeatGrid *h)
+{
+    upload_heat(&r->drap, h);
+}
+
+void renderer_clear_aurora(Renderer *r)
+{
+    r->aurora.visible = 0;
+}
+
+void renderer_clear_drap(Renderer *r)
 {
-    if (!r->muf_vao) {
-        glGenVertexArrays(1, &r->muf_vao);
-        glGenBuffers(1, &r->muf_vbo);
+    r->drap.visible = 0;
+}
+
+/* Upload km-space polylines with per-segment color into a line layer. */
+static void upload_lines(unsigned int *vao, unsigned int *vbo, SegTable **segs,
+                         const MufData *m)
+{
+    if (!*vao) {
+        glGenVertexArrays(1, vao);
+        glGenBuffers(1, vbo);
     }
-    glBindVertexArray(r->muf_vao);
-    glBindBuffer(GL_ARRAY_BUFFER, r->muf_vbo);
+    glBindVertexArray(*vao);
+    glBindBuffer(GL_ARRAY_BUFFER, *vbo);
     glBufferData(GL_ARRAY_BUFFER, m->vertex_count * 2 * sizeof(float),
                  m->vertices, GL_DYNAMIC_DRAW);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, NULL);
     glBindVertexArray(0);
 
-    r->muf_num_segments = m->num_segments;
-    for (int i = 0; i < m->num_segments; i++) {
-        r->muf_segment_starts[i] = m->segment_starts[i];
-        r->muf_segment_counts[i] = m->segment_counts[i];
-        memcpy(r->muf_segment_colors[i], m->segment_colors[i], 4 * sizeof(float));
-    }
+    share_segs(segs, m->segs);
+}
+
+void renderer_upload_muf(Renderer *r, const MufData *m)
+{
+    upload_lines(&r->muf_vao, &r->muf_vbo, &r->muf_segs, m);
 }
 
 void renderer_upload_spore(Renderer *r, const MufData *m)
 {
-    if (!r->spore_vao) {
-        glGenVertexArrays(1, &r->spore_vao);
-        glGenBuffers(1, &r->spore_vbo);
-    }
-    glBindVertexArray(r->spore_vao);
-    glBindBuffer(GL_ARRAY_BUFFER, r->spore_vbo);
-    glBufferData(GL_ARRAY_BUFFER, m->vertex_count * 2 * sizeof(float),
-                 m->vertices, GL_DYNAMIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, NULL);
-    glBindVertexArray(0);
+    upload_lines(&r->spore_vao, &r->spore_vbo, &r->spore_segs, m);
+}
 
-    r->spore_num_segments = m->num_segments;
-    for (int i = 0; i < m->num_segments; i++) {
-        r->spore_segment_starts[i] = m->segment_starts[i];
-        r->spore_segment_counts[i] = m->segment_counts[i];
-        memcpy(r->spore_segment_colors[i], m->segment_colors[i], 4 * sizeof(float));
-    }
+void renderer_upload_aurora_lines(Renderer *r, const MufData *m)
+{
+    upload_lines(&r->aurora_lines_vao, &r->aurora_lines_vbo, &r->aurora_lines_segs, m);
+}
+
+void renderer_upload_drap_lines(Renderer *r, const MufData *m)
+{
+    upload_lines(&r->drap_lines_vao, &r->drap_lines_vbo, &r->drap_lines_segs, m);
+}
+
+void renderer_clear_muf(Renderer *r)
+{
+    share_segs(&r->muf_segs, NULL);
+}
+
+void renderer_clear_spore(Renderer *r)
+{
+    share_segs(&r->spore_segs, NULL);
+}
+
+void renderer_clear_aurora_lines(Renderer *r)
+{
+    share_segs(&r->aurora_lines_segs, NULL);
+}
+
+void renderer_clear_drap_lines(Renderer *r)
+{
+    share_segs(&r->drap_lines_segs, NULL);
 }
 
 void renderer_upload_labels(Renderer *r, float *verts, int vertex_count, int split)
@@ -679,6 +891,35 @@ void renderer_upload_text(Renderer *r, float *verts, int vertex_count)
  * Drawing order: disc → land fill → boundary → grid → dist circles →
  * night → aurora → DRAP → borders → coastlines → MUF → Es → target line →
  * markers → labels → HUD text. */
+
+/* One disc pass of the heatmap program over a layer's texture; restores
+ * the main program afterwards. */
+static void draw_heat(const Renderer *r, const RenderHeat *rh, const float *mvp,
+                      float red, float green, float blue)
+{
+    if (!r->heat_program || !r->disc_vao || !rh->tex) return;
+    double clat, clon;
+    projection_get_center(&clat, &clon);
+    glUseProgram(r->heat_program);
+    glUniformMatrix4fv(r->heat_mvp_loc, 1, GL_FALSE, mvp);
+    glUniform4f(r->heat_color_loc, red, green, blue, 1.0f);
+    glUniform3f(r->heat_center_loc,
+                (float)sin(clat * M_PI / 180.0),
+                (float)cos(clat * M_PI / 180.0),
+                (float)(clon * M_PI / 180.0));
+    glUniform1i(r->heat_mode_loc, projection_get_mode() == PROJ_ORTHO);
+    glUniform4fv(r->heat_grid_map_loc, 1, rh->grid_map);
+    glUniform2fv(r->heat_grid_size_loc, 1, rh->grid_size);
+    glUniform2fv(r->heat_ramp_loc, HEAT_RAMP_STOPS, &rh->ramp[0][0]);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, rh->tex);
+    glUniform1i(r->heat_grid_loc, 0);
+    glBindVertexArray(r->disc_vao);
+    glDrawArrays(GL_TRIANGLE_FAN, 0, r->disc_vertex_count);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glUseProgram(r->program);
+}
+
 void renderer_draw(const Renderer *r, const float *mvp, int fb_w, int fb_h)
 {
     glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
@@ -688,17 +929,20 @@ void renderer_draw(const Renderer *r, const float *mvp, int fb_w, int fb_h)
     /* Default vertex alpha = 1.0 for all geometry without per-vertex alpha */
     glVertexAttrib1f(1, 1.0f);
 
+    profiler_gpu_begin(PROF_GPU_DISC);
     /* Earth filled disc - slightly lighter base for day/night contrast */
     if (r->disc_vao) {
         glUniform4f(r->color_loc, 0.12f, 0.12f, 0.25f, 1.0f);
         glBindVertexArray(r->disc_vao);
         glDrawArrays(GL_TRIANGLE_FAN, 0, r->disc_vertex_count);
     }
+    profiler_gpu_end(PROF_GPU_DISC);
 
     /* Land fill via stencil buffer (odd-even rule, clipped to disc).
      * Uses stencil bit 7 to mask the disc area so back-hemisphere
      * vertices (projected to 1e6) don't corrupt the stencil. */
-    if (r->land_vao && r->land_num_segments > 0 && r->disc_vao) {
+    if (r->land_vao && r->land_segs && r->land_segs->num > 0 && r->disc_vao) {
+        profiler_gpu_begin(PROF_GPU_LAND);
         glEnable(GL_STENCIL_TEST);
         glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
 
@@ -716,11 +960,10 @@ void renderer_draw(const Renderer *r, const float *mvp, int fb_w, int fb_h)
         glStencilFunc(GL_EQUAL, 0x80, 0x80);
         glStencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
         glBindVertexArray(r->land_vao);
-        for (int i = 0; i < r->land_num_segments; i++) {
-            if (r->land_segment_clamped[i]) continue;
-            glDrawArrays(GL_TRIANGLE_FAN,
-                         r->land_segment_starts[i],
-                         r->land_segment_counts[i]);
+        const SegTable *land = r->land_segs;
+        for (int i = 0; land && i < land->num; i++) {
+            if (land->clamped[i] || !seg_in_view(land, i, r->view_cap)) continue;
+            glDrawArrays(GL_TRIANGLE_FAN, land->starts[i], land->counts[i]);
         }
 
         /* Step 3: draw land color where disc+land bits are set (stencil > 0x80) */
@@ -734,8 +977,10 @@ void renderer_draw(const Renderer *r, const float *mvp, int fb_w, int fb_h)
 
         glStencilMask(0xFF);
         glDisable(GL_STENCIL_TEST);
+        profiler_gpu_end(PROF_GPU_LAND);
     }
 
+    profiler_gpu_begin(PROF_GPU_GRID);
     /* Earth boundary circle - dark blue */
     if (r->circle_vao) {
         glUniform4f(r->color_loc, 0.15f, 0.15f, 0.3f, 1.0f);
@@ -747,99 +992,180 @@ void renderer_draw(const Renderer *r, const float *mvp, int fb_w, int fb_h)
     if (r->grid_vao) {
         glUniform4f(r->color_loc, 0.2f, 0.2f, 0.3f, 1.0f);
         glBindVertexArray(r->grid_vao);
-        for (int i = 0; i < r->grid_num_segments; i++) {
-            glDrawArrays(GL_LINE_STRIP,
-                         r->grid_segment_starts[i],
-                         r->grid_segment_counts[i]);
-        }
+        draw_line_strips(r->grid_segs, r->view_cap);
     }
 
     /* Distance circles from center — slightly brighter than grid */
-    if (r->dist_vao && r->dist_num_segments > 0) {
+    if (r->dist_vao && r->dist_segs && r->dist_segs->num > 0) {
         glUniform4f(r->color_loc, 0.3f, 0.3f, 0.45f, 1.0f);
         glBindVertexArray(r->dist_vao);
-        for (int i = 0; i < r->dist_num_segments; i++) {
-            glDrawArrays(GL_LINE_STRIP,
-                         r->dist_segment_starts[i],
-                         r->dist_segment_counts[i]);
-        }
+        draw_line_strips(r->dist_segs, r->view_cap);
+    }
+    profiler_gpu_end(PROF_GPU_GRID);
+
+    /* Night overlay - one disc pass, zenith angle and twilight gradient
+     * computed per pixel from the center/mode/sun uniforms */
+    if (r->night_program && r->sun_valid && r->disc_vao) {
+        profiler_gpu_begin(PROF_GPU_NIGHT);
+        double clat, clon;
+        projection_get_center(&clat, &clon);
+        glUseProgram(r->night_program);
+        glUniformMatrix4fv(r->night_mvp_loc, 1, GL_FALSE, mvp);
+        glUniform4f(r->night_color_loc, 0.0f, 0.0f, 0.05f, 1.0f);
+        glUniform3f(r->night_center_loc,
+                    (float)sin(clat * M_PI / 180.0),
+                    (float)cos(clat * M_PI / 180.0),
+                    (float)(clon * M_PI / 180.0));
+        glUniform1i(r->night_mode_loc, projection_get_mode() == PROJ_ORTHO);
+        glUniform3fv(r->night_sun_loc, 1, r->sun_dir);
+        glBindVertexArray(r->disc_vao);
+        glDrawArrays(GL_TRIANGLE_FAN, 0, r->disc_vertex_count);
+        glUseProgram(r->program);
+        profiler_gpu_end(PROF_GPU_NIGHT);
     }
 
-    /* Night overlay - smooth gradient via per-vertex alpha */
-    if (r->night_vao && r->night_vertex_count > 0) {
-        glUniform4f(r->color_loc, 0.0f, 0.0f, 0.05f, 1.0f);
-        glBindVertexArray(r->night_vao);
-        glDrawArrays(GL_TRIANGLES, 0, r->night_vertex_count);
+    /* Aurora overlay — green heatmap */
+    if (r->aurora.visible) {
+        profiler_gpu_begin(PROF_GPU_AURORA);
+        draw_heat(r, &r->aurora, mvp, 0.0f, 0.8f, 0.2f);
+        profiler_gpu_end(PROF_GPU_AURORA);
     }
 
-    /* Aurora overlay — green heatmap with per-vertex alpha */
-    if (r->aurora_vao && r->aurora_vertex_count > 0) {
-        glUniform4f(r->color_loc, 0.0f, 0.8f, 0.2f, 1.0f);
-        glBindVertexArray(r->aurora_vao);
-        glDrawArrays(GL_TRIANGLES, 0, r->aurora_vertex_count);
+    /* DRAP absorption overlay — red-orange heatmap */
+    if (r->drap.visible) {
+        profiler_gpu_begin(PROF_GPU_DRAP);
+        draw_heat(r, &r->drap, mvp, 0.85f, 0.2f, 0.05f);
+        profiler_gpu_end(PROF_GPU_DRAP);
     }
 
-    /* DRAP absorption overlay — red-orange heatmap with per-vertex alpha */
-    if (r->drap_vao && r->drap_vertex_count > 0) {
-        glUniform4f(r->color_loc, 0.85f, 0.2f, 0.05f, 1.0f);
-        glBindVertexArray(r->drap_vao);
-        glDrawArrays(GL_TRIANGLES, 0, r->drap_vertex_count);
+    /* Borders and coastlines uploaded as raw lat/lon are projected on the
+     * GPU: only the center/mode uniforms change when the center moves. */
+    if (r->geo_program && (r->border_geo || r->map_geo)) {
+        double clat, clon;
+        projection_get_center(&clat, &clon);
+        glUseProgram(r->geo_program);
+        glUniformMatrix4fv(r->geo_mvp_loc, 1, GL_FALSE, mvp);
+        glUniform3f(r->geo_center_loc,
+                    (float)sin(clat * M_PI / 180.0),
+                    (float)cos(clat * M_PI / 180.0),
+                    (float)(clon * M_PI / 180.0));
+        glUniform1i(r->geo_mode_loc, projection_get_mode() == PROJ_ORTHO ? 1 : 0);
+        glUniform1f(r->geo_split_loc, GEO_SPLIT_THRESHOLD_KM);
     }
 
     /* Country borders - dim gray */
     if (r->border_vao) {
-        glUniform4f(r->color_loc, 0.4f, 0.4f, 0.5f, 1.0f);
+        profiler_gpu_begin(PROF_GPU_BORDERS);
+        int loc = r->border_geo ? r->geo_color_loc : r->color_loc;
+        glUseProgram(r->border_geo ? r->geo_program : r->program);
+        glUniform4f(loc, 0.4f, 0.4f, 0.5f, 1.0f);
         glBindVertexArray(r->border_vao);
-        for (int i = 0; i < r->border_num_segments; i++) {
-            glDrawArrays(GL_LINE_STRIP,
-                         r->border_segment_starts[i],
-                         r->border_segment_counts[i]);
-        }
+        draw_line_strips(r->border_segs, r->view_cap);
+        profiler_gpu_end(PROF_GPU_BORDERS);
     }
 
     /* Coastlines - dark gray */
     if (r->map_vao) {
-        glUniform4f(r->color_loc, 0.35f, 0.35f, 0.35f, 1.0f);
+        profiler_gpu_begin(PROF_GPU_COAST);
+        int loc = r->map_geo ? r->geo_color_loc : r->color_loc;
+        glUseProgram(r->map_geo ? r->geo_program : r->program);
+        glUniform4f(loc, 0.35f, 0.35f, 0.35f, 1.0f);
         glBindVertexArray(r->map_vao);
-        for (int i = 0; i < r->map_num_segments; i++) {
-            glDrawArrays(GL_LINE_STRIP,
-                         r->map_segment_starts[i],
-                         r->map_segment_counts[i]);
-        }
+        draw_line_strips(r->map_segs, r->view_cap);
+        profiler_gpu_end(PROF_GPU_COAST);
     }
+    glUseProgram(r->program);
 
     /* MUF contour lines — per-segment color */
-    if (r->muf_vao && r->muf_num_segments > 0) {
+    if (r->muf_vao && r->muf_segs && r->muf_segs->num > 0) {
+        profiler_gpu_begin(PROF_GPU_MUF);
         glVertexAttrib1f(1, 1.0f);
         glBindVertexArray(r->muf_vao);
-        for (int i = 0; i < r->muf_num_segments; i++) {
-            glUniform4fv(r->color_loc, 1, r->muf_segment_colors[i]);
-            glDrawArrays(GL_LINE_STRIP, r->muf_segment_starts[i],
-                         r->muf_segment_counts[i]);
+        draw_colored_strips(r, r->muf_segs);
+        profiler_gpu_end(PROF_GPU_MUF);
+    }
+
+    /* Aurora / DRAP isolines — per-level color */
+    if ((r->aurora_lines_segs && r->aurora_lines_segs->num > 0) ||
+        (r->drap_lines_segs && r->drap_lines_segs->num > 0)) {
+        profiler_gpu_begin(PROF_GPU_ISOLINES);
+        glVertexAttrib1f(1, 1.0f);
+        if (r->aurora_lines_segs) {
+            glBindVertexArray(r->aurora_lines_vao);
+            draw_colored_strips(r, r->aurora_lines_segs);
+        }
+        if (r->drap_lines_segs) {
+            glBindVertexArray(r->drap_lines_vao);
+            draw_colored_strips(r, r->drap_lines_segs);
         }
+        profiler_gpu_end(PROF_GPU_ISOLINES);
     }
 
     /* Sporadic E contour lines — thicker, semi-transparent (diffused look) */
-    if (r->spore_vao && r->spore_num_segments > 0) {
+    if (r->spore_vao && r->spore_segs && r->spore_segs->num > 0) {
+        profiler_gpu_begin(PROF_GPU_SPORE);
+        const SegTable *spore = r->spore_segs;
         glVertexAttrib1f(1, 1.0f);
         glBindVertexArray(r->spore_vao);
         /* Draw a wide translucent glow, then a bright core */
         for (int pass = 0; pass < 2; pass++) {
             glLineWidth(pass == 0 ? 6.0f : 2.0f);
             float alpha = pass == 0 ? 0.35f : 1.0f;
-            for (int i = 0; i < r->spore_num_segments; i++) {
-                float c[4] = { r->spore_segment_colors[i][0],
-                                r->spore_segment_colors[i][1],
-                                r->spore_segment_colors[i][2],
+            for (int i = 0; i < spore->num; i++) {
+                float c[4] = { spore->colors[i][0],
+                                spore->colors[i][1],
+                                spore->colors[i][2],
                                 alpha };
                 glUniform4fv(r->color_loc, 1, c);
-                glDrawArrays(GL_LINE_STRIP, r->spore_segment_starts[i],
-                             r->spore_segment_counts[i]);
+                glDrawArrays(GL_LINE_STRIP, spore->starts[i], spore->counts[i]);
             }
         }
         glLineWidth(1.5f); /* restore default */
+        profiler_gpu_end(PROF_GPU_SPORE);
+    }
+
+    /* Many-target spots: all paths in one instanced draw (projected,
+     * interpolated and faded on the GPU), then all markers in another */
+    if (r->spot_program && r->spot_count > 0) {
+        profiler_gpu_begin(PROF_GPU_SPOTS);
+        double clat, clon;
+        projection_get_center(&clat, &clon);
+        float center[3] = { (float)sin(clat * M_PI / 180.0),
+                            (float)cos(clat * M_PI / 180.0),
+                            (float)(clon * M_PI / 180.0) };
+        int ortho = projection_get_mode() == PROJ_ORTHO;
+
+        glUseProgram(r->path_program);
+        glUniformMatrix4fv(r->path_mvp_loc, 1, GL_FALSE, mvp);
+        glUniform4f(r->path_color_loc, 0.3f, 0.8f, 1.0f, 0.45f);
+        glUniform3fv(r->path_center_loc, 1, center);
+        glUniform1i(r->path_mode_loc, ortho);
+        glUniform1f(r->path_split_loc, GEO_SPLIT_THRESHOLD_KM);
+        glUniform3fv(r->path_home_loc, 1, r->spot_home);
+        glUniform1i(r->path_points_loc, SPOT_PATH_POINTS);
+        glUniform1f(r->path_now_loc, r->spot_now);
+        glUniform1f(r->path_max_age_loc, r->spot_max_age);
+        glLineWidth(1.0f);
+        glBindVertexArray(r->path_vao);
+        glDrawArraysInstanced(GL_LINE_STRIP, 0, SPOT_PATH_POINTS, r->spot_count);
+        glLineWidth(1.5f); /* restore default */
+
+        glUseProgram(r->spot_program);
+        glUniformMatrix4fv(r->spot_mvp_loc, 1, GL_FALSE, mvp);
+        glUniform4f(r->spot_color_loc, 1.0f, 0.55f, 0.1f, 0.9f);
+        glUniform3fv(r->spot_center_loc, 1, center);
+        glUniform1i(r->spot_mode_loc, ortho);
+        glUniform1f(r->spot_size_loc, r->spot_size_km);
+        glUniform1f(r->spot_now_loc, r->spot_now);
+        glUniform1f(r->spot_max_age_loc, r->spot_max_age);
+        glBindVertexArray(r->spot_vao);
+        glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, SPOT_MARKER_SEGS + 2, r->spot_count);
+
+        glUseProgram(r->program);
+        profiler_gpu_end(PROF_GPU_SPOTS);
     }
 
+    profiler_gpu_begin(PROF_GPU_MARKERS);
     /* Target line - yellow (great circle path) */
     if (r->line_vao && r->line_vertex_count > 1) {
         glUniform4f(r->color_loc, 1.0f, 0.9f, 0.2f, 1.0f);
@@ -867,9 +1193,11 @@ void renderer_draw(const Renderer *r, const float *mvp, int fb_w, int fb_h)
         glBindVertexArray(r->npole_vao);
         glDrawArrays(GL_TRIANGLES, 0, 3);
     }
+    profiler_gpu_end(PROF_GPU_MARKERS);
 
     /* Pixel-space overlays — switch to pixel-space orthographic matrix */
     if (fb_w > 0 && fb_h > 0) {
+        profiler_gpu_begin(PROF_GPU_TEXT);
         float ortho[16];
         memset(ortho, 0, sizeof(ortho));
         ortho[0]  = 2.0f / (float)fb_w;
@@ -921,6 +1249,7 @@ void renderer_draw(const Renderer *r, const float *mvp, int fb_w, int fb_h)
             glBindVertexArray(r->text_vao);
             glDrawArrays(GL_LINES, 0, r->text_vertex_count);
         }
+        profiler_gpu_end(PROF_GPU_TEXT);
     }
 
     glBindVertexArray(0);
@@ -947,6 +1276,7 @@ void renderer_draw_buttons(const Renderer *r, int fb_w, int fb_h)
     ortho[13] = 1.0f;
     ortho[15] = 1.0f;
     glUniformMatrix4fv(r->mvp_loc, 1, GL_FALSE, ortho);
+    profiler_gpu_begin(PROF_GPU_BUTTONS);
 
     /* Button backgrounds (rounded rectangles) */
     if (r->btn_bg_vao && r->btn_bg_vertex_count > 0) {
@@ -1023,10 +1353,46 @@ void renderer_draw_buttons(const Renderer *r, int fb_w, int fb_h)
         glBindVertexArray(r->popup_text_vao);
         glDrawArrays(GL_LINES, 0, r->popup_text_vertex_count);
     }
+    profiler_gpu_end(PROF_GPU_BUTTONS);
+
+    /* Profiler panel (not timed itself) */
+    if (r->prof_text_vertex_count > 0) {
+        glBindVertexArray(r->prof_bg_vao);
+        glUniform4f(r->color_loc, 0.0f, 0.0f, 0.0f, 0.7f);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        glUniform4f(r->color_loc, 0.6f, 1.0f, 0.6f, 1.0f);
+        glBindVertexArray(r->prof_text_vao);
+        glDrawArrays(GL_LINES, 0, r->prof_text_vertex_count);
+    }
 
     glBindVertexArray(0);
 }
 
+void renderer_upload_profile(Renderer *r, const float *bg_verts,
+                             const float *text_verts, int text_vertex_count)
+{
+    if (!r->prof_bg_vao) {
+        glGenVertexArrays(1, &r->prof_bg_vao);
+        glGenBuffers(1, &r->prof_bg_vbo);
+        glGenVertexArrays(1, &r->prof_text_vao);
+        glGenBuffers(1, &r->prof_text_vbo);
+    }
+    glBindVertexArray(r->prof_bg_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, r->prof_bg_vbo);
+    glBufferData(GL_ARRAY_BUFFER, 12 * sizeof(float), bg_verts, GL_DYNAMIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, NULL);
+
+    glBindVertexArray(r->prof_text_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, r->prof_text_vbo);
+    glBufferData(GL_ARRAY_BUFFER, text_vertex_count * 2 * sizeof(float),
+                 text_verts, GL_DYNAMIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, NULL);
+    glBindVertexArray(0);
+    r->prof_text_vertex_count = text_vertex_count;
+}
+
 void renderer_upload_sidebar(Renderer *r, int w, int h)
 {
     float verts[] = {
@@ -1076,6 +1442,7 @@ void renderer_draw_sidebar(const Renderer *r, int w, int h)
     ortho[13] = 1.0f;
     ortho[15] = 1.0f;
     glUniformMatrix4fv(r->mvp_loc, 1, GL_FALSE, ortho);
+    profiler_gpu_begin(PROF_GPU_SIDEBAR);
 
     /* Background */
     glUniform4f(r->color_loc, 0.06f, 0.06f, 0.10f, 0.95f);
@@ -1088,6 +1455,7 @@ void renderer_draw_sidebar(const Renderer *r, int w, int h)
         glBindVertexArray(r->sidebar_text_vao);
         glDrawArrays(GL_LINES, 0, r->sidebar_text_vertex_count);
     }
+    profiler_gpu_end(PROF_GPU_SIDEBAR);
 
     glBindVertexArray(0);
 }
@@ -1097,10 +1465,30 @@ void renderer_draw_sidebar(const Renderer *r, int w, int h)
 void renderer_destroy(Renderer *r)
 {
     glDeleteProgram(r->program);
+    if (r->geo_program) glDeleteProgram(r->geo_program);
+    if (r->night_program) glDeleteProgram(r->night_program);
+    if (r->heat_program) glDeleteProgram(r->heat_program);
+    if (r->spot_program) glDeleteProgram(r->spot_program);
+    if (r->path_program) glDeleteProgram(r->path_program);
+    share_segs(&r->map_segs, NULL);
+    share_segs(&r->border_segs, NULL);
+    share_segs(&r->land_segs, NULL);
+    share_segs(&r->grid_segs, NULL);
+    share_segs(&r->dist_segs, NULL);
+    share_segs(&r->muf_segs, NULL);
+    share_segs(&r->spore_segs, NULL);
+    share_segs(&r->aurora_lines_segs, NULL);
+    share_segs(&r->drap_lines_segs, NULL);
     if (r->map_vao) { glDeleteVertexArrays(1, &r->map_vao); glDeleteBuffers(1, &r->map_vbo); }
     if (r->border_vao) { glDeleteVertexArrays(1, &r->border_vao); glDeleteBuffers(1, &r->border_vbo); }
     if (r->land_vao) { glDeleteVertexArrays(1, &r->land_vao); glDeleteBuffers(1, &r->land_vbo); }
     if (r->line_vao) { glDeleteVertexArrays(1, &r->line_vao); glDeleteBuffers(1, &r->line_vbo); }
+    if (r->spot_vao) {
+        glDeleteVertexArrays(1, &r->spot_vao);
+        glDeleteVertexArrays(1, &r->path_vao);
+        glDeleteBuffers(1, &r->spot_corner_vbo);
+        glDeleteBuffers(1, &r->spot_inst_vbo);
+    }
     if (r->npole_vao) { glDeleteVertexArrays(1, &r->npole_vao); glDeleteBuffers(1, &r->npole_vbo); }
     if (r->center_marker_vao) { glDeleteVertexArrays(1, &r->center_marker_vao); glDeleteBuffers(1, &r->center_marker_vbo); }
     if (r->target_marker_vao) { glDeleteVertexArrays(1, &r->target_marker_vao); glDeleteBuffers(1, &r->target_marker_vbo); }
@@ -1109,11 +1497,18 @@ void renderer_destroy(Renderer *r)
     if (r->grid_vao) { glDeleteVertexArrays(1, &r->grid_vao); glDeleteBuffers(1, &r->grid_vbo); }
     if (r->dist_vao) { glDeleteVertexArrays(1, &r->dist_vao); glDeleteBuffers(1, &r->dist_vbo); }
     if (r->dist_label_vao) { glDeleteVertexArrays(1, &r->dist_label_vao); glDeleteBuffers(1, &r->dist_label_vbo); }
-    if (r->night_vao) { glDeleteVertexArrays(1, &r->night_vao); glDeleteBuffers(1, &r->night_vbo); }
-    if (r->aurora_vao) { glDeleteVertexArrays(1, &r->aurora_vao); glDeleteBuffers(1, &r->aurora_vbo); }
-    if (r->drap_vao) { glDeleteVertexArrays(1, &r->drap_vao); glDeleteBuffers(1, &r->drap_vbo); }
+    if (r->aurora.tex) glDeleteTextures(1, &r->aurora.tex);
+    if (r->drap.tex) glDeleteTextures(1, &r->drap.tex);
     if (r->muf_vao) { glDeleteVertexArrays(1, &r->muf_vao); glDeleteBuffers(1, &r->muf_vbo); }
     if (r->spore_vao) { glDeleteVertexArrays(1, &r->spore_vao); glDeleteBuffers(1, &r->spore_vbo); }
+    if (r->aurora_lines_vao) {
+        glDeleteVertexArrays(1, &r->aurora_lines_vao);
+        glDeleteBuffers(1, &r->aurora_lines_vbo);
+    }
+    if (r->drap_lines_vao) {
+        glDeleteVertexArrays(1, &r->drap_lines_vao);
+        glDeleteBuffers(1, &r->drap_lines_vbo);
+    }
     if (r->legend_line_vao) { glDeleteVertexArrays(1, &r->legend_line_vao); glDeleteBuffers(1, &r->legend_line_vbo); }
     if (r->legend_text_vao) { glDeleteVertexArrays(1, &r->legend_text_vao); glDeleteBuffers(1, &r->legend_text_vbo); }
     if (r->text_vao) { glDeleteVertexArrays(1, &r->text_vao); glDeleteBuffers(1, &r->text_vbo); }
@@ -1126,4 +1521,6 @@ void renderer_destroy(Renderer *r)
     if (r->popup_text_vao) { glDeleteVertexArrays(1, &r->popup_text_vao); glDeleteBuffers(1, &r->popup_text_vbo); }
     if (r->sidebar_vao) { glDeleteVertexArrays(1, &r->sidebar_vao); glDeleteBuffers(1, &r->sidebar_vbo); }
     if (r->sidebar_text_vao) { glDeleteVertexArrays(1, &r->sidebar_text_vao); glDeleteBuffers(1, &r->sidebar_text_vbo); }
+    if (r->prof_bg_vao) { glDeleteVertexArrays(1, &r->prof_bg_vao); glDeleteBuffers(1, &r->prof_bg_vbo); }
+    if (r->prof_text_vao) { glDeleteVertexArrays(1, &r->prof_text_vao); glDeleteBuffers(1, &r->prof_text_vbo); }
 }
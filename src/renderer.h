@@ -1,8 +1,12 @@
 /* renderer.h — OpenGL shader management, VAO/VBO upload, and draw calls.
  *
- * Owns all GPU resources: a single shader program (map.vert/map.frag) with
- * uniform color + MVP, and per-layer VAO/VBO pairs for every renderable element.
- * Upload functions transfer projected vertex data to the GPU; the draw functions
+ * Owns all GPU resources: the main shader program (map.vert/map.frag) with
+ * uniform color + MVP, an optional GPU projection program (geo.vert/geo.geom)
+ * for static lat/lon line layers, per-pixel programs for the day/night and
+ * heatmap passes, instanced programs for many-target spots, and per-layer VAO/VBO pairs (or textures) for every
+ * renderable element.
+ * Upload functions transfer projected vertex data to the GPU and take a
+ * reference on the source's segment table (no copy); the draw functions
  * render all layers in back-to-front order with appropriate colors and blend modes.
  * Drawing is split into km-space (map viewport with MVP) and pixel-space
  * (UI overlays with orthographic screen matrix). */
@@ -12,33 +16,70 @@
 
 #include "map_data.h"
 #include "overlay.h"
+#include "spots.h"
+
+/* A heatmap layer: texture plus the sampling transform and alpha ramp
+ * copied from its HeatGrid. */
+typedef struct {
+    unsigned int tex;
+    int          visible;
+    float        grid_map[4];   /* lon0, dlon, lat0, dlat */
+    float        grid_size[2];  /* width, height */
+    float        ramp[HEAT_RAMP_STOPS][2];
+} RenderHeat;
 
 typedef struct {
     unsigned int program;
     int          mvp_loc;
     int          color_loc;
 
+    /* GPU projection program (0 if unavailable) */
+    unsigned int geo_program;
+    int          geo_mvp_loc;
+    int          geo_color_loc;
+    int          geo_center_loc;
+    int          geo_mode_loc;
+    int          geo_split_loc;
+
+    /* Per-pixel day/night program (disc.vert/night.frag, 0 if unavailable) */
+    unsigned int night_program;
+    int          night_mvp_loc;
+    int          night_color_loc;
+    int          night_center_loc;
+    int          night_mode_loc;
+    int          night_sun_loc;
+
+    /* Per-pixel lat/lon heatmap program (disc.vert/heatmap.frag, 0 if unavailable) */
+    unsigned int heat_program;
+    int          heat_mvp_loc;
+    int          heat_color_loc;
+    int          heat_center_loc;
+    int          heat_mode_loc;
+    int          heat_grid_loc;
+    int          heat_grid_map_loc;
+    int          heat_grid_size_loc;
+    int          heat_ramp_loc;
+
     /* Map coastline geometry */
     unsigned int map_vao;
     unsigned int map_vbo;
-    int          map_segment_starts[MAX_SEGMENTS];
-    int          map_segment_counts[MAX_SEGMENTS];
-    int          map_num_segments;
+    int          map_geo;  /* 1 if map_vbo holds raw lat/lon (GPU-projected) */
+    SegTable    *map_segs;
 
     /* Country borders */
     unsigned int border_vao;
     unsigned int border_vbo;
-    int          border_segment_starts[MAX_SEGMENTS];
-    int          border_segment_counts[MAX_SEGMENTS];
-    int          border_num_segments;
+    int          border_geo;  /* 1 if border_vbo holds raw lat/lon (GPU-projected) */
+    SegTable    *border_segs;
+
+    /* Visible part of the globe (projection_view_cap); segments whose
+     * bounding cap misses it are not drawn */
+    float        view_cap[4];
 
     /* Land polygons (filled via stencil buffer) */
     unsigned int land_vao;
     unsigned int land_vbo;
-    int          land_segment_starts[MAX_SEGMENTS];
-    int          land_segment_counts[MAX_SEGMENTS];
-    int          land_segment_clamped[MAX_SEGMENTS];
-    int          land_num_segments;
+    SegTable    *land_segs;  /* clamped[] marks rings to skip */
 
     /* Target line (great circle path, center → target) */
     unsigned int line_vao;
@@ -55,6 +96,36 @@ typedef struct {
     unsigned int target_marker_vbo;
     int          target_marker_vcount;
 
+    /* Many-target mode: one instanced draw for all spot markers and one
+     * for all great-circle paths, from a single instance buffer of
+     * SpotInstance (programs are 0 if unavailable) */
+    unsigned int spot_program;      /* spot.vert + map.frag */
+    int          spot_mvp_loc;
+    int          spot_color_loc;
+    int          spot_center_loc;
+    int          spot_mode_loc;
+    int          spot_size_loc;
+    int          spot_now_loc;
+    int          spot_max_age_loc;
+    unsigned int path_program;      /* path.vert + geo.geom + map.frag */
+    int          path_mvp_loc;
+    int          path_color_loc;
+    int          path_center_loc;
+    int          path_mode_loc;
+    int          path_split_loc;
+    int          path_home_loc;
+    int          path_points_loc;
+    int          path_now_loc;
+    int          path_max_age_loc;
+    unsigned int spot_inst_vbo;     /* shared by both VAOs */
+    unsigned int spot_vao;
+    unsigned int spot_corner_vbo;
+    unsigned int path_vao;
+    int          spot_count;
+    float        spot_home[3];      /* path start as a unit vector */
+    float        spot_size_km;
+    float        spot_now, spot_max_age;
+
     /* North pole triangle (filled) */
     unsigned int npole_vao;
     unsigned int npole_vbo;
@@ -72,36 +143,25 @@ typedef struct {
     /* Grid (graticule) */
     unsigned int grid_vao;
     unsigned int grid_vbo;
-    int          grid_segment_starts[MAX_SEGMENTS];
-    int          grid_segment_counts[MAX_SEGMENTS];
-    int          grid_num_segments;
+    SegTable    *grid_segs;
 
     /* Distance circles from center (km-space) */
     unsigned int dist_vao;
     unsigned int dist_vbo;
-    int          dist_segment_starts[MAX_SEGMENTS];
-    int          dist_segment_counts[MAX_SEGMENTS];
-    int          dist_num_segments;
+    SegTable    *dist_segs;
 
     /* Distance circle labels (pixel-space GL_LINES) */
     unsigned int dist_label_vao;
     unsigned int dist_label_vbo;
     int          dist_label_vertex_count;
 
-    /* Night overlay (filled triangles with per-vertex alpha, km-space) */
-    unsigned int night_vao;
-    unsigned int night_vbo;
-    int          night_vertex_count;
+    /* Night overlay: subsolar point as a unit vector, drawn over the disc */
+    float        sun_dir[3];
+    int          sun_valid;
 
-    /* Aurora heatmap overlay (filled triangles with per-vertex alpha, km-space) */
-    unsigned int aurora_vao;
-    unsigned int aurora_vbo;
-    int          aurora_vertex_count;
-
-    /* DRAP absorption heatmap overlay (filled triangles with per-vertex alpha, km-space) */
-    unsigned int drap_vao;
-    unsigned int drap_vbo;
-    int          drap_vertex_count;
+    /* Aurora and DRAP heatmaps (R32F lat/lon textures drawn over the disc) */
+    RenderHeat   aurora;
+    RenderHeat   drap;
 
     /* MUF legend (pixel-space, colored line segments + text in sidebar) */
     unsigned int legend_line_vao;
@@ -116,18 +176,20 @@ typedef struct {
     /* MUF contour lines (per-segment color, km-space) */
     unsigned int muf_vao;
     unsigned int muf_vbo;
-    int          muf_segment_starts[MUF_MAX_SEGMENTS];
-    int          muf_segment_counts[MUF_MAX_SEGMENTS];
-    float        muf_segment_colors[MUF_MAX_SEGMENTS][4];
-    int          muf_num_segments;
+    SegTable    *muf_segs;   /* NULL while the layer is hidden */
 
     /* Sporadic E contour lines (per-segment color, km-space) */
     unsigned int spore_vao;
     unsigned int spore_vbo;
-    int          spore_segment_starts[MUF_MAX_SEGMENTS];
-    int          spore_segment_counts[MUF_MAX_SEGMENTS];
-    float        spore_segment_colors[MUF_MAX_SEGMENTS][4];
-    int          spore_num_segments;
+    SegTable    *spore_segs; /* NULL while the layer is hidden */
+
+    /* Aurora / DRAP isolines (per-segment color, km-space) */
+    unsigned int aurora_lines_vao;
+    unsigned int aurora_lines_vbo;
+    SegTable    *aurora_lines_segs; /* NULL while the layer is hidden */
+    unsigned int drap_lines_vao;
+    unsigned int drap_lines_vbo;
+    SegTable    *drap_lines_segs;
 
     /* Text overlay (pixel-space, HUD) */
     unsigned int text_vao;
@@ -179,6 +241,13 @@ typedef struct {
     unsigned int sidebar_text_vao;
     unsigned int sidebar_text_vbo;
     int          sidebar_text_vertex_count;
+
+    /* Profiler panel (pixel-space, drawn last in the button pass) */
+    unsigned int prof_bg_vao;
+    unsigned int prof_bg_vbo;
+    unsigned int prof_text_vao;
+    unsigned int prof_text_vbo;
+    int          prof_text_vertex_count;  /* 0 = hidden */
 } Renderer;
 
 /* Initialize shaders and GL state. Returns 0 on success. */
@@ -190,15 +259,35 @@ void renderer_upload_map(Renderer *r, const MapData *md);
 /* Upload country border data to GPU. */
 void renderer_upload_borders(Renderer *r, const MapData *md);
 
+/* Upload raw coastline lat/lon once for GPU-side projection (static VBO).
+ * Center/mode changes then only update shader uniforms. */
+void renderer_upload_map_geo(Renderer *r, const MapData *md);
+
+/* Upload raw border lat/lon once for GPU-side projection (static VBO). */
+void renderer_upload_borders_geo(Renderer *r, const MapData *md);
+
 /* Upload land polygon data to GPU (for stencil-based fill). */
 void renderer_upload_land(Renderer *r, const MapData *md);
 
+/* Set the view cap used to cull map segments (call each frame). */
+void renderer_set_view_cap(Renderer *r, const float *cap);
+
 /* Upload target line vertices (great circle path in km-space). */
 void renderer_upload_target_line(Renderer *r, const float *verts, int vertex_count);
 
 /* Upload markers: filled circle at center, outline circle at target. */
 void renderer_upload_markers(Renderer *r, float cx, float cy, float tx, float ty, float size_km);
 
+/* Upload the spot instances (one buffer upload for all spots).  Only
+ * needed when the set changes: moving the center, zooming and fading
+ * only change uniforms. */
+void renderer_upload_spots(Renderer *r, const SpotInstance *inst, int count);
+
+/* Set the spot view: path start (home), marker radius, the current time
+ * on the spots' clock and the age at which a spot has faded out. */
+void renderer_set_spot_view(Renderer *r, double home_lat, double home_lon,
+                            float size_km, float now, float max_age);
+
 /* Upload north pole triangle marker (km-space position + size). */
 void renderer_upload_npole(Renderer *r, float px, float py, float size_km);
 
@@ -214,14 +303,14 @@ void renderer_upload_dist_circles(Renderer *r, const MapData *md);
 /* Upload distance circle label text to GPU (pixel-space GL_LINES). */
 void renderer_upload_dist_labels(Renderer *r, float *verts, int vertex_count);
 
-/* Upload night overlay mesh (GL_TRIANGLES, 3 floats per vertex: x, y, alpha). */
-void renderer_upload_night(Renderer *r, const float *vertices, int vertex_count);
-
-/* Upload aurora overlay mesh (GL_TRIANGLES, 3 floats per vertex: x, y, alpha). */
-void renderer_upload_aurora(Renderer *r, const AuroraMesh *m);
+/* Set the subsolar point (degrees) for the night overlay, which is shaded
+ * per pixel over the Earth disc. */
+void renderer_set_sun(Renderer *r, double lat_deg, double lon_deg);
 
-/* Upload DRAP absorption overlay mesh (same format as aurora). */
-void renderer_upload_drap(Renderer *r, const AuroraMesh *m);
+/* Upload the aurora / DRAP rasters as textures and show the layer.  Only
+ * needed when the data changes; moving the center costs nothing. */
+void renderer_upload_aurora(Renderer *r, const HeatGrid *h);
+void renderer_upload_drap(Renderer *r, const HeatGrid *h);
 
 /* Upload MUF contour line data to GPU. */
 void renderer_upload_muf(Renderer *r, const MufData *m);
@@ -229,6 +318,21 @@ void renderer_upload_muf(Renderer *r, const MufData *m);
 /* Upload Sporadic E contour line data to GPU. */
 void renderer_upload_spore(Renderer *r, const MufData *m);
 
+/* Upload aurora / DRAP isolines (aurora_contours_build() /
+ * drap_contours_build()) to GPU. */
+void renderer_upload_aurora_lines(Renderer *r, const MufData *m);
+void renderer_upload_drap_lines(Renderer *r, const MufData *m);
+
+/* Hide the MUF / Sporadic E / isoline layers (drops the shared segment table). */
+void renderer_clear_muf(Renderer *r);
+void renderer_clear_spore(Renderer *r);
+void renderer_clear_aurora_lines(Renderer *r);
+void renderer_clear_drap_lines(Renderer *r);
+
+/* Hide the aurora / DRAP layers (the texture is kept for the next upload). */
+void renderer_clear_aurora(Renderer *r);
+void renderer_clear_drap(Renderer *r);
+
 /* Upload text overlay vertices (pixel-space GL_LINES). */
 void renderer_upload_text(Renderer *r, float *verts, int vertex_count);
 
@@ -260,6 +364,11 @@ void renderer_upload_legend(Renderer *r,
                             float *line_verts, float colors[][4], int count,
                             float *text_verts, int text_vert_count);
 
+/* Upload the profiler panel: background quad (6 verts) + GL_LINES text.
+ * A text_vertex_count of 0 hides the panel. */
+void renderer_upload_profile(Renderer *r, const float *bg_verts,
+                             const float *text_verts, int text_vertex_count);
+
 /* Draw UI buttons in their own full-window viewport pass. */
 void renderer_draw_buttons(const Renderer *r, int fb_w, int fb_h);
 
@@ -0,0 +1,136 @@
+/* reproj.c — Background reprojection after projection center changes.
+ *
+ * One joinable thread per job, polled under the mutex by the main loop as
+ * in map_lod.c.  The main thread starts and collects every job itself, so
+ * the layers change hands only at those two points. */
+
+#include <stdio.h>
+#include <string.h>
+#include "reproj.h"
+#include "grid.h"
+
+static void (*reproj_wake)(void);
+
+void reproj_set_wake(void (*wake)(void))
+{
+    reproj_wake = wake;
+}
+
+void reproj_init(Reprojector *rp, const ReprojLayers *layers)
+{
+    memset(rp, 0, sizeof(*rp));
+    rp->layers = *layers;
+    rp->grid_mode = projection_get_mode();
+    pthread_mutex_init(&rp->mutex, NULL);
+}
+
+/* Rebuild every layer around job_proj (runs on the worker thread). */
+static void run_job(Reprojector *rp)
+{
+    const ReprojLayers *l = &rp->layers;
+    const Camera *cam = &rp->job_cam;
+
+    projection_set_state(&rp->job_proj);
+    double half_h = cam->zoom_km * 0.5;
+    projection_view_cap(cam->pan_x, cam->pan_y, half_h * cam->aspect, half_h,
+                        rp->job_cap);
+
+    /* Same work as a synchronous center change: only the shown LOD levels,
+     * and only around the view */
+    if (l->project_lines) {
+        map_lod_reproject(l->map, rp->job_cap);
+        if (l->borders) map_lod_reproject(l->borders, rp->job_cap);
+    }
+    if (l->land) map_lod_reproject(l->land, rp->job_cap);
+
+    rp->job_grid = 0;
+    if (l->grid) {
+        if (rp->job_proj.mode == PROJ_ORTHO) {
+            grid_build_geo(l->grid);
+            rp->job_grid = 1;
+        } else if (rp->grid_mode != PROJ_AZEQ) {
+            grid_build(l->grid);
+            rp->job_grid = 1;
+        }
+        rp->grid_mode = rp->job_proj.mode;
+    }
+    if (l->dist_circles)
+        grid_build_dist_circles(l->dist_circles, l->home_lat, l->home_lon);
+
+    /* Hidden overlays too, so that showing them again needs no rebuild */
+    if (l->muf && l->muf->raw_count > 0) muf_reproject(l->muf);
+    if (l->spore && l->spore->raw_count > 0) muf_reproject(l->spore);
+    if (l->aurora_lines && l->aurora_lines->raw_count > 0)
+        muf_reproject(l->aurora_lines);
+    if (l->drap_lines && l->drap_lines->raw_count > 0)
+        muf_reproject(l->drap_lines);
+}
+
+static void *reproj_thread(void *arg)
+{
+    Reprojector *rp = arg;
+    run_job(rp);
+    pthread_mutex_lock(&rp->mutex);
+    rp->job_done = 1;
+    pthread_mutex_unlock(&rp->mutex);
+    if (reproj_wake) reproj_wake();
+    return NULL;
+}
+
+void reproj_request(Reprojector *rp, double lat, double lon, const Camera *cam)
+{
+    rp->next_lat = lat;
+    rp->next_lon = lon;
+    rp->next_cam = *cam;
+    rp->has_next = 1;
+}
+
+int reproj_kick(Reprojector *rp)
+{
+    if (rp->job_running || !rp->has_next) return 0;
+    rp->has_next = 0;
+    rp->job_proj.mode = projection_get_mode();
+    rp->job_proj.lat_deg = rp->next_lat;
+    rp->job_proj.lon_deg = rp->next_lon;
+    rp->job_cam = rp->next_cam;
+    rp->job_done = 0;
+    rp->job_running = 1;
+    rp->job_joinable = 1;
+    if (pthread_create(&rp->thread, NULL, reproj_thread, rp) != 0) {
+        /* The caller keeps drawing at its own center until it collects */
+        fprintf(stderr, "Warning: reprojection thread failed, projecting inline\n");
+        ProjState own;
+        projection_get_state(&own);
+        rp->job_joinable = 0;
+        run_job(rp);
+        projection_set_state(&own);
+        rp->job_done = 1;
+    }
+    return 1;
+}
+
+int reproj_collect(Reprojector *rp, int block)
+{
+    if (!rp->job_running) return 0;
+    if (!block) {
+        pthread_mutex_lock(&rp->mutex);
+        int done = rp->job_done;
+        pthread_mutex_unlock(&rp->mutex);
+        if (!done) return 0;
+    }
+    if (rp->job_joinable)
+        pthread_join(rp->thread, NULL);
+    rp->job_running = 0;
+    return 1;
+}
+
+int reproj_busy(const Reprojector *rp)
+{
+    return rp->job_running;
+}
+
+void reproj_free(Reprojector *rp)
+{
+    reproj_collect(rp, 1);
+    pthread_mutex_destroy(&rp->mutex);
+}
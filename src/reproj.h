@@ -0,0 +1,92 @@
+/* reproj.h — Background reprojection after projection center changes.
+ *
+ * Dragging the map requests a new center on every mouse move.  Instead of
+ * rebuilding every center-dependent layer before the next frame, the main
+ * loop queues the center here and a worker thread rebuilds the layers
+ * (shown LOD levels, ortho graticule, distance circles, MUF / Es lines,
+ * aurora / DRAP isolines)
+ * around it with its own projection state (ProjState).  Meanwhile the
+ * renderer keeps drawing the buffers it uploaded from the previous job; the
+ * main thread switches its projection center and uploads the new geometry
+ * in one go when the job is collected.  Requests that arrive while a job
+ * runs replace each other, so a burst of moves costs one extra job.
+ *
+ * While a job runs the worker owns every layer listed in ReprojLayers: the
+ * main thread must not read, rebuild or upload them until reproj_collect()
+ * has returned (reproj_busy() tells). */
+
+#ifndef REPROJ_H
+#define REPROJ_H
+
+#include <pthread.h>
+#include "camera.h"
+#include "map_data.h"
+#include "map_lod.h"
+#include "overlay.h"
+#include "projection.h"
+
+/* Center-dependent geometry the worker rebuilds (NULL = layer not loaded) */
+typedef struct {
+    MapLod  *map;
+    MapLod  *borders;
+    MapLod  *land;
+    int      project_lines;     /* 0 = coastlines/borders projected by geo.vert */
+    MapData *grid;              /* graticule: per center in ORTHO, per mode in AZEQ */
+    MapData *dist_circles;
+    double   home_lat, home_lon; /* distance circle center */
+    MufData *muf;
+    MufData *spore;
+    MufData *aurora_lines;      /* aurora / DRAP isolines */
+    MufData *drap_lines;
+} ReprojLayers;
+
+typedef struct {
+    ReprojLayers    layers;
+    ProjMode        grid_mode;   /* mode layers.grid was last built for */
+
+    /* Job in flight (one at a time, like map_lod.c) */
+    pthread_t       thread;
+    pthread_mutex_t mutex;
+    int             job_running; /* started and not yet collected */
+    int             job_done;
+    int             job_joinable; /* 0 if the job ran inline */
+    ProjState       job_proj;    /* center/mode the job projects at */
+    Camera          job_cam;     /* view the culling cap is computed for */
+    float           job_cap[4];  /* view cap at job_proj (set by the job) */
+    int             job_grid;    /* 1 if the job rebuilt layers.grid */
+
+    /* Latest request, not started yet */
+    int             has_next;
+    double          next_lat, next_lon;
+    Camera          next_cam;
+} Reprojector;
+
+/* Set up the worker for the given layers; the grid must currently be built
+ * for the current projection mode. */
+void reproj_init(Reprojector *rp, const ReprojLayers *layers);
+
+/* Queue a rebuild around (lat, lon) for the view cam.  Replaces a request
+ * that has not started yet. */
+void reproj_request(Reprojector *rp, double lat, double lon, const Camera *cam);
+
+/* Start the queued request, if any and no job is in flight, at the calling
+ * thread's projection mode.  Falls back to running it inline if no thread
+ * can be created.  Returns 1 if a job was started. */
+int reproj_kick(Reprojector *rp);
+
+/* Collect a finished job (block = 1 waits for a running one).  Returns 1
+ * if one was collected: the caller then adopts job_proj, uploads the
+ * layers and sets job_cap as the renderer's view cap. */
+int reproj_collect(Reprojector *rp, int block);
+
+/* 1 while a job runs or waits to be collected. */
+int reproj_busy(const Reprojector *rp);
+
+/* Call wake (must be thread-safe, e.g. glfwPostEmptyEvent) when a job
+ * finishes.  NULL disables it. */
+void reproj_set_wake(void (*wake)(void));
+
+/* Wait for a running job and release the worker. */
+void reproj_free(Reprojector *rp);
+
+#endif
@@ -0,0 +1,108 @@
+/* segtable.c — Growable, reference-counted polyline segment tables.
+ *
+ * Arrays grow by doubling; clamped[], colors[] and caps[] are only allocated when
+ * requested by the table's flags.  See segtable.h for the sharing rules. */
+
+#include <stdlib.h>
+#include <string.h>
+#include "segtable.h"
+
+#define SEGTABLE_MIN_CAP 64
+
+SegTable *segtable_new(int flags)
+{
+    SegTable *t = calloc(1, sizeof(*t));
+    if (!t) return NULL;
+    t->flags = flags;
+    atomic_init(&t->refs, 1);
+    return t;
+}
+
+SegTable *segtable_ref(SegTable *t)
+{
+    if (t) atomic_fetch_add(&t->refs, 1);
+    return t;
+}
+
+void segtable_unref(SegTable *t)
+{
+    if (!t || atomic_fetch_sub(&t->refs, 1) > 1) return;
+    free(t->starts);
+    free(t->counts);
+    free(t->clamped);
+    free(t->colors);
+    free(t->caps);
+    free(t);
+}
+
+int segtable_reset(SegTable **t, int flags)
+{
+    if (*t && atomic_load(&(*t)->refs) == 1 && (*t)->flags == flags) {
+        (*t)->num = 0;
+        return 0;
+    }
+    SegTable *fresh = segtable_new(flags);
+    if (!fresh) return -1;
+    segtable_unref(*t);
+    *t = fresh;
+    return 0;
+}
+
+int segtable_reserve(SegTable *t, int n)
+{
+    if (n <= t->cap) return 0;
+    int cap = t->cap ? t->cap : SEGTABLE_MIN_CAP;
+    while (cap < n) cap *= 2;
+
+    int *starts = realloc(t->starts, cap * sizeof(int));
+    if (!starts) return -1;
+    t->starts = starts;
+    int *counts = realloc(t->counts, cap * sizeof(int));
+    if (!counts) return -1;
+    t->counts = counts;
+    if (t->flags & SEG_CLAMPED) {
+        int *clamped = realloc(t->clamped, cap * sizeof(int));
+        if (!clamped) return -1;
+        t->clamped = clamped;
+    }
+    if (t->flags & SEG_COLORS) {
+        float (*colors)[4] = realloc(t->colors, cap * sizeof(*colors));
+        if (!colors) return -1;
+        t->colors = colors;
+    }
+    if (t->flags & SEG_CAPS) {
+        float (*caps)[4] = realloc(t->caps, cap * sizeof(*caps));
+        if (!caps) return -1;
+        t->caps = caps;
+    }
+    t->cap = cap;
+    return 0;
+}
+
+int segtable_push(SegTable *t, int start, int count)
+{
+    if (t->num == t->cap && segtable_reserve(t, t->num + 1) != 0)
+        return -1;
+    int i = t->num++;
+    t->starts[i] = start;
+    t->counts[i] = count;
+    if (t->clamped) t->clamped[i] = 0;
+    if (t->colors) memset(t->colors[i], 0, sizeof(t->colors[i]));
+    if (t->caps) {
+        t->caps[i][0] = 0.0f;
+        t->caps[i][1] = 0.0f;
+        t->caps[i][2] = 1.0f;
+        t->caps[i][3] = SEG_CAP_ALL;
+    }
+    return i;
+}
+
+size_t segtable_bytes(const SegTable *t)
+{
+    if (!t) return 0;
+    size_t per = 2 * sizeof(int);
+    if (t->clamped) per += sizeof(int);
+    if (t->colors) per += sizeof(t->colors[0]);
+    if (t->caps) per += sizeof(t->caps[0]);
+    return sizeof(*t) + (size_t)t->cap * per;
+}
@@ -0,0 +1,70 @@
+/* segtable.h — Growable polyline segment tables.
+ *
+ * A SegTable lists the polylines inside one contiguous vertex array as
+ * (start, count) pairs, with optional per-segment clamp flags and RGBA
+ * colors and bounding caps.  Tables grow on demand (no fixed segment limit) and are
+ * reference counted so that MapData/MufData and the Renderer share one
+ * table instead of copying it on every upload.
+ *
+ * Rebuilding goes through segtable_reset(): if another holder still
+ * references the table, the caller gets a fresh one and the other holder
+ * keeps the old contents, so a renderer never sees segment indices that
+ * don't match the VBO it last uploaded.
+ *
+ * The reference count is atomic: workers rebuild tables (and so drop
+ * references) while the main thread shares and releases them.  The
+ * contents are not synchronized; only the holder that is rebuilding a
+ * table may write it. */
+
+#ifndef SEGTABLE_H
+#define SEGTABLE_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+
+#define SEG_CLAMPED 0x1  /* allocate per-segment clamped[] flags */
+#define SEG_COLORS  0x2  /* allocate per-segment colors[] (RGBA) */
+#define SEG_CAPS    0x4  /* allocate per-segment bounding caps[] */
+
+/* Cap radius that covers the whole sphere (anything >= π) */
+#define SEG_CAP_ALL 4.0f
+
+typedef struct {
+    int   *starts;    /* first vertex index of each segment */
+    int   *counts;    /* vertex count of each segment */
+    int   *clamped;   /* 1 if segment was clipped away (SEG_CLAMPED only) */
+    float (*colors)[4]; /* RGBA per segment (SEG_COLORS only) */
+    float (*caps)[4];   /* unit center x,y,z + angular radius (rad) of the
+                         * segment on the sphere (SEG_CAPS only) */
+    int    num;       /* segments in use */
+    int    cap;       /* segments allocated */
+    int    flags;     /* SEG_* */
+    atomic_int refs;  /* holders; the LOD and reprojection workers unref
+                       * tables the renderer may also hold */
+} SegTable;
+
+/* Allocate an empty table with one reference.  Returns NULL on failure. */
+SegTable *segtable_new(int flags);
+
+/* Add a reference (NULL-safe) and return t. */
+SegTable *segtable_ref(SegTable *t);
+
+/* Drop a reference; frees the table when the last holder lets go. */
+void segtable_unref(SegTable *t);
+
+/* Prepare *t for rebuilding: empties it in place when unshared, otherwise
+ * replaces *t with a new empty table of the same flags.  Allocates *t if
+ * NULL.  Returns 0 on success, -1 on allocation failure. */
+int segtable_reset(SegTable **t, int flags);
+
+/* Ensure room for at least n segments.  Returns 0 on success, -1 on failure. */
+int segtable_reserve(SegTable *t, int n);
+
+/* Append a segment.  Returns its index, or -1 on allocation failure.
+ * clamped/colors of the new entry are zeroed; its cap covers the sphere. */
+int segtable_push(SegTable *t, int start, int count);
+
+/* Heap bytes held by the table (0 for NULL). */
+size_t segtable_bytes(const SegTable *t);
+
+#endif
@@ -0,0 +1,159 @@
+/* spots.c — Set of active spots for many-target mode.
+ *
+ * Spots live in a dense array (the upload layout); a chained hash table of
+ * indices finds a key.  Removing a spot moves the last one into its slot
+ * and patches that spot's chain link, so the array never has holes. */
+
+#include <stdlib.h>
+#include <string.h>
+#include "spots.h"
+
+/* FNV-1a over the part of key that is stored */
+static unsigned hash_key(const char *key)
+{
+    unsigned h = 2166136261u;
+    const unsigned char *p = (const unsigned char *)key;
+    for (int n = 0; n < SPOT_KEY_MAX - 1 && *p; n++, p++) {
+        h ^= *p;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+int spots_init(SpotSet *s)
+{
+    memset(s, 0, sizeof(*s));
+    s->nbuckets = 1;
+    while (s->nbuckets < SPOTS_MAX * 2)
+        s->nbuckets <<= 1;
+    s->inst = malloc(sizeof(*s->inst) * SPOTS_MAX);
+    s->keys = malloc(sizeof(*s->keys) * SPOTS_MAX);
+    s->next = malloc(sizeof(*s->next) * SPOTS_MAX);
+    s->buckets = malloc(sizeof(*s->buckets) * (size_t)s->nbuckets);
+    if (!s->inst || !s->keys || !s->next || !s->buckets) {
+        spots_free(s);
+        return -1;
+    }
+    memset(s->buckets, 0xff, sizeof(*s->buckets) * (size_t)s->nbuckets);
+    return 0;
+}
+
+void spots_free(SpotSet *s)
+{
+    free(s->inst);
+    free(s->keys);
+    free(s->next);
+    free(s->buckets);
+    memset(s, 0, sizeof(*s));
+}
+
+int spots_find(const SpotSet *s, const char *key)
+{
+    if (!s->buckets) return -1;
+    int i = s->buckets[hash_key(key) & (unsigned)(s->nbuckets - 1)];
+    while (i >= 0 && strncmp(s->keys[i], key, SPOT_KEY_MAX - 1) != 0)
+        i = s->next[i];
+    return i;
+}
+
+/* The chain slot that holds index i (i must be in the set). */
+static int *chain_slot(SpotSet *s, int i)
+{
+    int *slot = &s->buckets[hash_key(s->keys[i]) & (unsigned)(s->nbuckets - 1)];
+    while (*slot != i)
+        slot = &s->next[*slot];
+    return slot;
+}
+
+static void remove_at(SpotSet *s, int i)
+{
+    *chain_slot(s, i) = s->next[i];
+    int last = s->count - 1;
+    if (i != last) {
+        *chain_slot(s, last) = i;
+        s->inst[i] = s->inst[last];
+        memcpy(s->keys[i], s->keys[last], SPOT_KEY_MAX);
+        s->next[i] = s->next[last];
+    }
+    s->count--;
+    s->version++;
+}
+
+/* Index of the spot to evict from a full set: the oldest fading one. */
+static int oldest(const SpotSet *s)
+{
+    int best = s->count - 1;
+    float best_born = 0.0f;
+    int found = 0;
+    for (int i = 0; i < s->count; i++) {
+        float b = s->inst[i].born;
+        if (b >= 0.0f && (!found || b < best_born)) {
+            best = i;
+            best_born = b;
+            found = 1;
+        }
+    }
+    return best;
+}
+
+int spots_add(SpotSet *s, const char *key, double lat, double lon, float now)
+{
+    if (!s->buckets || !key || !key[0]) return -1;
+    int i = spots_find(s, key);
+    if (i < 0) {
+        if (s->count == SPOTS_MAX)
+            remove_at(s, oldest(s));
+        i = s->count++;
+        strncpy(s->keys[i], key, SPOT_KEY_MAX - 1);
+        s->keys[i][SPOT_KEY_MAX - 1] = '\0';
+        int *head = &s->buckets[hash_key(s->keys[i]) & (unsigned)(s->nbuckets - 1)];
+        s->next[i] = *head;
+        *head = i;
+    }
+    s->inst[i].lat = (float)lat;
+    s->inst[i].lon = (float)lon;
+    s->inst[i].born = now;
+    s->version++;
+    return i;
+}
+
+int spots_touch(SpotSet *s, const char *key, float now)
+{
+    int i = spots_find(s, key);
+    if (i < 0) return 0;
+    if (s->inst[i].born != SPOT_PINNED) {
+        s->inst[i].born = now;
+        s->version++;
+    }
+    return 1;
+}
+
+int spots_remove(SpotSet *s, const char *key)
+{
+    int i = spots_find(s, key);
+    if (i < 0) return 0;
+    remove_at(s, i);
+    return 1;
+}
+
+int spots_expire(SpotSet *s, float now, float max_age)
+{
+    /* Back to front: the spot swapped into slot i was already checked */
+    int removed = 0;
+    for (int i = s->count - 1; i >= 0; i--) {
+        float b = s->inst[i].born;
+        if (b >= 0.0f && now - b > max_age) {
+            remove_at(s, i);
+            removed++;
+        }
+    }
+    return removed;
+}
+
+void spots_clear(SpotSet *s)
+{
+    if (!s->buckets || s->count == 0) return;
+    memset(s->buckets, 0xff, sizeof(*s->buckets) * (size_t)s->nbuckets);
+    s->count = 0;
+    s->version++;
+}
@@ -0,0 +1,63 @@
+/* spots.h — Set of active spots for many-target mode.
+ *
+ * Each spot is a keyed (callsign / label) location with the time it was
+ * last heard.  The set keeps its spots in one dense array laid out the
+ * way the renderer uploads it as instance data, so all markers and
+ * great-circle paths go to the GPU in a single buffer upload and are
+ * drawn with one instanced draw each; projection, path interpolation and
+ * age fading happen in the shaders.  Lookup by key is a hash table over
+ * the dense array, removal swaps the last spot into the hole.
+ *
+ * Main thread only. */
+
+#ifndef SPOTS_H
+#define SPOTS_H
+
+#define SPOTS_MAX       16384   /* active spots; the oldest is evicted beyond */
+#define SPOT_KEY_MAX    32
+#define SPOT_PINNED     (-1.0f) /* born value of a spot that never fades */
+
+/* Per-spot instance data, uploaded as is (3 floats) */
+typedef struct {
+    float lat, lon;     /* degrees */
+    float born;         /* time last heard (seconds, caller's clock), or SPOT_PINNED */
+} SpotInstance;
+
+typedef struct {
+    SpotInstance *inst;                 /* dense, count in use */
+    char        (*keys)[SPOT_KEY_MAX];  /* parallel to inst */
+    int          *next;                 /* hash chain link per spot, -1 = end */
+    int          *buckets;              /* first spot per bucket, -1 = empty */
+    int           nbuckets;             /* power of two */
+    int           count;
+    unsigned      version;              /* bumped on every change */
+} SpotSet;
+
+/* Allocate an empty set.  Returns 0, or -1 on allocation failure. */
+int  spots_init(SpotSet *s);
+void spots_free(SpotSet *s);
+
+/* Add the spot key (truncated to SPOT_KEY_MAX - 1 bytes) at lat/lon heard
+ * at now (SPOT_PINNED: never fades), or move and refresh it if it is
+ * already in the set.  A full set evicts its oldest fading spot (or, with
+ * none, the last one).  Returns the spot's index, or -1 if key is empty. */
+int  spots_add(SpotSet *s, const char *key, double lat, double lon, float now);
+
+/* Refresh the time key was last heard, keeping its location.  Returns 1
+ * if it is in the set. */
+int  spots_touch(SpotSet *s, const char *key, float now);
+
+/* Index of key, or -1. */
+int  spots_find(const SpotSet *s, const char *key);
+
+/* Remove key.  Returns 1 if it was in the set. */
+int  spots_remove(SpotSet *s, const char *key);
+
+/* Drop every fading spot last heard more than max_age seconds before now.
+ * Returns the number removed. */
+int  spots_expire(SpotSet *s, float now, float max_age);
+
+/* Remove all spots. */
+void spots_clear(SpotSet *s);
+
+#endif
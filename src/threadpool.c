@@ -0,0 +1,204 @@
+/* threadpool.c — Persistent worker pool for data-parallel loops.
+ *
+ * Participant p (0 = the calling thread) owns the task range [lo, hi),
+ * packed into one 64-bit word so that both the owner taking lo and a
+ * thief cutting off the back half of the range are a single
+ * compare-and-swap.  Ranges only ever shrink, and a stolen range is
+ * published only once the thief's own range is empty, so no task index
+ * is handed out twice.  Workers sleep on a condition variable between
+ * loops; the caller waits under the same mutex until every worker has
+ * left the current loop before the task context goes out of scope. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "threadpool.h"
+
+/* One participant's remaining tasks, alone on its cache line */
+typedef struct {
+    _Alignas(64) _Atomic uint64_t range;   /* lo | hi << 32 */
+} TaskDeque;
+
+static pthread_t       *workers;
+static int              nworkers;
+static TaskDeque       *deques;            /* nworkers + 1 */
+
+static pthread_mutex_t  pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   pool_start = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t   pool_done  = PTHREAD_COND_INITIALIZER;
+static unsigned         pool_gen;          /* bumped for every loop */
+static int              pool_active;       /* workers inside the loop */
+static int              pool_stop;
+
+/* Current loop (written under pool_mutex before pool_gen changes) */
+static void           (*loop_fn)(void *ctx, int task);
+static void            *loop_ctx;
+static int              loop_parts;
+
+/* One loop at a time; other callers run theirs inline */
+static pthread_mutex_t  run_mutex = PTHREAD_MUTEX_INITIALIZER;
+static _Thread_local int in_task;
+
+static uint64_t pack_range(uint32_t lo, uint32_t hi)
+{
+    return lo | (uint64_t)hi << 32;
+}
+
+/* Take the next task of participant p's own range (-1 if empty). */
+static int pop_task(int p)
+{
+    uint64_t r = atomic_load(&deques[p].range);
+    for (;;) {
+        uint32_t lo = (uint32_t)r, hi = (uint32_t)(r >> 32);
+        if (lo >= hi) return -1;
+        if (atomic_compare_exchange_weak(&deques[p].range, &r, pack_range(lo + 1, hi)))
+            return (int)lo;
+    }
+}
+
+/* Steal the back half of another participant's range: return its first
+ * task and keep the rest as p's own range (-1 if all are empty). */
+static int steal_task(int p)
+{
+    for (int k = 1; k < loop_parts; k++) {
+        TaskDeque *victim = &deques[(p + k) % loop_parts];
+        uint64_t r = atomic_load(&victim->range);
+        for (;;) {
+            uint32_t lo = (uint32_t)r, hi = (uint32_t)(r >> 32);
+            if (lo >= hi) break;
+            uint32_t take = (hi - lo + 1) / 2;
+            if (atomic_compare_exchange_weak(&victim->range, &r, pack_range(lo, hi - take))) {
+                atomic_store(&deques[p].range, pack_range(hi - take + 1, hi));
+                return (int)(hi - take);
+            }
+        }
+    }
+    return -1;
+}
+
+static void run_tasks(int p)
+{
+    in_task = 1;
+    for (;;) {
+        int t = pop_task(p);
+        if (t < 0) t = steal_task(p);
+        if (t < 0) break;
+        loop_fn(loop_ctx, t);
+    }
+    in_task = 0;
+}
+
+static void *worker_main(void *arg)
+{
+    int p = (int)(intptr_t)arg;
+    unsigned seen = 0;
+
+    pthread_mutex_lock(&pool_mutex);
+    for (;;) {
+        while (!pool_stop && pool_gen == seen)
+            pthread_cond_wait(&pool_start, &pool_mutex);
+        if (pool_stop) break;
+        seen = pool_gen;
+        pthread_mutex_unlock(&pool_mutex);
+
+        run_tasks(p);
+
+        pthread_mutex_lock(&pool_mutex);
+        if (--pool_active == 0)
+            pthread_cond_signal(&pool_done);
+    }
+    pthread_mutex_unlock(&pool_mutex);
+    return NULL;
+}
+
+int threadpool_init(int nthreads)
+{
+    if (nthreads <= 0) {
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = ncpu > 0 ? (int)ncpu : 1;
+    }
+    if (nthreads > THREADPOOL_MAX_THREADS) nthreads = THREADPOOL_MAX_THREADS;
+    if (nthreads <= 1 || nworkers > 0) return 0;
+
+    workers = malloc((size_t)(nthreads - 1) * sizeof(pthread_t));
+    deques = aligned_alloc(_Alignof(TaskDeque), (size_t)nthreads * sizeof(TaskDeque));
+    if (!workers || !deques) {
+        fprintf(stderr, "Error: out of memory starting %d threads\n", nthreads);
+        free(workers);
+        free(deques);
+        workers = NULL;
+        deques = NULL;
+        return -1;
+    }
+    for (int p = 0; p < nthreads; p++)
+        atomic_init(&deques[p].range, 0);
+
+    pool_stop = 0;
+    for (int p = 1; p < nthreads; p++) {
+        if (pthread_create(&workers[nworkers], NULL, worker_main, (void *)(intptr_t)p) != 0) {
+            fprintf(stderr, "Warning: thread pool started %d of %d threads\n", p, nthreads);
+            break;
+        }
+        nworkers++;
+    }
+    return 0;
+}
+
+int threadpool_size(void)
+{
+    return nworkers + 1;
+}
+
+void threadpool_run(int ntasks, void (*fn)(void *ctx, int task), void *ctx)
+{
+    if (ntasks <= 0) return;
+    if (nworkers == 0 || ntasks == 1 || in_task ||
+        pthread_mutex_trylock(&run_mutex) != 0) {
+        for (int t = 0; t < ntasks; t++)
+            fn(ctx, t);
+        return;
+    }
+
+    /* Even initial split; stealing rebalances uneven tasks */
+    int parts = nworkers + 1;
+    for (int p = 0; p < parts; p++)
+        atomic_store(&deques[p].range,
+                     pack_range((uint32_t)((int64_t)ntasks * p / parts),
+                                (uint32_t)((int64_t)ntasks * (p + 1) / parts)));
+
+    pthread_mutex_lock(&pool_mutex);
+    loop_fn = fn;
+    loop_ctx = ctx;
+    loop_parts = parts;
+    pool_active = nworkers;
+    pool_gen++;
+    pthread_cond_broadcast(&pool_start);
+    pthread_mutex_unlock(&pool_mutex);
+
+    run_tasks(0);
+
+    pthread_mutex_lock(&pool_mutex);
+    while (pool_active > 0)
+        pthread_cond_wait(&pool_done, &pool_mutex);
+    pthread_mutex_unlock(&pool_mutex);
+    pthread_mutex_unlock(&run_mutex);
+}
+
+void threadpool_shutdown(void)
+{
+    if (nworkers == 0) return;
+    pthread_mutex_lock(&pool_mutex);
+    pool_stop = 1;
+    pthread_cond_broadcast(&pool_start);
+    pthread_mutex_unlock(&pool_mutex);
+    for (int i = 0; i < nworkers; i++)
+        pthread_join(workers[i], NULL);
+    free(workers);
+    free(deques);
+    workers = NULL;
+    deques = NULL;
+    nworkers = 0;
+}
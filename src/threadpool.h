@@ -0,0 +1,36 @@
+/* threadpool.h — Persistent worker pool for data-parallel loops.
+ *
+ * A fixed set of worker threads, started once, runs the tasks of one
+ * threadpool_run() call at a time together with the calling thread.  Each
+ * participant starts on its own contiguous block of task indices and,
+ * once that is exhausted, steals the back half of another participant's
+ * remaining block, so tasks of very uneven cost (map rings range from 2 to
+ * thousands of vertices) still finish together.
+ *
+ * Workers carry no projection state of their own: a task that projects
+ * must adopt the caller's ProjState (projection_set_state()) first. */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+/* Upper bound for --threads */
+#define THREADPOOL_MAX_THREADS 64
+
+/* Start the pool with nthreads participants in total (the caller of
+ * threadpool_run() counts as one, so nthreads - 1 workers are created).
+ * nthreads <= 0 uses one per online CPU.  Creating fewer workers than
+ * asked only prints a warning.  Returns 0 on success. */
+int threadpool_init(int nthreads);
+
+/* Participants per threadpool_run() (1 when the pool is not running). */
+int threadpool_size(void);
+
+/* Run fn(ctx, i) for every i in [0, ntasks) and return when all are done.
+ * Runs inline on the calling thread when the pool is stopped, already
+ * busy with another caller's loop, or called from inside a task. */
+void threadpool_run(int ntasks, void (*fn)(void *ctx, int task), void *ctx);
+
+/* Stop and join the workers. */
+void threadpool_shutdown(void);
+
+#endif
@@ -0,0 +1,369 @@
+/* wsjtx.c — WSJT-X UDP message listener.
+ *
+ * WSJT-X writes its messages with QDataStream: big-endian integers,
+ * IEEE doubles, and utf8 strings as a 32-bit byte count (0xffffffff for a
+ * null string) followed by the bytes.  Every message starts with the
+ * magic, the schema number, the message type and the sender's id.  Only
+ * the leading fields of Status and QSO Logged are read; later schema
+ * versions only append fields.
+ *
+ * The ring is the classic SPSC queue: head is written only by the
+ * listener, tail only by the main thread, each on its own cache line.  A
+ * slot is filled before head is published (release) and read before tail
+ * is (release), so neither side ever takes a lock. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "wsjtx.h"
+
+#define WSJTX_POLL_MS   250             /* lets wsjtx_listen_stop() end the thread */
+#define WSJTX_DGRAM_MAX 4096            /* WSJT-X datagrams are a few hundred bytes */
+#define WSJTX_RCVBUF    (1 << 20)       /* absorbs a decode burst */
+
+/* ── Message decoding ────────────────────────────────────────────── */
+
+typedef struct {
+    const unsigned char *p, *end;
+    int err;                            /* set on a read past the end */
+} Reader;
+
+static uint64_t rd_be(Reader *r, int n)
+{
+    if (r->err || r->end - r->p < n) {
+        r->err = 1;
+        return 0;
+    }
+    uint64_t v = 0;
+    for (int i = 0; i < n; i++)
+        v = v << 8 | *r->p++;
+    return v;
+}
+
+static double rd_double(Reader *r)
+{
+    uint64_t bits = rd_be(r, 8);
+    double d;
+    memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
+/* utf8 string into out (truncated, control characters dropped) */
+static void rd_utf8(Reader *r, char *out, size_t out_sz)
+{
+    uint32_t n = (uint32_t)rd_be(r, 4);
+    out[0] = '\0';
+    if (r->err || n == 0xffffffffu) return;
+    if ((size_t)(r->end - r->p) < n) {
+        r->err = 1;
+        return;
+    }
+    size_t k = 0;
+    for (uint32_t i = 0; i < n; i++)
+        if (r->p[i] >= 0x20 && k + 1 < out_sz)
+            out[k++] = (char)r->p[i];
+    out[k] = '\0';
+    r->p += n;
+}
+
+int wsjtx_grid_to_latlon(const char *grid, double *lat, double *lon)
+{
+    size_t n = strlen(grid);
+    if (n != 4 && n != 6) return -1;
+    int f0 = toupper((unsigned char)grid[0]) - 'A';
+    int f1 = toupper((unsigned char)grid[1]) - 'A';
+    int s0 = grid[2] - '0', s1 = grid[3] - '0';
+    if (f0 < 0 || f0 > 17 || f1 < 0 || f1 > 17 || s0 < 0 || s0 > 9 || s1 < 0 || s1 > 9)
+        return -1;
+    *lon = f0 * 20.0 - 180.0 + s0 * 2.0;
+    *lat = f1 * 10.0 - 90.0 + s1 * 1.0;
+    if (n == 6) {
+        int u0 = toupper((unsigned char)grid[4]) - 'A';
+        int u1 = toupper((unsigned char)grid[5]) - 'A';
+        if (u0 < 0 || u0 > 23 || u1 < 0 || u1 > 23) return -1;
+        *lon += (u0 + 0.5) * (2.0 / 24.0);
+        *lat += (u1 + 0.5) * (1.0 / 24.0);
+    } else {
+        *lon += 1.0;
+        *lat += 0.5;
+    }
+    return 0;
+}
+
+/* A 4-character grid square, excluding the RR73 sign-off */
+static int is_grid4(const char *t)
+{
+    return strlen(t) == 4 && t[0] >= 'A' && t[0] <= 'R' && t[1] >= 'A' && t[1] <= 'R' &&
+           isdigit((unsigned char)t[2]) && isdigit((unsigned char)t[3]) &&
+           strcmp(t, "RR73") != 0;
+}
+
+/* Strip the brackets of a hashed call ("<EA4ABC>") into out; 1 if the
+ * result looks like a callsign (letters, digits and '/', with at least one
+ * of each kind). */
+static int clean_call(const char *t, char *out, size_t out_sz)
+{
+    size_t n = strlen(t);
+    if (n >= 2 && t[0] == '<' && t[n - 1] == '>') {
+        t++;
+        n -= 2;
+    }
+    if (n < 3 || n >= out_sz) return 0;
+    int digits = 0, letters = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (isdigit((unsigned char)t[i])) digits++;
+        else if (isupper((unsigned char)t[i])) letters++;
+        else if (t[i] != '/') return 0;
+    }
+    if (!digits || !letters) return 0;
+    memcpy(out, t, n);
+    out[n] = '\0';
+    return 1;
+}
+
+int wsjtx_message_station(const char *msg, char *call, size_t call_sz,
+                          char *grid, size_t grid_sz)
+{
+    char buf[64], *tok[6];
+    int nt = 0;
+    size_t k = 0;
+    for (; msg[k] && k + 1 < sizeof(buf); k++)
+        buf[k] = (char)toupper((unsigned char)msg[k]);
+    buf[k] = '\0';
+    for (char *save, *t = strtok_r(buf, " ", &save); t && nt < 6; t = strtok_r(NULL, " ", &save))
+        tok[nt++] = t;
+    call[0] = grid[0] = '\0';
+    if (nt < 2) return 0;
+
+    /* "CQ [modifier] CALL [GRID]", otherwise "TO FROM [GRID|report]" */
+    int ci = 1;
+    if (strcmp(tok[0], "CQ") == 0 || strcmp(tok[0], "QRZ") == 0) {
+        if (nt >= 4 || (nt == 3 && !is_grid4(tok[2])))
+            ci = 2;
+    }
+    if (!clean_call(tok[ci], call, call_sz)) {
+        call[0] = '\0';
+        return 0;
+    }
+    if (ci + 1 < nt && is_grid4(tok[ci + 1]))
+        snprintf(grid, grid_sz, "%s", tok[ci + 1]);
+    return 1;
+}
+
+int wsjtx_parse(const unsigned char *buf, size_t len, WsjtxEvent *ev)
+{
+    Reader r = { buf, buf + len, 0 };
+    char id[64];
+    if (rd_be(&r, 4) != WSJTX_MAGIC) return -1;
+    rd_be(&r, 4);                                   /* schema */
+    uint32_t type = (uint32_t)rd_be(&r, 4);
+    rd_utf8(&r, id, sizeof(id));
+    if (r.err) return -1;
+
+    memset(ev, 0, sizeof(*ev));
+    switch (type) {
+    case WSJTX_MSG_STATUS: {
+        char skip[64];
+        ev->kind = WSJTX_EV_STATUS;
+        ev->freq_hz = rd_be(&r, 8);
+        rd_utf8(&r, ev->mode, sizeof(ev->mode));
+        rd_utf8(&r, ev->text, sizeof(ev->text));    /* DX call */
+        rd_utf8(&r, skip, sizeof(skip));            /* report */
+        rd_utf8(&r, skip, sizeof(skip));            /* TX mode */
+        rd_be(&r, 1);                               /* TX enabled */
+        rd_be(&r, 1);                               /* transmitting */
+        rd_be(&r, 1);                               /* decoding */
+        rd_be(&r, 4);                               /* RX DF */
+        rd_be(&r, 4);                               /* TX DF */
+        rd_utf8(&r, ev->call, sizeof(ev->call));    /* DE call */
+        rd_utf8(&r, ev->grid, sizeof(ev->grid));    /* DE grid */
+        break;
+    }
+    case WSJTX_MSG_DECODE: {
+        ev->kind = WSJTX_EV_DECODE;
+        rd_be(&r, 1);                               /* new */
+        rd_be(&r, 4);                               /* time (ms since midnight) */
+        ev->snr = (int32_t)rd_be(&r, 4);
+        rd_double(&r);                              /* delta time */
+        ev->df = (unsigned)rd_be(&r, 4);
+        rd_utf8(&r, ev->mode, sizeof(ev->mode));
+        rd_utf8(&r, ev->text, sizeof(ev->text));
+        if (r.err) return -1;
+        wsjtx_message_station(ev->text, ev->call, sizeof(ev->call),
+                              ev->grid, sizeof(ev->grid));
+        break;
+    }
+    case WSJTX_MSG_QSO_LOGGED: {
+        ev->kind = WSJTX_EV_LOGGED;
+        rd_be(&r, 8);                               /* date off (Julian day) */
+        rd_be(&r, 4);                               /* time off (ms) */
+        if (rd_be(&r, 1) == 2)                      /* time spec: offset from UTC */
+            rd_be(&r, 4);
+        rd_utf8(&r, ev->call, sizeof(ev->call));
+        rd_utf8(&r, ev->grid, sizeof(ev->grid));
+        ev->freq_hz = rd_be(&r, 8);
+        rd_utf8(&r, ev->mode, sizeof(ev->mode));
+        break;
+    }
+    default:
+        return 0;
+    }
+    if (r.err) return -1;
+    ev->has_pos = ev->grid[0] && wsjtx_grid_to_latlon(ev->grid, &ev->lat, &ev->lon) == 0;
+    return 1;
+}
+
+/* ── SPSC ring ───────────────────────────────────────────────────── */
+
+/* Listener side: 0 if the ring is full. */
+static int ring_push(WsjtxListener *wl, const WsjtxEvent *ev)
+{
+    size_t head = atomic_load_explicit(&wl->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&wl->tail, memory_order_acquire);
+    if (head - tail == WSJTX_RING_SIZE)
+        return 0;
+    wl->ring[head & (WSJTX_RING_SIZE - 1)] = *ev;
+    atomic_store_explicit(&wl->head, head + 1, memory_order_release);
+    return 1;
+}
+
+int wsjtx_take(WsjtxListener *wl, WsjtxEvent *out)
+{
+    if (!wl->ring) return 0;
+    size_t tail = atomic_load_explicit(&wl->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&wl->head, memory_order_acquire);
+    if (tail == head)
+        return 0;
+    *out = wl->ring[tail & (WSJTX_RING_SIZE - 1)];
+    atomic_store_explicit(&wl->tail, tail + 1, memory_order_release);
+    return 1;
+}
+
+/* ── Listener thread ─────────────────────────────────────────────── */
+
+static void count(atomic_long *c)
+{
+    atomic_fetch_add_explicit(c, 1, memory_order_relaxed);
+}
+
+static void *listen_thread(void *arg)
+{
+    WsjtxListener *wl = arg;
+    unsigned char buf[WSJTX_DGRAM_MAX];
+    while (!atomic_load_explicit(&wl->stop, memory_order_relaxed)) {
+        struct pollfd pfd = { .fd = wl->fd, .events = POLLIN };
+        if (poll(&pfd, 1, WSJTX_POLL_MS) <= 0 || !(pfd.revents & POLLIN))
+            continue;
+        /* Drain everything queued: a whole decode burst, one wakeup */
+        int produced = 0;
+        ssize_t n;
+        while ((n = recv(wl->fd, buf, sizeof(buf), MSG_DONTWAIT)) >= 0) {
+            WsjtxEvent ev;
+            count(&wl->datagrams);
+            int rc = wsjtx_parse(buf, (size_t)n, &ev);
+            if (rc < 0) {
+                count(&wl->bad);
+                continue;
+            }
+            if (rc == 0) continue;
+            if (ev.kind == WSJTX_EV_DECODE) {
+                count(&wl->decodes);
+                if (!ev.call[0]) continue;          /* no station in the text */
+                if (ev.has_pos) count(&wl->spots);
+            }
+            if (ring_push(wl, &ev)) produced = 1;
+            else count(&wl->dropped);
+        }
+        if (produced && wl->wake) wl->wake();
+    }
+    return NULL;
+}
+
+int wsjtx_listen_start(WsjtxListener *wl, int port, const char *group,
+                       void (*wake)(void))
+{
+    memset(wl, 0, sizeof(*wl));
+    wl->fd = -1;
+    if (port <= 0 || port > 65535) return -1;
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        fprintf(stderr, "Warning: WSJT-X socket: %s\n", strerror(errno));
+        return -1;
+    }
+    /* Share the port with other WSJT-X consumers (multicast) */
+    int on = 1, rcvbuf = WSJTX_RCVBUF;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+#ifdef SO_REUSEPORT
+    setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+#endif
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((uint16_t)port);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        fprintf(stderr, "Warning: WSJT-X: cannot bind UDP port %d: %s\n", port, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    if (group && group[0]) {
+        struct ip_mreq mreq;
+        memset(&mreq, 0, sizeof(mreq));
+        mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+        if (inet_pton(AF_INET, group, &mreq.imr_multiaddr) != 1 ||
+            setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) != 0) {
+            fprintf(stderr, "Warning: WSJT-X: cannot join multicast group %s: %s\n",
+                    group, strerror(errno));
+            close(fd);
+            return -1;
+        }
+    }
+
+    wl->ring = malloc(sizeof(*wl->ring) * WSJTX_RING_SIZE);
+    if (!wl->ring) {
+        close(fd);
+        return -1;
+    }
+    wl->fd = fd;
+    wl->wake = wake;
+    if (pthread_create(&wl->thread, NULL, listen_thread, wl) != 0) {
+        fprintf(stderr, "Warning: WSJT-X listener thread failed: %s\n", strerror(errno));
+        free(wl->ring);
+        wl->ring = NULL;
+        close(fd);
+        wl->fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+void wsjtx_get_stats(WsjtxListener *wl, WsjtxStats *out)
+{
+    out->datagrams = atomic_load_explicit(&wl->datagrams, memory_order_relaxed);
+    out->bad       = atomic_load_explicit(&wl->bad, memory_order_relaxed);
+    out->decodes   = atomic_load_explicit(&wl->decodes, memory_order_relaxed);
+    out->spots     = atomic_load_explicit(&wl->spots, memory_order_relaxed);
+    out->dropped   = atomic_load_explicit(&wl->dropped, memory_order_relaxed);
+}
+
+void wsjtx_listen_stop(WsjtxListener *wl)
+{
+    if (wl->fd < 0) return;
+    atomic_store(&wl->stop, 1);
+    pthread_join(wl->thread, NULL);
+    close(wl->fd);
+    wl->fd = -1;
+    free(wl->ring);
+    wl->ring = NULL;
+}
@@ -0,0 +1,103 @@
+/* wsjtx.h — WSJT-X UDP message listener.
+ *
+ * A background thread receives WSJT-X's UDP messages (its "UDP Server"
+ * setting, port 2237 by default, optionally a multicast group) and decodes
+ * the Status, Decode and QSO Logged messages.  A decode that carries a
+ * Maidenhead grid (CQ calls, first calls) becomes a spot at the center of
+ * that grid square.
+ *
+ * Events go to the main thread through a lock-free single-producer /
+ * single-consumer ring: the listener never waits for the render thread,
+ * and a decode burst at the end of an FT8 cycle costs the main loop one
+ * wakeup and a few copies.  When the ring is full, new events are dropped
+ * and counted. */
+
+#ifndef WSJTX_H
+#define WSJTX_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+#define WSJTX_DEFAULT_PORT 2237
+#define WSJTX_RING_SIZE    4096    /* events; a power of two */
+
+/* Message types of the WSJT-X protocol (NetworkMessage.hpp) */
+#define WSJTX_MSG_HEARTBEAT  0
+#define WSJTX_MSG_STATUS     1
+#define WSJTX_MSG_DECODE     2
+#define WSJTX_MSG_QSO_LOGGED 5
+#define WSJTX_MAGIC          0xadbccbdau
+
+typedef enum {
+    WSJTX_EV_DECODE,        /* a station was heard */
+    WSJTX_EV_STATUS,        /* dial frequency, mode, own call changed */
+    WSJTX_EV_LOGGED,        /* a QSO was logged */
+} WsjtxEventKind;
+
+typedef struct {
+    WsjtxEventKind kind;
+    char     call[16];      /* DECODE: sender, LOGGED: DX call, STATUS: own call */
+    char     grid[8];       /* "" if the message had none */
+    int      has_pos;       /* 1 if lat/lon hold the grid square's center */
+    double   lat, lon;
+    int      snr;           /* DECODE: dB */
+    unsigned df;            /* DECODE: audio offset (Hz) */
+    unsigned long long freq_hz;  /* STATUS: dial, LOGGED: TX frequency */
+    char     mode[8];       /* STATUS / LOGGED: "FT8"; DECODE: "~" (FT8), "+" (FT4) */
+    char     text[40];      /* DECODE: message, STATUS: DX call */
+} WsjtxEvent;
+
+/* Running totals (read with wsjtx_get_stats()) */
+typedef struct {
+    long datagrams;         /* received */
+    long bad;               /* not a WSJT-X message, or truncated */
+    long decodes;
+    long spots;             /* decodes with a grid */
+    long dropped;           /* events lost to a full ring */
+} WsjtxStats;
+
+typedef struct {
+    int          fd;
+    pthread_t    thread;
+    void       (*wake)(void);
+    atomic_int   stop;
+    WsjtxEvent  *ring;                        /* WSJTX_RING_SIZE slots */
+    _Alignas(64) atomic_size_t head;          /* next slot to write (listener) */
+    atomic_long  datagrams, bad, decodes, spots, dropped;  /* listener */
+    _Alignas(64) atomic_size_t tail;          /* next slot to read (main thread) */
+} WsjtxListener;
+
+/* Bind UDP port (0.0.0.0) and start the listener thread; with group
+ * (e.g. "224.0.0.1") non-empty, also join that multicast group, so several
+ * programs can share WSJT-X's output.  wake (thread-safe, e.g.
+ * glfwPostEmptyEvent, or NULL) is called after a datagram produced
+ * events.  Returns 0, or -1 with the reason printed (port 0 disables the
+ * listener quietly; the other calls then do nothing). */
+int  wsjtx_listen_start(WsjtxListener *wl, int port, const char *group,
+                        void (*wake)(void));
+
+/* Take the oldest event (main thread only).  Returns 1 if there was one. */
+int  wsjtx_take(WsjtxListener *wl, WsjtxEvent *out);
+
+/* Copy the running totals (any thread). */
+void wsjtx_get_stats(WsjtxListener *wl, WsjtxStats *out);
+
+/* Stop the thread and close the socket.  No-op if it never started. */
+void wsjtx_listen_stop(WsjtxListener *wl);
+
+/* Decode one datagram into ev.  Returns 1 if it produced an event, 0 for a
+ * valid message of no interest, -1 if it is not a valid WSJT-X message. */
+int  wsjtx_parse(const unsigned char *buf, size_t len, WsjtxEvent *ev);
+
+/* Sender callsign and grid of a decoded message text ("CQ EA4ABC IN80",
+ * "K1ABC EA4ABC IN80", "CQ DX EA4ABC IN80").  grid is "" when the message
+ * has none.  Returns 1 if a callsign was found. */
+int  wsjtx_message_station(const char *msg, char *call, size_t call_sz,
+                           char *grid, size_t grid_sz);
+
+/* Center of a 4- or 6-character Maidenhead square.  Returns 0, or -1 if
+ * grid is not one. */
+int  wsjtx_grid_to_latlon(const char *grid, double *lat, double *lon);
+
+#endif
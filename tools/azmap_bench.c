@@ -0,0 +1,670 @@
+/* azmap_bench.c — Headless benchmark of projection and overlay builds.
+ *
+ * Links the GL-free modules (projection, map_data, threadpool, segtable,
+ * overlay, contour, json_pull, cJSON) and times the hot paths over a sweep
+ * of projection centers in both modes:
+ *   map_data_reproject, map_data_reproject_nosplit, aurora_heat_build,
+ *   drap_heat_build, aurora_contours_build, spore_parse_json,
+ *   spore_parse_json_incr, muf_reproject, aurora_stream, aurora_cjson,
+ *   muf_stream, muf_cjson, kp_stream, kp_cjson
+ * Each case runs --reps times per center; the best run of every center
+ * feeds min / median / max ns per vertex (per texel for the heat and
+ * contour builds, per input byte for the feed parses; only the heat builds
+ * and the parses don't depend on the center).  The *_stream cases feed a
+ * synthetic response to the overlay stream parser in 16 KiB chunks, as
+ * curl delivers it; the *_cjson cases are cJSON_Parse() + cJSON_Delete()
+ * of the same document, the part of the former parsers that built the
+ * tree.  Heap allocations are counted by wrapping malloc/calloc/realloc/
+ * free at link time (see CMakeLists.txt), which also gives the peak heap
+ * in use during a call; peak RSS comes from getrusage().  Results are
+ * written as JSON.
+ *
+ * Map geometry comes from --shp PATH, or from a deterministic synthetic
+ * set of closed rings (same data on every machine).  Overlay inputs are
+ * always synthetic.
+ *
+ * --threads N sizes the reprojection pool as azmap's option does; timings
+ * are wall clock, so running the sweep at 1, 2, 4, 8 threads shows how
+ * the map_data cases scale.
+ *
+ * Usage: azmap_bench [--shp PATH] [--reps N] [--threads N] [--es-step D]
+ *                    [--fast] [--out PATH] */
+
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <malloc.h>
+#include <sys/resource.h>
+#include "projection.h"
+#include "map_data.h"
+#include "segtable.h"
+#include "threadpool.h"
+#include "overlay.h"
+#include "cJSON.h"
+
+#define BENCH_REPS_DEFAULT 5
+#define SYNTH_RINGS        2000
+#define SYNTH_RING_PTS     64
+#define SYNTH_STATIONS     60
+#define SYNTH_CHANGED      3
+#define SYNTH_MUF_LINES    96
+#define SYNTH_MUF_PTS      400
+#define SYNTH_KP_ROWS      240
+#define STREAM_CHUNK       16384
+
+/* ── Allocation counting (ld --wrap) ─────────────────────────────── */
+
+void *__real_malloc(size_t n);
+void *__real_calloc(size_t n, size_t sz);
+void *__real_realloc(void *p, size_t n);
+void  __real_free(void *p);
+
+/* Atomic: with --threads > 1 the pool workers allocate concurrently */
+static atomic_ulong alloc_calls;
+static atomic_ulong alloc_bytes;
+static atomic_long  heap_in_use;    /* usable bytes, of blocks seen by the wraps */
+static atomic_long  heap_peak;
+
+static void heap_add(void *p)
+{
+    if (!p) return;
+    long now = atomic_fetch_add(&heap_in_use, (long)malloc_usable_size(p))
+             + (long)malloc_usable_size(p);
+    long peak = atomic_load(&heap_peak);
+    while (now > peak && !atomic_compare_exchange_weak(&heap_peak, &peak, now))
+        ;
+}
+
+void *__wrap_malloc(size_t n)
+{
+    atomic_fetch_add(&alloc_calls, 1);
+    atomic_fetch_add(&alloc_bytes, n);
+    void *p = __real_malloc(n);
+    heap_add(p);
+    return p;
+}
+
+void *__wrap_calloc(size_t n, size_t sz)
+{
+    atomic_fetch_add(&alloc_calls, 1);
+    atomic_fetch_add(&alloc_bytes, n * sz);
+    void *p = __real_calloc(n, sz);
+    heap_add(p);
+    return p;
+}
+
+void *__wrap_realloc(void *p, size_t n)
+{
+    atomic_fetch_add(&alloc_calls, 1);
+    atomic_fetch_add(&alloc_bytes, n);
+    long old = p ? (long)malloc_usable_size(p) : 0;
+    void *q = __real_realloc(p, n);
+    if (q) {
+        atomic_fetch_sub(&heap_in_use, old);
+        heap_add(q);
+    }
+    return q;
+}
+
+void __wrap_free(void *p)
+{
+    if (p) atomic_fetch_sub(&heap_in_use, (long)malloc_usable_size(p));
+    __real_free(p);
+}
+
+/* ── Inputs ──────────────────────────────────────────────────────── */
+
+/* Projection centers: poles, mid-latitudes, equator, both hemispheres */
+static const double centers[][2] = {
+    {  90.0,    0.0 }, {  60.0,  -30.0 }, {  40.4,   -3.7 }, {  35.7,  139.7 },
+    {  20.0, -100.0 }, {   0.0,    0.0 }, {   0.0,  179.9 }, { -23.5,  -46.6 },
+    { -33.9,  151.2 }, { -45.0,   90.0 }, { -60.0, -150.0 }, { -90.0,    0.0 },
+};
+#define NUM_CENTERS ((int)(sizeof(centers) / sizeof(centers[0])))
+
+static unsigned int rng_state = 12345u;
+
+static double rng_unit(void)
+{
+    rng_state = rng_state * 1103515245u + 12345u;
+    return (double)((rng_state >> 8) & 0xFFFFFF) / (double)0x1000000;
+}
+
+/* Wobbly closed rings scattered over the sphere, shaped like a coastline
+ * layer after load (raw arrays, unit vectors, bounding caps). */
+static int synth_map(MapData *md)
+{
+    memset(md, 0, sizeof(*md));
+    int n = SYNTH_RINGS * SYNTH_RING_PTS;
+    md->raw_lats = malloc(n * sizeof(double));
+    md->raw_lons = malloc(n * sizeof(double));
+    md->raw_unit = malloc((size_t)n * 3 * sizeof(float));
+    md->raw_segs = segtable_new(SEG_CAPS);
+    if (!md->raw_lats || !md->raw_lons || !md->raw_unit || !md->raw_segs)
+        return -1;
+
+    for (int r = 0; r < SYNTH_RINGS; r++) {
+        double clat = asin(2.0 * rng_unit() - 1.0) * 180.0 / M_PI;
+        double clon = rng_unit() * 360.0 - 180.0;
+        double rad = 0.5 + rng_unit() * 4.5;
+        int start = md->raw_count;
+        for (int v = 0; v < SYNTH_RING_PTS - 1; v++) {
+            double a = 2.0 * M_PI * v / (SYNTH_RING_PTS - 1);
+            double rr = rad * (0.8 + 0.4 * rng_unit());
+            double lat = clat + rr * sin(a);
+            if (lat > 89.9) lat = 89.9;
+            if (lat < -89.9) lat = -89.9;
+            double lon = clon + rr * cos(a) / fmax(cos(clat * M_PI / 180.0), 0.1);
+            lon = fmod(lon + 540.0, 360.0) - 180.0;
+            md->raw_lats[md->raw_count] = lat;
+            md->raw_lons[md->raw_count] = lon;
+            md->raw_count++;
+        }
+        /* Close the ring */
+        md->raw_lats[md->raw_count] = md->raw_lats[start];
+        md->raw_lons[md->raw_count] = md->raw_lons[start];
+        md->raw_count++;
+        if (segtable_push(md->raw_segs, start, SYNTH_RING_PTS) < 0)
+            return -1;
+    }
+
+    projection_to_unit(md->raw_lats, md->raw_lons, md->raw_count, md->raw_unit);
+    SegTable *raw = md->raw_segs;
+    for (int s = 0; s < raw->num; s++)
+        projection_bound_cap(md->raw_unit + raw->starts[s], md->raw_count,
+                             raw->counts[s], raw->caps[s]);
+    return 0;
+}
+
+/* Auroral ovals around both magnetic poles, probability 0-100. */
+static int synth_aurora(AuroraGrid *g)
+{
+    aurora_grid_init(g);
+    g->values = calloc(360 * 181, sizeof(int));
+    if (!g->values) return -1;
+    for (int lon = 0; lon < 360; lon++) {
+        for (int lat = -90; lat <= 90; lat++) {
+            double band = fabs(fabs((double)lat) - 67.0 - 3.0 * sin(lon * M_PI / 180.0));
+            int p = (int)(90.0 * exp(-band * band / 18.0));
+            g->values[lon * 181 + lat + 90] = p;
+        }
+    }
+    g->valid = 1;
+    return 0;
+}
+
+/* Absorption blob over the dayside plus a polar cap, in MHz. */
+static int synth_drap(DrapGrid *g)
+{
+    drap_grid_init(g);
+    g->values = malloc(DRAP_GRID_ROWS * DRAP_GRID_COLS * sizeof(float));
+    if (!g->values) return -1;
+    for (int row = 0; row < DRAP_GRID_ROWS; row++) {
+        double lat = 89.0 - 2.0 * row;
+        for (int col = 0; col < DRAP_GRID_COLS; col++) {
+            double lon = -178.0 + 4.0 * col;
+            double d = projection_distance(lat, lon, 10.0, 30.0) / 1000.0;
+            float v = (float)(12.0 * exp(-d * d / 20.0));
+            if (fabs(lat) > 70.0) v += 5.0f;
+            g->values[row * DRAP_GRID_COLS + col] = v;
+            if (v > g->peak_mhz) g->peak_mhz = v;
+        }
+    }
+    g->valid = 1;
+    return 0;
+}
+
+/* KC2G stations.json layout: string lat/lon in a nested "station"
+ * object, longitude 0-360. */
+/* Station list, and in *alt the same list with SYNTH_CHANGED readings
+ * changed (a typical refresh).  Returns 0 on success. */
+static int synth_spore_json(char **json, char **alt)
+{
+    size_t cap = SYNTH_STATIONS * 128 + 16;
+    *json = malloc(cap);
+    *alt = malloc(cap);
+    if (!*json || !*alt) return -1;
+    size_t len = (size_t)snprintf(*json, cap, "[");
+    size_t alt_len = (size_t)snprintf(*alt, cap, "[");
+    for (int i = 0; i < SYNTH_STATIONS; i++) {
+        double lat = asin(2.0 * rng_unit() - 1.0) * 180.0 / M_PI * 0.8;
+        double lon = rng_unit() * 360.0;
+        double foes = 2.0 + rng_unit() * 10.0;
+        const char *fmt =
+            "%s{\"foes\":%.2f,\"station\":{\"latitude\":\"%.3f\",\"longitude\":\"%.3f\"}}";
+        len += (size_t)snprintf(*json + len, cap - len, fmt, i ? "," : "", foes, lat, lon);
+        alt_len += (size_t)snprintf(*alt + alt_len, cap - alt_len, fmt, i ? "," : "",
+                                    i < SYNTH_CHANGED ? foes + 1.5 : foes, lat, lon);
+    }
+    snprintf(*json + len, cap - len, "]");
+    snprintf(*alt + alt_len, cap - alt_len, "]");
+    return 0;
+}
+
+/* Growable text for the synthetic feed documents */
+typedef struct {
+    char  *buf;
+    size_t len, cap;
+} Text;
+
+static int text_printf(Text *t, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+static int text_printf(Text *t, const char *fmt, ...)
+{
+    for (;;) {
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(t->buf + t->len, t->cap - t->len, fmt, ap);
+        va_end(ap);
+        if (n < 0) return -1;
+        if (t->len + (size_t)n < t->cap) {
+            t->len += (size_t)n;
+            return 0;
+        }
+        size_t ncap = (t->cap + (size_t)n + 1) * 2;
+        char *b = realloc(t->buf, ncap);
+        if (!b) return -1;
+        t->buf = b;
+        t->cap = ncap;
+    }
+}
+
+/* OVATION aurora_latest.json: one [lon, lat, probability] triplet per
+ * degree, 360 x 181, from the synthetic aurora grid. */
+static int synth_aurora_json(Text *t, const AuroraGrid *g)
+{
+    if (text_printf(t, "{\"Observation Time\": \"2026-03-20T12:00:00Z\", "
+                       "\"Forecast Time\": \"2026-03-20T12:45:00Z\", "
+                       "\"Data Format\": \"[Longitude, Latitude, Aurora]\", "
+                       "\"coordinates\": [") != 0)
+        return -1;
+    for (int lon = 0; lon < 360; lon++)
+        for (int lat = -90; lat <= 90; lat++)
+            if (text_printf(t, "%s[%d, %d, %d]", lon || lat > -90 ? ", " : "",
+                            lon, lat, g->values[lon * 181 + lat + 90]) != 0)
+                return -1;
+    return text_printf(t, "], \"type\": \"MultiPoint\"}");
+}
+
+/* KC2G MUF GeoJSON: LineString contours with stroke color and level. */
+static int synth_muf_json(Text *t)
+{
+    if (text_printf(t, "{\"type\": \"FeatureCollection\", \"features\": [") != 0)
+        return -1;
+    for (int f = 0; f < SYNTH_MUF_LINES; f++) {
+        int mhz = 5 + (f % 12) * 2;
+        if (text_printf(t, "%s{\"type\": \"Feature\", \"properties\": "
+                           "{\"level-value\": %d, \"stroke\": \"#%02x%02x40\", "
+                           "\"title\": \"%d MHz\"}, \"geometry\": "
+                           "{\"type\": \"LineString\", \"coordinates\": [",
+                        f ? ", " : "", mhz, mhz * 8, 255 - mhz * 8, mhz) != 0)
+            return -1;
+        double lat = asin(2.0 * rng_unit() - 1.0) * 180.0 / M_PI * 0.7;
+        double lon = rng_unit() * 360.0 - 180.0;
+        for (int v = 0; v < SYNTH_MUF_PTS; v++) {
+            lat += rng_unit() - 0.5;
+            lon += 0.9;
+            if (text_printf(t, "%s[%.6f, %.6f]", v ? ", " : "",
+                            fmod(lon + 540.0, 360.0) - 180.0, lat) != 0)
+                return -1;
+        }
+        if (text_printf(t, "]}}") != 0) return -1;
+    }
+    return text_printf(t, "]}");
+}
+
+/* SWPC noaa-planetary-k-index.json: header row, then string rows. */
+static int synth_kp_json(Text *t)
+{
+    if (text_printf(t, "[[\"time_tag\",\"Kp\",\"a_running\",\"station_count\"]") != 0)
+        return -1;
+    for (int i = 0; i < SYNTH_KP_ROWS; i++)
+        if (text_printf(t, ",[\"2026-03-%02d %02d:00:00.000\",\"%.2f\",\"%d\",\"8\"]",
+                        1 + i / 8, i % 8 * 3, rng_unit() * 9.0, i % 50) != 0)
+            return -1;
+    return text_printf(t, "]");
+}
+
+/* ── Benchmark cases ─────────────────────────────────────────────── */
+
+typedef struct {
+    MapData     map;
+    AuroraGrid  aurora;
+    DrapGrid    drap;
+    HeatGrid    heat;
+    HeatGrid    aurora_heat;      /* input of the contour case */
+    MufData     isolines;
+    char       *spore_json;
+    char       *spore_json_alt;   /* spore_json with SYNTH_CHANGED readings changed */
+    SporeGrid   spore_grid;
+    MufData     spore;
+    Text        aurora_json, muf_json, kp_json;
+    AuroraGrid  aurora_parsed;    /* output of aurora_stream */
+} BenchInputs;
+
+/* Run one case once; returns the vertex count it processed. */
+typedef long (*BenchFn)(BenchInputs *in);
+
+static long run_reproject(BenchInputs *in)
+{
+    map_data_reproject(&in->map);
+    return in->map.raw_count;
+}
+
+static long run_reproject_nosplit(BenchInputs *in)
+{
+    map_data_reproject_nosplit(&in->map);
+    return in->map.raw_count;
+}
+
+static long run_aurora(BenchInputs *in)
+{
+    aurora_heat_build(&in->heat, &in->aurora);
+    return (long)in->heat.width * in->heat.height;
+}
+
+static long run_drap(BenchInputs *in)
+{
+    drap_heat_build(&in->heat, &in->drap);
+    return (long)in->heat.width * in->heat.height;
+}
+
+static long run_aurora_contours(BenchInputs *in)
+{
+    aurora_contours_build(&in->isolines, &in->aurora_heat);
+    return (long)in->aurora_heat.width * in->aurora_heat.height;
+}
+
+static long run_spore_parse(BenchInputs *in)
+{
+    muf_data_free(&in->spore);
+    muf_data_init(&in->spore);
+    spore_grid_reset(&in->spore_grid);
+    spore_parse_json(in->spore_json, &in->spore_grid, &in->spore);
+    return in->spore.raw_count;
+}
+
+/* Refresh with a few changed stations: only those are re-scattered */
+static long run_spore_parse_incr(BenchInputs *in)
+{
+    static int flip;
+    muf_data_free(&in->spore);
+    muf_data_init(&in->spore);
+    flip = !flip;
+    spore_parse_json(flip ? in->spore_json_alt : in->spore_json,
+                     &in->spore_grid, &in->spore);
+    return in->spore.raw_count;
+}
+
+static long run_muf_reproject(BenchInputs *in)
+{
+    muf_reproject(&in->spore);
+    return in->spore.raw_count;
+}
+
+/* Feed doc to a stream parser the way a fetch does, 16 KiB at a time */
+static void stream_doc(OverlayStream *s, OverlayFeed feed, const Text *doc)
+{
+    overlay_stream_init(s, feed);
+    for (size_t i = 0; i < doc->len; i += STREAM_CHUNK)
+        overlay_stream_feed(s, doc->buf + i,
+                            doc->len - i < STREAM_CHUNK ? doc->len - i : STREAM_CHUNK);
+    overlay_stream_feed(s, NULL, 0);
+}
+
+static long run_cjson(const Text *doc)
+{
+    cJSON_Delete(cJSON_Parse(doc->buf));
+    return (long)doc->len;
+}
+
+static long run_aurora_stream(BenchInputs *in)
+{
+    OverlayStream s;
+    stream_doc(&s, OVERLAY_FEED_AURORA, &in->aurora_json);
+    aurora_take_stream(&in->aurora_parsed, &s);
+    overlay_stream_free(&s);
+    return (long)in->aurora_json.len;
+}
+
+static long run_aurora_cjson(BenchInputs *in)
+{
+    return run_cjson(&in->aurora_json);
+}
+
+/* Vertices and segments only: muf_take_stream() would add the projection */
+static long run_muf_stream(BenchInputs *in)
+{
+    OverlayStream s;
+    stream_doc(&s, OVERLAY_FEED_MUF, &in->muf_json);
+    overlay_stream_free(&s);
+    return (long)in->muf_json.len;
+}
+
+static long run_muf_cjson(BenchInputs *in)
+{
+    return run_cjson(&in->muf_json);
+}
+
+static long run_kp_stream(BenchInputs *in)
+{
+    OverlayStream s;
+    GeomagIndices g;
+    geomag_init(&g);
+    stream_doc(&s, OVERLAY_FEED_KP, &in->kp_json);
+    geomag_take_kp(&g, &s);
+    overlay_stream_free(&s);
+    return (long)in->kp_json.len;
+}
+
+static long run_kp_cjson(BenchInputs *in)
+{
+    return run_cjson(&in->kp_json);
+}
+
+static const struct {
+    const char *name;
+    BenchFn     fn;
+} cases[] = {
+    { "map_data_reproject",         run_reproject },
+    { "map_data_reproject_nosplit", run_reproject_nosplit },
+    { "aurora_heat_build",          run_aurora },
+    { "drap_heat_build",            run_drap },
+    { "aurora_contours_build",      run_aurora_contours },
+    { "spore_parse_json",           run_spore_parse },
+    { "spore_parse_json_incr",      run_spore_parse_incr },
+    { "muf_reproject",              run_muf_reproject },
+    { "aurora_stream",              run_aurora_stream },
+    { "aurora_cjson",               run_aurora_cjson },
+    { "muf_stream",                 run_muf_stream },
+    { "muf_cjson",                  run_muf_cjson },
+    { "kp_stream",                  run_kp_stream },
+    { "kp_cjson",                   run_kp_cjson },
+};
+#define NUM_CASES ((int)(sizeof(cases) / sizeof(cases[0])))
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static long peak_rss_kb(void)
+{
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return -1;
+    return ru.ru_maxrss;
+}
+
+/* Time case c in one mode over all centers and write its JSON object. */
+static void bench_case(FILE *out, int c, ProjMode mode, BenchInputs *in,
+                       int reps, int first)
+{
+    double ns_per_vtx[NUM_CENTERS];
+    double vtx_sum = 0.0;
+    unsigned long calls = 0, bytes = 0, runs = 0;
+    long peak_heap = 0;
+
+    projection_set_mode(mode);
+    for (int ci = 0; ci < NUM_CENTERS; ci++) {
+        projection_set_center(centers[ci][0], centers[ci][1]);
+        /* muf_reproject needs contours to exist for this center */
+        if (cases[c].fn == run_muf_reproject && in->spore.raw_count == 0)
+            run_spore_parse(in);
+
+        double best = -1.0;
+        long verts = 0;
+        for (int r = 0; r < reps; r++) {
+            unsigned long c0 = atomic_load(&alloc_calls), b0 = atomic_load(&alloc_bytes);
+            long h0 = atomic_load(&heap_in_use);
+            atomic_store(&heap_peak, h0);
+            double t0 = now_ns();
+            verts = cases[c].fn(in);
+            double dt = now_ns() - t0;
+            calls += atomic_load(&alloc_calls) - c0;
+            bytes += atomic_load(&alloc_bytes) - b0;
+            long peak = atomic_load(&heap_peak) - h0;
+            if (peak > peak_heap) peak_heap = peak;
+            runs++;
+            if (best < 0.0 || dt < best) best = dt;
+        }
+        ns_per_vtx[ci] = verts > 0 ? best / (double)verts : 0.0;
+        vtx_sum += (double)verts;
+    }
+    qsort(ns_per_vtx, NUM_CENTERS, sizeof(double), cmp_double);
+
+    fprintf(out, "%s    {\"name\": \"%s\", \"mode\": \"%s\", \"vertices\": %.0f,\n"
+                 "     \"ns_per_vertex\": {\"min\": %.3f, \"median\": %.3f, \"max\": %.3f},\n"
+                 "     \"allocs_per_call\": %.1f, \"alloc_bytes_per_call\": %.0f,"
+                 " \"peak_heap_bytes\": %ld, \"peak_rss_kb\": %ld}",
+            first ? "" : ",\n", cases[c].name,
+            mode == PROJ_AZEQ ? "azeq" : "ortho",
+            vtx_sum / NUM_CENTERS,
+            ns_per_vtx[0], ns_per_vtx[NUM_CENTERS / 2], ns_per_vtx[NUM_CENTERS - 1],
+            (double)calls / (double)runs, (double)bytes / (double)runs,
+            peak_heap, peak_rss_kb());
+}
+
+static void print_usage(const char *prog)
+{
+    fprintf(stderr,
+        "Usage: %s [--shp PATH] [--reps N] [--threads N] [--es-step D] [--fast]\n"
+        "          [--out PATH]\n"
+        "  --shp PATH   map geometry from a shapefile (default: synthetic rings)\n"
+        "  --reps N     runs per center, best one counts (default %d)\n"
+        "  --threads N  reprojection pool size (default: one per CPU)\n"
+        "  --es-step D  Sporadic E grid spacing in degrees: 2, 1 or 0.5 (default 2)\n"
+        "  --fast       float32 projection kernels (fast_projection = 1)\n"
+        "  --out PATH   write JSON to PATH instead of stdout\n",
+        prog, BENCH_REPS_DEFAULT);
+}
+
+int main(int argc, char **argv)
+{
+    const char *shp_path = NULL;
+    const char *out_path = NULL;
+    int reps = BENCH_REPS_DEFAULT;
+    int fast = 0;
+    int threads = 0;
+    double spore_step = 2.0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--shp") == 0 && i + 1 < argc) {
+            shp_path = argv[++i];
+        } else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            reps = atoi(argv[++i]);
+            if (reps < 1) reps = 1;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+            if (threads < 1) threads = 1;
+        } else if (strcmp(argv[i], "--es-step") == 0 && i + 1 < argc) {
+            spore_step = strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--fast") == 0) {
+            fast = 1;
+        } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    projection_set_batch_fast(fast);
+    if (threadpool_init(threads) != 0)
+        return 1;
+
+    BenchInputs in;
+    memset(&in, 0, sizeof(in));
+    if (shp_path) {
+        if (map_data_load(&in.map, shp_path) != 0)
+            return 1;
+    } else if (synth_map(&in.map) != 0) {
+        fprintf(stderr, "Error: out of memory building synthetic map\n");
+        return 1;
+    }
+    heat_grid_init(&in.heat);
+    heat_grid_init(&in.aurora_heat);
+    muf_data_init(&in.isolines);
+    muf_data_init(&in.spore);
+    spore_grid_init(&in.spore_grid, spore_step);
+    if (synth_spore_json(&in.spore_json, &in.spore_json_alt) != 0 ||
+        synth_aurora(&in.aurora) != 0 || synth_drap(&in.drap) != 0 ||
+        aurora_heat_build(&in.aurora_heat, &in.aurora) != 0 ||
+        synth_aurora_json(&in.aurora_json, &in.aurora) != 0 ||
+        synth_muf_json(&in.muf_json) != 0 || synth_kp_json(&in.kp_json) != 0) {
+        fprintf(stderr, "Error: out of memory building benchmark inputs\n");
+        return 1;
+    }
+
+    FILE *out = stdout;
+    if (out_path) {
+        out = fopen(out_path, "w");
+        if (!out) {
+            fprintf(stderr, "Error: cannot write %s\n", out_path);
+            return 1;
+        }
+    }
+
+    fprintf(out, "{\n  \"version\": \"%s\",\n  \"isa\": \"%s\",\n  \"fast\": %d,\n"
+                 "  \"threads\": %d,\n  \"es_step\": %g,\n  \"reps\": %d,\n  \"centers\": %d,\n  \"source\": \"%s\",\n"
+                 "  \"raw_vertices\": %d,\n  \"results\": [\n",
+            AZMAP_VERSION, projection_batch_isa(), fast, threadpool_size(), in.spore_grid.step, reps, NUM_CENTERS,
+            shp_path ? shp_path : "synthetic", in.map.raw_count);
+    int first = 1;
+    for (int c = 0; c < NUM_CASES; c++) {
+        bench_case(out, c, PROJ_AZEQ, &in, reps, first);
+        first = 0;
+        bench_case(out, c, PROJ_ORTHO, &in, reps, first);
+        fflush(out);
+    }
+    fprintf(out, "\n  ],\n  \"peak_rss_kb\": %ld\n}\n", peak_rss_kb());
+    if (out != stdout) fclose(out);
+
+    map_data_free(&in.map);
+    aurora_grid_free(&in.aurora);
+    aurora_grid_free(&in.aurora_parsed);
+    drap_grid_free(&in.drap);
+    heat_grid_free(&in.heat);
+    heat_grid_free(&in.aurora_heat);
+    muf_data_free(&in.isolines);
+    muf_data_free(&in.spore);
+    spore_grid_free(&in.spore_grid);
+    free(in.spore_json);
+    free(in.spore_json_alt);
+    free(in.aurora_json.buf);
+    free(in.muf_json.buf);
+    free(in.kp_json.buf);
+    threadpool_shutdown();
+    return 0;
+}
@@ -0,0 +1,387 @@
+/* ipc_load.c — Load generator for the IPC socket.
+ *
+ * Opens --clients connections and has each send its share of --rate
+ * updates per second for --seconds: target moves with station fields,
+ * station-info updates, and spots / unspots over --spots keys.  Replies
+ * are read as they come; "full" replies add up the updates the server
+ * could not queue.
+ *   send   loads a running azmap (its socket, or --socket PATH); the
+ *          server's totals are fetched with a stats request at the end
+ *   bench  runs the server (ipc.c) in-process on a temporary socket and
+ *          pipe, with a consumer that takes and applies the queue once per
+ *          60 Hz frame into a spot set as the main loop does; it reports
+ *          updates per frame, the time spent taking and applying them, and
+ *          frames that overran their 16.7 ms slot
+ * With --fifo one more writer sends target lines in the legacy pipe
+ * format (bench only).  --rate 0 sends as fast as the socket takes it.
+ *
+ * Usage: ipc_load send [--socket PATH] [--clients N] [--rate R]
+ *                      [--seconds S] [--spots K]
+ *        ipc_load bench [--clients N] [--rate R] [--seconds S] [--spots K]
+ *                       [--fifo] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "ipc.h"
+#include "spots.h"
+
+#define LOAD_CLIENTS      4
+#define LOAD_RATE         20000     /* updates per second, all clients */
+#define LOAD_SECONDS      5.0
+#define LOAD_SPOTS        2000
+#define LOAD_TICK_US      1000      /* senders catch up on their schedule this often */
+#define FRAME_US          16667     /* consumer period: one 60 Hz frame */
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static void sleep_us(uint64_t us)
+{
+    struct timespec ts = { (time_t)(us / 1000000), (long)(us % 1000000) * 1000 };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+        ;
+}
+
+/* ── Clients ─────────────────────────────────────────────────────── */
+
+typedef struct {
+    int       id;
+    int       fd;
+    int       fifo;             /* legacy pipe lines instead of JSON */
+    double    rate;             /* updates per second, 0 = unthrottled */
+    double    seconds;
+    int       spots;
+    unsigned  rng;
+    long      sent, full_dropped, errors;
+    char      rbuf[4096];       /* partial reply line */
+    int       rlen;
+} Client;
+
+static unsigned rng_next(Client *c, unsigned n)
+{
+    c->rng = c->rng * 1103515245u + 12345u;
+    return ((c->rng >> 8) & 0xFFFFFF) % n;
+}
+
+static double rng_coord(Client *c, double range)
+{
+    return ((double)rng_next(c, 200001) / 100000.0 - 1.0) * range;
+}
+
+/* One update line into out; returns its length */
+static int make_update(Client *c, char *out, size_t out_sz)
+{
+    unsigned kind = rng_next(c, 100);
+    if (c->fifo)
+        return snprintf(out, out_sz, "%.4f,%.4f,PIPE %d|Pipe station|%u kHz|Spain|Noblejas|es|Americas\n",
+                        rng_coord(c, 89.0), rng_coord(c, 179.0), c->id, 5000 + rng_next(c, 20000));
+    if (kind < 10)
+        return snprintf(out, out_sz,
+                        "{\"type\":\"target\",\"lat\":%.4f,\"lon\":%.4f,\"name\":\"TGT %d\","
+                        "\"station\":\"Radio %d\",\"freq\":\"%u kHz\",\"country\":\"Spain\","
+                        "\"site\":\"Noblejas\",\"lang\":\"es\",\"target\":\"Americas\"}\n",
+                        rng_coord(c, 89.0), rng_coord(c, 179.0), c->id, c->id,
+                        5000 + rng_next(c, 20000));
+    if (kind < 20)
+        return snprintf(out, out_sz,
+                        "{\"type\":\"station\",\"station\":\"Radio %d\",\"freq\":\"%u kHz\"}\n",
+                        c->id, 5000 + rng_next(c, 20000));
+    unsigned key = rng_next(c, (unsigned)c->spots);
+    if (kind < 95)
+        return snprintf(out, out_sz,
+                        "{\"type\":\"spot\",\"key\":\"S%05u\",\"lat\":%.4f,\"lon\":%.4f}\n",
+                        key, rng_coord(c, 89.0), rng_coord(c, 179.0));
+    return snprintf(out, out_sz, "{\"type\":\"unspot\",\"key\":\"S%05u\"}\n", key);
+}
+
+/* Count the "full" and "error" replies received so far */
+static void read_replies(Client *c)
+{
+    if (c->fifo) return;
+    ssize_t n;
+    while ((n = recv(c->fd, c->rbuf + c->rlen, sizeof(c->rbuf) - 1 - (size_t)c->rlen,
+                     MSG_DONTWAIT)) > 0) {
+        c->rlen += (int)n;
+        c->rbuf[c->rlen] = '\0';
+        char *line = c->rbuf, *nl;
+        while ((nl = strchr(line, '\n'))) {
+            *nl = '\0';
+            const char *d = strstr(line, "\"dropped\":");
+            if (strstr(line, "\"status\":\"full\"") && d)
+                c->full_dropped += atol(d + 10);
+            else if (strstr(line, "\"status\":\"error\""))
+                c->errors++;
+            line = nl + 1;
+        }
+        c->rlen = (int)strlen(line);
+        memmove(c->rbuf, line, (size_t)c->rlen + 1);
+    }
+}
+
+static void *client_run(void *arg)
+{
+    Client *c = arg;
+    char buf[65536];
+    uint64_t start = now_us(), end = start + (uint64_t)(c->seconds * 1e6);
+    for (uint64_t t = start; t < end; t = now_us()) {
+        long due = c->rate > 0 ? (long)((t - start) / 1e6 * c->rate) + 1 : c->sent + 256;
+        size_t len = 0;
+        while (c->sent < due && len + 512 < sizeof(buf)) {
+            len += (size_t)make_update(c, buf + len, sizeof(buf) - len);
+            c->sent++;
+        }
+        for (size_t off = 0; off < len;) {
+            ssize_t w = write(c->fd, buf + off, len - off);
+            if (w < 0 && errno != EINTR) return NULL;
+            if (w > 0) off += (size_t)w;
+        }
+        read_replies(c);
+        if (c->rate > 0 && c->sent >= due) sleep_us(LOAD_TICK_US);
+    }
+    sleep_us(100000);                   /* replies still on the way */
+    read_replies(c);
+    return NULL;
+}
+
+static int connect_unix(const char *path)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        fprintf(stderr, "Error: cannot connect to %s: %s\n", path, strerror(errno));
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* Run nclients (plus the pipe writer, fifo_fd >= 0) to completion */
+static int run_clients(const char *path, int fifo_fd, int nclients, double rate,
+                       double seconds, int spots, Client *cl)
+{
+    int total = nclients + (fifo_fd >= 0);
+    pthread_t th[IPC_CLIENTS_MAX + 1];
+    for (int i = 0; i < total; i++) {
+        Client *c = &cl[i];
+        memset(c, 0, sizeof(*c));
+        c->id = i;
+        c->fifo = i == nclients;
+        c->fd = c->fifo ? fifo_fd : connect_unix(path);
+        if (c->fd < 0) return -1;
+        c->rate = rate / nclients;
+        c->seconds = seconds;
+        c->spots = spots;
+        c->rng = 12345u + (unsigned)i * 7919u;
+        if (c->fifo) c->rate = 100.0;          /* a dashboard's pace */
+    }
+    for (int i = 0; i < total; i++)
+        pthread_create(&th[i], NULL, client_run, &cl[i]);
+    for (int i = 0; i < total; i++)
+        pthread_join(th[i], NULL);
+    return 0;
+}
+
+static void print_clients(const Client *cl, int total, double seconds)
+{
+    long sent = 0, full = 0, errors = 0;
+    for (int i = 0; i < total; i++) {
+        sent += cl[i].sent;
+        full += cl[i].full_dropped;
+        errors += cl[i].errors;
+    }
+    printf("sent:       %ld updates in %.1f s (%.0f/s) from %d writers\n",
+           sent, seconds, sent / seconds, total);
+    printf("replies:    %ld updates reported dropped (queue full), %ld errors\n", full, errors);
+}
+
+/* ── send ────────────────────────────────────────────────────────── */
+
+static int cmd_send(const char *path, int nclients, double rate, double seconds, int spots)
+{
+    static Client cl[IPC_CLIENTS_MAX + 1];
+    if (run_clients(path, -1, nclients, rate, seconds, spots, cl) != 0) return 1;
+    print_clients(cl, nclients, seconds);
+
+    int fd = connect_unix(path);
+    if (fd < 0) return 1;
+    const char req[] = "{\"type\":\"stats\"}\n";
+    char reply[512];
+    ssize_t n = -1;
+    if (write(fd, req, sizeof(req) - 1) == (ssize_t)sizeof(req) - 1)
+        n = read(fd, reply, sizeof(reply) - 1);
+    if (n > 0) {
+        reply[n] = '\0';
+        printf("server:     %s", reply);
+    }
+    for (int i = 0; i < nclients; i++) close(cl[i].fd);
+    close(fd);
+    return 0;
+}
+
+/* ── bench ───────────────────────────────────────────────────────── */
+
+static atomic_int load_done;
+
+typedef struct {
+    const char *path;
+    int fifo_fd, nclients, spots;
+    double rate, seconds;
+    Client *cl;
+    int rc;
+} LoadArgs;
+
+static void *load_run(void *arg)
+{
+    LoadArgs *a = arg;
+    a->rc = run_clients(a->path, a->fifo_fd, a->nclients, a->rate, a->seconds, a->spots, a->cl);
+    atomic_store(&load_done, 1);
+    return NULL;
+}
+
+static int cmd_bench(int nclients, double rate, double seconds, int spots, int use_fifo)
+{
+    char path[108], fifo_path[108];
+    snprintf(path, sizeof(path), "/tmp/ipc_load-%d.sock", (int)getpid());
+    snprintf(fifo_path, sizeof(fifo_path), "/tmp/ipc_load-%d.fifo", (int)getpid());
+    IpcServer srv;
+    if (ipc_server_start(&srv, path, use_fifo ? fifo_path : NULL, NULL) != 0) return 1;
+    int fifo_fd = use_fifo ? open(fifo_path, O_WRONLY) : -1;
+
+    SpotSet set;
+    if (spots_init(&set) != 0) return 1;
+    static Client cl[IPC_CLIENTS_MAX + 1];
+    LoadArgs a = { path, fifo_fd, nclients, spots, rate, seconds, cl, 0 };
+    pthread_t loader;
+    pthread_create(&loader, NULL, load_run, &a);
+
+    /* Consumer: the main loop's share, once per frame */
+    long frames = 0, late = 0, updates = 0, max_batch = 0, targets = 0, stations = 0;
+    uint64_t apply_us = 0, max_apply_us = 0, start = now_us(), next = start + FRAME_US;
+    int quiet = 0;
+    for (;;) {
+        uint64_t t = now_us();
+        if (t < next) sleep_us(next - t);
+        else if (t > next + FRAME_US) late++;   /* a whole frame slot missed */
+        next += FRAME_US;
+        if (next < now_us()) next = now_us() + FRAME_US;
+
+        uint64_t t0 = now_us();
+        const IpcUpdate *upd;
+        int n = ipc_take(&srv, &upd);
+        float heard = (float)((t0 - start) / 1e6);
+        for (int i = 0; i < n; i++) {
+            const IpcUpdate *u = &upd[i];
+            if (u->kind == IPC_SPOT)
+                spots_add(&set, u->key, u->lat, u->lon, u->pinned ? SPOT_PINNED : heard);
+            else if (u->kind == IPC_UNSPOT)
+                spots_remove(&set, u->key);
+            else if (u->kind == IPC_TARGET)
+                targets++;
+            else
+                stations++;
+        }
+        uint64_t dt = now_us() - t0;
+        frames++;
+        updates += n;
+        apply_us += dt;
+        if (dt > max_apply_us) max_apply_us = dt;
+        if (n > max_batch) max_batch = n;
+        if (atomic_load(&load_done) && n == 0) {
+            if (++quiet >= 6) break;
+        } else {
+            quiet = 0;
+        }
+    }
+    pthread_join(loader, NULL);
+    IpcStats st;
+    ipc_get_stats(&srv, &st);
+    ipc_server_stop(&srv);
+    if (fifo_fd >= 0) close(fifo_fd);
+    unlink(fifo_path);
+    if (a.rc != 0) return 1;
+
+    int writers = nclients + use_fifo;
+    print_clients(cl, writers, seconds);
+    printf("server:     %ld received, %ld coalesced, %ld dropped, %ld invalid\n",
+           st.received, st.coalesced, st.dropped, st.errors);
+    printf("main loop:  %ld frames, %ld late, %ld updates applied (max %ld per frame; "
+           "%ld targets, %ld station infos), %d spots in the set\n",
+           frames, late, updates, max_batch, targets, stations, set.count);
+    printf("apply:      %.1f us/frame avg, %.1f us max\n",
+           frames ? (double)apply_us / frames : 0.0, (double)max_apply_us);
+    for (int i = 0; i < nclients; i++) close(cl[i].fd);
+    spots_free(&set);
+    return 0;
+}
+
+/* ── main ────────────────────────────────────────────────────────── */
+
+static void print_usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s send [--socket PATH] [--clients N] [--rate R] [--seconds S] [--spots K]\n"
+            "       %s bench [--clients N] [--rate R] [--seconds S] [--spots K] [--fifo]\n"
+            "Defaults: %d clients, %d updates/s in all, %.0f s, %d spot keys.\n"
+            "--rate 0 sends as fast as the socket takes it.\n",
+            prog, prog, LOAD_CLIENTS, LOAD_RATE, LOAD_SECONDS, LOAD_SPOTS);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    char path[108];
+    ipc_default_path(path, sizeof(path));
+    int nclients = LOAD_CLIENTS, spots = LOAD_SPOTS, use_fifo = 0;
+    double rate = LOAD_RATE, seconds = LOAD_SECONDS;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            snprintf(path, sizeof(path), "%s", argv[++i]);
+        } else if (strcmp(argv[i], "--clients") == 0 && i + 1 < argc) {
+            nclients = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            rate = strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--spots") == 0 && i + 1 < argc) {
+            spots = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--fifo") == 0) {
+            use_fifo = 1;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (nclients < 1) nclients = 1;
+    if (nclients > IPC_CLIENTS_MAX) nclients = IPC_CLIENTS_MAX;
+    if (spots < 1) spots = 1;
+    if (seconds <= 0) seconds = LOAD_SECONDS;
+    if (rate < 0) rate = 0;
+
+    if (strcmp(argv[1], "send") == 0)
+        return cmd_send(path, nclients, rate, seconds, spots);
+    if (strcmp(argv[1], "bench") == 0)
+        return cmd_bench(nclients, rate, seconds, spots, use_fifo);
+    print_usage(argv[0]);
+    return 1;
+}
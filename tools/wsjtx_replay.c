@@ -0,0 +1,615 @@
+/* wsjtx_replay.c — Record, replay and load-test WSJT-X UDP traffic.
+ *
+ * Links the listener (wsjtx) and the spot set (spots) and exercises them
+ * the way azmap does, without a window:
+ *   record  saves the datagrams WSJT-X sends into a capture file
+ *   send    replays a capture, or a synthetic FT8 band, to a UDP port at
+ *           an accelerated rate (e.g. to a running azmap)
+ *   bench   replays into an in-process listener on a loopback port while
+ *           a consumer drains the ring once per 60 Hz frame into a spot
+ *           set, as the main loop does, and reports spots per second,
+ *           datagrams lost in the socket buffer and events dropped by the
+ *           full ring
+ *
+ * A capture is "WSJTXCAP" followed by one record per datagram: the time
+ * since the first one (u64 microseconds), the length (u32) and the bytes,
+ * integers big-endian.
+ *
+ * The synthetic band is deterministic: SYNTH_STATIONS stations with fixed
+ * calls and grids, a Status message and a heartbeat per 15 s FT8 cycle
+ * and a burst of decodes near its end (CQs and grid exchanges, which
+ * carry a grid, and reports and sign-offs, which do not), plus a logged
+ * QSO every few cycles.  --speed multiplies the replay rate (0 = as fast
+ * as the socket takes it); the traffic's own time is kept, so a speed of
+ * 100 turns one FT8 cycle into 150 ms.
+ *
+ * Usage: wsjtx_replay record FILE [--port P] [--group G] [--seconds S]
+ *        wsjtx_replay send [FILE] [--host H] [--port P] [--speed X]
+ *                          [--cycles N] [--loop N]
+ *        wsjtx_replay bench [FILE] [--port P] [--speed X] [--cycles N]
+ *                           [--loop N] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <signal.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "wsjtx.h"
+#include "spots.h"
+
+#define CAP_MAGIC         "WSJTXCAP"
+#define CAP_DGRAM_MAX     4096
+#define BENCH_PORT        52237         /* loopback port of the bench listener */
+#define FRAME_NS          16666667L     /* consumer period: one 60 Hz frame */
+#define FT8_CYCLE_US      15000000ULL
+#define SYNTH_STATIONS    400
+#define SYNTH_DECODES     45            /* per cycle: a busy 20 m FT8 band */
+#define SYNTH_CYCLES      40            /* default: ten minutes of traffic */
+#define SYNTH_BURST_US    12800000ULL   /* decodes start this far into a cycle */
+#define SYNTH_DECODE_GAP  25000ULL      /* and follow each other this often */
+
+/* ── Captures ────────────────────────────────────────────────────── */
+
+typedef struct {
+    uint64_t t_us;                      /* since the first datagram */
+    uint32_t len;
+    unsigned char *data;
+} Record;
+
+typedef struct {
+    Record *rec;
+    int     count, cap;
+} Capture;
+
+static int cap_append(Capture *c, uint64_t t_us, const unsigned char *data, uint32_t len)
+{
+    if (c->count == c->cap) {
+        int ncap = c->cap ? c->cap * 2 : 1024;
+        Record *r = realloc(c->rec, sizeof(*r) * (size_t)ncap);
+        if (!r) return -1;
+        c->rec = r;
+        c->cap = ncap;
+    }
+    unsigned char *d = malloc(len ? len : 1);
+    if (!d) return -1;
+    memcpy(d, data, len);
+    c->rec[c->count++] = (Record){ t_us, len, d };
+    return 0;
+}
+
+static void cap_free(Capture *c)
+{
+    for (int i = 0; i < c->count; i++)
+        free(c->rec[i].data);
+    free(c->rec);
+    memset(c, 0, sizeof(*c));
+}
+
+static void put_be(unsigned char *p, uint64_t v, int n)
+{
+    for (int i = n - 1; i >= 0; i--, v >>= 8)
+        p[i] = (unsigned char)v;
+}
+
+static uint64_t get_be(const unsigned char *p, int n)
+{
+    uint64_t v = 0;
+    for (int i = 0; i < n; i++)
+        v = v << 8 | p[i];
+    return v;
+}
+
+static int cap_load(Capture *c, const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "Error: cannot read %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    char magic[8];
+    if (fread(magic, 1, 8, f) != 8 || memcmp(magic, CAP_MAGIC, 8) != 0) {
+        fprintf(stderr, "Error: %s is not a WSJT-X capture\n", path);
+        fclose(f);
+        return -1;
+    }
+    unsigned char hdr[12], buf[CAP_DGRAM_MAX];
+    while (fread(hdr, 1, sizeof(hdr), f) == sizeof(hdr)) {
+        uint32_t len = (uint32_t)get_be(hdr + 8, 4);
+        if (len > sizeof(buf) || fread(buf, 1, len, f) != len) {
+            fprintf(stderr, "Error: %s is truncated\n", path);
+            break;
+        }
+        if (cap_append(c, get_be(hdr, 8), buf, len) != 0) {
+            fclose(f);
+            return -1;
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+/* ── Synthetic FT8 band ──────────────────────────────────────────── */
+
+/* QDataStream writer */
+typedef struct {
+    unsigned char buf[512];
+    uint32_t n;
+} Writer;
+
+static void w_be(Writer *w, uint64_t v, int n)
+{
+    if (w->n + (uint32_t)n > sizeof(w->buf)) return;
+    put_be(w->buf + w->n, v, n);
+    w->n += (uint32_t)n;
+}
+
+static void w_double(Writer *w, double d)
+{
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    w_be(w, bits, 8);
+}
+
+static void w_utf8(Writer *w, const char *s)
+{
+    uint32_t n = (uint32_t)strlen(s);
+    if (w->n + 4 + n > sizeof(w->buf)) return;
+    w_be(w, n, 4);
+    memcpy(w->buf + w->n, s, n);
+    w->n += n;
+}
+
+static void w_header(Writer *w, uint32_t type)
+{
+    w->n = 0;
+    w_be(w, WSJTX_MAGIC, 4);
+    w_be(w, 3, 4);                      /* schema */
+    w_be(w, type, 4);
+    w_utf8(w, "WSJT-X");
+}
+
+static unsigned int rng_state = 12345u;
+
+static unsigned rng_next(unsigned n)
+{
+    rng_state = rng_state * 1103515245u + 12345u;
+    return ((rng_state >> 8) & 0xFFFFFF) % n;
+}
+
+typedef struct {
+    char call[12];
+    char grid[5];
+} Station;
+
+static void synth_stations(Station *st, int n)
+{
+    static const char *prefixes[] = {
+        "EA", "K", "W", "N", "JA", "DL", "G", "VK", "PY", "UA", "F", "I",
+        "ZS", "VE", "LU", "OH", "SM", "YB", "HL", "VU",
+    };
+    for (int i = 0; i < n; i++) {
+        const char *p = prefixes[rng_next(sizeof(prefixes) / sizeof(prefixes[0]))];
+        snprintf(st[i].call, sizeof(st[i].call), "%s%u%c%c%c", p, rng_next(10),
+                 'A' + rng_next(26), 'A' + rng_next(26), 'A' + rng_next(26));
+        snprintf(st[i].grid, sizeof(st[i].grid), "%c%c%u%u", 'A' + rng_next(18),
+                 'A' + rng_next(18), rng_next(10), rng_next(10));
+    }
+}
+
+static int synth_band(Capture *c, int cycles)
+{
+    static Station st[SYNTH_STATIONS];
+    synth_stations(st, SYNTH_STATIONS);
+    const Station *me = &st[0];
+    Writer w;
+    for (int cy = 0; cy < cycles; cy++) {
+        uint64_t t0 = (uint64_t)cy * FT8_CYCLE_US;
+        uint32_t ms_of_day = (uint32_t)((t0 / 1000) % 86400000ULL);
+
+        w_header(&w, WSJTX_MSG_HEARTBEAT);
+        w_be(&w, 3, 4);                 /* maximum schema */
+        w_utf8(&w, "2.6.1");
+        w_utf8(&w, "");
+        if (cap_append(c, t0, w.buf, w.n) != 0) return -1;
+
+        w_header(&w, WSJTX_MSG_STATUS);
+        w_be(&w, 14074000, 8);          /* dial frequency */
+        w_utf8(&w, "FT8");
+        w_utf8(&w, "");                 /* DX call */
+        w_utf8(&w, "");                 /* report */
+        w_utf8(&w, "FT8");              /* TX mode */
+        w_be(&w, 0, 1);                 /* TX enabled */
+        w_be(&w, 0, 1);                 /* transmitting */
+        w_be(&w, 1, 1);                 /* decoding */
+        w_be(&w, 1500, 4);              /* RX DF */
+        w_be(&w, 1500, 4);              /* TX DF */
+        w_utf8(&w, me->call);
+        w_utf8(&w, me->grid);
+        if (cap_append(c, t0 + 1000, w.buf, w.n) != 0) return -1;
+
+        for (int d = 0; d < SYNTH_DECODES; d++) {
+            const Station *a = &st[1 + rng_next(SYNTH_STATIONS - 1)];
+            const Station *b = &st[1 + rng_next(SYNTH_STATIONS - 1)];
+            char text[40];
+            unsigned kind = rng_next(10);
+            if (kind < 3)                           /* CQ: sender + grid */
+                snprintf(text, sizeof(text), "CQ %s %s", a->call, a->grid);
+            else if (kind < 5)                      /* answer: sender + grid */
+                snprintf(text, sizeof(text), "%s %s %s", b->call, a->call, a->grid);
+            else if (kind < 8)                      /* report: no grid */
+                snprintf(text, sizeof(text), "%s %s -%02u", b->call, a->call, rng_next(24));
+            else                                    /* sign-off: no grid */
+                snprintf(text, sizeof(text), "%s %s RR73", b->call, a->call);
+
+            w_header(&w, WSJTX_MSG_DECODE);
+            w_be(&w, 1, 1);                         /* new */
+            w_be(&w, ms_of_day, 4);
+            w_be(&w, (uint32_t)(int32_t)((int)rng_next(40) - 24), 4);
+            w_double(&w, (double)rng_next(20) / 10.0 - 0.5);
+            w_be(&w, 200 + rng_next(2800), 4);      /* audio offset */
+            w_utf8(&w, "~");
+            w_utf8(&w, text);
+            w_be(&w, 0, 1);                         /* low confidence */
+            w_be(&w, 0, 1);                         /* off air */
+            if (cap_append(c, t0 + SYNTH_BURST_US + (uint64_t)d * SYNTH_DECODE_GAP,
+                           w.buf, w.n) != 0)
+                return -1;
+        }
+
+        if (cy % 4 == 3) {
+            const Station *dx = &st[1 + rng_next(SYNTH_STATIONS - 1)];
+            w_header(&w, WSJTX_MSG_QSO_LOGGED);
+            w_be(&w, 2460000, 8);                   /* date off (Julian day) */
+            w_be(&w, ms_of_day, 4);
+            w_be(&w, 1, 1);                         /* UTC */
+            w_utf8(&w, dx->call);
+            w_utf8(&w, dx->grid);
+            w_be(&w, 14075500, 8);
+            w_utf8(&w, "FT8");
+            w_utf8(&w, "-10");                      /* report sent */
+            w_utf8(&w, "-12");                      /* report received */
+            if (cap_append(c, t0 + FT8_CYCLE_US - 500000, w.buf, w.n) != 0) return -1;
+        }
+    }
+    return 0;
+}
+
+/* ── Timing ──────────────────────────────────────────────────────── */
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static void sleep_us(uint64_t us)
+{
+    struct timespec ts = { (time_t)(us / 1000000), (long)(us % 1000000) * 1000 };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+        ;
+}
+
+/* ── record ──────────────────────────────────────────────────────── */
+
+static volatile sig_atomic_t interrupted;
+
+static void on_sigint(int sig)
+{
+    (void)sig;
+    interrupted = 1;
+}
+
+static int cmd_record(const char *path, int port, const char *group, double seconds)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+#ifdef SO_REUSEPORT
+    setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+#endif
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((uint16_t)port);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        fprintf(stderr, "Error: cannot bind UDP port %d: %s\n", port, strerror(errno));
+        return 1;
+    }
+    if (group && group[0]) {
+        struct ip_mreq mreq;
+        memset(&mreq, 0, sizeof(mreq));
+        mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+        if (inet_pton(AF_INET, group, &mreq.imr_multiaddr) != 1 ||
+            setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) != 0) {
+            fprintf(stderr, "Error: cannot join multicast group %s\n", group);
+            return 1;
+        }
+    }
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        fprintf(stderr, "Error: cannot write %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    fwrite(CAP_MAGIC, 1, 8, f);
+    signal(SIGINT, on_sigint);
+    printf("Recording UDP %d into %s (Ctrl-C stops)\n", port, path);
+
+    unsigned char buf[CAP_DGRAM_MAX], hdr[12];
+    uint64_t start = now_us(), first = 0;
+    long count = 0;
+    while (!interrupted && (seconds <= 0 || now_us() - start < seconds * 1e6)) {
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        if (poll(&pfd, 1, 250) <= 0) continue;
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n < 0) continue;
+        uint64_t t = now_us();
+        if (count == 0) first = t;
+        put_be(hdr, t - first, 8);
+        put_be(hdr + 8, (uint64_t)n, 4);
+        fwrite(hdr, 1, sizeof(hdr), f);
+        fwrite(buf, 1, (size_t)n, f);
+        count++;
+    }
+    fclose(f);
+    close(fd);
+    printf("%ld datagrams recorded\n", count);
+    return 0;
+}
+
+/* ── send ────────────────────────────────────────────────────────── */
+
+typedef struct {
+    const Capture *cap;
+    int       fd;               /* connected UDP socket */
+    double    speed;            /* 0 = unthrottled */
+    int       loops;
+    long      sent, send_errors;
+    uint64_t  elapsed_us;
+    double    traffic_s;        /* the traffic's own duration */
+    atomic_int done;            /* set when the replay has finished */
+} Sender;
+
+static int sender_open(Sender *s, const char *host, int port)
+{
+    struct addrinfo hints, *res;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    char service[16];
+    snprintf(service, sizeof(service), "%d", port);
+    if (getaddrinfo(host, service, &hints, &res) != 0) {
+        fprintf(stderr, "Error: cannot resolve %s\n", host);
+        return -1;
+    }
+    s->fd = socket(res->ai_family, res->ai_socktype, 0);
+    if (s->fd < 0 || connect(s->fd, res->ai_addr, res->ai_addrlen) != 0) {
+        fprintf(stderr, "Error: cannot send to %s:%d: %s\n", host, port, strerror(errno));
+        freeaddrinfo(res);
+        return -1;
+    }
+    freeaddrinfo(res);
+    return 0;
+}
+
+/* Replay the capture loops times, keeping its timing divided by speed */
+static void *sender_run(void *arg)
+{
+    Sender *s = arg;
+    const Capture *c = s->cap;
+    uint64_t span = c->count ? c->rec[c->count - 1].t_us + 1000000 : 0;
+    uint64_t start = now_us();
+    for (int l = 0; l < s->loops && !interrupted; l++) {
+        for (int i = 0; i < c->count && !interrupted; i++) {
+            if (s->speed > 0) {
+                uint64_t due = start + (uint64_t)((double)(span * (uint64_t)l + c->rec[i].t_us) / s->speed);
+                uint64_t t = now_us();
+                if (due > t) sleep_us(due - t);
+            }
+            if (send(s->fd, c->rec[i].data, c->rec[i].len, 0) < 0)
+                s->send_errors++;
+            else
+                s->sent++;
+        }
+    }
+    s->elapsed_us = now_us() - start;
+    s->traffic_s = (double)span * s->loops / 1e6;
+    atomic_store(&s->done, 1);
+    return NULL;
+}
+
+static void print_sent(const Sender *s)
+{
+    double sec = s->elapsed_us / 1e6;
+    printf("sent:       %ld datagrams in %.2f s (%.0f/s), %ld send errors\n",
+           s->sent, sec, sec > 0 ? s->sent / sec : 0.0, s->send_errors);
+    printf("traffic:    %.0f s of band time, %.1fx real time\n",
+           s->traffic_s, sec > 0 ? s->traffic_s / sec : 0.0);
+}
+
+static int cmd_send(const Capture *cap, const char *host, int port, double speed, int loops)
+{
+    Sender s = { .cap = cap, .speed = speed, .loops = loops };
+    if (sender_open(&s, host, port) != 0) return 1;
+    signal(SIGINT, on_sigint);
+    sender_run(&s);
+    close(s.fd);
+    print_sent(&s);
+    return 0;
+}
+
+/* ── bench ───────────────────────────────────────────────────────── */
+
+static atomic_long wakeups;
+
+static void count_wakeup(void)
+{
+    atomic_fetch_add_explicit(&wakeups, 1, memory_order_relaxed);
+}
+
+static int cmd_bench(const Capture *cap, int port, double speed, int loops)
+{
+    WsjtxListener wl;
+    if (wsjtx_listen_start(&wl, port, NULL, count_wakeup) != 0) return 1;
+    SpotSet spots;
+    if (spots_init(&spots) != 0) {
+        wsjtx_listen_stop(&wl);
+        return 1;
+    }
+    Sender s = { .cap = cap, .speed = speed, .loops = loops };
+    if (sender_open(&s, "127.0.0.1", port) != 0) {
+        wsjtx_listen_stop(&wl);
+        return 1;
+    }
+    signal(SIGINT, on_sigint);
+    pthread_t sender;
+    if (pthread_create(&sender, NULL, sender_run, &s) != 0) {
+        fprintf(stderr, "Error: cannot start the sender thread\n");
+        return 1;
+    }
+
+    /* Consumer: the main loop's share, once per frame until the sender is
+     * done and the listener has gone quiet */
+    long frames = 0, events = 0, spot_adds = 0, max_batch = 0;
+    uint64_t drain_us = 0, max_drain_us = 0, start = now_us();
+    WsjtxStats st, last = { 0 };
+    int quiet = 0;
+    for (;;) {
+        sleep_us(FRAME_NS / 1000);
+        uint64_t t0 = now_us();
+        float heard = (float)((t0 - start) / 1e6);
+        long batch = 0;
+        WsjtxEvent ev;
+        while (wsjtx_take(&wl, &ev)) {
+            batch++;
+            if (ev.kind == WSJTX_EV_DECODE && ev.has_pos) {
+                spots_add(&spots, ev.call, ev.lat, ev.lon, heard);
+                spot_adds++;
+            } else if (ev.kind == WSJTX_EV_DECODE) {
+                spots_touch(&spots, ev.call, heard);
+            }
+        }
+        uint64_t dt = now_us() - t0;
+        frames++;
+        events += batch;
+        drain_us += dt;
+        if (dt > max_drain_us) max_drain_us = dt;
+        if (batch > max_batch) max_batch = batch;
+
+        wsjtx_get_stats(&wl, &st);
+        if (atomic_load(&s.done) && st.datagrams == last.datagrams && batch == 0) {
+            if (++quiet >= 6) break;            /* 100 ms without traffic */
+        } else {
+            quiet = 0;
+        }
+        last = st;
+    }
+    pthread_join(sender, NULL);
+    wsjtx_listen_stop(&wl);
+    wsjtx_get_stats(&wl, &st);
+
+    double sec = s.elapsed_us / 1e6;
+    print_sent(&s);
+    printf("received:   %ld datagrams, %ld lost in the socket buffer, %ld invalid\n",
+           st.datagrams, s.sent - st.datagrams, st.bad);
+    printf("decodes:    %ld, %ld with a grid, %ld dropped by the full ring\n",
+           st.decodes, st.spots, st.dropped);
+    printf("spots:      %ld added (%.0f/s), %d in the set\n",
+           spot_adds, sec > 0 ? spot_adds / sec : 0.0, spots.count);
+    printf("consumer:   %ld frames, %ld wakeups, %ld events (max %ld per frame), "
+           "drain %.2f us/frame avg, %.1f us max\n",
+           frames, (long)atomic_load(&wakeups), events, max_batch,
+           frames ? (double)drain_us / frames : 0.0, (double)max_drain_us);
+    close(s.fd);
+    spots_free(&spots);
+    return 0;
+}
+
+/* ── main ────────────────────────────────────────────────────────── */
+
+static void print_usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s record FILE [--port P] [--group G] [--seconds S]\n"
+            "       %s send [FILE] [--host H] [--port P] [--speed X] [--cycles N] [--loop N]\n"
+            "       %s bench [FILE] [--port P] [--speed X] [--cycles N] [--loop N]\n"
+            "Without FILE, send and bench replay a synthetic FT8 band of --cycles\n"
+            "15 s cycles (default %d).  --speed 0 sends as fast as possible.\n",
+            prog, prog, prog, SYNTH_CYCLES);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    const char *cmd = argv[1];
+    const char *file = NULL, *host = "127.0.0.1", *group = NULL;
+    int is_bench = strcmp(cmd, "bench") == 0;
+    int port = is_bench ? BENCH_PORT : WSJTX_DEFAULT_PORT;
+    int cycles = SYNTH_CYCLES, loops = 1;
+    double speed = 1.0, seconds = 0.0;
+
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--host") == 0 && i + 1 < argc) {
+            host = argv[++i];
+        } else if (strcmp(argv[i], "--group") == 0 && i + 1 < argc) {
+            group = argv[++i];
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+            speed = strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--cycles") == 0 && i + 1 < argc) {
+            cycles = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--loop") == 0 && i + 1 < argc) {
+            loops = atoi(argv[++i]);
+        } else if (argv[i][0] != '-' && !file) {
+            file = argv[i];
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (loops < 1) loops = 1;
+    if (cycles < 1) cycles = 1;
+    if (speed < 0) speed = 0;
+
+    if (strcmp(cmd, "record") == 0) {
+        if (!file) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        return cmd_record(file, port, group, seconds);
+    }
+    if (strcmp(cmd, "send") != 0 && !is_bench) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    Capture cap = { 0 };
+    int rc = file ? cap_load(&cap, file) : synth_band(&cap, cycles);
+    if (rc != 0 || cap.count == 0) {
+        fprintf(stderr, "Error: nothing to replay\n");
+        cap_free(&cap);
+        return 1;
+    }
+    printf("%d datagrams per pass, %s\n", cap.count, file ? file : "synthetic FT8 band");
+    rc = is_bench ? cmd_bench(&cap, port, speed, loops)
+                  : cmd_send(&cap, host, port, speed, loops);
+    cap_free(&cap);
+    return rc;
+}